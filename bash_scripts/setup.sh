@@ -26,6 +26,8 @@ if ! sudo dnf install -y \
     libffi-devel \
     expat-devel \
     libxml2-devel \
+    libusb1-devel \
+    opencascade-devel \
     graphviz \
     tree \
     htop \
@@ -0,0 +1,670 @@
+// Microbenchmarks for the UI, geometry and encoder hot paths. Builds
+// without Wayland (StepViewerBench target) and prints one tab-separated
+// line per benchmark so runs from two builds can be diffed or joined.
+//
+//   StepViewerBench [--filter <substring>] [--min-time <seconds>] [--list] [--memory]
+
+#include "ui/layout.h"
+#include "ui/layout_manager.h"
+#include "ui/static_layout.h"
+#include "ui/box.h"
+#include "comms/k40_comms.h"
+#include "comms/simulated_k40.h"
+#include "core/memory_accounting.h"
+#include "dxf/dxf_reader.h"
+#include "geometry/batch_kernels.h"
+#include "geometry/contour.h"
+#include "geometry/edit_history.h"
+#include "geometry/mesh.h"
+#include "geometry/mesh_slicer.h"
+#include "geometry/path_order.h"
+#include "geometry/polygon_offset.h"
+#include "geometry/polyline_simplify.h"
+#include "job/egv_encoder.h"
+#include "job/time_estimator.h"
+#include "job/toolpath.h"
+#include "job/toolpath_builder.h"
+#include "job/toolpath_optimizer.h"
+#include "raster/thumbnail.h"
+#include "viewport/soft_canvas.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+    constexpr double PI = 3.141592653589793;
+    constexpr int SAMPLES = 5;
+
+    struct Options {
+        std::string filter;
+        double min_time_s;
+        bool list_only;
+        bool memory;   // per-subsystem peaks to stderr after the run
+
+        Options() : min_time_s(0.2), list_only(false), memory(false) {}
+    };
+
+    struct Benchmark {
+        const char* name;
+        const char* unit;                // what one item is, for the throughput column
+        std::function<double()> setup;   // builds inputs, returns items per iteration
+        std::function<void()> run;
+    };
+
+    // Keeps results alive so the optimizer cannot drop the work
+    volatile uint64_t sink;
+    // Correctness checks run by setups; any failure fails the run
+    int check_failures = 0;
+
+    typedef std::chrono::steady_clock Clock;
+
+    double seconds_since(Clock::time_point start) {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    // Grows the iteration count until one sample takes min_time / SAMPLES,
+    // then reports the median and fastest sample
+    void run_benchmark(const Benchmark& bench, const Options& options) {
+        const double items = bench.setup();
+        bench.run(); // warm up caches and allocators
+
+        const double sample_target = options.min_time_s / SAMPLES;
+        uint64_t iterations = 1;
+        while (true) {
+            auto start = Clock::now();
+            for (uint64_t i = 0; i < iterations; ++i) bench.run();
+            double elapsed = seconds_since(start);
+            if (elapsed >= sample_target || iterations >= (1ull << 30)) break;
+            double scale = elapsed > 0.0 ? sample_target / elapsed * 1.2 : 10.0;
+            iterations = std::max<uint64_t>(iterations + 1, static_cast<uint64_t>(iterations * std::min(scale, 10.0)));
+        }
+
+        std::vector<double> per_iteration;
+        for (int s = 0; s < SAMPLES; ++s) {
+            auto start = Clock::now();
+            for (uint64_t i = 0; i < iterations; ++i) bench.run();
+            per_iteration.push_back(seconds_since(start) * 1e9 / static_cast<double>(iterations));
+        }
+        std::sort(per_iteration.begin(), per_iteration.end());
+        double median_ns = per_iteration[SAMPLES / 2];
+        double min_ns = per_iteration.front();
+        double items_per_s = median_ns > 0.0 ? items * 1e9 / median_ns : 0.0;
+
+        std::printf("%s\t%llu\t%.1f\t%.1f\t%.0f\t%.4g\t%s/s\n", bench.name,
+                    static_cast<unsigned long long>(iterations), median_ns, min_ns, items,
+                    items_per_s, bench.unit);
+        std::fflush(stdout);
+    }
+
+    // --- inputs -----------------------------------------------------------
+
+    std::string make_dxf(int entities, bool curves) {
+        std::mt19937 rng(7);
+        std::uniform_real_distribution<double> coord(0.0, 300.0);
+        std::uniform_real_distribution<double> radius(0.5, 20.0);
+        std::string dxf = "0\nSECTION\n2\nENTITIES\n";
+        char buf[256];
+        for (int i = 0; i < entities; ++i) {
+            double x = coord(rng), y = coord(rng);
+            switch (curves ? i % 3 : 3) {
+                case 0:
+                    std::snprintf(buf, sizeof(buf), "0\nCIRCLE\n8\nCUT\n10\n%.4f\n20\n%.4f\n40\n%.4f\n", x, y, radius(rng));
+                    break;
+                case 1:
+                    std::snprintf(buf, sizeof(buf), "0\nARC\n8\nCUT\n10\n%.4f\n20\n%.4f\n40\n%.4f\n50\n15.0\n51\n250.0\n",
+                                  x, y, radius(rng));
+                    break;
+                case 2:
+                    std::snprintf(buf, sizeof(buf),
+                                  "0\nLWPOLYLINE\n8\nCUT\n90\n3\n70\n1\n10\n%.4f\n20\n%.4f\n42\n0.5\n10\n%.4f\n20\n%.4f\n10\n%.4f\n20\n%.4f\n42\n-0.3\n",
+                                  x, y, x + 10, y, x + 5, y + 8);
+                    break;
+                default:
+                    std::snprintf(buf, sizeof(buf), "0\nLINE\n8\nENGRAVE\n10\n%.4f\n20\n%.4f\n11\n%.4f\n21\n%.4f\n",
+                                  x, y, coord(rng), coord(rng));
+                    break;
+            }
+            dxf += buf;
+        }
+        dxf += "0\nENDSEC\n0\nEOF\n";
+        return dxf;
+    }
+
+    TriangleMesh make_sphere(int rings, int segments, float r) {
+        TriangleMesh mesh;
+        for (int i = 0; i <= rings; ++i) {
+            double phi = PI * i / rings;
+            for (int j = 0; j < segments; ++j) {
+                double theta = 2.0 * PI * j / segments;
+                float x = static_cast<float>(r * std::sin(phi) * std::cos(theta));
+                float y = static_cast<float>(r * std::sin(phi) * std::sin(theta));
+                float z = static_cast<float>(r * std::cos(phi));
+                mesh.positions.insert(mesh.positions.end(), {x, y, z});
+                mesh.bounds.expand(x, y, z);
+            }
+        }
+        for (int i = 0; i < rings; ++i) {
+            for (int j = 0; j < segments; ++j) {
+                uint32_t a = static_cast<uint32_t>(i * segments + j);
+                uint32_t b = static_cast<uint32_t>(i * segments + (j + 1) % segments);
+                uint32_t c = a + static_cast<uint32_t>(segments);
+                uint32_t d = b + static_cast<uint32_t>(segments);
+                mesh.indices.insert(mesh.indices.end(), {a, c, b, b, c, d});
+            }
+        }
+        return mesh;
+    }
+
+    // Streams commands to a fresh simulated board and reports whether it
+    // received exactly that stream, padded to whole packets
+    bool stream_arrives_intact(const char* bench_name, const char* label, const SimulatedK40::Config& board_config,
+                               const std::string& commands) {
+        SimulatedK40 board(board_config);
+        K40Comms comms(&board);
+        bool idle = comms.start();
+        comms.submit(commands);
+        idle = idle && comms.wait_until_idle(60000);
+        K40Comms::Stats stats = comms.get_stats();
+        comms.stop();
+        std::string expected = commands;
+        expected.resize(K40Protocol::packetize(commands).size() * K40Protocol::PAYLOAD_SIZE,
+                        static_cast<char>(K40Protocol::PACKET_PAD));
+        std::string received = board.get_received_commands();
+        bool match = idle && received == expected;
+        std::printf("# %s: %s, %zu of %zu bytes, %llu resends, %s\n", bench_name, label, received.size(),
+                    expected.size(), static_cast<unsigned long long>(stats.resends),
+                    match ? "intact" : "FAILED");
+        return match;
+    }
+
+    // A stream that stalls past the timeout must fail, and after
+    // clear_error() the next stream must go through whole
+    bool recovers_after_stall(const char* bench_name, const std::string& commands) {
+        SimulatedK40 board;
+        K40Comms::Config comms_config;
+        comms_config.stall_timeout_ms = 50;
+        K40Comms comms(&board, comms_config);
+        comms.start();
+        board.force_busy(200);
+        comms.submit(commands);
+        bool failed = !comms.wait_until_idle(60000) && comms.get_state() == K40Comms::State::ERROR;
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        comms.clear_error();
+        comms.submit(commands);
+        bool recovered = comms.wait_until_idle(60000);
+        comms.stop();
+        bool match = failed && recovered && board.get_received_commands().size() ==
+                     K40Protocol::packetize(commands).size() * K40Protocol::PAYLOAD_SIZE;
+        std::printf("# %s: stalled stream %s, next stream %s\n", bench_name, failed ? "aborted" : "FAILED",
+                    match ? "intact" : "FAILED");
+        return match;
+    }
+
+    Drawing make_grid_drawing(int parts) {
+        Drawing drawing;
+        drawing.layers.push_back("CUT");
+        int side = static_cast<int>(std::ceil(std::sqrt(parts)));
+        for (int i = 0; i < parts; ++i) {
+            double x = (i % side) * 12.0, y = (i / side) * 12.0;
+            Contour contour;
+            contour.closed = true;
+            for (int k = 0; k < 32; ++k) {
+                double a = 2.0 * PI * k / 32;
+                contour.points.push_back(Vec2{x + 5.0 + 4.0 * std::cos(a), y + 5.0 + 4.0 * std::sin(a)});
+            }
+            contour.update_bounds();
+            drawing.contours.push_back(std::move(contour));
+        }
+        return drawing;
+    }
+
+    std::vector<Benchmark> make_benchmarks() {
+        std::vector<Benchmark> list;
+
+        // UI: grid layout recalculation and box hit testing
+        static Layout* layout = nullptr;
+        list.push_back({"ui.layout_recalculate", "layout", [] {
+            delete layout;
+            layout = create_layout(0, 0, 1920, 1080);
+            for (int r = 0; r < 12; ++r) {
+                layout->add_row("a b c d e f g h");
+                layout->set_custom_col_width(r, 0, 70.0f);
+            }
+            layout->set_custom_row_height(0, 40.0f);
+            return 1.0;
+        }, [] {
+            layout->recalculate();
+            sink = sink + static_cast<uint64_t>(layout->get_element_area(11, 7).x);
+        }});
+
+        // Main window layout built from scratch, from strings and from the
+        // compile-time table
+        list.push_back({"ui.layout_build_main", "layout", [] { return 1.0; }, [] {
+            Layout* main_layout = create_layout(0, 0, 1920, 1080);
+            main_layout->add_row("titlebar closebtn");
+            main_layout->add_row("maincontent");
+            main_layout->set_custom_row_height(0, 40.0f);
+            main_layout->set_custom_col_width(0, 1, 70.0f);
+            main_layout->recalculate();
+            sink = sink + static_cast<uint64_t>(main_layout->get_element_area(0, 1).x);
+            delete main_layout;
+        }});
+
+        static constexpr auto MAIN = parse_layout({"titlebar closebtn", "maincontent"});
+        static constexpr LayoutCell MAIN_CLOSE = MAIN.cell("closebtn");
+        list.push_back({"ui.static_layout_build_main", "layout", [] { return 1.0; }, [] {
+            StaticLayout<2> main_layout(MAIN, {0, 0, 1920, 1080});
+            main_layout.set_custom_row_height(0, 40.0f);
+            main_layout.set_custom_col_width(MAIN_CLOSE, 70.0f);
+            main_layout.recalculate();
+            sink = sink + static_cast<uint64_t>(main_layout.get_element_area(MAIN_CLOSE).x);
+        }});
+
+        // Same grid, parsed at compile time
+        static constexpr std::string_view GRID_ROW = "a b c d e f g h";
+        static constexpr auto GRID = parse_layout({GRID_ROW, GRID_ROW, GRID_ROW, GRID_ROW, GRID_ROW, GRID_ROW,
+                                                   GRID_ROW, GRID_ROW, GRID_ROW, GRID_ROW, GRID_ROW, GRID_ROW});
+        static constexpr LayoutCell GRID_LAST = GRID.cell("h", 11);
+        static StaticLayout<12> static_layout(GRID);
+        list.push_back({"ui.static_layout_recalculate", "layout", [] {
+            static_layout = StaticLayout<12>(GRID, {0, 0, 1920, 1080});
+            for (uint8_t r = 0; r < 12; ++r) static_layout.set_custom_col_width(LayoutCell{r, 0}, 70.0f);
+            static_layout.set_custom_row_height(0, 40.0f);
+            return 1.0;
+        }, [] {
+            static_layout.recalculate();
+            sink = sink + static_cast<uint64_t>(static_layout.get_element_area(GRID_LAST).x);
+        }});
+
+        static LayoutManager* manager = nullptr;
+        static std::vector<TouchData> touches;
+        list.push_back({"ui.hit_test_500_boxes", "touch", [] {
+            delete manager;
+            manager = new LayoutManager(1920, 1080);
+            for (int i = 0; i < 500; ++i) {
+                float x = static_cast<float>((i % 25) * 76), y = static_cast<float>((i / 25) * 54);
+                manager->register_box(create_box(x, y, 70, 50, nullptr, "", "center", false));
+            }
+            std::mt19937 rng(3);
+            std::uniform_real_distribution<float> px(0.0f, 1920.0f), py(0.0f, 1080.0f);
+            touches.clear();
+            for (int i = 0; i < 1024; ++i) {
+                touches.push_back(TouchData{px(rng), py(rng), false, false, false});
+            }
+            return static_cast<double>(touches.size());
+        }, [] {
+            for (const auto& touch : touches) manager->handle_touch_for_all(touch);
+        }});
+
+        // Software rendering of a 1920x1080 frame: 500 boxes and a 2000-move
+        // preview, unchanged, with one box changing per frame (a progress
+        // bar), and repainted from scratch
+        static LayoutManager* soft_manager = nullptr;
+        static SoftCanvas soft_canvas;
+        static SoftTarget soft_target;
+        static std::vector<uint32_t> soft_pixels;
+        static std::vector<float> soft_lines;
+        static std::vector<DamageRect> soft_repainted, soft_damage;
+        static int soft_frame = 0;
+        static auto soft_setup = [] {
+            delete soft_manager;
+            soft_manager = new LayoutManager(1920, 1080);
+            for (int i = 0; i < 500; ++i) {
+                float x = static_cast<float>((i % 25) * 76), y = static_cast<float>((i / 25) * 54);
+                soft_manager->register_box(create_box(x, y, 70, 50, nullptr, "", "center", false));
+            }
+            soft_pixels.assign(1920 * 1080, 0);
+            soft_target = SoftTarget();
+            soft_target.pixels = soft_pixels.data();
+            soft_target.width = soft_target.stride = 1920;
+            soft_target.height = 1080;
+            std::mt19937 rng(5);
+            std::uniform_real_distribution<float> step(-12.0f, 12.0f);
+            soft_lines.clear();
+            float x = 960.0f, y = 540.0f;
+            for (int i = 0; i < 2000; ++i) {
+                soft_lines.push_back(x);
+                soft_lines.push_back(y);
+                x = std::clamp(x + step(rng), 600.0f, 1320.0f);
+                y = std::clamp(y + step(rng), 200.0f, 880.0f);
+            }
+            soft_frame = 0;
+            return 1.0;
+        };
+        static auto soft_render = [](bool progress) {
+            soft_canvas.begin_frame(1920, 1080, SoftCanvas::pixel(0.2f, 0.2f, 0.2f, 1.0f));
+            SoftCanvas::set_current(&soft_canvas);
+            soft_manager->render_all();
+            const uint32_t cut = SoftCanvas::pixel(1.0f, 0.55f, 0.1f, 1.0f);
+            for (size_t i = 2; i < soft_lines.size(); i += 2) {
+                soft_canvas.line(soft_lines[i - 2], soft_lines[i - 1], soft_lines[i], soft_lines[i + 1], cut);
+            }
+            if (progress) soft_canvas.fill_rect(100, 1040, 1 + soft_frame++ % 1700, 20, cut);
+            SoftCanvas::set_current(nullptr);
+            soft_canvas.render(soft_target, soft_repainted, soft_damage);
+            sink = sink + soft_damage.size() + soft_target.pixels[soft_frame % 1920];
+        };
+        list.push_back({"ui.soft_frame_unchanged", "frame", soft_setup, [] { soft_render(false); }});
+        list.push_back({"ui.soft_frame_progress", "frame", soft_setup, [] { soft_render(true); }});
+        list.push_back({"ui.soft_frame_full_repaint", "frame", soft_setup, [] {
+            soft_target.tile_hashes.clear();
+            soft_render(false);
+        }});
+
+        // File browser thumbnail of a 2000-part drawing (64k points)
+        static Drawing thumbnail_source;
+        static Thumbnail thumbnail;
+        list.push_back({"ui.thumbnail_rasterize_2k", "point", [] {
+            thumbnail_source = make_grid_drawing(2000);
+            return static_cast<double>(thumbnail_source.point_count());
+        }, [] {
+            ThumbnailRaster::rasterize(thumbnail_source, ThumbnailRaster::DEFAULT_SIZE, thumbnail);
+            sink = sink + thumbnail.coverage[thumbnail.coverage.size() / 2];
+        }});
+
+        // DXF: raw tokenizing, and parsing with curve flattening
+        static std::string dxf_lines;
+        list.push_back({"dxf.tokenize", "byte", [] {
+            dxf_lines = make_dxf(50000, false);
+            return static_cast<double>(dxf_lines.size());
+        }, [] {
+            DxfTokenizer tokenizer(dxf_lines.data(), dxf_lines.size());
+            int code;
+            std::string_view value;
+            uint64_t count = 0;
+            while (tokenizer.next(code, value)) count += static_cast<uint64_t>(code);
+            sink = sink + count;
+        }});
+
+        static std::string dxf_curves;
+        list.push_back({"tessellate.dxf_curves", "entity", [] {
+            dxf_curves = make_dxf(20000, true);
+            return 20000.0;
+        }, [] {
+            DxfReader reader;
+            Drawing drawing;
+            reader.parse(dxf_curves.data(), dxf_curves.size(), drawing);
+            sink = sink + drawing.point_count();
+        }});
+
+        static std::vector<TriangleMesh> meshes;
+        static std::vector<SlicePlane> planes;
+        list.push_back({"tessellate.slice_mesh", "triangle", [] {
+            meshes.clear();
+            meshes.push_back(make_sphere(200, 400, 50.0f));
+            planes = {SlicePlane::at_z(-20.0), SlicePlane::at_z(0.0), SlicePlane::at_z(20.0)};
+            return static_cast<double>(meshes[0].triangle_count());
+        }, [] {
+            MeshSlicer slicer;
+            Drawing drawing = slicer.slice(meshes, planes);
+            sink = sink + drawing.point_count();
+        }});
+
+        // Geometry: cut ordering
+        static Drawing grid;
+        list.push_back({"geometry.path_order_10k", "contour", [] {
+            grid = make_grid_drawing(10000);
+            return static_cast<double>(grid.contours.size());
+        }, [] {
+            PathOrder order = PathOrdering::nearest_neighbour(grid);
+            sink = sink + order.size();
+        }});
+
+        // Geometry: densely exported curves simplified to half a machine
+        // step; the point counts go to stdout as a comment line
+        static Drawing dense;
+        list.push_back({"geometry.simplify_dense_circles", "point", [] {
+            dense = Drawing();
+            dense.layers.push_back("CUT");
+            for (int i = 0; i < 500; ++i) {
+                double x = (i % 25) * 25.0, y = (i / 25) * 25.0, r = 2.0 + (i % 10);
+                Contour contour;
+                contour.closed = true;
+                for (int k = 0; k < 2000; ++k) {
+                    double a = 2.0 * PI * k / 2000;
+                    contour.points.push_back(Vec2{x + r * std::cos(a), y + r * std::sin(a)});
+                }
+                contour.update_bounds();
+                dense.contours.push_back(std::move(contour));
+            }
+            SimplifyStats stats;
+            PolylineSimplify::simplify(dense, 0.0127, &stats);
+            std::printf("# geometry.simplify_dense_circles: %zu points in, %zu out\n", stats.points_in, stats.points_out);
+            return static_cast<double>(dense.point_count());
+        }, [] {
+            Drawing simplified = PolylineSimplify::simplify(dense, 0.0127);
+            sink = sink + simplified.contours.size();
+        }});
+
+        // Geometry: kerf offsets of shapes whose raw offset overlaps itself.
+        // The setup checks the loop counts: slots that close up leave one
+        // outline, a neck that collapses splits the shape in two, and an
+        // inward offset past half the width leaves nothing
+        static IntPath slotted;
+        list.push_back({"geometry.offset_slot_and_neck", "offset", [] {
+            slotted = {{0, 0}, {1000, 0}, {1000, 1000}, {600, 1000}, {600, 200}, {400, 200}, {400, 1000}, {0, 1000}};
+            const IntPath c_shape = {{0, 0}, {1000, 0}, {1000, 300}, {400, 300}, {400, 700}, {1000, 700}, {1000, 1000},
+                                     {0, 1000}};
+            const IntPath dumbbell = {{0, 0}, {400, 0}, {400, 450}, {600, 450}, {600, 0}, {1000, 0}, {1000, 1000},
+                                      {600, 1000}, {600, 550}, {400, 550}, {400, 1000}, {0, 1000}};
+            const IntPath square = {{0, 0}, {100, 0}, {100, 100}, {0, 100}};
+            struct Case {
+                const char* shape;
+                const IntPath* path;
+                double delta;
+                size_t loops;
+            };
+            const Case cases[] = {
+                {"slot", &slotted, 50.0, 1}, {"slot", &slotted, 101.0, 1}, {"slot", &slotted, 150.0, 1},
+                {"slot", &slotted, 300.0, 1}, {"c_shape", &c_shape, 250.0, 1}, {"c_shape", &c_shape, 300.0, 1},
+                {"dumbbell", &dumbbell, -60.0, 2}, {"dumbbell", &dumbbell, -150.0, 2},
+                {"dumbbell", &dumbbell, -250.0, 0}, {"square", &square, -60.0, 0},
+            };
+            const JoinType joins[] = {JoinType::MITER, JoinType::ROUND, JoinType::SQUARE};
+            int checked = 0, failed = 0;
+            for (const Case& c : cases) {
+                for (JoinType join : joins) {
+                    OffsetSettings settings;
+                    settings.join = join;
+                    size_t loops = PolygonOffset::offset(*c.path, c.delta, settings).size();
+                    ++checked;
+                    if (loops == c.loops) continue;
+                    ++failed;
+                    std::printf("# geometry.offset_slot_and_neck: FAILED %s by %g (join %d): %zu loops, expected %zu\n",
+                                c.shape, c.delta, static_cast<int>(join), loops, c.loops);
+                }
+            }
+            check_failures += failed;
+            std::printf("# geometry.offset_slot_and_neck: %d of %d offset checks passed\n", checked - failed, checked);
+            return 1.0;
+        }, [] {
+            sink = sink + PolygonOffset::offset(slotted, 150.0).size();
+        }});
+
+        // Geometry: placement transform and bed clipping over segment arrays
+        static SegmentBatch segments;
+        list.push_back({"geometry.transform_segments", "segment", [] {
+            segments = SegmentBatch::from(make_grid_drawing(10000));
+            return static_cast<double>(segments.size());
+        }, [] {
+            BatchKernels::transform(Affine2::rotation_deg(1.0).then(Affine2::translation(0.5, -0.5)), segments);
+            sink = sink + BatchKernels::bounds(segments.x0.data(), segments.y0.data(), segments.size()).max_x;
+        }});
+
+        static SegmentBatch clipped;
+        list.push_back({"geometry.clip_segments_to_bed", "segment", [] {
+            segments = SegmentBatch::from(make_grid_drawing(10000));
+            clipped.reserve(segments.size());
+            return static_cast<double>(segments.size());
+        }, [] {
+            Bounds2 bed;
+            bed.expand(0.0, 0.0);
+            bed.expand(300.0, 200.0);
+            clipped.clear();
+            sink = sink + BatchKernels::clip(segments, bed, clipped);
+        }});
+
+        // Editing: one move step on a large drawing, undone and redone
+        static EditHistory history;
+        static std::vector<uint32_t> selection;
+        list.push_back({"edit.move_undo_redo_100_of_100k", "entity", [] {
+            history.reset(make_grid_drawing(100000));
+            selection.clear();
+            for (uint32_t i = 0; i < 100; ++i) selection.push_back(i * 997);
+            return static_cast<double>(selection.size());
+        }, [] {
+            history.move(selection, 1.0, 0.0);
+            history.undo();
+            history.redo();
+            sink = sink + history.entity_count();
+        }});
+
+        // Encoder: toolpath to Lhymicro-GL
+        static Toolpath toolpath;
+        list.push_back({"job.egv_encode", "move", [] {
+            Drawing drawing = make_grid_drawing(10000);
+            toolpath = ToolpathBuilder::build(drawing, PathOrdering::nearest_neighbour(drawing), {});
+            return static_cast<double>(toolpath.size());
+        }, [] {
+            EgvEncoder encoder(EgvEncoder::Options::unoptimized());
+            encoder.encode_toolpath(toolpath);
+            encoder.finish();
+            sink = sink + encoder.total_bytes();
+        }});
+
+        // Optimizer pass plus optimized encoding of the same toolpath; the
+        // stream sizes go to stdout as a comment line
+        list.push_back({"job.egv_encode_optimized", "move", [] {
+            Drawing drawing = make_grid_drawing(10000);
+            toolpath = ToolpathBuilder::build(drawing, PathOrdering::nearest_neighbour(drawing), {});
+            EgvEncoder plain(EgvEncoder::Options::unoptimized());
+            plain.encode_toolpath(toolpath);
+            plain.finish();
+            EgvEncoder optimized;
+            optimized.encode_toolpath(ToolpathOptimizer::optimize(toolpath));
+            optimized.finish();
+            std::printf("# job.egv_encode_optimized: %llu bytes unoptimized, %llu optimized\n",
+                        static_cast<unsigned long long>(plain.total_bytes()),
+                        static_cast<unsigned long long>(optimized.total_bytes()));
+            return static_cast<double>(toolpath.size());
+        }, [] {
+            EgvEncoder encoder;
+            encoder.encode_toolpath(ToolpathOptimizer::optimize(toolpath));
+            encoder.finish();
+            sink = sink + encoder.total_bytes();
+        }});
+
+        // Time estimate of the same toolpath. The setup checks that a layer
+        // speed change applied incrementally gives the full pass's total.
+        static TimeEstimator estimator;
+        list.push_back({"job.estimate_time", "move", [] {
+            Drawing drawing = make_grid_drawing(100000);
+            toolpath = ToolpathBuilder::build(drawing, PathOrdering::nearest_neighbour(drawing), {});
+            estimator.estimate(toolpath);
+            if (!toolpath.layers.empty()) {
+                double incremental = estimator.update_layer_speed(0, 55.0).total_s;
+                Toolpath changed = toolpath;
+                changed.layers[0].speed_mm_s = 55.0;
+                TimeEstimator fresh;
+                double full = fresh.estimate(changed).total_s;
+                bool match = std::fabs(incremental - full) <= 1e-9 * full;
+                if (!match) ++check_failures;
+                std::printf("# job.estimate_time: %s kernels, %s, incremental update %s (%.6f s vs %.6f s)\n",
+                            EstimateKernels::active_isa(), TimeEstimator::format_duration(full).c_str(),
+                            match ? "matches" : "FAILED", incremental, full);
+            }
+            return static_cast<double>(toolpath.size());
+        }, [] {
+            sink = sink + static_cast<uint64_t>(estimator.estimate(toolpath).total_s);
+        }});
+
+        // Comms: an encoded job streamed to the simulated board. The setup
+        // checks the board receives the stream byte for byte with its
+        // default buffer and with a small one that is full most of the time,
+        // and that a stream after a stall abort goes through.
+        static std::string stream;
+        static SimulatedK40* fast_board = nullptr;
+        static K40Comms* fast_comms = nullptr;
+        list.push_back({"comms.stream_to_simulator", "packet", [] {
+            Drawing drawing = make_grid_drawing(4);
+            EgvEncoder encoder;
+            encoder.encode_toolpath(ToolpathBuilder::build(drawing, PathOrdering::nearest_neighbour(drawing), {}));
+            encoder.finish();
+            stream = encoder.take();
+
+            SimulatedK40::Config small_buffer;
+            small_buffer.buffer_packets = 4;
+            if (!stream_arrives_intact("comms.stream_to_simulator", "default board", SimulatedK40::Config(), stream)) {
+                ++check_failures;
+            }
+            if (!stream_arrives_intact("comms.stream_to_simulator", "4 packet buffer", small_buffer, stream)) {
+                ++check_failures;
+            }
+            if (!recovers_after_stall("comms.stream_to_simulator", stream)) ++check_failures;
+
+            // The timed loop measures the host side against a board that
+            // never holds it up
+            if (!fast_comms) {
+                SimulatedK40::Config instant;
+                instant.write_latency_us = 0;
+                instant.read_latency_us = 0;
+                instant.packets_per_second = 1e9;
+                fast_board = new SimulatedK40(instant);
+                fast_comms = new K40Comms(fast_board);
+                fast_comms->start();
+            }
+            return static_cast<double>(K40Protocol::packetize(stream).size());
+        }, [] {
+            fast_comms->submit(stream);
+            fast_comms->wait_until_idle(60000);
+            sink = sink + fast_comms->get_stats().packets_sent;
+        }});
+
+        return list;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--filter" && i + 1 < argc) {
+            options.filter = argv[++i];
+        } else if (arg == "--min-time" && i + 1 < argc) {
+            options.min_time_s = std::max(0.01, std::atof(argv[++i]));
+        } else if (arg == "--list") {
+            options.list_only = true;
+        } else if (arg == "--memory") {
+            options.memory = true;
+        } else {
+            std::fprintf(stderr, "usage: %s [--filter <substring>] [--min-time <seconds>] [--list] [--memory]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    std::vector<Benchmark> benchmarks = make_benchmarks();
+    if (options.list_only) {
+        for (const auto& bench : benchmarks) std::printf("%s\n", bench.name);
+        return 0;
+    }
+
+    std::printf("# benchmark\titerations\tns_per_iter\tns_min\titems_per_iter\titems_per_s\tunit\n");
+    for (const auto& bench : benchmarks) {
+        if (!options.filter.empty() && std::strstr(bench.name, options.filter.c_str()) == nullptr) continue;
+        run_benchmark(bench, options);
+    }
+    if (options.memory) MemoryAccounting::log_summary(std::cerr);
+    if (check_failures > 0) {
+        std::fprintf(stderr, "%d check(s) failed\n", check_failures);
+        return 1;
+    }
+    return 0;
+}
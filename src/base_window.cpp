@@ -1,18 +1,13 @@
 #include "base_window.h"
+#include "shm_buffers.h"
+#include "viewport/span_kernels.h"
+#include "core/trace.h"
+#include "viewport/gl_state.h"
+#include <algorithm>
 #include <iostream>
 #include <cstring>
 
-// Wayland registry listeners
-static const struct wl_registry_listener registry_listener = {
-    BaseWindow::registry_global,
-    BaseWindow::registry_global_remove
-};
-
-// XDG Shell listeners  
-static const struct xdg_wm_base_listener xdg_wm_base_listener = {
-    BaseWindow::xdg_wm_base_ping
-};
-
+// XDG Shell listeners
 static const struct xdg_surface_listener xdg_surface_listener = {
     BaseWindow::xdg_surface_configure
 };
@@ -22,28 +17,28 @@ static const struct xdg_toplevel_listener xdg_toplevel_listener = {
     BaseWindow::xdg_toplevel_close
 };
 
-// Pointer listeners
-static const struct wl_pointer_listener pointer_listener = {
-    BaseWindow::pointer_enter,
-    BaseWindow::pointer_leave,
-    BaseWindow::pointer_motion,
-    BaseWindow::pointer_button,
-    BaseWindow::pointer_axis,
-    BaseWindow::pointer_frame
+// Presentation feedback listener
+static const struct wp_presentation_feedback_listener feedback_listener = {
+    BaseWindow::feedback_sync_output,
+    BaseWindow::feedback_presented,
+    BaseWindow::feedback_discarded
+};
+
+// Frame callback listener (software rendering)
+static const struct wl_callback_listener frame_listener = {
+    BaseWindow::frame_done
 };
 
 BaseWindow* BaseWindow::current_instance = nullptr;
 
-BaseWindow::BaseWindow(int w, int h, const std::string& t) 
-    : display(nullptr), registry(nullptr), compositor(nullptr), surface(nullptr),
-      egl_window(nullptr), xdg_wm_base(nullptr), xdg_surface(nullptr), 
-      xdg_toplevel(nullptr), decoration_manager(nullptr), toplevel_decoration(nullptr),
-      seat(nullptr), pointer(nullptr), keyboard(nullptr),
-      shm(nullptr), cursor_theme(nullptr), current_cursor(nullptr), cursor_surface(nullptr),
-      egl_display(EGL_NO_DISPLAY), egl_context(EGL_NO_CONTEXT), 
-      egl_surface(EGL_NO_SURFACE), width(w), height(h), title(t),
-      configured(false), running(true), main_callback(nullptr), last_button_serial(0) {
-    
+BaseWindow::BaseWindow(int w, int h, const std::string& t, DisplayConnection* display_connection)
+    : connection(display_connection ? display_connection : &DisplayConnection::shared()),
+      surface(nullptr), egl_window(nullptr), xdg_surface(nullptr), xdg_toplevel(nullptr),
+      toplevel_decoration(nullptr), egl_surface(EGL_NO_SURFACE),
+      soft_queue(nullptr), shm_buffers(nullptr), soft_canvas(nullptr), frame_callback(nullptr), width(w), height(h), title(t),
+      configured(false), running(true), main_callback(nullptr), last_button_serial(0),
+      frame_start_ns(0), swap_interval(1), defer_submit(false), submit_margin_ns(2000000) {
+
     window_data.screen_width = static_cast<float>(width);
     window_data.screen_height = static_cast<float>(height);
     current_instance = this;
@@ -51,340 +46,342 @@ BaseWindow::BaseWindow(int w, int h, const std::string& t)
 
 BaseWindow::~BaseWindow() {
     cleanup();
+    if (current_instance == this) {
+        current_instance = nullptr;
+    }
 }
 
 bool BaseWindow::initialize() {
-    if (!init_wayland()) {
+    if (!connection->connect()) {
+        return false;
+    }
+
+    if (!init_surface()) {
         return false;
     }
-    
-    if (!init_egl()) {
+
+    if (connection->is_software() ? !init_soft_surface() : !init_egl_surface()) {
         return false;
     }
-    
+    connection->add_window(this);
+
     // Wait for initial configuration
     while (!configured && running) {
-        process_events();
-    }
-    
-    // Initialize OpenGL state
-    glViewport(0, 0, width, height);
-    glClearColor(0.2f, 0.2f, 0.2f, 1.0f);
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    
-    // Initialize cursor theme if shm is available
-    if (shm) {
-        cursor_theme = wl_cursor_theme_load(nullptr, 24, shm);
-        if (cursor_theme) {
-            cursor_surface = wl_compositor_create_surface(compositor);
-            std::cout << "Cursor theme initialized" << std::endl;
-        }
+        wl_display_dispatch(connection->get_display());
     }
-    
+
+    if (connection->is_software()) {
+        std::cout << "Base window initialized: " << width << "x" << height << " (software, "
+                  << SpanKernels::active_isa() << ")" << std::endl;
+        return true;
+    }
+
+    // Initialize OpenGL state (context-wide, so shared by every window; a
+    // second window's calls are dropped as redundant)
+    GlState::viewport(0, 0, width, height);
+    GlState::clear_color(0.2f, 0.2f, 0.2f, 1.0f);
+    GlState::enable(GL_BLEND, true);
+    GlState::blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
     std::cout << "Base window initialized: " << width << "x" << height << std::endl;
-    std::cout << "OpenGL ES " << glGetString(GL_VERSION) << std::endl;
-    std::cout << "Renderer: " << glGetString(GL_RENDERER) << std::endl;
-    
     return true;
 }
 
 void BaseWindow::run() {
     std::cout << "Starting basic main loop..." << std::endl;
-    
-    while (running) {
-        process_events();
-        
-        // Update window dimensions if changed
-        window_data.screen_width = static_cast<float>(width);
-        window_data.screen_height = static_cast<float>(height);
-        
-        // Clear screen
-        glClear(GL_COLOR_BUFFER_BIT);
-        
-        // Swap buffers
-        swap_buffers();
-    }
-    
+    main_callback = nullptr;
+    connection->run();
     std::cout << "Main loop ended" << std::endl;
 }
 
 void BaseWindow::run_with_callback(MainLoopFunction callback) {
     std::cout << "Starting main loop with callback..." << std::endl;
     main_callback = callback;
-    
-    window_data.should_exit = false;
-    
-    while (running) {
-        process_events();
-        
-        // Update window dimensions 
-        int old_width = static_cast<int>(window_data.screen_width);
-        int old_height = static_cast<int>(window_data.screen_height);
-        
-        window_data.screen_width = static_cast<float>(width);
-        window_data.screen_height = static_cast<float>(height);
-        
-        if (width != old_width || height != old_height) {
-            window_data.window_resized = true;
-            glViewport(0, 0, width, height);
-        } else {
-            window_data.window_resized = false;
-        }
-        
-        // Reset mouse events (will be updated by Wayland handlers)
-        window_data.mouse_pressed = false;
-        window_data.mouse_released = false;
-        
-        // Clear screen
-        glClear(GL_COLOR_BUFFER_BIT);
-        
-        // Call main loop function
-        if (main_callback) {
-            int result = main_callback(window_data);
-            if (result != 0) {
-                std::cout << "Main callback returned error, closing window" << std::endl;
-                running = false;
-                break;
-            }
-        }
-        
-        // Swap buffers
-        swap_buffers();
-    }
-    
+    connection->run();
     std::cout << "Callback loop ended" << std::endl;
 }
 
-bool BaseWindow::init_wayland() {
-    display = wl_display_connect(nullptr);
-    if (!display) {
-        std::cerr << "Failed to connect to Wayland display" << std::endl;
-        return false;
+bool BaseWindow::render_frame(uint64_t start_ns) {
+    if (!running) return false;
+    const bool software = soft_canvas != nullptr;
+
+    // All windows share one context; point it at this surface
+    if (!software) {
+        eglMakeCurrent(connection->get_egl_display(), egl_surface, egl_surface, connection->get_egl_context());
     }
-    
-    registry = wl_display_get_registry(display);
-    wl_registry_add_listener(registry, &registry_listener, this);
-    
-    wl_display_dispatch(display);
-    wl_display_roundtrip(display);
-    
-    if (!compositor) {
-        std::cerr << "Wayland compositor not available" << std::endl;
-        return false;
+    current_instance = this;
+    frame_start_ns = start_ns;
+
+    // Update window dimensions
+    int old_width = static_cast<int>(window_data.screen_width);
+    int old_height = static_cast<int>(window_data.screen_height);
+
+    window_data.screen_width = static_cast<float>(width);
+    window_data.screen_height = static_cast<float>(height);
+    window_data.window_resized = width != old_width || height != old_height;
+
+    // Reset mouse events (will be updated by Wayland handlers)
+    window_data.mouse_pressed = false;
+    window_data.mouse_released = false;
+
+    if (software) {
+        soft_canvas->begin_frame(width, height, SoftCanvas::pixel(0.2f, 0.2f, 0.2f, 1.0f));
+        SoftCanvas::set_current(soft_canvas);
+    } else {
+        // The viewport is context state, so the previous window's is still set
+        GlState::viewport(0, 0, width, height);
+
+        // Clear screen, in the window's clear colour (boxes change it)
+        GlState::clear_color(0.2f, 0.2f, 0.2f, 1.0f);
+        GlState::clear(GL_COLOR_BUFFER_BIT);
     }
-    
-    surface = wl_compositor_create_surface(compositor);
+
+    // Call main loop function
+    if (main_callback) {
+        int result;
+        {
+            TRACE_SPAN("main_loop");
+            result = main_callback(window_data);
+        }
+        // Scrolling accumulates between frames; this frame has used it
+        window_data.scroll_y = 0.0f;
+        if (result != 0) {
+            std::cout << "Main callback returned error, closing window" << std::endl;
+            SoftCanvas::set_current(nullptr);
+            running = false;
+            return false;
+        }
+    }
+
+    // Swap buffers
+    swap_buffers();
+    if (software) {
+        SoftCanvas::set_current(nullptr);
+        return true;
+    }
+
+    GlFrameStats gl = GlState::end_frame();
+    Trace::counter("gl.calls", gl.calls);
+    Trace::counter("gl.skipped", gl.skipped);
+    Trace::counter("gl.draws", gl.draws);
+    return true;
+}
+
+bool BaseWindow::init_surface() {
+    surface = wl_compositor_create_surface(connection->get_compositor());
     if (!surface) {
         std::cerr << "Failed to create Wayland surface" << std::endl;
         return false;
     }
-    
-    if (!xdg_wm_base) {
+
+    if (!connection->get_xdg_wm_base()) {
         std::cerr << "XDG WM Base not available" << std::endl;
         return false;
     }
-    
-    xdg_surface = xdg_wm_base_get_xdg_surface(xdg_wm_base, surface);
+
+    xdg_surface = xdg_wm_base_get_xdg_surface(connection->get_xdg_wm_base(), surface);
     xdg_surface_add_listener(xdg_surface, &xdg_surface_listener, this);
-    
+
     xdg_toplevel = xdg_surface_get_toplevel(xdg_surface);
     xdg_toplevel_add_listener(xdg_toplevel, &xdg_toplevel_listener, this);
-    
+
     xdg_toplevel_set_title(xdg_toplevel, title.c_str());
-    
+
     // Request server-side decorations if available
-    if (decoration_manager) {
+    if (connection->get_decoration_manager()) {
         std::cout << "Requesting server-side decorations..." << std::endl;
         toplevel_decoration = zxdg_decoration_manager_v1_get_toplevel_decoration(
-            decoration_manager, xdg_toplevel);
-        zxdg_toplevel_decoration_v1_set_mode(toplevel_decoration, 
+            connection->get_decoration_manager(), xdg_toplevel);
+        zxdg_toplevel_decoration_v1_set_mode(toplevel_decoration,
             ZXDG_TOPLEVEL_DECORATION_V1_MODE_SERVER_SIDE);
     } else {
         std::cout << "No decoration manager available - window will have no title bar" << std::endl;
     }
-    
+
     wl_surface_commit(surface);
-    
+
     return true;
 }
 
-bool BaseWindow::init_egl() {
-    egl_display = eglGetDisplay((EGLNativeDisplayType)display);
-    if (egl_display == EGL_NO_DISPLAY) {
-        std::cerr << "Failed to get EGL display" << std::endl;
-        return false;
-    }
-    
-    if (!eglInitialize(egl_display, nullptr, nullptr)) {
-        std::cerr << "Failed to initialize EGL" << std::endl;
-        return false;
-    }
-    
-    EGLint config_attribs[] = {
-        EGL_SURFACE_TYPE, EGL_WINDOW_BIT,
-        EGL_RED_SIZE, 8,
-        EGL_GREEN_SIZE, 8,
-        EGL_BLUE_SIZE, 8,
-        EGL_ALPHA_SIZE, 8,
-        EGL_RENDERABLE_TYPE, EGL_OPENGL_ES2_BIT,
-        EGL_NONE
-    };
-    
-    EGLint num_configs;
-    if (!eglChooseConfig(egl_display, config_attribs, &egl_config, 1, &num_configs)) {
-        std::cerr << "Failed to choose EGL config" << std::endl;
-        return false;
-    }
-    
-    EGLint context_attribs[] = {
-        EGL_CONTEXT_CLIENT_VERSION, 2,
-        EGL_NONE
-    };
-    
-    egl_context = eglCreateContext(egl_display, egl_config, EGL_NO_CONTEXT, context_attribs);
-    if (egl_context == EGL_NO_CONTEXT) {
-        std::cerr << "Failed to create EGL context" << std::endl;
-        return false;
-    }
-    
+bool BaseWindow::init_egl_surface() {
     egl_window = wl_egl_window_create(surface, width, height);
     if (!egl_window) {
         std::cerr << "Failed to create EGL window" << std::endl;
         return false;
     }
-    
-    egl_surface = eglCreateWindowSurface(egl_display, egl_config, egl_window, nullptr);
+
+    EGLDisplay egl_display = connection->get_egl_display();
+    egl_surface = eglCreateWindowSurface(egl_display, connection->get_egl_config(), egl_window, nullptr);
     if (egl_surface == EGL_NO_SURFACE) {
         std::cerr << "Failed to create EGL surface" << std::endl;
         return false;
     }
-    
-    if (!eglMakeCurrent(egl_display, egl_surface, egl_surface, egl_context)) {
+
+    if (!eglMakeCurrent(egl_display, egl_surface, egl_surface, connection->get_egl_context())) {
         std::cerr << "Failed to make EGL context current" << std::endl;
         return false;
     }
-    
+
+    // The swap interval belongs to the surface current when it is set
+    if (!eglSwapInterval(egl_display, swap_interval)) {
+        std::cerr << "eglSwapInterval(" << swap_interval << ") not supported" << std::endl;
+    }
+
     return true;
 }
 
-void BaseWindow::process_events() {
-    wl_display_dispatch_pending(display);
-    wl_display_flush(display);
+bool BaseWindow::init_soft_surface() {
+    soft_queue = wl_display_create_queue(connection->get_display());
+    if (!soft_queue) {
+        std::cerr << "Failed to create Wayland event queue" << std::endl;
+        return false;
+    }
+    shm_buffers = new ShmBuffers(connection->get_shm(), connection->get_display(), soft_queue);
+    soft_canvas = new SoftCanvas();
+    return true;
 }
 
 void BaseWindow::swap_buffers() {
-    eglSwapBuffers(egl_display, egl_surface);
+    if (soft_canvas) {
+        swap_soft_buffers();
+        return;
+    }
+    TRACE_SPAN("frame.swap");
+
+    // Feedback must be requested before the commit inside eglSwapBuffers
+    struct wp_presentation* presentation = connection->get_presentation();
+    if (presentation) request_feedback(presentation);
+    eglSwapBuffers(connection->get_egl_display(), egl_surface);
 }
 
-void BaseWindow::cleanup() {
+// Without EGL there is nothing to pace frames, so the swap interval is
+// honoured by hand: wait for the previous frame's callback first, as
+// eglSwapBuffers would
+void BaseWindow::swap_soft_buffers() {
+    TRACE_SPAN("frame.swap");
+    struct wl_display* display = connection->get_display();
+    while (swap_interval > 0 && frame_callback && running) {
+        if (wl_display_dispatch_queue(display, soft_queue) < 0) break;
+    }
+
+    ShmBuffers::Buffer* buffer = shm_buffers->acquire(width, height);
+    if (!buffer) return;
+    {
+        TRACE_SPAN("soft.render");
+        soft_canvas->render(buffer->target, soft_repainted, soft_damage);
+    }
+    Trace::counter("soft.commands", static_cast<uint64_t>(soft_canvas->command_count()));
+    Trace::counter("soft.repainted_rects", static_cast<uint64_t>(soft_repainted.size()));
+    Trace::counter("soft.damage_rects", static_cast<uint64_t>(soft_damage.size()));
+    // Nothing changed on screen: no commit, so the compositor has no work
+    if (soft_damage.empty()) return;
+
+    struct wp_presentation* presentation = connection->get_presentation();
+    if (presentation) request_feedback(presentation);
+    wl_surface_attach(surface, buffer->buffer, 0, 0);
+    for (const DamageRect& rect : soft_damage) {
+        wl_surface_damage_buffer(surface, rect.x, rect.y, rect.width, rect.height);
+    }
+    if (frame_callback) wl_callback_destroy(frame_callback);
+    frame_callback = wl_surface_frame(surface);
+    wl_proxy_set_queue(reinterpret_cast<struct wl_proxy*>(frame_callback), soft_queue);
+    wl_callback_add_listener(frame_callback, &frame_listener, this);
+    wl_surface_commit(surface);
+    buffer->busy = true;
+    wl_display_flush(display);
+}
+
+void BaseWindow::note_input_time(uint32_t time_ms) {
+    uint64_t now = connection->presentation_now();
+    uint64_t input_ns = now;
+
+    // Event times are milliseconds on CLOCK_MONOTONIC, truncated to 32 bits.
+    // Using them counts compositor-side delay too; fall back to receipt time
+    // when the presentation clock is something else or the time looks off.
+    if (connection->get_presentation_clock() == CLOCK_MONOTONIC) {
+        uint32_t age_ms = static_cast<uint32_t>(now / 1000000ull) - time_ms;
+        if (age_ms < 1000) input_ns = now - static_cast<uint64_t>(age_ms) * 1000000ull;
+    }
+    frame_timing.note_input(input_ns);
+}
+
+void BaseWindow::set_swap_interval(int interval) {
+    swap_interval = interval < 0 ? 0 : interval;
     if (egl_surface != EGL_NO_SURFACE) {
-        eglDestroySurface(egl_display, egl_surface);
+        EGLDisplay egl_display = connection->get_egl_display();
+        eglMakeCurrent(egl_display, egl_surface, egl_surface, connection->get_egl_context());
+        eglSwapInterval(egl_display, swap_interval);
     }
-    
-    if (egl_context != EGL_NO_CONTEXT) {
-        eglDestroyContext(egl_display, egl_context);
+}
+
+void BaseWindow::set_submit_deferral(bool enabled, int margin_us) {
+    defer_submit = enabled;
+    submit_margin_ns = static_cast<uint64_t>(margin_us > 0 ? margin_us : 0) * 1000ull;
+}
+
+void BaseWindow::request_feedback(struct wp_presentation* presentation) {
+    uint32_t frame = frame_timing.submit(frame_start_ns, connection->presentation_now());
+    PendingFeedback* pending = new PendingFeedback{this, wp_presentation_feedback(presentation, surface), frame};
+    wp_presentation_feedback_add_listener(pending->feedback, &feedback_listener, pending);
+    pending_feedbacks.push_back(pending);
+}
+
+void BaseWindow::finish_feedback(PendingFeedback* pending) {
+    auto& list = pending->window->pending_feedbacks;
+    list.erase(std::remove(list.begin(), list.end(), pending), list.end());
+    wp_presentation_feedback_destroy(pending->feedback);
+    delete pending;
+}
+
+void BaseWindow::cleanup() {
+    connection->remove_window(this);
+    for (PendingFeedback* pending : pending_feedbacks) {
+        wp_presentation_feedback_destroy(pending->feedback);
+        delete pending;
     }
-    
-    if (egl_display != EGL_NO_DISPLAY) {
-        eglTerminate(egl_display);
+    pending_feedbacks.clear();
+    if (connection->get_presentation() && frame_timing.summary().presented > 0) {
+        std::cout << title << ": ";
+        frame_timing.log_summary(std::cout);
     }
-    
+
+    if (egl_surface != EGL_NO_SURFACE) {
+        EGLDisplay egl_display = connection->get_egl_display();
+        eglMakeCurrent(egl_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        eglDestroySurface(egl_display, egl_surface);
+    }
+
     if (egl_window) {
         wl_egl_window_destroy(egl_window);
     }
-    
-    if (cursor_surface) {
-        wl_surface_destroy(cursor_surface);
-    }
-    
-    if (cursor_theme) {
-        wl_cursor_theme_destroy(cursor_theme);
+
+    if (frame_callback) {
+        wl_callback_destroy(frame_callback);
     }
-    
-    if (shm) {
-        wl_shm_destroy(shm);
+    delete shm_buffers;
+    delete soft_canvas;
+    if (soft_queue) {
+        wl_event_queue_destroy(soft_queue);
     }
-    
+
     if (toplevel_decoration) {
         zxdg_toplevel_decoration_v1_destroy(toplevel_decoration);
     }
-    
-    if (decoration_manager) {
-        zxdg_decoration_manager_v1_destroy(decoration_manager);
-    }
-    
-    if (pointer) {
-        wl_pointer_destroy(pointer);
-    }
-    
-    if (seat) {
-        wl_seat_destroy(seat);
-    }
-    
+
     if (xdg_toplevel) {
         xdg_toplevel_destroy(xdg_toplevel);
     }
-    
+
     if (xdg_surface) {
         xdg_surface_destroy(xdg_surface);
     }
-    
-    if (xdg_wm_base) {
-        xdg_wm_base_destroy(xdg_wm_base);
-    }
-    
+
     if (surface) {
         wl_surface_destroy(surface);
     }
-    
-    if (compositor) {
-        wl_compositor_destroy(compositor);
-    }
-    
-    if (registry) {
-        wl_registry_destroy(registry);
-    }
-    
-    if (display) {
-        wl_display_disconnect(display);
-    }
 }
 
 // Wayland callbacks
-void BaseWindow::registry_global(void* data, struct wl_registry* registry,
-                                uint32_t name, const char* interface, uint32_t version) {
-    BaseWindow* window = static_cast<BaseWindow*>(data);
-    
-    if (strcmp(interface, wl_compositor_interface.name) == 0) {
-        window->compositor = static_cast<struct wl_compositor*>(
-            wl_registry_bind(registry, name, &wl_compositor_interface, 4));
-    } else if (strcmp(interface, xdg_wm_base_interface.name) == 0) {
-        window->xdg_wm_base = static_cast<struct xdg_wm_base*>(
-            wl_registry_bind(registry, name, &xdg_wm_base_interface, 1));
-        xdg_wm_base_add_listener(window->xdg_wm_base, &xdg_wm_base_listener, window);
-    } else if (strcmp(interface, zxdg_decoration_manager_v1_interface.name) == 0) {
-        window->decoration_manager = static_cast<struct zxdg_decoration_manager_v1*>(
-            wl_registry_bind(registry, name, &zxdg_decoration_manager_v1_interface, 1));
-    } else if (strcmp(interface, wl_shm_interface.name) == 0) {
-        window->shm = static_cast<struct wl_shm*>(
-            wl_registry_bind(registry, name, &wl_shm_interface, 1));
-    } else if (strcmp(interface, wl_seat_interface.name) == 0) {
-        window->seat = static_cast<struct wl_seat*>(
-            wl_registry_bind(registry, name, &wl_seat_interface, 7));
-        
-        // Get pointer for mouse input
-        window->pointer = wl_seat_get_pointer(window->seat);
-        if (window->pointer) {
-            wl_pointer_add_listener(window->pointer, &pointer_listener, window);
-        }
-    }
-}
-
-void BaseWindow::registry_global_remove(void* data, struct wl_registry* registry, uint32_t name) {
-    // Handle global removal
-}
-
 void BaseWindow::xdg_surface_configure(void* data, struct xdg_surface* surface, uint32_t serial) {
     BaseWindow* window = static_cast<BaseWindow*>(data);
     xdg_surface_ack_configure(surface, serial);
@@ -394,11 +391,11 @@ void BaseWindow::xdg_surface_configure(void* data, struct xdg_surface* surface,
 void BaseWindow::xdg_toplevel_configure(void* data, struct xdg_toplevel* toplevel,
                                        int32_t width, int32_t height, struct wl_array* states) {
     BaseWindow* window = static_cast<BaseWindow*>(data);
-    
+
     if (width > 0 && height > 0) {
         window->width = width;
         window->height = height;
-        
+
         if (window->egl_window) {
             wl_egl_window_resize(window->egl_window, width, height, 0, 0);
         }
@@ -410,85 +407,51 @@ void BaseWindow::xdg_toplevel_close(void* data, struct xdg_toplevel* toplevel) {
     window->running = false;
 }
 
-void BaseWindow::xdg_wm_base_ping(void* data, struct xdg_wm_base* shell, uint32_t serial) {
-    xdg_wm_base_pong(shell, serial);
-}
-
-// Pointer event handlers - update WindowData directly
-void BaseWindow::pointer_enter(void* data, struct wl_pointer* pointer, uint32_t serial,
-                              struct wl_surface* surface, wl_fixed_t sx, wl_fixed_t sy) {
-    BaseWindow* window = static_cast<BaseWindow*>(data);
-    window->window_data.mouse_x = wl_fixed_to_double(sx);
-    window->window_data.mouse_y = wl_fixed_to_double(sy);
+void BaseWindow::feedback_sync_output(void* data, struct wp_presentation_feedback* feedback,
+                                      struct wl_output* output) {
 }
 
-void BaseWindow::pointer_leave(void* data, struct wl_pointer* pointer, uint32_t serial,
-                              struct wl_surface* surface) {
-    BaseWindow* window = static_cast<BaseWindow*>(data);
-    window->window_data.mouse_held = false;
-}
+void BaseWindow::feedback_presented(void* data, struct wp_presentation_feedback* feedback,
+                                    uint32_t tv_sec_hi, uint32_t tv_sec_lo, uint32_t tv_nsec,
+                                    uint32_t refresh, uint32_t seq_hi, uint32_t seq_lo, uint32_t flags) {
+    PendingFeedback* pending = static_cast<PendingFeedback*>(data);
+    BaseWindow* window = pending->window;
 
-void BaseWindow::pointer_motion(void* data, struct wl_pointer* pointer, uint32_t time,
-                               wl_fixed_t sx, wl_fixed_t sy) {
-    BaseWindow* window = static_cast<BaseWindow*>(data);
-    window->window_data.mouse_x = wl_fixed_to_double(sx);
-    window->window_data.mouse_y = wl_fixed_to_double(sy);
-}
+    uint64_t seconds = (static_cast<uint64_t>(tv_sec_hi) << 32) | tv_sec_lo;
+    uint64_t present_ns = seconds * 1000000000ull + tv_nsec;
+    uint64_t latency = window->frame_timing.presented(pending->frame, present_ns, refresh);
 
-void BaseWindow::pointer_button(void* data, struct wl_pointer* pointer, uint32_t serial,
-                               uint32_t time, uint32_t button, uint32_t state) {
-    BaseWindow* window = static_cast<BaseWindow*>(data);
-    
-    // Store the serial for interactive operations
-    window->last_button_serial = serial;
-    
-    if (state == 1) { // Button pressed
-        window->window_data.mouse_pressed = true;
-        window->window_data.mouse_held = true;
-        window->window_data.mouse_released = false;
-    } else { // Button released
-        window->window_data.mouse_pressed = false;
-        window->window_data.mouse_held = false;
-        window->window_data.mouse_released = true;
+    if (latency > 0 && Trace::enabled()) {
+        // Map the presentation clock onto the trace clock
+        uint64_t age = window->connection->presentation_now() - present_ns;
+        uint64_t end = Trace::now_ns() - age;
+        if (end > latency) Trace::record("latency.input_to_photon", end - latency, end);
     }
+    if (window->frame_timing.unreported_samples() >= LATENCY_REPORT_FRAMES) {
+        window->frame_timing.log_summary(std::cout);
+    }
+    finish_feedback(pending);
 }
 
-void BaseWindow::pointer_axis(void* data, struct wl_pointer* pointer, uint32_t time,
-                             uint32_t axis, wl_fixed_t value) {
-    // Handle scroll events
-}
-
-void BaseWindow::pointer_frame(void* data, struct wl_pointer* pointer) {
-    // Handle pointer frame events (batching)
+void BaseWindow::feedback_discarded(void* data, struct wp_presentation_feedback* feedback) {
+    PendingFeedback* pending = static_cast<PendingFeedback*>(data);
+    pending->window->frame_timing.discarded(pending->frame);
+    finish_feedback(pending);
 }
 
-void BaseWindow::set_cursor(const std::string& cursor_name) {
-    if (!cursor_theme || !cursor_surface || !pointer) {
-        return;
-    }
-    
-    struct wl_cursor* cursor = wl_cursor_theme_get_cursor(cursor_theme, cursor_name.c_str());
-    if (!cursor) {
-        cursor = wl_cursor_theme_get_cursor(cursor_theme, "default");
-    }
-    
-    if (cursor && cursor->image_count > 0) {
-        struct wl_cursor_image* image = cursor->images[0];
-        wl_surface_attach(cursor_surface, wl_cursor_image_get_buffer(image), 0, 0);
-        wl_surface_damage(cursor_surface, 0, 0, image->width, image->height);
-        wl_surface_commit(cursor_surface);
-        wl_pointer_set_cursor(pointer, 0, cursor_surface, image->hotspot_x, image->hotspot_y);
-        current_cursor = cursor;
-    }
+void BaseWindow::frame_done(void* data, struct wl_callback* callback, uint32_t time) {
+    BaseWindow* window = static_cast<BaseWindow*>(data);
+    wl_callback_destroy(callback);
+    if (window->frame_callback == callback) window->frame_callback = nullptr;
 }
 
 void BaseWindow::start_interactive_resize(const std::string& direction) {
-    if (!xdg_toplevel || !seat) {
+    if (!xdg_toplevel || !connection->get_seat()) {
         return;
     }
-    
+
     uint32_t edges = 0;
-    
+
     if (direction == "nw") {
         edges = XDG_TOPLEVEL_RESIZE_EDGE_TOP | XDG_TOPLEVEL_RESIZE_EDGE_LEFT;
     } else if (direction == "n") {
@@ -506,9 +469,9 @@ void BaseWindow::start_interactive_resize(const std::string& direction) {
     } else if (direction == "w") {
         edges = XDG_TOPLEVEL_RESIZE_EDGE_LEFT;
     }
-    
+
     if (edges != 0) {
-        xdg_toplevel_resize(xdg_toplevel, seat, last_button_serial, edges);
+        xdg_toplevel_resize(xdg_toplevel, connection->get_seat(), last_button_serial, edges);
         std::cout << "Starting interactive resize: " << direction << " with serial: " << last_button_serial << std::endl;
     }
-}
\ No newline at end of file
+}
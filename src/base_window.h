@@ -1,111 +1,143 @@
 #pragma once
 
 #include "window_data.h"
-#include <wayland-client.h>
-#include <wayland-egl.h>
-#include <wayland-cursor.h>
-#include <EGL/egl.h>
-#include <GLES2/gl2.h>
-#include "xdg-shell-client-protocol.h"
-#include "xdg-decoration-unstable-v1-client-protocol.h"
+#include "display_connection.h"
+#include "core/frame_scheduler.h"
+#include "core/frame_timing.h"
+#include "viewport/soft_canvas.h"
 #include <string>
+#include <vector>
 
+class ShmBuffers;
+
+// One toplevel surface with its EGL window surface and main loop callback.
+// The Wayland connection, EGL context and GPU caches belong to the
+// DisplayConnection, so any number of windows can share them. When the
+// connection renders in software the window instead draws its frames into a
+// SoftCanvas and presents them through a pair of wl_shm buffers.
 class BaseWindow {
 private:
-    // Wayland core objects
-    struct wl_display* display;
-    struct wl_registry* registry;
-    struct wl_compositor* compositor;
+    DisplayConnection* connection;
+
+    // Per-window Wayland objects
     struct wl_surface* surface;
     struct wl_egl_window* egl_window;
-    
-    // XDG Shell (window management)
-    struct xdg_wm_base* xdg_wm_base;
     struct xdg_surface* xdg_surface;
     struct xdg_toplevel* xdg_toplevel;
-    
-    // Server-side decorations
-    struct zxdg_decoration_manager_v1* decoration_manager;
     struct zxdg_toplevel_decoration_v1* toplevel_decoration;
-    
-    // Input devices
-    struct wl_seat* seat;
-    struct wl_pointer* pointer;
-    struct wl_keyboard* keyboard;
-    
-    // Cursor support
-    struct wl_shm* shm;
-    struct wl_cursor_theme* cursor_theme;
-    struct wl_cursor* current_cursor;
-    struct wl_surface* cursor_surface;
-    
-    // EGL context
-    EGLDisplay egl_display;
-    EGLConfig egl_config;
-    EGLContext egl_context;
     EGLSurface egl_surface;
-    
+
+    // Software rendering; buffer releases and frame callbacks arrive on the
+    // window's own queue, so waiting for them dispatches nothing else
+    struct wl_event_queue* soft_queue;
+    ShmBuffers* shm_buffers;
+    SoftCanvas* soft_canvas;
+    struct wl_callback* frame_callback;
+    std::vector<DamageRect> soft_repainted, soft_damage;
+
     // Window state
     int width, height;
     std::string title;
     bool configured;
     bool running;
-    
+
     WindowData window_data;
     MainLoopFunction main_callback;
-    
-    // Static pointer for Wayland callbacks to access window data
+
+    // Window whose callback is running (or the last one created)
     static BaseWindow* current_instance;
-    
+
     // For interactive resize
     uint32_t last_button_serial;
-    
-    // Wayland initialization
-    bool init_wayland();
-    bool init_egl();
+
+    // Presentation timing of this surface's frames
+    FrameTiming frame_timing;
+    uint64_t frame_start_ns;
+
+    // One per committed frame until its feedback arrives; cleanup() destroys
+    // the rest so no late event reaches a deleted window
+    struct PendingFeedback {
+        BaseWindow* window;
+        struct wp_presentation_feedback* feedback;
+        uint32_t frame;
+    };
+    std::vector<PendingFeedback*> pending_feedbacks;
+
+    // 1 = eglSwapBuffers waits for vblank; 0 lets deferred submission
+    // place the commit itself
+    int swap_interval;
+    bool defer_submit;
+    uint64_t submit_margin_ns;
+
+    // Report latency every this many input-carrying frames
+    static constexpr size_t LATENCY_REPORT_FRAMES = 120;
+
+    bool init_surface();
+    bool init_egl_surface();
+    bool init_soft_surface();
+    void swap_soft_buffers();
+    void request_feedback(struct wp_presentation* presentation);
+    static void finish_feedback(PendingFeedback* pending);
     void cleanup();
-    
-    
+
+    friend class DisplayConnection;
+    void note_input_time(uint32_t time_ms);
+
 public:
-    BaseWindow(int w, int h, const std::string& title);
+    // Without a connection the window uses DisplayConnection::shared()
+    BaseWindow(int w, int h, const std::string& title, DisplayConnection* display_connection = nullptr);
     ~BaseWindow();
-    
+
+    BaseWindow(const BaseWindow&) = delete;
+    BaseWindow& operator=(const BaseWindow&) = delete;
+
     bool initialize();
     void run();
     void run_with_callback(MainLoopFunction callback);
-    
+
+    // For several windows: set each callback, then DisplayConnection::run()
+    void set_main_callback(MainLoopFunction callback) { main_callback = callback; }
+    // Draws one frame into this window; false once the window has closed
+    bool render_frame(uint64_t start_ns);
+    void close() { running = false; }
+
     // Window properties
     int get_width() const { return width; }
     int get_height() const { return height; }
     bool should_close() const { return !running; }
-    
+    DisplayConnection& get_connection() { return *connection; }
+    FrameScheduler& get_frame_scheduler() { return connection->get_frame_scheduler(); }
+    FrameTiming& get_frame_timing() { return frame_timing; }
+    struct wl_surface* get_surface() const { return surface; }
+    bool is_deferring_submit() const { return defer_submit; }
+    uint64_t get_submit_margin_ns() const { return submit_margin_ns; }
+
+    // eglSwapInterval for this window's surface; may be called before or
+    // after initialize()
+    void set_swap_interval(int interval);
+    // Start each frame late enough that it is submitted margin_us before the
+    // predicted vblank, so it samples the newest input. Needs wp_presentation.
+    void set_submit_deferral(bool enabled, int margin_us = 2000);
+
     // Wayland callbacks (must be public for C callback access)
-    static void registry_global(void* data, struct wl_registry* registry,
-                               uint32_t name, const char* interface, uint32_t version);
-    static void registry_global_remove(void* data, struct wl_registry* registry, uint32_t name);
-    
     static void xdg_surface_configure(void* data, struct xdg_surface* surface, uint32_t serial);
     static void xdg_toplevel_configure(void* data, struct xdg_toplevel* toplevel,
                                       int32_t width, int32_t height, struct wl_array* states);
     static void xdg_toplevel_close(void* data, struct xdg_toplevel* toplevel);
-    static void xdg_wm_base_ping(void* data, struct xdg_wm_base* shell, uint32_t serial);
-    
-    static void pointer_enter(void* data, struct wl_pointer* pointer, uint32_t serial,
-                             struct wl_surface* surface, wl_fixed_t sx, wl_fixed_t sy);
-    static void pointer_leave(void* data, struct wl_pointer* pointer, uint32_t serial,
-                             struct wl_surface* surface);
-    static void pointer_motion(void* data, struct wl_pointer* pointer, uint32_t time,
-                              wl_fixed_t sx, wl_fixed_t sy);
-    static void pointer_button(void* data, struct wl_pointer* pointer, uint32_t serial,
-                              uint32_t time, uint32_t button, uint32_t state);
-    static void pointer_axis(void* data, struct wl_pointer* pointer, uint32_t time,
-                            uint32_t axis, wl_fixed_t value);
-    static void pointer_frame(void* data, struct wl_pointer* pointer);
-    
-    void process_events();
+
+    static void feedback_sync_output(void* data, struct wp_presentation_feedback* feedback,
+                                     struct wl_output* output);
+    static void feedback_presented(void* data, struct wp_presentation_feedback* feedback,
+                                   uint32_t tv_sec_hi, uint32_t tv_sec_lo, uint32_t tv_nsec,
+                                   uint32_t refresh, uint32_t seq_hi, uint32_t seq_lo, uint32_t flags);
+    static void feedback_discarded(void* data, struct wp_presentation_feedback* feedback);
+    static void frame_done(void* data, struct wl_callback* callback, uint32_t time);
+
+    void wait_for_frame() { connection->wait_for_frame(); }
+    void process_events() { connection->process_events(); }
     void swap_buffers();
-    void set_cursor(const std::string& cursor_name);
+    void set_cursor(const std::string& cursor_name) { connection->set_cursor(cursor_name); }
     void start_interactive_resize(const std::string& direction);
-    
+
     static BaseWindow* get_current_instance() { return current_instance; }
-};
\ No newline at end of file
+};
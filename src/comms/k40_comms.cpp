@@ -0,0 +1,241 @@
+#include "k40_comms.h"
+#include "core/trace.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+K40Comms::K40Comms(Transport* link, const Config& cfg)
+    : transport(link), config(cfg), stop_requested(false), packet_in_flight(false),
+      state(State::STOPPED), packets_sent(0), bytes_sent(0), resends(0),
+      status_polls(0), busy_polls(0), stalled_us(0) {
+}
+
+K40Comms::~K40Comms() {
+    stop();
+}
+
+bool K40Comms::start() {
+    if (worker.joinable()) return true;
+
+    if (!transport || (!transport->is_open() && !transport->open())) {
+        std::cerr << "Failed to open K40 transport" << std::endl;
+        state = State::ERROR;
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        stop_requested = false;
+    }
+    state = State::IDLE;
+    worker = std::thread(&K40Comms::worker_loop, this);
+
+    std::cout << "K40 comms started on " << transport->name() << " transport" << std::endl;
+    return true;
+}
+
+void K40Comms::stop() {
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        stop_requested = true;
+        queue.clear();
+    }
+    queue_cv.notify_all();
+    idle_cv.notify_all();
+
+    if (worker.joinable()) {
+        worker.join();
+    }
+    state = State::STOPPED;
+}
+
+void K40Comms::set_progress_hook(ProgressHook hook) {
+    if (worker.joinable()) {
+        std::cerr << "K40 comms: progress hook can only be set while stopped" << std::endl;
+        return;
+    }
+    progress_hook = std::move(hook);
+}
+
+size_t K40Comms::submit(const std::string& commands) {
+    return submit_packets(K40Protocol::packetize(commands));
+}
+
+size_t K40Comms::submit_packets(const std::vector<K40Protocol::Packet>& packets) {
+    if (packets.empty()) return 0;
+
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        queue.insert(queue.end(), packets.begin(), packets.end());
+    }
+    queue_cv.notify_one();
+    return packets.size();
+}
+
+void K40Comms::clear_queue() {
+    std::lock_guard<std::mutex> lock(queue_mutex);
+    queue.clear();
+}
+
+void K40Comms::clear_error() {
+    State expected = State::ERROR;
+    state.compare_exchange_strong(expected, State::IDLE);
+}
+
+bool K40Comms::wait_until_idle(int timeout_ms) {
+    std::unique_lock<std::mutex> lock(queue_mutex);
+    return idle_cv.wait_for(lock, std::chrono::milliseconds(timeout_ms), [this] {
+        return (queue.empty() && !packet_in_flight) || stop_requested;
+    }) && !stop_requested && state != State::ERROR;
+}
+
+size_t K40Comms::pending_packets() const {
+    std::lock_guard<std::mutex> lock(queue_mutex);
+    return queue.size() + (packet_in_flight ? 1 : 0);
+}
+
+K40Comms::Stats K40Comms::get_stats() const {
+    Stats stats;
+    stats.packets_sent = packets_sent.load(std::memory_order_relaxed);
+    stats.bytes_sent = bytes_sent.load(std::memory_order_relaxed);
+    stats.resends = resends.load(std::memory_order_relaxed);
+    stats.status_polls = status_polls.load(std::memory_order_relaxed);
+    stats.busy_polls = busy_polls.load(std::memory_order_relaxed);
+    stats.stalled_seconds = stalled_us.load(std::memory_order_relaxed) / 1e6;
+    return stats;
+}
+
+void K40Comms::worker_loop() {
+    Trace::set_thread_name("k40-comms");
+
+    while (true) {
+        K40Protocol::Packet packet;
+        {
+            TRACE_SPAN("comms.wait_queue");
+            std::unique_lock<std::mutex> lock(queue_mutex);
+            if (queue.empty()) {
+                packet_in_flight = false;
+                idle_cv.notify_all();
+                if (state != State::ERROR) state = State::IDLE;
+            }
+            queue_cv.wait(lock, [this] { return stop_requested || !queue.empty(); });
+            if (stop_requested) break;
+
+            packet = queue.front();
+            queue.pop_front();
+            packet_in_flight = true;
+        }
+
+        if (!send_packet(packet)) {
+            std::cerr << "K40 comms: packet not accepted, aborting stream" << std::endl;
+            // Queue first: once ERROR shows, clear_error() and a new
+            // submit must not lose packets to this clear
+            clear_queue();
+            state = State::ERROR;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(queue_mutex);
+    packet_in_flight = false;
+    idle_cv.notify_all();
+}
+
+bool K40Comms::send_packet(const K40Protocol::Packet& packet) {
+    TRACE_SPAN("comms.send_packet");
+    for (int attempt = 0; attempt <= config.max_resends; ++attempt) {
+        if (attempt > 0) resends++;
+
+        if (!wait_until_ready()) return false;
+
+        state = State::SENDING;
+        int written = transport->write(packet.data(), packet.size(), config.io_timeout_ms);
+        if (written != static_cast<int>(packet.size())) continue;
+
+        K40Protocol::Status status = poll_status();
+        if (status == K40Protocol::Status::OK) {
+            uint64_t sent = ++packets_sent;
+            bytes_sent += K40Protocol::PACKET_SIZE;
+            if (progress_hook) progress_hook(sent);
+            return true;
+        }
+        if (status == K40Protocol::Status::BUSY) {
+            busy_polls++;
+        }
+        // CRC_ERROR, BUSY (packet dropped) or no reply: resend
+    }
+    return false;
+}
+
+bool K40Comms::wait_until_ready() {
+    TRACE_SPAN("comms.wait_ready");
+    auto stall_start = std::chrono::steady_clock::now();
+    int interval_us = config.poll_interval_us;
+    bool stalled = false;
+
+    while (true) {
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex);
+            if (stop_requested) return false;
+        }
+
+        K40Protocol::Status status = poll_status();
+        if (status == K40Protocol::Status::OK || status == K40Protocol::Status::FINISHED) {
+            break;
+        }
+        if (status == K40Protocol::Status::POWER || status == K40Protocol::Status::BAD_STATE) {
+            std::cerr << "K40 comms: controller reports "
+                      << (status == K40Protocol::Status::POWER ? "power fault" : "bad state") << std::endl;
+            return false;
+        }
+        if (status == K40Protocol::Status::NONE) {
+            // No reply at all; treat as a dead link
+            if (!transport->is_open()) return false;
+        } else if (status == K40Protocol::Status::BUSY) {
+            busy_polls++;
+        }
+
+        stalled = true;
+        state = State::STALLED;
+        auto waited = std::chrono::steady_clock::now() - stall_start;
+        if (config.stall_timeout_ms > 0 && waited >= std::chrono::milliseconds(config.stall_timeout_ms)) {
+            stalled_us += std::chrono::duration_cast<std::chrono::microseconds>(waited).count();
+            std::cerr << "K40 comms: controller not ready after " << config.stall_timeout_ms << " ms" << std::endl;
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(interval_us));
+        interval_us = std::min(interval_us * 2, config.max_poll_interval_us);
+    }
+
+    if (stalled) {
+        auto elapsed = std::chrono::steady_clock::now() - stall_start;
+        stalled_us += std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+    }
+    return true;
+}
+
+K40Protocol::Status K40Comms::poll_status() {
+    status_polls++;
+
+    uint8_t request = K40Protocol::STATUS_REQUEST;
+    if (transport->write(&request, 1, config.io_timeout_ms) != 1) {
+        return K40Protocol::Status::NONE;
+    }
+
+    uint8_t reply[K40Protocol::STATUS_REPLY_SIZE] = {};
+    int received = transport->read(reply, sizeof(reply), config.io_timeout_ms);
+    if (received <= 0) {
+        return K40Protocol::Status::NONE;
+    }
+    return K40Protocol::parse_status(reply, static_cast<size_t>(received));
+}
+
+const char* K40Comms::state_name(State state) {
+    switch (state) {
+        case State::STOPPED: return "stopped";
+        case State::IDLE: return "idle";
+        case State::SENDING: return "sending";
+        case State::STALLED: return "stalled";
+        case State::ERROR: return "error";
+    }
+    return "unknown";
+}
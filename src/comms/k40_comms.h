@@ -0,0 +1,112 @@
+#pragma once
+
+#include "transport.h"
+#include "k40_protocol.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Streams encoded K40 commands to a Transport on a dedicated thread.
+// submit() never blocks the caller; the comms thread polls controller
+// status before every packet and backs off while the board reports BUSY,
+// resending packets the board rejected or received corrupted. A board that
+// stays busy or silent past the stall timeout, or reports POWER or
+// BAD_STATE, aborts the stream with State::ERROR.
+class K40Comms {
+public:
+    struct Config {
+        int io_timeout_ms;
+        int poll_interval_us;     // first wait after a BUSY reply
+        int max_poll_interval_us; // backoff ceiling while BUSY
+        int max_resends;          // per packet, before giving up
+        int stall_timeout_ms;     // longest wait for the board to be ready; 0 waits forever
+
+        Config() : io_timeout_ms(500), poll_interval_us(200),
+                   max_poll_interval_us(20000), max_resends(8), stall_timeout_ms(60000) {}
+    };
+
+    enum class State {
+        STOPPED,
+        IDLE,
+        SENDING,
+        STALLED,
+        ERROR
+    };
+
+    // Called on the comms thread after each packet the controller accepts,
+    // with the running total of accepted packets. Must not block.
+    typedef std::function<void(uint64_t packets_sent)> ProgressHook;
+
+    struct Stats {
+        uint64_t packets_sent;
+        uint64_t bytes_sent;
+        uint64_t resends;
+        uint64_t status_polls;
+        uint64_t busy_polls;
+        double stalled_seconds;
+    };
+
+private:
+    Transport* transport;
+    Config config;
+    ProgressHook progress_hook;
+
+    std::thread worker;
+    mutable std::mutex queue_mutex;
+    std::condition_variable queue_cv;
+    std::condition_variable idle_cv;
+    std::deque<K40Protocol::Packet> queue;
+    bool stop_requested;
+    bool packet_in_flight;
+
+    std::atomic<State> state;
+    std::atomic<uint64_t> packets_sent;
+    std::atomic<uint64_t> bytes_sent;
+    std::atomic<uint64_t> resends;
+    std::atomic<uint64_t> status_polls;
+    std::atomic<uint64_t> busy_polls;
+    std::atomic<uint64_t> stalled_us;
+
+    void worker_loop();
+    bool send_packet(const K40Protocol::Packet& packet);
+    bool wait_until_ready();
+    K40Protocol::Status poll_status();
+
+public:
+    explicit K40Comms(Transport* link, const Config& cfg = Config());
+    ~K40Comms();
+
+    // Opens the transport and starts the comms thread
+    bool start();
+    // Stops after the packet currently on the wire; queued packets are dropped
+    void stop();
+
+    // Only while stopped; the hook runs unsynchronized on the comms thread
+    void set_progress_hook(ProgressHook hook);
+
+    // Packetizes and queues commands; returns the number of packets added
+    size_t submit(const std::string& commands);
+    // Queues packets made earlier with K40Protocol::packetize, so a job
+    // prepared off the UI thread starts with a plain queue insert
+    size_t submit_packets(const std::vector<K40Protocol::Packet>& packets);
+    void clear_queue();
+    // After an aborted stream: back from State::ERROR to IDLE, so the next
+    // job can be queued. The aborted stream's packets are already gone.
+    void clear_error();
+
+    // Blocks until every queued packet was accepted by the controller;
+    // false on timeout, stop, or an aborted stream (State::ERROR)
+    bool wait_until_idle(int timeout_ms);
+
+    size_t pending_packets() const;
+    State get_state() const { return state.load(std::memory_order_relaxed); }
+    Stats get_stats() const;
+
+    static const char* state_name(State state);
+};
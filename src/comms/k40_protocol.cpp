@@ -0,0 +1,81 @@
+#include "k40_protocol.h"
+#include <algorithm>
+
+namespace K40Protocol {
+
+    namespace {
+        // Reflected polynomial 0x31 (x^8 + x^5 + x^4 + 1)
+        struct Crc8Table {
+            std::array<uint8_t, 256> values;
+
+            constexpr Crc8Table() : values{} {
+                for (int i = 0; i < 256; ++i) {
+                    uint8_t crc = static_cast<uint8_t>(i);
+                    for (int bit = 0; bit < 8; ++bit) {
+                        crc = (crc & 0x01) ? static_cast<uint8_t>((crc >> 1) ^ 0x8C)
+                                           : static_cast<uint8_t>(crc >> 1);
+                    }
+                    values[i] = crc;
+                }
+            }
+        };
+
+        constexpr Crc8Table crc_table;
+    }
+
+    uint8_t crc8(const uint8_t* data, size_t length) {
+        uint8_t crc = 0;
+        for (size_t i = 0; i < length; ++i) {
+            crc = crc_table.values[crc ^ data[i]];
+        }
+        return crc;
+    }
+
+    Packet build_packet(const uint8_t* payload, size_t length) {
+        Packet packet;
+        size_t count = std::min(length, PAYLOAD_SIZE);
+
+        packet[0] = PACKET_START;
+        packet[1] = 0x00;
+        std::copy(payload, payload + count, packet.begin() + 2);
+        std::fill(packet.begin() + 2 + count, packet.begin() + 2 + PAYLOAD_SIZE, PACKET_PAD);
+        packet[PACKET_SIZE - 2] = PACKET_START;
+        packet[PACKET_SIZE - 1] = crc8(packet.data() + 2, PAYLOAD_SIZE);
+
+        return packet;
+    }
+
+    std::vector<Packet> packetize(const std::string& commands) {
+        std::vector<Packet> packets;
+        packets.reserve((commands.size() + PAYLOAD_SIZE - 1) / PAYLOAD_SIZE);
+
+        const uint8_t* data = reinterpret_cast<const uint8_t*>(commands.data());
+        for (size_t offset = 0; offset < commands.size(); offset += PAYLOAD_SIZE) {
+            packets.push_back(build_packet(data + offset, commands.size() - offset));
+        }
+        return packets;
+    }
+
+    bool verify_packet(const uint8_t* data, size_t length) {
+        if (length != PACKET_SIZE) return false;
+        if (data[0] != PACKET_START || data[1] != 0x00 || data[PACKET_SIZE - 2] != PACKET_START) return false;
+        return crc8(data + 2, PAYLOAD_SIZE) == data[PACKET_SIZE - 1];
+    }
+
+    Status parse_status(const uint8_t* reply, size_t length) {
+        if (length <= STATUS_BYTE_INDEX) return Status::NONE;
+        return static_cast<Status>(reply[STATUS_BYTE_INDEX]);
+    }
+
+    const char* status_name(Status status) {
+        switch (status) {
+            case Status::OK: return "OK";
+            case Status::BUSY: return "BUSY";
+            case Status::CRC_ERROR: return "CRC_ERROR";
+            case Status::FINISHED: return "FINISHED";
+            case Status::POWER: return "POWER";
+            case Status::BAD_STATE: return "BAD_STATE";
+            default: return "NONE";
+        }
+    }
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Lhystudios M2 Nano (CH341 bridge) wire protocol used by the K40.
+namespace K40Protocol {
+    // CH341 USB identifiers and bulk endpoints
+    constexpr uint16_t USB_VENDOR_ID = 0x1a86;
+    constexpr uint16_t USB_PRODUCT_ID = 0x5512;
+    constexpr uint8_t USB_ENDPOINT_OUT = 0x02;
+    constexpr uint8_t USB_ENDPOINT_IN = 0x82;
+
+    // Every packet is: 0xA6 0x00 <30 payload bytes> 0xA6 <crc8(payload)>
+    constexpr size_t PAYLOAD_SIZE = 30;
+    constexpr size_t PACKET_SIZE = PAYLOAD_SIZE + 4;
+    constexpr uint8_t PACKET_START = 0xA6;
+    constexpr uint8_t PACKET_PAD = 'F';
+
+    // Status is requested with a single 0xA0 byte; the reply is 6 bytes,
+    // the controller state lives in byte 1.
+    constexpr uint8_t STATUS_REQUEST = 0xA0;
+    constexpr size_t STATUS_REPLY_SIZE = 6;
+    constexpr size_t STATUS_BYTE_INDEX = 1;
+
+    enum class Status : uint8_t {
+        NONE = 0,
+        BAD_STATE = 204,
+        OK = 206,
+        CRC_ERROR = 207,
+        FINISHED = 236,
+        BUSY = 238,
+        POWER = 239
+    };
+
+    typedef std::array<uint8_t, PACKET_SIZE> Packet;
+
+    // Dallas/Maxim one-wire CRC-8 as computed by the controller firmware
+    uint8_t crc8(const uint8_t* data, size_t length);
+
+    // Frame up to PAYLOAD_SIZE bytes, padding the rest with PACKET_PAD
+    Packet build_packet(const uint8_t* payload, size_t length);
+
+    // Split an encoded command stream into framed packets
+    std::vector<Packet> packetize(const std::string& commands);
+
+    // Validate framing and CRC of a received packet
+    bool verify_packet(const uint8_t* data, size_t length);
+
+    Status parse_status(const uint8_t* reply, size_t length);
+    const char* status_name(Status status);
+}
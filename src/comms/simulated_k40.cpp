@@ -0,0 +1,157 @@
+#include "simulated_k40.h"
+#include <algorithm>
+#include <thread>
+
+SimulatedK40::SimulatedK40(const Config& cfg)
+    : config(cfg), opened(false), buffered_packets(0.0),
+      last_drain(Clock::now()), forced_busy_until(Clock::now()),
+      last_packet_status(K40Protocol::Status::OK), packet_reply_pending(false), status_requested(false),
+      rng_state(0x9e3779b9u), counters{} {
+}
+
+bool SimulatedK40::open() {
+    std::lock_guard<std::mutex> lock(mutex);
+    opened = true;
+    buffered_packets = 0.0;
+    last_drain = Clock::now();
+    return true;
+}
+
+void SimulatedK40::close() {
+    std::lock_guard<std::mutex> lock(mutex);
+    opened = false;
+}
+
+bool SimulatedK40::is_open() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return opened;
+}
+
+void SimulatedK40::drain_buffer(Clock::time_point now) {
+    double elapsed = std::chrono::duration<double>(now - last_drain).count();
+    buffered_packets = std::max(0.0, buffered_packets - elapsed * config.packets_per_second);
+    last_drain = now;
+}
+
+bool SimulatedK40::buffer_full() const {
+    return buffered_packets > static_cast<double>(config.buffer_packets) - 1.0;
+}
+
+bool SimulatedK40::corrupt_next_packet() {
+    if (config.crc_error_rate <= 0.0) return false;
+
+    // xorshift32 keeps runs reproducible between test sessions
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return (rng_state / 4294967296.0) < config.crc_error_rate;
+}
+
+void SimulatedK40::sleep_us(int microseconds) {
+    if (microseconds > 0) {
+        std::this_thread::sleep_for(std::chrono::microseconds(microseconds));
+    }
+}
+
+int SimulatedK40::write(const uint8_t* data, size_t length, int timeout_ms) {
+    (void)timeout_ms; // the modelled board always takes a write
+    sleep_us(config.write_latency_us);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!opened) return -1;
+
+    if (length == 1 && data[0] == K40Protocol::STATUS_REQUEST) {
+        status_requested = true;
+        counters.status_requests++;
+        return 1;
+    }
+
+    packet_reply_pending = true;
+    if (length != K40Protocol::PACKET_SIZE) {
+        last_packet_status = K40Protocol::Status::BAD_STATE;
+        return static_cast<int>(length);
+    }
+
+    Clock::time_point now = Clock::now();
+    drain_buffer(now);
+
+    if (!K40Protocol::verify_packet(data, length) || corrupt_next_packet()) {
+        last_packet_status = K40Protocol::Status::CRC_ERROR;
+        counters.crc_errors++;
+    } else if (buffer_full() || now < forced_busy_until) {
+        // The board drops packets it has no room for; the host must resend
+        last_packet_status = K40Protocol::Status::BUSY;
+        counters.packets_rejected++;
+    } else {
+        last_packet_status = K40Protocol::Status::OK;
+        buffered_packets += 1.0;
+        counters.packets_accepted++;
+
+        // Padding kept: a payload may itself end in the pad byte
+        const char* payload = reinterpret_cast<const char*>(data + 2);
+        received_commands.append(payload, K40Protocol::PAYLOAD_SIZE);
+    }
+
+    return static_cast<int>(length);
+}
+
+int SimulatedK40::read(uint8_t* buffer, size_t length, int timeout_ms) {
+    sleep_us(config.read_latency_us);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    if (!opened) return -1;
+    if (!status_requested || length < K40Protocol::STATUS_REPLY_SIZE) {
+        // Nothing to send back: the bulk IN transfer runs to its timeout
+        lock.unlock();
+        sleep_us(timeout_ms * 1000);
+        return 0;
+    }
+    status_requested = false;
+
+    Clock::time_point now = Clock::now();
+    drain_buffer(now);
+
+    // The first reply after a packet reports its acceptance, even when that
+    // packet filled the buffer; later polls report whether there is room
+    // for another one.
+    K40Protocol::Status status;
+    if (packet_reply_pending) {
+        status = last_packet_status;
+        packet_reply_pending = false;
+    } else {
+        status = (buffer_full() || now < forced_busy_until) ? K40Protocol::Status::BUSY : K40Protocol::Status::OK;
+    }
+    if (status == K40Protocol::Status::BUSY) {
+        counters.busy_replies++;
+    }
+
+    std::fill(buffer, buffer + K40Protocol::STATUS_REPLY_SIZE, 0);
+    buffer[K40Protocol::STATUS_BYTE_INDEX] = static_cast<uint8_t>(status);
+    return static_cast<int>(K40Protocol::STATUS_REPLY_SIZE);
+}
+
+void SimulatedK40::force_busy(int milliseconds) {
+    std::lock_guard<std::mutex> lock(mutex);
+    forced_busy_until = Clock::now() + std::chrono::milliseconds(milliseconds);
+}
+
+void SimulatedK40::set_config(const Config& cfg) {
+    std::lock_guard<std::mutex> lock(mutex);
+    drain_buffer(Clock::now());
+    config = cfg;
+}
+
+SimulatedK40::Counters SimulatedK40::get_counters() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return counters;
+}
+
+std::string SimulatedK40::get_received_commands() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return received_commands;
+}
+
+double SimulatedK40::get_buffered_packets() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return buffered_packets;
+}
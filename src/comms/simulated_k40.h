@@ -0,0 +1,78 @@
+#pragma once
+
+#include "transport.h"
+#include "k40_protocol.h"
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+// In-process stand-in for a K40 controller. Speaks the same packet/status
+// protocol as the real board and models its command buffer draining at a
+// fixed packet rate, so throughput and stall handling can be exercised
+// without hardware.
+class SimulatedK40 : public Transport {
+public:
+    struct Config {
+        int write_latency_us;      // per bulk OUT transfer
+        int read_latency_us;       // per bulk IN transfer
+        int buffer_packets;        // controller-side command buffer
+        double packets_per_second; // rate at which the machine consumes packets
+        double crc_error_rate;     // fraction of packets corrupted in transit (0..1)
+
+        Config() : write_latency_us(125), read_latency_us(125), buffer_packets(16),
+                   packets_per_second(400.0), crc_error_rate(0.0) {}
+    };
+
+    struct Counters {
+        uint64_t packets_accepted;
+        uint64_t packets_rejected;
+        uint64_t crc_errors;
+        uint64_t status_requests;
+        uint64_t busy_replies;
+    };
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    Config config;
+    mutable std::mutex mutex;
+    bool opened;
+
+    double buffered_packets;
+    Clock::time_point last_drain;
+    Clock::time_point forced_busy_until;
+    K40Protocol::Status last_packet_status;
+    bool packet_reply_pending;   // next status reply answers the last packet
+    bool status_requested;
+    uint32_t rng_state;
+
+    Counters counters;
+    std::string received_commands;
+
+    void drain_buffer(Clock::time_point now);
+    bool buffer_full() const;
+    bool corrupt_next_packet();
+    static void sleep_us(int microseconds);
+
+public:
+    explicit SimulatedK40(const Config& cfg = Config());
+
+    bool open() override;
+    void close() override;
+    bool is_open() const override;
+
+    int write(const uint8_t* data, size_t length, int timeout_ms) override;
+    int read(uint8_t* buffer, size_t length, int timeout_ms) override;
+
+    std::string name() const override { return "simulated"; }
+
+    // Report BUSY for the given time regardless of buffer state (e.g. a paused job)
+    void force_busy(int milliseconds);
+    void set_config(const Config& cfg);
+
+    Counters get_counters() const;
+    // Payloads of every accepted packet in order, padding included
+    std::string get_received_commands() const;
+    double get_buffered_packets() const;
+};
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Byte-level link to a K40 controller. Implementations are used from the
+// comms thread only and may block up to the given timeout.
+class Transport {
+public:
+    virtual ~Transport() = default;
+
+    virtual bool open() = 0;
+    virtual void close() = 0;
+    virtual bool is_open() const = 0;
+
+    // Returns the number of bytes transferred, or -1 on a link error
+    virtual int write(const uint8_t* data, size_t length, int timeout_ms) = 0;
+    virtual int read(uint8_t* buffer, size_t length, int timeout_ms) = 0;
+
+    virtual std::string name() const = 0;
+};
@@ -0,0 +1,115 @@
+#include "usb_transport.h"
+#include "k40_protocol.h"
+#include <iostream>
+
+#ifdef HAVE_LIBUSB
+#include <libusb.h>
+#endif
+
+UsbTransport::UsbTransport()
+    : context(nullptr), handle(nullptr), detached_kernel_driver(false) {
+}
+
+UsbTransport::~UsbTransport() {
+    close();
+}
+
+#ifdef HAVE_LIBUSB
+
+bool UsbTransport::open() {
+    if (handle) return true;
+
+    if (libusb_init(&context) != 0) {
+        std::cerr << "Failed to initialize libusb" << std::endl;
+        context = nullptr;
+        return false;
+    }
+
+    handle = libusb_open_device_with_vid_pid(context, K40Protocol::USB_VENDOR_ID,
+                                             K40Protocol::USB_PRODUCT_ID);
+    if (!handle) {
+        std::cerr << "K40 controller (CH341) not found" << std::endl;
+        close();
+        return false;
+    }
+
+    if (libusb_kernel_driver_active(handle, 0) == 1) {
+        if (libusb_detach_kernel_driver(handle, 0) == 0) {
+            detached_kernel_driver = true;
+        }
+    }
+
+    if (libusb_claim_interface(handle, 0) != 0) {
+        std::cerr << "Failed to claim K40 USB interface" << std::endl;
+        close();
+        return false;
+    }
+
+    std::cout << "K40 controller opened over USB" << std::endl;
+    return true;
+}
+
+void UsbTransport::close() {
+    if (handle) {
+        libusb_release_interface(handle, 0);
+        if (detached_kernel_driver) {
+            libusb_attach_kernel_driver(handle, 0);
+            detached_kernel_driver = false;
+        }
+        libusb_close(handle);
+        handle = nullptr;
+    }
+
+    if (context) {
+        libusb_exit(context);
+        context = nullptr;
+    }
+}
+
+int UsbTransport::write(const uint8_t* data, size_t length, int timeout_ms) {
+    if (!handle) return -1;
+
+    int transferred = 0;
+    int result = libusb_bulk_transfer(handle, K40Protocol::USB_ENDPOINT_OUT,
+                                      const_cast<uint8_t*>(data), static_cast<int>(length),
+                                      &transferred, static_cast<unsigned int>(timeout_ms));
+    if (result != 0 && result != LIBUSB_ERROR_TIMEOUT) {
+        std::cerr << "USB write failed: " << libusb_error_name(result) << std::endl;
+        return -1;
+    }
+    return transferred;
+}
+
+int UsbTransport::read(uint8_t* buffer, size_t length, int timeout_ms) {
+    if (!handle) return -1;
+
+    int transferred = 0;
+    int result = libusb_bulk_transfer(handle, K40Protocol::USB_ENDPOINT_IN,
+                                      buffer, static_cast<int>(length),
+                                      &transferred, static_cast<unsigned int>(timeout_ms));
+    if (result != 0 && result != LIBUSB_ERROR_TIMEOUT) {
+        std::cerr << "USB read failed: " << libusb_error_name(result) << std::endl;
+        return -1;
+    }
+    return transferred;
+}
+
+#else
+
+bool UsbTransport::open() {
+    std::cerr << "USB transport unavailable: built without libusb-1.0" << std::endl;
+    return false;
+}
+
+void UsbTransport::close() {
+}
+
+int UsbTransport::write(const uint8_t*, size_t, int) {
+    return -1;
+}
+
+int UsbTransport::read(uint8_t*, size_t, int) {
+    return -1;
+}
+
+#endif
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "transport.h"
+
+struct libusb_context;
+struct libusb_device_handle;
+
+// CH341 bulk transport via libusb. Built only when libusb-1.0 is found;
+// otherwise open() always fails with a message.
+class UsbTransport : public Transport {
+private:
+    libusb_context* context;
+    libusb_device_handle* handle;
+    bool detached_kernel_driver;
+
+public:
+    UsbTransport();
+    ~UsbTransport() override;
+
+    bool open() override;
+    void close() override;
+    bool is_open() const override { return handle != nullptr; }
+
+    int write(const uint8_t* data, size_t length, int timeout_ms) override;
+    int read(uint8_t* buffer, size_t length, int timeout_ms) override;
+
+    std::string name() const override { return "usb"; }
+};
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Fast non-cryptographic 64-bit content hash (xxHash64 layout), used to key
+// on-disk caches by file contents rather than by name or timestamp.
+namespace ContentHash {
+    uint64_t hash64(const void* data, size_t length, uint64_t seed = 0);
+
+    // Hashes a whole file through a read-only mapping; false if unreadable
+    bool hash_file(const std::string& path, uint64_t& out);
+
+    // 16 lowercase hex digits
+    std::string to_hex(uint64_t hash);
+}
@@ -0,0 +1,61 @@
+#include "file_watcher.h"
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+FileWatcher::FileWatcher() : inotify_fd(-1), watch_descriptor(-1) {
+}
+
+FileWatcher::~FileWatcher() {
+    stop();
+}
+
+bool FileWatcher::watch(const std::string& path) {
+    stop();
+
+    size_t slash = path.find_last_of('/');
+    std::string directory = slash == std::string::npos ? "." : (slash == 0 ? "/" : path.substr(0, slash));
+    file_name = slash == std::string::npos ? path : path.substr(slash + 1);
+
+    inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_fd < 0) {
+        std::cerr << "FileWatcher: inotify_init1 failed: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    // Writes in place end with CLOSE_WRITE; save-by-rename ends with MOVED_TO
+    watch_descriptor = inotify_add_watch(inotify_fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+    if (watch_descriptor < 0) {
+        std::cerr << "FileWatcher: cannot watch " << directory << ": " << std::strerror(errno) << std::endl;
+        stop();
+        return false;
+    }
+    watched_path = path;
+    return true;
+}
+
+void FileWatcher::stop() {
+    if (inotify_fd >= 0) close(inotify_fd);
+    inotify_fd = -1;
+    watch_descriptor = -1;
+    watched_path.clear();
+}
+
+bool FileWatcher::take_change() {
+    if (inotify_fd < 0) return false;
+
+    // Events for other files in the directory are read and dropped
+    alignas(struct inotify_event) char buffer[4096];
+    bool changed = false;
+    for (;;) {
+        ssize_t got = read(inotify_fd, buffer, sizeof(buffer));
+        if (got <= 0) break;
+        for (char* p = buffer; p < buffer + got;) {
+            const struct inotify_event* event = reinterpret_cast<const struct inotify_event*>(p);
+            p += sizeof(struct inotify_event) + event->len;
+            if (event->len > 0 && file_name == event->name) changed = true;
+        }
+    }
+    return changed;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <string>
+
+// Reports when a file is rewritten, through inotify on its directory rather
+// than on the file itself: editors and CAD exports often write a new file and
+// rename it over the old one, which a watch on the old inode never sees.
+// Non-blocking; register fd() with the event loop and call take_change() when
+// it is readable (or every frame).
+class FileWatcher {
+private:
+    int inotify_fd;
+    int watch_descriptor;
+    std::string watched_path;
+    std::string file_name;
+
+public:
+    FileWatcher();
+    ~FileWatcher();
+
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+    // Replaces any previous watch; false (logged) if inotify is unavailable
+    bool watch(const std::string& path);
+    void stop();
+
+    int fd() const { return inotify_fd; }
+    const std::string& path() const { return watched_path; }
+
+    // Drains pending events; true if the file was finished writing or
+    // renamed into place since the last call
+    bool take_change();
+};
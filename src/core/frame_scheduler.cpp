@@ -0,0 +1,91 @@
+#include "frame_scheduler.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <iostream>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+FrameScheduler::FrameScheduler() : wake_fd(-1), pending(false) {
+    wake_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (wake_fd < 0) {
+        std::cerr << "FrameScheduler: eventfd failed, falling back to polling" << std::endl;
+    }
+}
+
+FrameScheduler::~FrameScheduler() {
+    if (wake_fd >= 0) close(wake_fd);
+}
+
+void FrameScheduler::request_frame() {
+    // Only the first request since the last frame touches the eventfd
+    if (pending.exchange(true, std::memory_order_acq_rel)) return;
+    if (wake_fd >= 0) {
+        uint64_t one = 1;
+        ssize_t written = write(wake_fd, &one, sizeof(one));
+        (void)written; // EAGAIN means the counter is already non-zero
+    }
+}
+
+bool FrameScheduler::take_request() {
+    if (!pending.exchange(false, std::memory_order_acq_rel)) return false;
+    if (wake_fd >= 0) {
+        uint64_t count;
+        ssize_t got = read(wake_fd, &count, sizeof(count));
+        (void)got;
+    }
+    return true;
+}
+
+void FrameScheduler::watch(int fd) {
+    if (fd < 0 || std::find(watched_fds.begin(), watched_fds.end(), fd) != watched_fds.end()) return;
+    if (watched_fds.size() == MAX_WATCHED_FDS) {
+        std::cerr << "FrameScheduler: too many watched descriptors, ignoring fd " << fd << std::endl;
+        return;
+    }
+    watched_fds.push_back(fd);
+}
+
+void FrameScheduler::unwatch(int fd) {
+    watched_fds.erase(std::remove(watched_fds.begin(), watched_fds.end(), fd), watched_fds.end());
+}
+
+bool FrameScheduler::wait(int display_fd, int timeout_ms) {
+    if (pending.load(std::memory_order_acquire)) return false;
+
+    // Display first, then the eventfd (or a placeholder poll() skips), then
+    // the watched descriptors
+    struct pollfd fds[2 + MAX_WATCHED_FDS];
+    fds[0].fd = display_fd;
+    fds[0].events = POLLIN;
+    fds[0].revents = 0;
+    fds[1].fd = wake_fd;
+    fds[1].events = POLLIN;
+    fds[1].revents = 0;
+    nfds_t count = 2;
+    for (int fd : watched_fds) {
+        fds[count].fd = fd;
+        fds[count].events = POLLIN;
+        fds[count].revents = 0;
+        count++;
+    }
+
+    // Without an eventfd requests are only noticed on the timeout
+    if (wake_fd < 0 && (timeout_ms < 0 || timeout_ms > 16)) timeout_ms = 16;
+
+    int ready;
+    do {
+        ready = poll(fds, count, timeout_ms);
+    } while (ready < 0 && errno == EINTR);
+
+    // A write racing take_request() can leave the counter set with no
+    // request pending; drain it here so it cannot wake every wait
+    if (ready > 0 && wake_fd >= 0 && (fds[1].revents & POLLIN) != 0) {
+        uint64_t drained;
+        ssize_t got = read(wake_fd, &drained, sizeof(drained));
+        (void)got;
+    }
+
+    return ready > 0 && (fds[0].revents & POLLIN) != 0;
+}
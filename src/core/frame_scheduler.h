@@ -0,0 +1,40 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+
+// Decides when the UI thread draws. Any thread may ask for a frame; the UI
+// thread sleeps in wait() until one is asked for or the display connection
+// has events, instead of redrawing in a busy loop. Requests coalesce: many
+// requests before the next frame cost one wakeup.
+class FrameScheduler {
+private:
+    int wake_fd;
+    std::atomic<bool> pending;
+    // Extra descriptors (inotify, ...) that wake the UI thread for a frame
+    std::vector<int> watched_fds;
+    static constexpr size_t MAX_WATCHED_FDS = 8;
+
+public:
+    FrameScheduler();
+    ~FrameScheduler();
+
+    FrameScheduler(const FrameScheduler&) = delete;
+    FrameScheduler& operator=(const FrameScheduler&) = delete;
+
+    // Lock-free and never blocks; safe from any thread
+    void request_frame();
+
+    // UI thread: true (and clears the request) if a frame was asked for
+    bool take_request();
+
+    // UI thread: readability of fd also wakes wait(); whoever owns fd
+    // drains it during the frame, or every wait returns at once
+    void watch(int fd);
+    void unwatch(int fd);
+
+    // UI thread: sleeps until a frame is requested, display_fd or a watched
+    // fd becomes readable or timeout_ms passes (-1 waits forever). Returns
+    // true when display_fd is readable.
+    bool wait(int display_fd, int timeout_ms);
+};
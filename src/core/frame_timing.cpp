@@ -0,0 +1,102 @@
+#include "frame_timing.h"
+#include <algorithm>
+#include <cstdio>
+
+FrameTiming::FrameTiming()
+    : pending_input_ns(0), in_flight{}, next_id(1), last_present_ns(0), refresh_ns(0), render_ns(0),
+      latency_next(0), unreported(0), presented_count(0), discarded_count(0) {
+    latency_ms.reserve(SAMPLE_WINDOW);
+}
+
+void FrameTiming::note_input(uint64_t input_ns) {
+    if (pending_input_ns == 0 || input_ns < pending_input_ns) {
+        pending_input_ns = input_ns;
+    }
+}
+
+uint32_t FrameTiming::submit(uint64_t render_start_ns, uint64_t submit_ns) {
+    if (submit_ns > render_start_ns) {
+        uint64_t sample = submit_ns - render_start_ns;
+        // Rise quickly, decay slowly: a missed vblank costs a whole refresh
+        render_ns = sample > render_ns ? sample : render_ns - (render_ns - sample) / 8;
+    }
+
+    uint32_t id = next_id++;
+    if (next_id == 0) next_id = 1;
+    // Feedback older than MAX_IN_FLIGHT frames is never coming; overwrite it
+    in_flight[id % MAX_IN_FLIGHT] = InFlight{id, pending_input_ns};
+    pending_input_ns = 0;
+    return id;
+}
+
+uint64_t FrameTiming::presented(uint32_t id, uint64_t present_ns, uint64_t refresh_interval_ns) {
+    presented_count++;
+    if (present_ns > last_present_ns) last_present_ns = present_ns;
+    if (refresh_interval_ns > 0) refresh_ns = refresh_interval_ns;
+
+    InFlight& frame = in_flight[id % MAX_IN_FLIGHT];
+    if (frame.id != id) return 0;
+    frame.id = 0;
+    if (frame.input_ns == 0 || present_ns <= frame.input_ns) return 0;
+
+    uint64_t latency = present_ns - frame.input_ns;
+    float sample = static_cast<float>(latency / 1e6);
+    if (latency_ms.size() < SAMPLE_WINDOW) {
+        latency_ms.push_back(sample);
+    } else {
+        latency_ms[latency_next] = sample;
+    }
+    latency_next = (latency_next + 1) % SAMPLE_WINDOW;
+    unreported++;
+    return latency;
+}
+
+void FrameTiming::discarded(uint32_t id) {
+    discarded_count++;
+    InFlight& frame = in_flight[id % MAX_IN_FLIGHT];
+    if (frame.id != id) return;
+    frame.id = 0;
+    // The input is still unanswered; the next frame carries it
+    if (frame.input_ns != 0) note_input(frame.input_ns);
+}
+
+uint64_t FrameTiming::predicted_vblank(uint64_t now_ns) const {
+    if (last_present_ns == 0 || refresh_ns == 0) return 0;
+    if (now_ns < last_present_ns) return last_present_ns;
+    uint64_t periods = (now_ns - last_present_ns) / refresh_ns + 1;
+    return last_present_ns + periods * refresh_ns;
+}
+
+uint64_t FrameTiming::start_deadline(uint64_t now_ns, uint64_t margin_ns) const {
+    uint64_t vblank = predicted_vblank(now_ns + render_ns + margin_ns);
+    if (vblank == 0) return 0;
+    return vblank - render_ns - margin_ns;
+}
+
+LatencySummary FrameTiming::summary() const {
+    LatencySummary out = {};
+    out.samples = latency_ms.size();
+    out.presented = presented_count;
+    out.discarded = discarded_count;
+    out.refresh_ms = refresh_ns / 1e6;
+    if (latency_ms.empty()) return out;
+
+    std::vector<float> sorted(latency_ms);
+    std::sort(sorted.begin(), sorted.end());
+    out.p50_ms = sorted[sorted.size() / 2];
+    out.p95_ms = sorted[std::min(sorted.size() - 1, sorted.size() * 95 / 100)];
+    out.max_ms = sorted.back();
+    return out;
+}
+
+void FrameTiming::log_summary(std::ostream& out) {
+    LatencySummary s = summary();
+    unreported = 0;
+    char line[200];
+    std::snprintf(line, sizeof(line),
+                  "Input-to-photon: p50 %.1f ms, p95 %.1f ms, max %.1f ms over %zu frames "
+                  "(%llu presented, %llu discarded, refresh %.2f ms, render %.2f ms)",
+                  s.p50_ms, s.p95_ms, s.max_ms, s.samples, static_cast<unsigned long long>(s.presented),
+                  static_cast<unsigned long long>(s.discarded), s.refresh_ms, render_ns / 1e6);
+    out << line << std::endl;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+struct LatencySummary {
+    size_t samples;        // presented frames that carried input
+    double p50_ms, p95_ms, max_ms;
+    uint64_t presented;
+    uint64_t discarded;
+    double refresh_ms;     // 0 until the compositor reports it
+};
+
+// Frame bookkeeping for presentation feedback: which input each submitted
+// frame carried, when the compositor actually showed it, and when the next
+// vblank is due. All times are nanoseconds on the presentation clock. UI
+// thread only; knows nothing about Wayland so it can be driven from tests
+// and benchmarks.
+class FrameTiming {
+private:
+    struct InFlight {
+        uint32_t id;
+        uint64_t input_ns;   // 0: frame carried no input
+    };
+
+    static constexpr size_t MAX_IN_FLIGHT = 16;
+    static constexpr size_t SAMPLE_WINDOW = 512;
+
+    uint64_t pending_input_ns;
+    InFlight in_flight[MAX_IN_FLIGHT];
+    uint32_t next_id;
+
+    uint64_t last_present_ns;
+    uint64_t refresh_ns;
+    uint64_t render_ns;      // smoothed frame start -> submit time
+
+    std::vector<float> latency_ms;  // ring of the last SAMPLE_WINDOW samples
+    size_t latency_next;
+    size_t unreported;
+    uint64_t presented_count;
+    uint64_t discarded_count;
+
+public:
+    FrameTiming();
+
+    // Input arrived at input_ns; the next submitted frame answers it. Only
+    // the oldest unanswered input counts, which is what the user waited on.
+    void note_input(uint64_t input_ns);
+
+    // Frame committed; pass the returned id back with its feedback
+    uint32_t submit(uint64_t render_start_ns, uint64_t submit_ns);
+
+    // Returns input-to-photon latency in ns, or 0 if the frame carried no input
+    uint64_t presented(uint32_t id, uint64_t present_ns, uint64_t refresh_interval_ns);
+    void discarded(uint32_t id);
+
+    // Next vblank after now_ns, or 0 before the first presented frame
+    uint64_t predicted_vblank(uint64_t now_ns) const;
+
+    // When to start a frame so it is submitted margin_ns before the
+    // earliest vblank it can still make. 0 without a prediction.
+    uint64_t start_deadline(uint64_t now_ns, uint64_t margin_ns) const;
+
+    LatencySummary summary() const;
+    // New latency samples since the last log_summary()
+    size_t unreported_samples() const { return unreported; }
+    void log_summary(std::ostream& out);
+};
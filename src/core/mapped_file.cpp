@@ -0,0 +1,99 @@
+#include "mapped_file.h"
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+
+MappedFile::MappedFile() : base(nullptr), length(0), opened(false) {
+}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : base(other.base), length(other.length), opened(other.opened) {
+    other.base = nullptr;
+    other.length = 0;
+    other.opened = false;
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        close();
+        std::swap(base, other.base);
+        std::swap(length, other.length);
+        std::swap(opened, other.opened);
+    }
+    return *this;
+}
+
+bool MappedFile::open(const std::string& path) {
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)) {
+        ::close(fd);
+        return false;
+    }
+
+    length = static_cast<size_t>(info.st_size);
+    if (length > 0) {
+        void* mapping = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED) {
+            ::close(fd);
+            length = 0;
+            return false;
+        }
+        base = mapping;
+    }
+
+    ::close(fd);
+    opened = true;
+    return true;
+}
+
+void MappedFile::close() {
+    if (base) {
+        munmap(base, length);
+    }
+    base = nullptr;
+    length = 0;
+    opened = false;
+}
+
+bool read_file_copy(const std::string& path, std::string& out) {
+    out.clear();
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)) {
+        ::close(fd);
+        return false;
+    }
+
+    // The size is only a hint; read until end of file whatever it became
+    out.resize(static_cast<size_t>(info.st_size) + 1);
+    size_t filled = 0;
+    while (true) {
+        if (filled == out.size()) out.resize(out.size() * 2);
+        ssize_t got = ::read(fd, &out[filled], out.size() - filled);
+        if (got < 0 && errno == EINTR) continue;
+        if (got < 0) {
+            ::close(fd);
+            out.clear();
+            return false;
+        }
+        if (got == 0) break;
+        filled += static_cast<size_t>(got);
+    }
+    ::close(fd);
+    out.resize(filled);
+    return true;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// Read-only memory mapping of a whole file. Move-only; unmaps on destruction.
+class MappedFile {
+private:
+    void* base;
+    size_t length;
+    bool opened;
+
+public:
+    MappedFile();
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    // Returns false if the file cannot be opened or mapped. Empty files map
+    // successfully with a null data pointer.
+    bool open(const std::string& path);
+    void close();
+
+    const char* data() const { return static_cast<const char*>(base); }
+    size_t size() const { return length; }
+    bool is_open() const { return opened; }
+};
+
+// Copies a whole file into out with read(). For files other programs may
+// truncate while they are read: a mapping of one faults with SIGBUS.
+bool read_file_copy(const std::string& path, std::string& out);
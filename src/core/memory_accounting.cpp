@@ -0,0 +1,83 @@
+#include "memory_accounting.h"
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+    MemoryAccounting::Counters all_counters[MemoryAccounting::TAG_COUNT];
+
+    void format_bytes(char* buf, size_t size, uint64_t bytes) {
+        if (bytes >= (1ull << 30)) {
+            std::snprintf(buf, size, "%.2f GiB", bytes / double(1ull << 30));
+        } else if (bytes >= (1ull << 20)) {
+            std::snprintf(buf, size, "%.1f MiB", bytes / double(1ull << 20));
+        } else {
+            std::snprintf(buf, size, "%.1f KiB", bytes / 1024.0);
+        }
+    }
+}
+
+namespace MemoryAccounting {
+    Counters& counters(MemoryTag tag) {
+        return all_counters[static_cast<size_t>(tag)];
+    }
+
+    const char* tag_name(MemoryTag tag) {
+        switch (tag) {
+            case MemoryTag::UI: return "ui";
+            case MemoryTag::DRAWING: return "drawing";
+            case MemoryTag::MESH: return "mesh";
+            case MemoryTag::GPU_STAGING: return "gpu_staging";
+            case MemoryTag::JOB: return "job";
+            case MemoryTag::COUNT: break;
+        }
+        return "unknown";
+    }
+
+    void* allocate(MemoryTag tag, size_t bytes) {
+        void* pointer = std::malloc(bytes ? bytes : 1);
+        if (!pointer) throw std::bad_alloc();
+        note_allocate(tag, bytes);
+        return pointer;
+    }
+
+    void deallocate(MemoryTag tag, void* pointer, size_t bytes) {
+        if (!pointer) return;
+        note_free(tag, bytes);
+        std::free(pointer);
+    }
+
+    MemoryStats stats(MemoryTag tag) {
+        const Counters& c = counters(tag);
+        MemoryStats out;
+        out.live_bytes = c.live_bytes.load(std::memory_order_relaxed);
+        out.peak_bytes = c.peak_bytes.load(std::memory_order_relaxed);
+        out.live_allocations = c.live_allocations.load(std::memory_order_relaxed);
+        out.total_allocations = c.total_allocations.load(std::memory_order_relaxed);
+        return out;
+    }
+
+    uint64_t total_live_bytes() {
+        uint64_t total = 0;
+        for (size_t i = 0; i < TAG_COUNT; ++i) {
+            total += all_counters[i].live_bytes.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+    void log_summary(std::ostream& out) {
+        char live[32], peak[32], line[160];
+        out << "Memory by subsystem:" << '\n';
+        for (size_t i = 0; i < TAG_COUNT; ++i) {
+            MemoryTag tag = static_cast<MemoryTag>(i);
+            MemoryStats s = stats(tag);
+            format_bytes(live, sizeof(live), s.live_bytes);
+            format_bytes(peak, sizeof(peak), s.peak_bytes);
+            std::snprintf(line, sizeof(line), "  %-12s live %12s  peak %12s  %10llu live / %llu total allocs",
+                          tag_name(tag), live, peak, static_cast<unsigned long long>(s.live_allocations),
+                          static_cast<unsigned long long>(s.total_allocations));
+            out << line << '\n';
+        }
+        format_bytes(live, sizeof(live), total_live_bytes());
+        out << "  tracked total " << live << std::endl;
+    }
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <ostream>
+#include <vector>
+
+// Heap bytes per subsystem. Containers opt in through TrackedAllocator (a
+// stateless allocator, so copies and moves keep their tag) and UI objects
+// through class-level operator new; everything else stays untracked.
+enum class MemoryTag : uint8_t {
+    UI,          // boxes, layouts
+    DRAWING,     // 2D contours from DXF, slicing, nesting, offsetting
+    MESH,        // tessellated STEP bodies
+    GPU_STAGING, // vertex data on its way to GL buffers
+    JOB,         // toolpaths and encoded job streams
+    COUNT
+};
+
+struct MemoryStats {
+    uint64_t live_bytes;
+    uint64_t peak_bytes;
+    uint64_t live_allocations;
+    uint64_t total_allocations;
+};
+
+namespace MemoryAccounting {
+    constexpr size_t TAG_COUNT = static_cast<size_t>(MemoryTag::COUNT);
+
+    struct Counters {
+        std::atomic<uint64_t> live_bytes{0};
+        std::atomic<uint64_t> peak_bytes{0};
+        std::atomic<uint64_t> live_allocations{0};
+        std::atomic<uint64_t> total_allocations{0};
+    };
+
+    Counters& counters(MemoryTag tag);
+    const char* tag_name(MemoryTag tag);
+
+    inline void note_allocate(MemoryTag tag, size_t bytes) {
+        Counters& c = counters(tag);
+        uint64_t live = c.live_bytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+        uint64_t peak = c.peak_bytes.load(std::memory_order_relaxed);
+        while (live > peak && !c.peak_bytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {}
+        c.live_allocations.fetch_add(1, std::memory_order_relaxed);
+        c.total_allocations.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    inline void note_free(MemoryTag tag, size_t bytes) {
+        Counters& c = counters(tag);
+        c.live_bytes.fetch_sub(bytes, std::memory_order_relaxed);
+        c.live_allocations.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    void* allocate(MemoryTag tag, size_t bytes);
+    void deallocate(MemoryTag tag, void* pointer, size_t bytes);
+
+    MemoryStats stats(MemoryTag tag);
+    uint64_t total_live_bytes();
+
+    // One line per subsystem: live, peak, live and total allocation counts
+    void log_summary(std::ostream& out);
+}
+
+template <class T, MemoryTag Tag>
+class TrackedAllocator {
+public:
+    typedef T value_type;
+
+    TrackedAllocator() noexcept {}
+    template <class U>
+    TrackedAllocator(const TrackedAllocator<U, Tag>&) noexcept {}
+
+    template <class U>
+    struct rebind {
+        typedef TrackedAllocator<U, Tag> other;
+    };
+
+    T* allocate(size_t n) {
+        return static_cast<T*>(MemoryAccounting::allocate(Tag, n * sizeof(T)));
+    }
+    void deallocate(T* pointer, size_t n) noexcept {
+        MemoryAccounting::deallocate(Tag, pointer, n * sizeof(T));
+    }
+
+    template <class U>
+    bool operator==(const TrackedAllocator<U, Tag>&) const noexcept { return true; }
+    template <class U>
+    bool operator!=(const TrackedAllocator<U, Tag>&) const noexcept { return false; }
+};
+
+template <class T, MemoryTag Tag>
+using TrackedVector = std::vector<T, TrackedAllocator<T, Tag>>;
+
+// Class-level operator new/delete that charge the object itself to a tag:
+//   class Box { ... MEMORY_TAGGED_NEW(MemoryTag::UI) };
+#define MEMORY_TAGGED_NEW(tag)                                                         \
+public:                                                                                \
+    static void* operator new(size_t bytes) { return MemoryAccounting::allocate(tag, bytes); } \
+    static void operator delete(void* pointer, size_t bytes) {                         \
+        MemoryAccounting::deallocate(tag, pointer, bytes);                             \
+    }
@@ -0,0 +1,180 @@
+#pragma once
+
+#include "memory_accounting.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Immutable indexed sequence with structural sharing: a 32-way trie of
+// fixed-size chunks. Every "modification" returns a new vector that copies
+// only the chunks on the paths to the changed slots and shares the rest, so
+// keeping many versions alive (undo history) costs O(changed) per version
+// rather than O(size). Nodes are never written after construction, which also
+// makes a version safe to read from any thread.
+template <typename T, MemoryTag Tag>
+class PersistentVector {
+public:
+    static constexpr uint32_t BITS = 5;
+    static constexpr uint32_t WIDTH = 1u << BITS;
+    static constexpr uint32_t MASK = WIDTH - 1;
+
+private:
+    struct Leaf {
+        T items[WIDTH];
+    };
+    struct Branch {
+        std::shared_ptr<const void> children[WIDTH];
+    };
+
+    // Leaf when shift is 0, otherwise a Branch whose children sit at shift - BITS
+    std::shared_ptr<const void> root;
+    size_t count;
+    uint32_t shift;
+
+    template <typename Node>
+    static std::shared_ptr<Node> make_node() {
+        return std::allocate_shared<Node>(TrackedAllocator<Node, Tag>());
+    }
+
+    template <typename Node>
+    static std::shared_ptr<Node> copy_node(const std::shared_ptr<const void>& node) {
+        if (!node) return make_node<Node>();
+        return std::allocate_shared<Node>(TrackedAllocator<Node, Tag>(), *static_cast<const Node*>(node.get()));
+    }
+
+    size_t capacity() const { return root ? size_t(WIDTH) << shift : 0; }
+
+    // Copies the path to index (creating missing nodes) and stores value there
+    static std::shared_ptr<const void> assign(const std::shared_ptr<const void>& node, uint32_t level, size_t index,
+                                              const T& value) {
+        if (level == 0) {
+            auto leaf = copy_node<Leaf>(node);
+            leaf->items[index & MASK] = value;
+            return leaf;
+        }
+        auto branch = copy_node<Branch>(node);
+        auto& child = branch->children[(index >> level) & MASK];
+        child = assign(child, level - BITS, index, value);
+        return branch;
+    }
+
+    // Rebuilds only the nodes that hold one of indices[first, last), which
+    // are sorted and unique; each touched node is copied once
+    template <typename F>
+    static std::shared_ptr<const void> update_range(const std::shared_ptr<const void>& node, uint32_t level,
+                                                    const uint32_t* first, const uint32_t* last, F& fn) {
+        if (level == 0) {
+            auto leaf = copy_node<Leaf>(node);
+            for (const uint32_t* i = first; i != last; ++i) fn(leaf->items[*i & MASK]);
+            return leaf;
+        }
+        auto branch = copy_node<Branch>(node);
+        while (first != last) {
+            const uint32_t slot = (*first >> level) & MASK;
+            const uint32_t* end = first;
+            while (end != last && ((*end >> level) & MASK) == slot) ++end;
+            branch->children[slot] = update_range(branch->children[slot], level - BITS, first, end, fn);
+            first = end;
+        }
+        return branch;
+    }
+
+public:
+    PersistentVector() : count(0), shift(0) {}
+
+    // Bottom-up build: leaves first, then each level of branches over them
+    static PersistentVector from(const std::vector<T>& items) {
+        PersistentVector result;
+        if (items.empty()) return result;
+
+        std::vector<std::shared_ptr<const void>> level;
+        for (size_t start = 0; start < items.size(); start += WIDTH) {
+            auto leaf = make_node<Leaf>();
+            for (size_t i = start; i < items.size() && i < start + WIDTH; ++i) leaf->items[i - start] = items[i];
+            level.push_back(std::move(leaf));
+        }
+        while (level.size() > 1) {
+            std::vector<std::shared_ptr<const void>> parents;
+            for (size_t start = 0; start < level.size(); start += WIDTH) {
+                auto branch = make_node<Branch>();
+                for (size_t i = start; i < level.size() && i < start + WIDTH; ++i) {
+                    branch->children[i - start] = std::move(level[i]);
+                }
+                parents.push_back(std::move(branch));
+            }
+            level.swap(parents);
+            result.shift += BITS;
+        }
+        result.root = std::move(level[0]);
+        result.count = items.size();
+        return result;
+    }
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    const T& operator[](size_t index) const {
+        const void* node = root.get();
+        for (uint32_t level = shift; level > 0; level -= BITS) {
+            node = static_cast<const Branch*>(node)->children[(index >> level) & MASK].get();
+        }
+        return static_cast<const Leaf*>(node)->items[index & MASK];
+    }
+
+    PersistentVector set(size_t index, const T& value) const {
+        PersistentVector result = *this;
+        result.root = assign(root, shift, index, value);
+        return result;
+    }
+
+    PersistentVector push_back(const T& value) const {
+        PersistentVector result = *this;
+        if (!root) {
+            result.root = assign(nullptr, 0, 0, value);
+        } else if (count == capacity()) {
+            // Full: grow a level, the old tree becomes the first child
+            auto branch = make_node<Branch>();
+            branch->children[0] = root;
+            result.shift = shift + BITS;
+            result.root = assign(branch, result.shift, count, value);
+        } else {
+            result.root = assign(root, shift, count, value);
+        }
+        result.count = count + 1;
+        return result;
+    }
+
+    // Applies fn(T&) to each listed slot; indices must be sorted, unique and
+    // in range. Costs O(indices + touched chunks), however large the vector.
+    template <typename F>
+    PersistentVector update(const std::vector<uint32_t>& indices, F fn) const {
+        if (indices.empty()) return *this;
+        PersistentVector result = *this;
+        result.root = update_range(root, shift, indices.data(), indices.data() + indices.size(), fn);
+        return result;
+    }
+
+    template <typename F>
+    void for_each(F fn) const {
+        for (size_t start = 0; start < count; start += WIDTH) {
+            const Leaf* leaf = static_cast<const Leaf*>(leaf_at(start));
+            for (size_t i = start; i < count && i < start + WIDTH; ++i) fn(leaf->items[i & MASK]);
+        }
+    }
+
+    // True when both versions hold the very same chunk for index (shared,
+    // not merely equal)
+    bool shares_chunk(const PersistentVector& other, size_t index) const {
+        return shift == other.shift && leaf_at(index) == other.leaf_at(index);
+    }
+
+private:
+    const void* leaf_at(size_t index) const {
+        const void* node = root.get();
+        for (uint32_t level = shift; level > 0 && node; level -= BITS) {
+            node = static_cast<const Branch*>(node)->children[(index >> level) & MASK].get();
+        }
+        return node;
+    }
+};
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+
+// Bounded lock-free queue for exactly one producer thread and one consumer
+// thread. Neither side ever blocks or takes a lock: push fails when the ring
+// is full and pop fails when it is empty, so a stalled consumer can never
+// hold up the producer (and the other way round). Head and tail live on
+// separate cache lines so the two threads do not fight over one line.
+template <typename T, size_t Capacity>
+class SpscRing {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "capacity must be a power of two");
+    static_assert(std::is_trivially_copyable<T>::value, "ring slots are copied without locking");
+
+private:
+    static constexpr size_t MASK = Capacity - 1;
+    static constexpr size_t CACHE_LINE = 64;
+
+    // Written by the consumer only
+    alignas(CACHE_LINE) std::atomic<size_t> head;
+    // Written by the producer only
+    alignas(CACHE_LINE) std::atomic<size_t> tail;
+    alignas(CACHE_LINE) T slots[Capacity];
+
+public:
+    SpscRing() : head(0), tail(0) {}
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    // Producer side
+    bool try_push(const T& value) {
+        const size_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) == Capacity) return false;
+        slots[t & MASK] = value;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side
+    bool try_pop(T& out) {
+        const size_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire)) return false;
+        out = slots[h & MASK];
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side: pops everything available and keeps only the newest
+    // entry, for streams where each update supersedes the previous one
+    bool pop_latest(T& out) {
+        const size_t h = head.load(std::memory_order_relaxed);
+        const size_t t = tail.load(std::memory_order_acquire);
+        if (h == t) return false;
+        out = slots[(t - 1) & MASK];
+        head.store(t, std::memory_order_release);
+        return true;
+    }
+
+    // Approximate when called while the other side is active
+    size_t size() const {
+        return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+    }
+    bool empty() const { return size() == 0; }
+    static constexpr size_t capacity() { return Capacity; }
+};
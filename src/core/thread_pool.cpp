@@ -0,0 +1,111 @@
+#include "thread_pool.h"
+#include "trace.h"
+#include <algorithm>
+#include <memory>
+#include <string>
+
+ThreadPool::ThreadPool(size_t threads) : active(0), stopping(false) {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    workers.reserve(threads);
+    for (size_t i = 0; i < threads; ++i) {
+        workers.emplace_back(&ThreadPool::worker_loop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    task_cv.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::worker_loop(size_t index) {
+    Trace::set_thread_name(("pool-" + std::to_string(index)).c_str());
+
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            task_cv.wait(lock, [this] { return stopping || !tasks.empty(); });
+            if (stopping && tasks.empty()) return;
+
+            task = std::move(tasks.front());
+            tasks.pop_front();
+            active++;
+        }
+
+        {
+            TRACE_SPAN("pool.task");
+            task();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            active--;
+            if (active == 0 && tasks.empty()) {
+                idle_cv.notify_all();
+            }
+        }
+    }
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.push_back(std::move(task));
+    }
+    task_cv.notify_one();
+}
+
+void ThreadPool::wait_idle() {
+    std::unique_lock<std::mutex> lock(mutex);
+    idle_cv.wait(lock, [this] { return active == 0 && tasks.empty(); });
+}
+
+void ThreadPool::parallel_for(size_t count, const std::function<void(size_t)>& fn) {
+    if (count == 0) return;
+    if (count == 1 || workers.empty()) {
+        for (size_t i = 0; i < count; ++i) fn(i);
+        return;
+    }
+
+    struct Shared {
+        std::atomic<size_t> next{0};
+        std::atomic<size_t> done{0};
+        std::mutex mutex;
+        std::condition_variable cv;
+    };
+    auto shared = std::make_shared<Shared>();
+
+    auto run = [shared, count, &fn]() {
+        size_t finished = 0;
+        for (size_t i = shared->next.fetch_add(1); i < count; i = shared->next.fetch_add(1)) {
+            fn(i);
+            finished++;
+        }
+        if (finished > 0 && shared->done.fetch_add(finished) + finished == count) {
+            std::lock_guard<std::mutex> lock(shared->mutex);
+            shared->cv.notify_all();
+        }
+    };
+
+    size_t helpers = std::min(workers.size(), count - 1);
+    for (size_t i = 0; i < helpers; ++i) {
+        submit(run);
+    }
+    run();
+
+    std::unique_lock<std::mutex> lock(shared->mutex);
+    shared->cv.wait(lock, [&] { return shared->done.load() == count; });
+}
+
+ThreadPool& ThreadPool::shared() {
+    static ThreadPool pool;
+    return pool;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed-size worker pool for background CPU work (import, tessellation,
+// geometry passes). The UI thread only ever submits and never waits on it.
+class ThreadPool {
+private:
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> tasks;
+    std::mutex mutex;
+    std::condition_variable task_cv;
+    std::condition_variable idle_cv;
+    size_t active;
+    bool stopping;
+
+    void worker_loop(size_t index);
+
+public:
+    // 0 threads = one per hardware thread
+    explicit ThreadPool(size_t threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void submit(std::function<void()> task);
+    void wait_idle();
+    size_t size() const { return workers.size(); }
+
+    // Runs fn(i) for every i in [0, count) and returns when all are done.
+    // The calling thread takes part, so this is safe to call from a worker.
+    void parallel_for(size_t count, const std::function<void(size_t)>& fn);
+
+    // Process-wide pool shared by the geometry and import stages
+    static ThreadPool& shared();
+};
@@ -0,0 +1,206 @@
+#include "trace.h"
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+    constexpr uint32_t CHUNK_EVENTS = 4096;
+    // Per thread, between dumps; beyond this spans are counted and dropped
+    constexpr size_t MAX_CHUNKS = 256;
+
+    // A counter sample keeps its value in end_ns
+    struct Event {
+        const char* name;
+        uint64_t start_ns;
+        uint64_t end_ns;
+        bool counter;
+    };
+
+    // Filled by one thread only; count is published with release so the
+    // dumper can read every event below it without a lock
+    struct Chunk {
+        Event events[CHUNK_EVENTS];
+        std::atomic<uint32_t> count;
+
+        Chunk() : count(0) {}
+    };
+
+    struct ThreadBuffer {
+        uint32_t tid;
+        std::string name;
+
+        // The owning thread only takes the mutex to add a chunk; the
+        // dumper takes it to walk and free chunks
+        std::mutex mutex;
+        std::vector<std::unique_ptr<Chunk>> chunks;
+        Chunk* current;
+        uint32_t dumped;  // events of the first chunk already written
+        std::atomic<uint64_t> dropped;
+
+        ThreadBuffer() : tid(0), current(nullptr), dumped(0), dropped(0) {}
+    };
+
+    struct Registry {
+        std::mutex mutex;
+        std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+        uint32_t next_tid = 1;
+    };
+
+    Registry& registry() {
+        static Registry instance;
+        return instance;
+    }
+
+    const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+    std::atomic<bool> dump_requested(false);
+
+    ThreadBuffer& this_thread_buffer() {
+        // Owned by the registry too, so spans from exited threads still dump
+        thread_local std::shared_ptr<ThreadBuffer> buffer;
+        if (!buffer) {
+            buffer = std::make_shared<ThreadBuffer>();
+            Registry& reg = registry();
+            std::lock_guard<std::mutex> lock(reg.mutex);
+            buffer->tid = reg.next_tid++;
+            buffer->name = "thread " + std::to_string(buffer->tid);
+            reg.buffers.push_back(buffer);
+        }
+        return *buffer;
+    }
+
+    void write_escaped(FILE* out, const std::string& text) {
+        for (char c : text) {
+            if (c == '"' || c == '\\') fputc('\\', out);
+            if (static_cast<unsigned char>(c) >= 0x20) fputc(c, out);
+        }
+    }
+
+    void append(const Event& event) {
+        ThreadBuffer& buffer = this_thread_buffer();
+        Chunk* chunk = buffer.current;
+        uint32_t n = chunk ? chunk->count.load(std::memory_order_relaxed) : CHUNK_EVENTS;
+
+        if (n == CHUNK_EVENTS) {
+            std::lock_guard<std::mutex> lock(buffer.mutex);
+            if (buffer.chunks.size() >= MAX_CHUNKS) {
+                buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            buffer.chunks.push_back(std::make_unique<Chunk>());
+            chunk = buffer.chunks.back().get();
+            buffer.current = chunk;
+            n = 0;
+        }
+
+        chunk->events[n] = event;
+        chunk->count.store(n + 1, std::memory_order_release);
+    }
+}
+
+namespace Trace {
+    std::atomic<bool> active(false);
+
+    void enable(bool on) {
+        active.store(on, std::memory_order_relaxed);
+    }
+
+    void set_thread_name(const char* name) {
+        ThreadBuffer& buffer = this_thread_buffer();
+        std::lock_guard<std::mutex> lock(buffer.mutex);
+        buffer.name = name;
+    }
+
+    uint64_t now_ns() {
+        return static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count());
+    }
+
+    void record(const char* name, uint64_t start_ns, uint64_t end_ns) {
+        append(Event{name, start_ns, end_ns, false});
+    }
+
+    void counter(const char* name, uint64_t value) {
+        if (enabled()) append(Event{name, now_ns(), value, true});
+    }
+
+    bool dump(const std::string& path) {
+        FILE* out = fopen(path.c_str(), "w");
+        if (!out) {
+            std::cerr << "Trace: cannot write " << path << std::endl;
+            return false;
+        }
+
+        std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+        {
+            Registry& reg = registry();
+            std::lock_guard<std::mutex> lock(reg.mutex);
+            buffers = reg.buffers;
+        }
+
+        const int pid = static_cast<int>(getpid());
+        size_t written = 0;
+        uint64_t dropped = 0;
+        bool first = true;
+        fprintf(out, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+        for (const auto& buffer : buffers) {
+            std::lock_guard<std::mutex> lock(buffer->mutex);
+            fprintf(out, "%s{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":%d,\"tid\":%u,\"args\":{\"name\":\"",
+                    first ? "" : ",\n", pid, buffer->tid);
+            write_escaped(out, buffer->name);
+            fprintf(out, "\"}}");
+            first = false;
+
+            // Spans the owner appends while this runs are left for the next
+            // dump: the last chunk remembers the count it was written up to
+            uint32_t last_written = 0;
+            for (size_t c = 0; c < buffer->chunks.size(); ++c) {
+                Chunk* chunk = buffer->chunks[c].get();
+                uint32_t count = chunk->count.load(std::memory_order_acquire);
+                last_written = count;
+                for (uint32_t i = c == 0 ? buffer->dumped : 0; i < count; ++i) {
+                    const Event& e = chunk->events[i];
+                    fprintf(out, ",\n{\"ph\":\"%s\",\"name\":\"", e.counter ? "C" : "X");
+                    write_escaped(out, e.name);
+                    if (e.counter) {
+                        fprintf(out, "\",\"pid\":%d,\"tid\":%u,\"ts\":%.3f,\"args\":{\"value\":%llu}}", pid,
+                                buffer->tid, e.start_ns / 1000.0, static_cast<unsigned long long>(e.end_ns));
+                    } else {
+                        fprintf(out, "\",\"pid\":%d,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}", pid, buffer->tid,
+                                e.start_ns / 1000.0, (e.end_ns - e.start_ns) / 1000.0);
+                    }
+                    written++;
+                }
+            }
+
+            // Full chunks the thread has moved past can go; the current one
+            // stays and remembers how far it was written
+            if (!buffer->chunks.empty()) {
+                Chunk* last = buffer->chunks.back().get();
+                buffer->chunks.erase(buffer->chunks.begin(), buffer->chunks.end() - 1);
+                buffer->dumped = last == buffer->current ? last_written : 0;
+            }
+            dropped += buffer->dropped.exchange(0, std::memory_order_relaxed);
+        }
+
+        fprintf(out, "\n]}\n");
+        bool ok = fclose(out) == 0;
+        std::cout << "Trace: wrote " << written << " spans to " << path;
+        if (dropped) std::cout << " (" << dropped << " dropped, buffers full)";
+        std::cout << std::endl;
+        return ok;
+    }
+
+    void request_dump() {
+        dump_requested.store(true, std::memory_order_relaxed);
+    }
+
+    bool take_dump_request() {
+        return dump_requested.exchange(false, std::memory_order_relaxed);
+    }
+}
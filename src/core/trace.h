@@ -0,0 +1,53 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// Scoped timing spans written as Chrome trace-event JSON (chrome://tracing,
+// ui.perfetto.dev). Each thread records into its own append-only buffer, so
+// recording takes no locks; a disabled span costs one relaxed atomic load.
+// Span names must be string literals (only the pointer is stored).
+//
+//   TRACE_SPAN("comms.send_packet");
+namespace Trace {
+    extern std::atomic<bool> active;
+
+    inline bool enabled() { return active.load(std::memory_order_relaxed); }
+    void enable(bool on);
+
+    // Names the calling thread in the trace (pool workers, comms, loaders)
+    void set_thread_name(const char* name);
+
+    uint64_t now_ns();
+    void record(const char* name, uint64_t start_ns, uint64_t end_ns);
+    // Counter track sample (GL calls per frame, queue depth); no-op when off
+    void counter(const char* name, uint64_t value);
+
+    // Writes everything recorded since the previous dump and forgets it
+    bool dump(const std::string& path);
+
+    // Async-signal-safe; the UI thread polls take_dump_request() per frame
+    void request_dump();
+    bool take_dump_request();
+}
+
+class TraceSpan {
+private:
+    const char* name;
+    uint64_t start;
+
+public:
+    explicit TraceSpan(const char* span_name)
+        : name(Trace::enabled() ? span_name : nullptr), start(name ? Trace::now_ns() : 0) {}
+    ~TraceSpan() {
+        if (name) Trace::record(name, start, Trace::now_ns());
+    }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SPAN(name) TraceSpan TRACE_CONCAT(trace_span_, __LINE__)(name)
@@ -0,0 +1,452 @@
+#include "display_connection.h"
+#include "base_window.h"
+#include "core/trace.h"
+#include "viewport/gl_api.h"
+#include "viewport/gl_state.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <poll.h>
+
+// Wayland registry listeners
+static const struct wl_registry_listener registry_listener = {
+    DisplayConnection::registry_global,
+    DisplayConnection::registry_global_remove
+};
+
+// XDG Shell listeners
+static const struct xdg_wm_base_listener xdg_wm_base_listener = {
+    DisplayConnection::xdg_wm_base_ping
+};
+
+// Pointer listeners
+static const struct wl_pointer_listener pointer_listener = {
+    DisplayConnection::pointer_enter,
+    DisplayConnection::pointer_leave,
+    DisplayConnection::pointer_motion,
+    DisplayConnection::pointer_button,
+    DisplayConnection::pointer_axis,
+    DisplayConnection::pointer_frame
+};
+
+// Presentation listener
+static const struct wp_presentation_listener presentation_listener = {
+    DisplayConnection::presentation_clock_id
+};
+
+DisplayConnection::DisplayConnection()
+    : display(nullptr), registry(nullptr), compositor(nullptr), xdg_wm_base(nullptr),
+      decoration_manager(nullptr), seat(nullptr), pointer(nullptr), pointer_focus(nullptr),
+      shm(nullptr), cursor_theme(nullptr), current_cursor(nullptr), cursor_surface(nullptr),
+      presentation(nullptr), presentation_clock(CLOCK_MONOTONIC),
+      egl_display(EGL_NO_DISPLAY), egl_config(nullptr), egl_context(EGL_NO_CONTEXT),
+      software(false), connected(false) {
+}
+
+DisplayConnection::~DisplayConnection() {
+    cleanup();
+}
+
+DisplayConnection& DisplayConnection::shared() {
+    static DisplayConnection connection;
+    return connection;
+}
+
+bool DisplayConnection::connect() {
+    if (is_connected()) return true;
+
+    if (!init_wayland()) {
+        return false;
+    }
+
+    // Without the EGL/GLES libraries installed this is where the software
+    // fallback starts; the binary does not link them
+    if (!software && !(GlApi::load() && init_egl())) {
+        if (!shm) return false;
+        std::cerr << "EGL unavailable, falling back to software rendering" << std::endl;
+        release_egl();
+        software = true;
+    }
+    if (software && !shm) {
+        std::cerr << "Software rendering needs wl_shm" << std::endl;
+        return false;
+    }
+
+    // Initialize cursor theme if shm is available
+    if (shm) {
+        cursor_theme = wl_cursor_theme_load(nullptr, 24, shm);
+        if (cursor_theme) {
+            cursor_surface = wl_compositor_create_surface(compositor);
+            std::cout << "Cursor theme initialized" << std::endl;
+        }
+    }
+    connected = true;
+    return true;
+}
+
+bool DisplayConnection::init_wayland() {
+    display = wl_display_connect(nullptr);
+    if (!display) {
+        std::cerr << "Failed to connect to Wayland display" << std::endl;
+        return false;
+    }
+
+    registry = wl_display_get_registry(display);
+    wl_registry_add_listener(registry, &registry_listener, this);
+
+    wl_display_dispatch(display);
+    wl_display_roundtrip(display);
+
+    if (!compositor) {
+        std::cerr << "Wayland compositor not available" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool DisplayConnection::init_egl() {
+    egl_display = eglGetDisplay((EGLNativeDisplayType)display);
+    if (egl_display == EGL_NO_DISPLAY) {
+        std::cerr << "Failed to get EGL display" << std::endl;
+        return false;
+    }
+
+    if (!eglInitialize(egl_display, nullptr, nullptr)) {
+        std::cerr << "Failed to initialize EGL" << std::endl;
+        return false;
+    }
+
+    EGLint config_attribs[] = {
+        EGL_SURFACE_TYPE, EGL_WINDOW_BIT,
+        EGL_RED_SIZE, 8,
+        EGL_GREEN_SIZE, 8,
+        EGL_BLUE_SIZE, 8,
+        EGL_ALPHA_SIZE, 8,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_ES2_BIT,
+        EGL_NONE
+    };
+
+    EGLint num_configs;
+    if (!eglChooseConfig(egl_display, config_attribs, &egl_config, 1, &num_configs)) {
+        std::cerr << "Failed to choose EGL config" << std::endl;
+        return false;
+    }
+
+    EGLint context_attribs[] = {
+        EGL_CONTEXT_CLIENT_VERSION, 2,
+        EGL_NONE
+    };
+
+    // One context for every window: programs, buffers and textures made
+    // while drawing one window are usable from all of them
+    egl_context = eglCreateContext(egl_display, egl_config, EGL_NO_CONTEXT, context_attribs);
+    if (egl_context == EGL_NO_CONTEXT) {
+        std::cerr << "Failed to create EGL context" << std::endl;
+        return false;
+    }
+    // Fresh context: nothing the tracker remembers is true of it
+    GlState::invalidate();
+    shader_cache.enable_binary_cache(ShaderCache::default_directory(),
+                                     reinterpret_cast<ShaderCache::GlProcLoader>(eglGetProcAddress));
+    return true;
+}
+
+void DisplayConnection::add_window(BaseWindow* window) {
+    if (std::find(windows.begin(), windows.end(), window) == windows.end()) {
+        windows.push_back(window);
+    }
+}
+
+void DisplayConnection::remove_window(BaseWindow* window) {
+    windows.erase(std::remove(windows.begin(), windows.end(), window), windows.end());
+    if (pointer_focus == window) pointer_focus = nullptr;
+}
+
+BaseWindow* DisplayConnection::window_for_surface(struct wl_surface* surface) const {
+    for (BaseWindow* window : windows) {
+        if (window->get_surface() == surface) return window;
+    }
+    return nullptr;
+}
+
+void DisplayConnection::run() {
+    while (true) {
+        bool any_open = false;
+        for (BaseWindow* window : windows) {
+            if (!window->should_close()) any_open = true;
+        }
+        if (!any_open) break;
+
+        wait_for_frame();
+        defer_frame_start();
+        uint64_t start_ns = presentation_now();
+        process_events();
+
+        // Index loop: a callback may open another window
+        for (size_t i = 0; i < windows.size(); ++i) {
+            windows[i]->render_frame(start_ns);
+        }
+    }
+}
+
+void DisplayConnection::wait_for_frame() {
+    if (frame_scheduler.take_request()) return;
+    TRACE_SPAN("frame.wait");
+
+    // Sleep until input arrives or another thread asks for a frame
+    while (wl_display_prepare_read(display) != 0) {
+        wl_display_dispatch_pending(display);
+    }
+    wl_display_flush(display);
+
+    if (frame_scheduler.wait(wl_display_get_fd(display), IDLE_FRAME_TIMEOUT_MS)) {
+        wl_display_read_events(display);
+    } else {
+        wl_display_cancel_read(display);
+    }
+    frame_scheduler.take_request();
+}
+
+void DisplayConnection::defer_frame_start() {
+    if (!presentation) return;
+
+    // The window closest to its vblank decides; the others ride along
+    uint64_t now = presentation_now();
+    uint64_t deadline = 0;
+    for (BaseWindow* window : windows) {
+        if (!window->is_deferring_submit() || window->should_close()) continue;
+        uint64_t start = window->get_frame_timing().start_deadline(now, window->get_submit_margin_ns());
+        if (start != 0 && (deadline == 0 || start < deadline)) deadline = start;
+    }
+    if (deadline == 0) return;
+
+    TRACE_SPAN("frame.defer");
+    struct timespec ts;
+    ts.tv_sec = static_cast<time_t>(deadline / 1000000000ull);
+    ts.tv_nsec = static_cast<long>(deadline % 1000000000ull);
+    while (clock_nanosleep(presentation_clock, TIMER_ABSTIME, &ts, nullptr) == EINTR) {}
+
+    // Pick up whatever input arrived while sleeping
+    wl_display_dispatch_pending(display);
+    if (wl_display_prepare_read(display) == 0) {
+        wl_display_flush(display);
+        struct pollfd pfd = {wl_display_get_fd(display), POLLIN, 0};
+        if (poll(&pfd, 1, 0) > 0) {
+            wl_display_read_events(display);
+        } else {
+            wl_display_cancel_read(display);
+        }
+    }
+}
+
+void DisplayConnection::process_events() {
+    TRACE_SPAN("wayland.dispatch");
+    wl_display_dispatch_pending(display);
+    wl_display_flush(display);
+}
+
+uint64_t DisplayConnection::presentation_now() const {
+    struct timespec ts;
+    clock_gettime(presentation_clock, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+void DisplayConnection::set_cursor(const std::string& cursor_name) {
+    if (!cursor_theme || !cursor_surface || !pointer) {
+        return;
+    }
+
+    struct wl_cursor* cursor = wl_cursor_theme_get_cursor(cursor_theme, cursor_name.c_str());
+    if (!cursor) {
+        cursor = wl_cursor_theme_get_cursor(cursor_theme, "default");
+    }
+
+    if (cursor && cursor->image_count > 0) {
+        struct wl_cursor_image* image = cursor->images[0];
+        wl_surface_attach(cursor_surface, wl_cursor_image_get_buffer(image), 0, 0);
+        wl_surface_damage(cursor_surface, 0, 0, image->width, image->height);
+        wl_surface_commit(cursor_surface);
+        wl_pointer_set_cursor(pointer, 0, cursor_surface, image->hotspot_x, image->hotspot_y);
+        current_cursor = cursor;
+    }
+}
+
+void DisplayConnection::release_egl() {
+    if (egl_context != EGL_NO_CONTEXT) {
+        // Programs can only be deleted with the context current; without a
+        // surface left that needs EGL_KHR_surfaceless_context, otherwise
+        // destroying the context frees them anyway
+        if (eglMakeCurrent(egl_display, EGL_NO_SURFACE, EGL_NO_SURFACE, egl_context)) {
+            shader_cache.clear();
+        }
+        GlState::log_summary(std::cout);
+        eglMakeCurrent(egl_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        eglDestroyContext(egl_display, egl_context);
+    }
+
+    if (egl_display != EGL_NO_DISPLAY) {
+        eglTerminate(egl_display);
+    }
+    egl_context = EGL_NO_CONTEXT;
+    egl_display = EGL_NO_DISPLAY;
+}
+
+void DisplayConnection::cleanup() {
+    release_egl();
+
+    if (cursor_surface) {
+        wl_surface_destroy(cursor_surface);
+    }
+
+    if (cursor_theme) {
+        wl_cursor_theme_destroy(cursor_theme);
+    }
+
+    if (shm) {
+        wl_shm_destroy(shm);
+    }
+
+    if (presentation) {
+        wp_presentation_destroy(presentation);
+    }
+
+    if (decoration_manager) {
+        zxdg_decoration_manager_v1_destroy(decoration_manager);
+    }
+
+    if (pointer) {
+        wl_pointer_destroy(pointer);
+    }
+
+    if (seat) {
+        wl_seat_destroy(seat);
+    }
+
+    if (xdg_wm_base) {
+        xdg_wm_base_destroy(xdg_wm_base);
+    }
+
+    if (compositor) {
+        wl_compositor_destroy(compositor);
+    }
+
+    if (registry) {
+        wl_registry_destroy(registry);
+    }
+
+    if (display) {
+        wl_display_disconnect(display);
+    }
+}
+
+// Wayland callbacks
+void DisplayConnection::registry_global(void* data, struct wl_registry* registry,
+                                       uint32_t name, const char* interface, uint32_t version) {
+    DisplayConnection* connection = static_cast<DisplayConnection*>(data);
+
+    if (strcmp(interface, wl_compositor_interface.name) == 0) {
+        connection->compositor = static_cast<struct wl_compositor*>(
+            wl_registry_bind(registry, name, &wl_compositor_interface, 4));
+    } else if (strcmp(interface, xdg_wm_base_interface.name) == 0) {
+        connection->xdg_wm_base = static_cast<struct xdg_wm_base*>(
+            wl_registry_bind(registry, name, &xdg_wm_base_interface, 1));
+        xdg_wm_base_add_listener(connection->xdg_wm_base, &xdg_wm_base_listener, connection);
+    } else if (strcmp(interface, zxdg_decoration_manager_v1_interface.name) == 0) {
+        connection->decoration_manager = static_cast<struct zxdg_decoration_manager_v1*>(
+            wl_registry_bind(registry, name, &zxdg_decoration_manager_v1_interface, 1));
+    } else if (strcmp(interface, wp_presentation_interface.name) == 0) {
+        connection->presentation = static_cast<struct wp_presentation*>(
+            wl_registry_bind(registry, name, &wp_presentation_interface, 1));
+        wp_presentation_add_listener(connection->presentation, &presentation_listener, connection);
+    } else if (strcmp(interface, wl_shm_interface.name) == 0) {
+        connection->shm = static_cast<struct wl_shm*>(
+            wl_registry_bind(registry, name, &wl_shm_interface, 1));
+    } else if (strcmp(interface, wl_seat_interface.name) == 0) {
+        connection->seat = static_cast<struct wl_seat*>(
+            wl_registry_bind(registry, name, &wl_seat_interface, 7));
+
+        // Get pointer for mouse input
+        connection->pointer = wl_seat_get_pointer(connection->seat);
+        if (connection->pointer) {
+            wl_pointer_add_listener(connection->pointer, &pointer_listener, connection);
+        }
+    }
+}
+
+void DisplayConnection::registry_global_remove(void* data, struct wl_registry* registry, uint32_t name) {
+    // Handle global removal
+}
+
+void DisplayConnection::xdg_wm_base_ping(void* data, struct xdg_wm_base* shell, uint32_t serial) {
+    xdg_wm_base_pong(shell, serial);
+}
+
+void DisplayConnection::presentation_clock_id(void* data, struct wp_presentation* presentation,
+                                              uint32_t clock_id) {
+    DisplayConnection* connection = static_cast<DisplayConnection*>(data);
+    connection->presentation_clock = static_cast<clockid_t>(clock_id);
+}
+
+// Pointer event handlers - update the focused window's WindowData directly
+void DisplayConnection::pointer_enter(void* data, struct wl_pointer* pointer, uint32_t serial,
+                                     struct wl_surface* surface, wl_fixed_t sx, wl_fixed_t sy) {
+    DisplayConnection* connection = static_cast<DisplayConnection*>(data);
+    BaseWindow* window = connection->window_for_surface(surface);
+    connection->pointer_focus = window;
+    if (!window) return;
+    window->window_data.mouse_x = wl_fixed_to_double(sx);
+    window->window_data.mouse_y = wl_fixed_to_double(sy);
+}
+
+void DisplayConnection::pointer_leave(void* data, struct wl_pointer* pointer, uint32_t serial,
+                                     struct wl_surface* surface) {
+    DisplayConnection* connection = static_cast<DisplayConnection*>(data);
+    BaseWindow* window = connection->window_for_surface(surface);
+    if (window) window->window_data.mouse_held = false;
+    if (connection->pointer_focus == window) connection->pointer_focus = nullptr;
+}
+
+void DisplayConnection::pointer_motion(void* data, struct wl_pointer* pointer, uint32_t time,
+                                      wl_fixed_t sx, wl_fixed_t sy) {
+    DisplayConnection* connection = static_cast<DisplayConnection*>(data);
+    BaseWindow* window = connection->pointer_focus;
+    if (!window) return;
+    window->window_data.mouse_x = wl_fixed_to_double(sx);
+    window->window_data.mouse_y = wl_fixed_to_double(sy);
+    window->note_input_time(time);
+}
+
+void DisplayConnection::pointer_button(void* data, struct wl_pointer* pointer, uint32_t serial,
+                                      uint32_t time, uint32_t button, uint32_t state) {
+    DisplayConnection* connection = static_cast<DisplayConnection*>(data);
+    BaseWindow* window = connection->pointer_focus;
+    if (!window) return;
+
+    // Store the serial for interactive operations
+    window->last_button_serial = serial;
+    window->note_input_time(time);
+
+    if (state == 1) { // Button pressed
+        window->window_data.mouse_pressed = true;
+        window->window_data.mouse_held = true;
+        window->window_data.mouse_released = false;
+    } else { // Button released
+        window->window_data.mouse_pressed = false;
+        window->window_data.mouse_held = false;
+        window->window_data.mouse_released = true;
+    }
+}
+
+void DisplayConnection::pointer_axis(void* data, struct wl_pointer* pointer, uint32_t time,
+                                    uint32_t axis, wl_fixed_t value) {
+    DisplayConnection* connection = static_cast<DisplayConnection*>(data);
+    BaseWindow* window = connection->pointer_focus;
+    if (!window || axis != WL_POINTER_AXIS_VERTICAL_SCROLL) return;
+    window->window_data.scroll_y += static_cast<float>(wl_fixed_to_double(value));
+    window->note_input_time(time);
+}
+
+void DisplayConnection::pointer_frame(void* data, struct wl_pointer* pointer) {
+    // Handle pointer frame events (batching)
+}
@@ -0,0 +1,136 @@
+#pragma once
+
+#include "core/frame_scheduler.h"
+#include "viewport/shader_cache.h"
+#include <wayland-client.h>
+#include <wayland-egl.h>
+#include <wayland-cursor.h>
+#include <EGL/egl.h>
+#include <GLES2/gl2.h>
+#include "xdg-shell-client-protocol.h"
+#include "xdg-decoration-unstable-v1-client-protocol.h"
+#include "presentation-time-client-protocol.h"
+#include <cstdint>
+#include <string>
+#include <time.h>
+#include <vector>
+
+class BaseWindow;
+
+// Per-process half of the windowing layer: one Wayland connection with its
+// registry globals and input devices, one EGL display and context, and the
+// GPU caches built in that context. Every BaseWindow is just a surface on top
+// of this, so windows share shaders and buffers, and one event loop drives
+// them all. UI thread only, apart from get_frame_scheduler().request_frame().
+class DisplayConnection {
+private:
+    // Wayland core objects
+    struct wl_display* display;
+    struct wl_registry* registry;
+    struct wl_compositor* compositor;
+    struct xdg_wm_base* xdg_wm_base;
+    struct zxdg_decoration_manager_v1* decoration_manager;
+
+    // Input devices; pointer events go to the window under the pointer
+    struct wl_seat* seat;
+    struct wl_pointer* pointer;
+    BaseWindow* pointer_focus;
+
+    // Cursor support
+    struct wl_shm* shm;
+    struct wl_cursor_theme* cursor_theme;
+    struct wl_cursor* current_cursor;
+    struct wl_surface* cursor_surface;
+
+    // Presentation feedback (wp_presentation): when frames reach the screen
+    struct wp_presentation* presentation;
+    clockid_t presentation_clock;
+
+    // EGL display and the context every window renders with
+    EGLDisplay egl_display;
+    EGLConfig egl_config;
+    EGLContext egl_context;
+
+    // Windows draw on the CPU into wl_shm buffers instead of through EGL:
+    // asked for, or because EGL could not be brought up
+    bool software;
+    bool connected;
+
+    FrameScheduler frame_scheduler;
+    ShaderCache shader_cache;
+    std::vector<BaseWindow*> windows;
+
+    // Redraw at least this often even when nothing asks for a frame
+    static constexpr int IDLE_FRAME_TIMEOUT_MS = 500;
+
+    bool init_wayland();
+    bool init_egl();
+    void release_egl();
+    void cleanup();
+
+    BaseWindow* window_for_surface(struct wl_surface* surface) const;
+    void defer_frame_start();
+
+public:
+    DisplayConnection();
+    ~DisplayConnection();
+
+    DisplayConnection(const DisplayConnection&) = delete;
+    DisplayConnection& operator=(const DisplayConnection&) = delete;
+
+    // Connection used by windows created without an explicit one
+    static DisplayConnection& shared();
+
+    // Connects and creates the EGL context, falling back to software
+    // rendering without one; later calls are no-ops
+    bool connect();
+    bool is_connected() const { return connected; }
+
+    // Skip EGL altogether; only before connect()
+    void set_software_rendering(bool enabled) { software = enabled; }
+    bool is_software() const { return software; }
+
+    void add_window(BaseWindow* window);
+    void remove_window(BaseWindow* window);
+
+    // Frames every open window until all of them are closed
+    void run();
+
+    void wait_for_frame();
+    void process_events();
+    void set_cursor(const std::string& cursor_name);
+    uint64_t presentation_now() const;
+
+    struct wl_display* get_display() const { return display; }
+    struct wl_compositor* get_compositor() const { return compositor; }
+    struct xdg_wm_base* get_xdg_wm_base() const { return xdg_wm_base; }
+    struct zxdg_decoration_manager_v1* get_decoration_manager() const { return decoration_manager; }
+    struct wl_seat* get_seat() const { return seat; }
+    struct wl_shm* get_shm() const { return shm; }
+    struct wp_presentation* get_presentation() const { return presentation; }
+    clockid_t get_presentation_clock() const { return presentation_clock; }
+    EGLDisplay get_egl_display() const { return egl_display; }
+    EGLConfig get_egl_config() const { return egl_config; }
+    EGLContext get_egl_context() const { return egl_context; }
+    FrameScheduler& get_frame_scheduler() { return frame_scheduler; }
+    ShaderCache& get_shader_cache() { return shader_cache; }
+
+    // Wayland callbacks (must be public for C callback access)
+    static void registry_global(void* data, struct wl_registry* registry,
+                               uint32_t name, const char* interface, uint32_t version);
+    static void registry_global_remove(void* data, struct wl_registry* registry, uint32_t name);
+    static void xdg_wm_base_ping(void* data, struct xdg_wm_base* shell, uint32_t serial);
+    static void presentation_clock_id(void* data, struct wp_presentation* presentation, uint32_t clock_id);
+
+    static void pointer_enter(void* data, struct wl_pointer* pointer, uint32_t serial,
+                             struct wl_surface* surface, wl_fixed_t sx, wl_fixed_t sy);
+    static void pointer_leave(void* data, struct wl_pointer* pointer, uint32_t serial,
+                             struct wl_surface* surface);
+    static void pointer_motion(void* data, struct wl_pointer* pointer, uint32_t time,
+                              wl_fixed_t sx, wl_fixed_t sy);
+    static void pointer_button(void* data, struct wl_pointer* pointer, uint32_t serial,
+                              uint32_t time, uint32_t button, uint32_t state);
+    static void pointer_axis(void* data, struct wl_pointer* pointer, uint32_t time,
+                            uint32_t axis, wl_fixed_t value);
+    static void pointer_frame(void* data, struct wl_pointer* pointer);
+};
@@ -0,0 +1,499 @@
+#include "dxf_reader.h"
+#include "core/content_hash.h"
+#include "core/mapped_file.h"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+namespace {
+    constexpr double TWO_PI = 6.283185307179586;
+    constexpr double DEG_TO_RAD = 3.141592653589793 / 180.0;
+    constexpr int MAX_ARC_SEGMENTS = 4096;
+
+    std::string_view trim(std::string_view text) {
+        size_t first = 0;
+        while (first < text.size() && (text[first] == ' ' || text[first] == '\t')) ++first;
+        size_t last = text.size();
+        while (last > first && (text[last - 1] == ' ' || text[last - 1] == '\t' || text[last - 1] == '\r')) --last;
+        return text.substr(first, last - first);
+    }
+
+    double to_double(std::string_view text) {
+        double value = 0.0;
+        std::from_chars(text.data(), text.data() + text.size(), value);
+        return value;
+    }
+
+    int to_int(std::string_view text) {
+        int value = 0;
+        std::from_chars(text.data(), text.data() + text.size(), value);
+        return value;
+    }
+
+    // Millimetres per drawing unit for the $INSUNITS code
+    double units_to_mm(int units) {
+        switch (units) {
+            case 1: return 25.4;
+            case 2: return 304.8;
+            case 5: return 10.0;
+            case 6: return 1000.0;
+            case 8: return 25.4e-6;
+            case 9: return 0.0254;
+            case 10: return 914.4;
+            case 13: return 0.001;
+            case 14: return 100.0;
+            default: return 1.0; // unitless or millimetres
+        }
+    }
+
+    int arc_segments(double radius, double sweep, double tolerance) {
+        sweep = std::fabs(sweep);
+        if (radius <= tolerance || sweep <= 0.0) return 1;
+        double step = 2.0 * std::acos(1.0 - tolerance / radius);
+        int segments = static_cast<int>(std::ceil(sweep / step));
+        return std::clamp(segments, 1, MAX_ARC_SEGMENTS);
+    }
+
+    // Points strictly between the arc's end points are appended; callers add
+    // the ends themselves so shared vertices are not duplicated.
+    void append_arc_interior(PointList& points, double cx, double cy, double radius,
+                             double start, double sweep, double tolerance) {
+        int segments = arc_segments(radius, sweep, tolerance);
+        for (int i = 1; i < segments; ++i) {
+            double angle = start + sweep * i / segments;
+            points.push_back(Vec2{cx + radius * std::cos(angle), cy + radius * std::sin(angle)});
+        }
+    }
+
+    // Polyline arc segment from a to b; bulge = tan(included angle / 4),
+    // positive for counter-clockwise.
+    void append_bulge(PointList& points, const Vec2& a, const Vec2& b, double bulge, double tolerance) {
+        double dx = b.x - a.x, dy = b.y - a.y;
+        double chord = std::hypot(dx, dy);
+        if (chord <= 0.0) return;
+
+        double sweep = 4.0 * std::atan(bulge);
+        double radius = std::fabs(chord / (2.0 * std::sin(sweep / 2.0)));
+        double offset = (1.0 - bulge * bulge) / (4.0 * bulge);
+        double cx = (a.x + b.x) / 2.0 - offset * dy;
+        double cy = (a.y + b.y) / 2.0 + offset * dx;
+        append_arc_interior(points, cx, cy, radius, std::atan2(a.y - cy, a.x - cx), sweep, tolerance);
+    }
+
+    struct Entity {
+        std::string_view type;
+        std::string_view layer;
+        double x0, y0, x1, y1;
+        double radius, ratio;
+        double angle0, angle1;
+        double param0, param1;
+        double bulge;
+        int flags;
+        bool mirrored;
+        std::vector<Vec2> vertices;
+        std::vector<double> bulges;
+
+        // Everything that affects the flattened result
+        uint64_t hash(double scale, double tolerance) const {
+            const double scalars[] = {x0, y0, x1, y1, radius, ratio, angle0, angle1,
+                                      param0, param1, bulge, scale, tolerance};
+            const int32_t bits[] = {flags, mirrored ? 1 : 0};
+            uint64_t h = ContentHash::hash64(type.data(), type.size());
+            h = ContentHash::hash64(layer.data(), layer.size(), h);
+            h = ContentHash::hash64(scalars, sizeof(scalars), h);
+            h = ContentHash::hash64(bits, sizeof(bits), h);
+            h = ContentHash::hash64(vertices.data(), vertices.size() * sizeof(Vec2), h);
+            return ContentHash::hash64(bulges.data(), bulges.size() * sizeof(double), h);
+        }
+
+        void reset(std::string_view entity_type) {
+            type = entity_type;
+            layer = "0";
+            x0 = y0 = x1 = y1 = 0.0;
+            radius = 0.0;
+            ratio = 1.0;
+            angle0 = 0.0;
+            angle1 = 360.0;
+            param0 = 0.0;
+            param1 = TWO_PI;
+            bulge = 0.0;
+            flags = 0;
+            mirrored = false;
+            vertices.clear();
+            bulges.clear();
+        }
+    };
+
+    class EntityBuilder {
+    private:
+        Drawing& drawing;
+        DxfReadStats& stats;
+        double tolerance;
+        double scale;
+        const DxfEntityMemo* previous_memo;
+        DxfEntityMemo* next_memo;
+        size_t previous_hits;
+
+        std::string_view last_layer;
+        uint16_t last_layer_index;
+        bool have_layer;
+
+        uint16_t layer_for(std::string_view name) {
+            if (!have_layer || name != last_layer) {
+                last_layer = name;
+                last_layer_index = drawing.layer_index(std::string(name));
+                have_layer = true;
+            }
+            return last_layer_index;
+        }
+
+        void emit(Contour&& contour, const Entity& entity) {
+            if (contour.closed && contour.points.size() > 2) {
+                const Vec2& first = contour.points.front();
+                const Vec2& last = contour.points.back();
+                if (first.x == last.x && first.y == last.y) contour.points.pop_back();
+            }
+            if (contour.points.size() < 2) return;
+            for (auto& p : contour.points) {
+                // Extrusion (0, 0, -1) mirrors the entity's coordinate system
+                p.x = (entity.mirrored ? -p.x : p.x) * scale;
+                p.y *= scale;
+            }
+            contour.layer = layer_for(entity.layer);
+            contour.update_bounds();
+            stats.points += contour.points.size();
+            drawing.contours.push_back(std::move(contour));
+        }
+
+        // Copies a memoized entity; false if neither memo has it
+        bool reuse(uint64_t key) {
+            const DxfEntityMemo::Entry* entry = nullptr;
+            auto seen = next_memo->entries.find(key);
+            if (seen != next_memo->entries.end()) {
+                entry = seen->second.get();
+            } else if (previous_memo) {
+                auto found = previous_memo->entries.find(key);
+                if (found == previous_memo->entries.end()) return false;
+                next_memo->entries.emplace(key, found->second);
+                entry = found->second.get();
+                previous_hits++;
+            } else {
+                return false;
+            }
+
+            drawing.contours.push_back(entry->contour);
+            drawing.contours.back().layer = layer_for(entry->layer);
+            stats.points += entry->contour.points.size();
+            stats.reused++;
+            return true;
+        }
+
+        void add_polyline(const Entity& entity) {
+            const size_t count = entity.vertices.size();
+            if (count < 2) return;
+
+            Contour contour;
+            contour.closed = (entity.flags & 1) != 0;
+            contour.points.reserve(count);
+            // Bulge tolerance is in drawing units until emit() scales
+            const double local_tolerance = tolerance / scale;
+            for (size_t i = 0; i < count; ++i) {
+                contour.points.push_back(entity.vertices[i]);
+                bool has_next = i + 1 < count || contour.closed;
+                if (has_next && entity.bulges[i] != 0.0) {
+                    append_bulge(contour.points, entity.vertices[i], entity.vertices[(i + 1) % count],
+                                 entity.bulges[i], local_tolerance);
+                }
+            }
+            emit(std::move(contour), entity);
+        }
+
+    public:
+        EntityBuilder(Drawing& out, DxfReadStats& read_stats, double tolerance_mm,
+                      const DxfEntityMemo* previous, DxfEntityMemo* next)
+            : drawing(out), stats(read_stats), tolerance(tolerance_mm), scale(1.0),
+              previous_memo(previous), next_memo(next), previous_hits(0),
+              last_layer_index(0), have_layer(false) {}
+
+        // Previous entities that did not turn up in this read
+        size_t removed_count() const {
+            return previous_memo ? previous_memo->entries.size() - previous_hits : 0;
+        }
+
+        void set_scale(double mm_per_unit) { scale = mm_per_unit; }
+
+        // Polyline vertices arrive as separate VERTEX entities
+        void add_vertex(Entity& polyline, const Entity& vertex) {
+            polyline.vertices.push_back(Vec2{vertex.x0, vertex.y0});
+            polyline.bulges.push_back(vertex.bulge);
+        }
+
+        void finish(const Entity& entity) {
+            uint64_t key = 0;
+            if (next_memo) {
+                key = entity.hash(scale, tolerance);
+                if (reuse(key)) {
+                    stats.entities++;
+                    return;
+                }
+            }
+            const size_t contours_before = drawing.contours.size();
+            flatten(entity);
+            if (next_memo && drawing.contours.size() > contours_before) {
+                next_memo->entries.emplace(key, std::make_shared<const DxfEntityMemo::Entry>(
+                    DxfEntityMemo::Entry{drawing.contours.back(), std::string(entity.layer)}));
+            }
+        }
+
+        void flatten(const Entity& entity) {
+            const double local_tolerance = tolerance / scale;
+            bool supported = true;
+
+            if (entity.type == "LINE") {
+                if (entity.x0 == entity.x1 && entity.y0 == entity.y1) return;
+                Contour contour;
+                contour.points = {Vec2{entity.x0, entity.y0}, Vec2{entity.x1, entity.y1}};
+                emit(std::move(contour), entity);
+            } else if (entity.type == "LWPOLYLINE" || entity.type == "POLYLINE") {
+                add_polyline(entity);
+            } else if (entity.type == "CIRCLE") {
+                if (entity.radius <= 0.0) return;
+                int segments = std::max(3, arc_segments(entity.radius, TWO_PI, local_tolerance));
+                Contour contour;
+                contour.closed = true;
+                contour.points.reserve(segments);
+                for (int i = 0; i < segments; ++i) {
+                    double angle = TWO_PI * i / segments;
+                    contour.points.push_back(Vec2{entity.x0 + entity.radius * std::cos(angle),
+                                                  entity.y0 + entity.radius * std::sin(angle)});
+                }
+                emit(std::move(contour), entity);
+            } else if (entity.type == "ARC") {
+                if (entity.radius <= 0.0) return;
+                double start = entity.angle0 * DEG_TO_RAD;
+                double sweep = entity.angle1 * DEG_TO_RAD - start;
+                while (sweep <= 0.0) sweep += TWO_PI;
+                Contour contour;
+                contour.points.push_back(Vec2{entity.x0 + entity.radius * std::cos(start),
+                                              entity.y0 + entity.radius * std::sin(start)});
+                append_arc_interior(contour.points, entity.x0, entity.y0, entity.radius, start, sweep, local_tolerance);
+                contour.points.push_back(Vec2{entity.x0 + entity.radius * std::cos(start + sweep),
+                                              entity.y0 + entity.radius * std::sin(start + sweep)});
+                emit(std::move(contour), entity);
+            } else if (entity.type == "ELLIPSE") {
+                double major = std::hypot(entity.x1, entity.y1);
+                if (major <= 0.0) return;
+                double minor_x = -entity.y1 * entity.ratio;
+                double minor_y = entity.x1 * entity.ratio;
+                double sweep = entity.param1 - entity.param0;
+                while (sweep <= 0.0) sweep += TWO_PI;
+                bool full = std::fabs(sweep - TWO_PI) < 1e-9;
+
+                int segments = std::max(full ? 3 : 1, arc_segments(major, sweep, local_tolerance));
+                Contour contour;
+                contour.closed = full;
+                int last = full ? segments - 1 : segments;
+                for (int i = 0; i <= last; ++i) {
+                    double t = entity.param0 + sweep * i / segments;
+                    contour.points.push_back(Vec2{entity.x0 + entity.x1 * std::cos(t) + minor_x * std::sin(t),
+                                                  entity.y0 + entity.y1 * std::cos(t) + minor_y * std::sin(t)});
+                }
+                emit(std::move(contour), entity);
+            } else {
+                supported = false;
+            }
+
+            if (supported) stats.entities++;
+            else stats.unsupported++;
+        }
+    };
+}
+
+DxfTokenizer::DxfTokenizer(const char* data, size_t length)
+    : cursor(data), end(data + length), line(0) {
+}
+
+bool DxfTokenizer::next_line(std::string_view& out) {
+    if (cursor >= end) return false;
+    const char* newline = static_cast<const char*>(std::memchr(cursor, '\n', end - cursor));
+    const char* line_end = newline ? newline : end;
+    out = trim(std::string_view(cursor, line_end - cursor));
+    cursor = newline ? newline + 1 : end;
+    line++;
+    return true;
+}
+
+bool DxfTokenizer::next(int& code, std::string_view& value) {
+    std::string_view code_text;
+    if (!next_line(code_text)) return false;
+    auto result = std::from_chars(code_text.data(), code_text.data() + code_text.size(), code);
+    if (result.ec != std::errc() || result.ptr != code_text.data() + code_text.size()) return false;
+    return next_line(value);
+}
+
+DxfReader::DxfReader(const DxfReadSettings& read_settings)
+    : settings(read_settings), previous_memo(nullptr), next_memo(nullptr) {
+}
+
+bool DxfReader::read_file(const std::string& path, Drawing& out) {
+    MappedFile file;
+    if (!file.open(path)) {
+        error_message = "Cannot open " + path;
+        return false;
+    }
+    return parse(file.data(), file.size(), out);
+}
+
+bool DxfReader::parse(const char* data, size_t length, Drawing& out) {
+    stats = DxfReadStats();
+    error_message.clear();
+
+    if (length >= 22 && std::memcmp(data, "AutoCAD Binary DXF", 18) == 0) {
+        error_message = "Binary DXF is not supported";
+        return false;
+    }
+
+    DxfTokenizer tokenizer(data, length);
+    if (next_memo) next_memo->entries.clear();
+    EntityBuilder builder(out, stats, settings.tolerance_mm, next_memo ? previous_memo : nullptr, next_memo);
+
+    enum class Section { NONE, HEADER, ENTITIES, OTHER };
+    Section section = Section::NONE;
+    bool expect_section_name = false;
+    std::string_view header_variable;
+
+    Entity entity;
+    Entity polyline;
+    Entity vertex;
+    bool in_entity = false;
+    bool in_polyline = false;
+    Entity* target = &entity;
+
+    int code;
+    std::string_view value;
+    bool saw_eof = false;
+    while (tokenizer.next(code, value)) {
+        if (expect_section_name) {
+            expect_section_name = false;
+            if (code == 2) {
+                section = value == "HEADER" ? Section::HEADER
+                        : value == "ENTITIES" ? Section::ENTITIES : Section::OTHER;
+            }
+            continue;
+        }
+
+        if (code == 0) {
+            // A new group 0 ends whatever entity was being collected
+            if (in_entity) {
+                if (target == &vertex) {
+                    builder.add_vertex(polyline, vertex);
+                } else if (target == &polyline) {
+                    in_polyline = true;
+                } else {
+                    builder.finish(entity);
+                }
+                in_entity = false;
+            }
+
+            if (value == "SECTION") {
+                expect_section_name = true;
+            } else if (value == "ENDSEC") {
+                section = Section::NONE;
+            } else if (value == "EOF") {
+                saw_eof = true;
+                break;
+            } else if (section == Section::ENTITIES) {
+                if (in_polyline && value == "VERTEX") {
+                    vertex.reset(value);
+                    target = &vertex;
+                } else if (in_polyline && value == "SEQEND") {
+                    builder.finish(polyline);
+                    in_polyline = false;
+                    continue;
+                } else if (value == "POLYLINE") {
+                    polyline.reset(value);
+                    target = &polyline;
+                } else {
+                    if (in_polyline) {
+                        // Missing SEQEND: close out what was collected
+                        builder.finish(polyline);
+                        in_polyline = false;
+                    }
+                    entity.reset(value);
+                    target = &entity;
+                }
+                in_entity = true;
+            }
+            continue;
+        }
+
+        if (section == Section::HEADER) {
+            if (code == 9) {
+                header_variable = value;
+            } else if (code == 70 && header_variable == "$INSUNITS") {
+                builder.set_scale(units_to_mm(to_int(value)));
+            }
+            continue;
+        }
+
+        if (!in_entity) continue;
+
+        Entity& e = *target;
+        const bool lightweight = e.type == "LWPOLYLINE";
+        switch (code) {
+            case 8: e.layer = value; break;
+            case 10:
+                if (lightweight) {
+                    e.vertices.push_back(Vec2{to_double(value), 0.0});
+                    e.bulges.push_back(0.0);
+                } else {
+                    e.x0 = to_double(value);
+                }
+                break;
+            case 20:
+                if (lightweight) {
+                    if (!e.vertices.empty()) e.vertices.back().y = to_double(value);
+                } else {
+                    e.y0 = to_double(value);
+                }
+                break;
+            case 11: e.x1 = to_double(value); break;
+            case 21: e.y1 = to_double(value); break;
+            case 40:
+                e.radius = to_double(value);
+                e.ratio = e.radius;
+                break;
+            case 41: e.param0 = to_double(value); break;
+            case 42:
+                if (lightweight) {
+                    if (!e.bulges.empty()) e.bulges.back() = to_double(value);
+                } else if (target == &vertex) {
+                    e.bulge = to_double(value);
+                } else {
+                    e.param1 = to_double(value);
+                }
+                break;
+            case 50: e.angle0 = to_double(value); break;
+            case 51: e.angle1 = to_double(value); break;
+            case 70: e.flags = to_int(value); break;
+            case 230: e.mirrored = to_double(value) < 0.0; break;
+            default: break;
+        }
+    }
+
+    if (in_entity) {
+        if (target == &entity) builder.finish(entity);
+        else if (target == &vertex) builder.add_vertex(polyline, vertex);
+        else in_polyline = true;
+    }
+    if (in_polyline) builder.finish(polyline);
+    stats.removed = builder.removed_count();
+
+    if (!saw_eof && out.contours.empty()) {
+        error_message = "No DXF entities found (stopped at line " + std::to_string(tokenizer.get_line()) + ")";
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "geometry/contour.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// Splits ASCII DXF text into (group code, value) pairs without copying.
+// Values are trimmed views into the source buffer.
+class DxfTokenizer {
+private:
+    const char* cursor;
+    const char* end;
+    size_t line;
+
+    bool next_line(std::string_view& out);
+
+public:
+    DxfTokenizer(const char* data, size_t length);
+
+    // False at end of input or on a malformed group code
+    bool next(int& code, std::string_view& value);
+    size_t get_line() const { return line; }
+};
+
+struct DxfReadSettings {
+    double tolerance_mm;  // max chord deviation when flattening arcs
+
+    DxfReadSettings() : tolerance_mm(0.01) {}
+};
+
+struct DxfReadStats {
+    size_t entities;
+    size_t unsupported;   // entities skipped (SPLINE, TEXT, INSERT, ...)
+    size_t points;
+    size_t reused;        // with a memo: copied from the previous read
+    size_t removed;       // with a memo: previous entities no longer present
+
+    DxfReadStats() : entities(0), unsupported(0), points(0), reused(0), removed(0) {}
+};
+
+// Flattened entities from one read, keyed by a hash of each entity's parsed
+// fields plus the scale and tolerance used. Handing the previous read's memo
+// to the next read lets it copy unchanged entities instead of flattening
+// them again, so a small edit to a large file costs little more than parsing.
+struct DxfEntityMemo {
+    struct Entry {
+        Contour contour;
+        std::string layer;
+    };
+    // Shared, so carrying an entry over to the next memo copies a pointer
+    std::unordered_map<uint64_t, std::shared_ptr<const Entry>> entries;
+
+    size_t size() const { return entries.size(); }
+};
+
+// Reads the ENTITIES section of an ASCII DXF into flattened contours, one
+// drawing layer per DXF layer. LINE, LWPOLYLINE (with bulges), POLYLINE,
+// CIRCLE, ARC and ELLIPSE are supported; $INSUNITS scales to millimetres.
+class DxfReader {
+private:
+    DxfReadSettings settings;
+    DxfReadStats stats;
+    std::string error_message;
+    const DxfEntityMemo* previous_memo;
+    DxfEntityMemo* next_memo;
+
+public:
+    explicit DxfReader(const DxfReadSettings& read_settings = DxfReadSettings());
+
+    // Reuse entities from previous (may be null) and record this read's
+    // entities in next, which is cleared first and must be a different
+    // memo; a null next turns memoizing off
+    void set_memo(const DxfEntityMemo* previous, DxfEntityMemo* next) {
+        previous_memo = previous;
+        next_memo = next;
+    }
+
+    bool read_file(const std::string& path, Drawing& out);
+    bool parse(const char* data, size_t length, Drawing& out);
+
+    const DxfReadStats& get_stats() const { return stats; }
+    const std::string& get_error() const { return error_message; }
+};
@@ -0,0 +1,460 @@
+#include "batch_kernels.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define BATCH_KERNELS_X86 1
+#endif
+
+namespace BatchKernels {
+
+    namespace {
+        typedef void (*TransformSoaFn)(const Affine2&, double*, double*, size_t);
+        typedef void (*TransformAosFn)(const Affine2&, Vec2*, size_t);
+        typedef Bounds2 (*BoundsSoaFn)(const double*, const double*, size_t);
+        typedef Bounds2 (*BoundsAosFn)(const Affine2*, const Vec2*, size_t);
+        typedef size_t (*ClipFn)(const SegmentBatch&, size_t, const Bounds2&, SegmentBatch&, size_t);
+
+        // --- transform ---
+
+        void transform_soa_tail(const Affine2& m, double* xs, double* ys, size_t start, size_t count) {
+            for (size_t i = start; i < count; ++i) {
+                double x = xs[i], y = ys[i];
+                xs[i] = m.a * x + m.b * y + m.tx;
+                ys[i] = m.c * x + m.d * y + m.ty;
+            }
+        }
+
+        void transform_aos_tail(const Affine2& m, Vec2* points, size_t start, size_t count) {
+            for (size_t i = start; i < count; ++i) points[i] = m.apply(points[i]);
+        }
+
+        void transform_soa_scalar(const Affine2& m, double* xs, double* ys, size_t count) {
+            transform_soa_tail(m, xs, ys, 0, count);
+        }
+
+        void transform_aos_scalar(const Affine2& m, Vec2* points, size_t count) {
+            transform_aos_tail(m, points, 0, count);
+        }
+
+        // --- bounds ---
+
+        Bounds2 bounds_soa_tail(Bounds2 result, const double* xs, const double* ys, size_t start, size_t count) {
+            for (size_t i = start; i < count; ++i) result.expand(xs[i], ys[i]);
+            return result;
+        }
+
+        // m is null for the points as they are
+        Bounds2 bounds_aos_tail(Bounds2 result, const Affine2* m, const Vec2* points, size_t start, size_t count) {
+            for (size_t i = start; i < count; ++i) {
+                Vec2 p = m ? m->apply(points[i]) : points[i];
+                result.expand(p.x, p.y);
+            }
+            return result;
+        }
+
+        Bounds2 bounds_soa_scalar(const double* xs, const double* ys, size_t count) {
+            return bounds_soa_tail(Bounds2(), xs, ys, 0, count);
+        }
+
+        Bounds2 bounds_aos_scalar(const Affine2* m, const Vec2* points, size_t count) {
+            return bounds_aos_tail(Bounds2(), m, points, 0, count);
+        }
+
+        // --- clip ---
+
+        // One Liang-Barsky boundary: p is the direction component facing the
+        // edge, q the distance to it (negative = outside)
+        inline void clip_edge(double p, double q, double& t0, double& t1, bool& reject) {
+            if (p == 0.0) {
+                if (q < 0.0) reject = true;
+                return;
+            }
+            double r = q / p;
+            if (p < 0.0) {
+                t0 = r > t0 ? r : t0;
+            } else {
+                t1 = r < t1 ? r : t1;
+            }
+        }
+
+        // Clips segments [start, count) of in, appending to out from slot
+        // written on; out is already sized to hold all of them
+        size_t clip_tail(const SegmentBatch& in, size_t start, size_t count, const Bounds2& rect,
+                         SegmentBatch& out, size_t written) {
+            for (size_t i = start; i < count; ++i) {
+                const double x0 = in.x0[i], y0 = in.y0[i], x1 = in.x1[i], y1 = in.y1[i];
+                const double dx = x1 - x0, dy = y1 - y0;
+                double t0 = 0.0, t1 = 1.0;
+                bool reject = false;
+                clip_edge(-dx, x0 - rect.min_x, t0, t1, reject);
+                clip_edge(dx, rect.max_x - x0, t0, t1, reject);
+                clip_edge(-dy, y0 - rect.min_y, t0, t1, reject);
+                clip_edge(dy, rect.max_y - y0, t0, t1, reject);
+                if (reject || !(t0 <= t1)) continue;
+
+                out.x0[written] = t0 > 0.0 ? x0 + t0 * dx : x0;
+                out.y0[written] = t0 > 0.0 ? y0 + t0 * dy : y0;
+                out.x1[written] = t1 < 1.0 ? x0 + t1 * dx : x1;
+                out.y1[written] = t1 < 1.0 ? y0 + t1 * dy : y1;
+                out.contour[written] = in.contour[i];
+                ++written;
+            }
+            return written;
+        }
+
+        size_t clip_scalar(const SegmentBatch& in, size_t count, const Bounds2& rect, SegmentBatch& out,
+                           size_t written) {
+            return clip_tail(in, 0, count, rect, out, written);
+        }
+
+#ifdef BATCH_KERNELS_X86
+        void transform_soa_sse2(const Affine2& m, double* xs, double* ys, size_t count) {
+            const __m128d a = _mm_set1_pd(m.a), b = _mm_set1_pd(m.b), c = _mm_set1_pd(m.c), d = _mm_set1_pd(m.d);
+            const __m128d tx = _mm_set1_pd(m.tx), ty = _mm_set1_pd(m.ty);
+            size_t i = 0;
+            for (; i + 2 <= count; i += 2) {
+                __m128d x = _mm_loadu_pd(xs + i), y = _mm_loadu_pd(ys + i);
+                _mm_storeu_pd(xs + i, _mm_add_pd(_mm_add_pd(_mm_mul_pd(a, x), _mm_mul_pd(b, y)), tx));
+                _mm_storeu_pd(ys + i, _mm_add_pd(_mm_add_pd(_mm_mul_pd(c, x), _mm_mul_pd(d, y)), ty));
+            }
+            transform_soa_tail(m, xs, ys, i, count);
+        }
+
+        // One point per register: (x, y) times (a, d) plus (y, x) times
+        // (b, c) gives both outputs; the sums commute, so this matches apply()
+        void transform_aos_sse2(const Affine2& m, Vec2* points, size_t count) {
+            const __m128d diagonal = _mm_set_pd(m.d, m.a), cross = _mm_set_pd(m.c, m.b);
+            const __m128d offset = _mm_set_pd(m.ty, m.tx);
+            for (size_t i = 0; i < count; ++i) {
+                __m128d p = _mm_loadu_pd(&points[i].x);
+                __m128d swapped = _mm_shuffle_pd(p, p, 1);
+                __m128d r = _mm_add_pd(_mm_add_pd(_mm_mul_pd(p, diagonal), _mm_mul_pd(swapped, cross)), offset);
+                _mm_storeu_pd(&points[i].x, r);
+            }
+        }
+
+        Bounds2 bounds_soa_sse2(const double* xs, const double* ys, size_t count) {
+            if (count < 2) return bounds_soa_scalar(xs, ys, count);
+            __m128d min_x = _mm_loadu_pd(xs), max_x = min_x;
+            __m128d min_y = _mm_loadu_pd(ys), max_y = min_y;
+            size_t i = 2;
+            for (; i + 2 <= count; i += 2) {
+                __m128d x = _mm_loadu_pd(xs + i), y = _mm_loadu_pd(ys + i);
+                min_x = _mm_min_pd(x, min_x);
+                max_x = _mm_max_pd(x, max_x);
+                min_y = _mm_min_pd(y, min_y);
+                max_y = _mm_max_pd(y, max_y);
+            }
+            double lo_x[2], hi_x[2], lo_y[2], hi_y[2];
+            _mm_storeu_pd(lo_x, min_x);
+            _mm_storeu_pd(hi_x, max_x);
+            _mm_storeu_pd(lo_y, min_y);
+            _mm_storeu_pd(hi_y, max_y);
+            Bounds2 result;
+            for (int k = 0; k < 2; ++k) {
+                result.expand(lo_x[k], lo_y[k]);
+                result.expand(hi_x[k], hi_y[k]);
+            }
+            return bounds_soa_tail(result, xs, ys, i, count);
+        }
+
+        Bounds2 bounds_aos_sse2(const Affine2* m, const Vec2* points, size_t count) {
+            if (count == 0) return Bounds2();
+            const Affine2 map = m ? *m : Affine2::identity();
+            const __m128d diagonal = _mm_set_pd(map.d, map.a), cross = _mm_set_pd(map.c, map.b);
+            const __m128d offset = _mm_set_pd(map.ty, map.tx);
+            __m128d lo = _mm_set1_pd(1e300), hi = _mm_set1_pd(-1e300);
+            for (size_t i = 0; i < count; ++i) {
+                __m128d p = _mm_loadu_pd(&points[i].x);
+                if (m) {
+                    __m128d swapped = _mm_shuffle_pd(p, p, 1);
+                    p = _mm_add_pd(_mm_add_pd(_mm_mul_pd(p, diagonal), _mm_mul_pd(swapped, cross)), offset);
+                }
+                lo = _mm_min_pd(p, lo);
+                hi = _mm_max_pd(p, hi);
+            }
+            double low[2], high[2];
+            _mm_storeu_pd(low, lo);
+            _mm_storeu_pd(high, hi);
+            Bounds2 result;
+            result.expand(low[0], low[1]);
+            result.expand(high[0], high[1]);
+            return result;
+        }
+
+        // Two segments per step. Each boundary narrows t0 or t1 only in the
+        // lanes facing it; the division in the other lanes (by zero for
+        // parallel segments) is computed but masked out.
+        struct ClipLanes2 {
+            __m128d t0, t1, reject;
+
+            void edge(__m128d p, __m128d q) {
+                const __m128d zero = _mm_setzero_pd();
+                __m128d parallel = _mm_cmpeq_pd(p, zero);
+                reject = _mm_or_pd(reject, _mm_and_pd(parallel, _mm_cmplt_pd(q, zero)));
+                __m128d r = _mm_div_pd(q, p);
+                __m128d entering = _mm_cmplt_pd(p, zero), leaving = _mm_cmpgt_pd(p, zero);
+                __m128d t0_new = _mm_max_pd(r, t0), t1_new = _mm_min_pd(r, t1);
+                t0 = _mm_or_pd(_mm_and_pd(entering, t0_new), _mm_andnot_pd(entering, t0));
+                t1 = _mm_or_pd(_mm_and_pd(leaving, t1_new), _mm_andnot_pd(leaving, t1));
+            }
+        };
+
+        size_t clip_sse2(const SegmentBatch& in, size_t count, const Bounds2& rect, SegmentBatch& out,
+                         size_t written) {
+            const __m128d min_x = _mm_set1_pd(rect.min_x), max_x = _mm_set1_pd(rect.max_x);
+            const __m128d min_y = _mm_set1_pd(rect.min_y), max_y = _mm_set1_pd(rect.max_y);
+            const __m128d zero = _mm_setzero_pd(), one = _mm_set1_pd(1.0);
+            size_t i = 0;
+            for (; i + 2 <= count; i += 2) {
+                __m128d x0 = _mm_loadu_pd(&in.x0[i]), y0 = _mm_loadu_pd(&in.y0[i]);
+                __m128d x1 = _mm_loadu_pd(&in.x1[i]), y1 = _mm_loadu_pd(&in.y1[i]);
+                __m128d dx = _mm_sub_pd(x1, x0), dy = _mm_sub_pd(y1, y0);
+
+                ClipLanes2 lanes{zero, one, _mm_setzero_pd()};
+                lanes.edge(_mm_sub_pd(zero, dx), _mm_sub_pd(x0, min_x));
+                lanes.edge(dx, _mm_sub_pd(max_x, x0));
+                lanes.edge(_mm_sub_pd(zero, dy), _mm_sub_pd(y0, min_y));
+                lanes.edge(dy, _mm_sub_pd(max_y, y0));
+                __m128d accept = _mm_andnot_pd(lanes.reject, _mm_cmple_pd(lanes.t0, lanes.t1));
+                int mask = _mm_movemask_pd(accept);
+                if (mask == 0) continue;
+
+                __m128d moved0 = _mm_cmpgt_pd(lanes.t0, zero), moved1 = _mm_cmplt_pd(lanes.t1, one);
+                __m128d cx0 = _mm_add_pd(x0, _mm_mul_pd(lanes.t0, dx)), cy0 = _mm_add_pd(y0, _mm_mul_pd(lanes.t0, dy));
+                __m128d cx1 = _mm_add_pd(x0, _mm_mul_pd(lanes.t1, dx)), cy1 = _mm_add_pd(y0, _mm_mul_pd(lanes.t1, dy));
+                double ox0[2], oy0[2], ox1[2], oy1[2];
+                _mm_storeu_pd(ox0, _mm_or_pd(_mm_and_pd(moved0, cx0), _mm_andnot_pd(moved0, x0)));
+                _mm_storeu_pd(oy0, _mm_or_pd(_mm_and_pd(moved0, cy0), _mm_andnot_pd(moved0, y0)));
+                _mm_storeu_pd(ox1, _mm_or_pd(_mm_and_pd(moved1, cx1), _mm_andnot_pd(moved1, x1)));
+                _mm_storeu_pd(oy1, _mm_or_pd(_mm_and_pd(moved1, cy1), _mm_andnot_pd(moved1, y1)));
+                for (int k = 0; k < 2; ++k) {
+                    if (!(mask & (1 << k))) continue;
+                    out.x0[written] = ox0[k];
+                    out.y0[written] = oy0[k];
+                    out.x1[written] = ox1[k];
+                    out.y1[written] = oy1[k];
+                    out.contour[written] = in.contour[i + k];
+                    ++written;
+                }
+            }
+            return clip_tail(in, i, count, rect, out, written);
+        }
+
+        __attribute__((target("avx2")))
+        void transform_soa_avx2(const Affine2& m, double* xs, double* ys, size_t count) {
+            const __m256d a = _mm256_set1_pd(m.a), b = _mm256_set1_pd(m.b);
+            const __m256d c = _mm256_set1_pd(m.c), d = _mm256_set1_pd(m.d);
+            const __m256d tx = _mm256_set1_pd(m.tx), ty = _mm256_set1_pd(m.ty);
+            size_t i = 0;
+            for (; i + 4 <= count; i += 4) {
+                __m256d x = _mm256_loadu_pd(xs + i), y = _mm256_loadu_pd(ys + i);
+                _mm256_storeu_pd(xs + i, _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(a, x), _mm256_mul_pd(b, y)), tx));
+                _mm256_storeu_pd(ys + i, _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(c, x), _mm256_mul_pd(d, y)), ty));
+            }
+            transform_soa_tail(m, xs, ys, i, count);
+        }
+
+        // Two points per register, as in the SSE2 version
+        __attribute__((target("avx2")))
+        void transform_aos_avx2(const Affine2& m, Vec2* points, size_t count) {
+            const __m256d diagonal = _mm256_set_pd(m.d, m.a, m.d, m.a), cross = _mm256_set_pd(m.c, m.b, m.c, m.b);
+            const __m256d offset = _mm256_set_pd(m.ty, m.tx, m.ty, m.tx);
+            size_t i = 0;
+            for (; i + 2 <= count; i += 2) {
+                __m256d p = _mm256_loadu_pd(&points[i].x);
+                __m256d swapped = _mm256_permute_pd(p, 0x5);
+                __m256d r = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(p, diagonal), _mm256_mul_pd(swapped, cross)),
+                                          offset);
+                _mm256_storeu_pd(&points[i].x, r);
+            }
+            transform_aos_tail(m, points, i, count);
+        }
+
+        __attribute__((target("avx2")))
+        Bounds2 bounds_soa_avx2(const double* xs, const double* ys, size_t count) {
+            if (count < 4) return bounds_soa_scalar(xs, ys, count);
+            __m256d min_x = _mm256_loadu_pd(xs), max_x = min_x;
+            __m256d min_y = _mm256_loadu_pd(ys), max_y = min_y;
+            size_t i = 4;
+            for (; i + 4 <= count; i += 4) {
+                __m256d x = _mm256_loadu_pd(xs + i), y = _mm256_loadu_pd(ys + i);
+                min_x = _mm256_min_pd(x, min_x);
+                max_x = _mm256_max_pd(x, max_x);
+                min_y = _mm256_min_pd(y, min_y);
+                max_y = _mm256_max_pd(y, max_y);
+            }
+            double lo_x[4], hi_x[4], lo_y[4], hi_y[4];
+            _mm256_storeu_pd(lo_x, min_x);
+            _mm256_storeu_pd(hi_x, max_x);
+            _mm256_storeu_pd(lo_y, min_y);
+            _mm256_storeu_pd(hi_y, max_y);
+            Bounds2 result;
+            for (int k = 0; k < 4; ++k) {
+                result.expand(lo_x[k], lo_y[k]);
+                result.expand(hi_x[k], hi_y[k]);
+            }
+            return bounds_soa_tail(result, xs, ys, i, count);
+        }
+
+        __attribute__((target("avx2")))
+        Bounds2 bounds_aos_avx2(const Affine2* m, const Vec2* points, size_t count) {
+            const Affine2 map = m ? *m : Affine2::identity();
+            const __m256d diagonal = _mm256_set_pd(map.d, map.a, map.d, map.a);
+            const __m256d cross = _mm256_set_pd(map.c, map.b, map.c, map.b);
+            const __m256d offset = _mm256_set_pd(map.ty, map.tx, map.ty, map.tx);
+            __m256d lo = _mm256_set1_pd(1e300), hi = _mm256_set1_pd(-1e300);
+            size_t i = 0;
+            for (; i + 2 <= count; i += 2) {
+                __m256d p = _mm256_loadu_pd(&points[i].x);
+                if (m) {
+                    __m256d swapped = _mm256_permute_pd(p, 0x5);
+                    p = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(p, diagonal), _mm256_mul_pd(swapped, cross)), offset);
+                }
+                lo = _mm256_min_pd(p, lo);
+                hi = _mm256_max_pd(p, hi);
+            }
+            double low[4], high[4];
+            _mm256_storeu_pd(low, lo);
+            _mm256_storeu_pd(high, hi);
+            Bounds2 result;
+            if (i > 0) {
+                for (int k = 0; k < 4; k += 2) {
+                    result.expand(low[k], low[k + 1]);
+                    result.expand(high[k], high[k + 1]);
+                }
+            }
+            return bounds_aos_tail(result, m, points, i, count);
+        }
+
+        struct ClipLanes4 {
+            __m256d t0, t1, reject;
+
+            __attribute__((target("avx2")))
+            void edge(__m256d p, __m256d q) {
+                const __m256d zero = _mm256_setzero_pd();
+                __m256d parallel = _mm256_cmp_pd(p, zero, _CMP_EQ_OQ);
+                reject = _mm256_or_pd(reject, _mm256_and_pd(parallel, _mm256_cmp_pd(q, zero, _CMP_LT_OQ)));
+                __m256d r = _mm256_div_pd(q, p);
+                t0 = _mm256_blendv_pd(t0, _mm256_max_pd(r, t0), _mm256_cmp_pd(p, zero, _CMP_LT_OQ));
+                t1 = _mm256_blendv_pd(t1, _mm256_min_pd(r, t1), _mm256_cmp_pd(p, zero, _CMP_GT_OQ));
+            }
+        };
+
+        __attribute__((target("avx2")))
+        size_t clip_avx2(const SegmentBatch& in, size_t count, const Bounds2& rect, SegmentBatch& out,
+                         size_t written) {
+            const __m256d min_x = _mm256_set1_pd(rect.min_x), max_x = _mm256_set1_pd(rect.max_x);
+            const __m256d min_y = _mm256_set1_pd(rect.min_y), max_y = _mm256_set1_pd(rect.max_y);
+            const __m256d zero = _mm256_setzero_pd(), one = _mm256_set1_pd(1.0);
+            size_t i = 0;
+            for (; i + 4 <= count; i += 4) {
+                __m256d x0 = _mm256_loadu_pd(&in.x0[i]), y0 = _mm256_loadu_pd(&in.y0[i]);
+                __m256d x1 = _mm256_loadu_pd(&in.x1[i]), y1 = _mm256_loadu_pd(&in.y1[i]);
+                __m256d dx = _mm256_sub_pd(x1, x0), dy = _mm256_sub_pd(y1, y0);
+
+                ClipLanes4 lanes{zero, one, _mm256_setzero_pd()};
+                lanes.edge(_mm256_sub_pd(zero, dx), _mm256_sub_pd(x0, min_x));
+                lanes.edge(dx, _mm256_sub_pd(max_x, x0));
+                lanes.edge(_mm256_sub_pd(zero, dy), _mm256_sub_pd(y0, min_y));
+                lanes.edge(dy, _mm256_sub_pd(max_y, y0));
+                __m256d accept = _mm256_andnot_pd(lanes.reject, _mm256_cmp_pd(lanes.t0, lanes.t1, _CMP_LE_OQ));
+                int mask = _mm256_movemask_pd(accept);
+                if (mask == 0) continue;
+
+                __m256d moved0 = _mm256_cmp_pd(lanes.t0, zero, _CMP_GT_OQ);
+                __m256d moved1 = _mm256_cmp_pd(lanes.t1, one, _CMP_LT_OQ);
+                double ox0[4], oy0[4], ox1[4], oy1[4];
+                _mm256_storeu_pd(ox0, _mm256_blendv_pd(x0, _mm256_add_pd(x0, _mm256_mul_pd(lanes.t0, dx)), moved0));
+                _mm256_storeu_pd(oy0, _mm256_blendv_pd(y0, _mm256_add_pd(y0, _mm256_mul_pd(lanes.t0, dy)), moved0));
+                _mm256_storeu_pd(ox1, _mm256_blendv_pd(x1, _mm256_add_pd(x0, _mm256_mul_pd(lanes.t1, dx)), moved1));
+                _mm256_storeu_pd(oy1, _mm256_blendv_pd(y1, _mm256_add_pd(y0, _mm256_mul_pd(lanes.t1, dy)), moved1));
+                for (int k = 0; k < 4; ++k) {
+                    if (!(mask & (1 << k))) continue;
+                    out.x0[written] = ox0[k];
+                    out.y0[written] = oy0[k];
+                    out.x1[written] = ox1[k];
+                    out.y1[written] = oy1[k];
+                    out.contour[written] = in.contour[i + k];
+                    ++written;
+                }
+            }
+            return clip_tail(in, i, count, rect, out, written);
+        }
+#endif
+
+        struct Dispatch {
+            TransformSoaFn transform_soa;
+            TransformAosFn transform_aos;
+            BoundsSoaFn bounds_soa;
+            BoundsAosFn bounds_aos;
+            ClipFn clip;
+            const char* isa;
+
+            Dispatch()
+                : transform_soa(transform_soa_scalar), transform_aos(transform_aos_scalar),
+                  bounds_soa(bounds_soa_scalar), bounds_aos(bounds_aos_scalar), clip(clip_scalar), isa("scalar") {
+#ifdef BATCH_KERNELS_X86
+                __builtin_cpu_init();
+                if (__builtin_cpu_supports("avx2")) {
+                    transform_soa = transform_soa_avx2;
+                    transform_aos = transform_aos_avx2;
+                    bounds_soa = bounds_soa_avx2;
+                    bounds_aos = bounds_aos_avx2;
+                    clip = clip_avx2;
+                    isa = "avx2";
+                } else if (__builtin_cpu_supports("sse2")) {
+                    transform_soa = transform_soa_sse2;
+                    transform_aos = transform_aos_sse2;
+                    bounds_soa = bounds_soa_sse2;
+                    bounds_aos = bounds_aos_sse2;
+                    clip = clip_sse2;
+                    isa = "sse2";
+                }
+#endif
+            }
+        };
+
+        const Dispatch& dispatch() {
+            static const Dispatch instance;
+            return instance;
+        }
+    }
+
+    void transform(const Affine2& m, double* xs, double* ys, size_t count) {
+        dispatch().transform_soa(m, xs, ys, count);
+    }
+
+    void transform(const Affine2& m, Vec2* points, size_t count) {
+        dispatch().transform_aos(m, points, count);
+    }
+
+    void transform(const Affine2& m, SegmentBatch& batch) {
+        dispatch().transform_soa(m, batch.x0.data(), batch.y0.data(), batch.size());
+        dispatch().transform_soa(m, batch.x1.data(), batch.y1.data(), batch.size());
+    }
+
+    Bounds2 bounds(const double* xs, const double* ys, size_t count) {
+        return dispatch().bounds_soa(xs, ys, count);
+    }
+
+    Bounds2 bounds(const Vec2* points, size_t count) {
+        return dispatch().bounds_aos(nullptr, points, count);
+    }
+
+    Bounds2 transformed_bounds(const Affine2& m, const Vec2* points, size_t count) {
+        return dispatch().bounds_aos(&m, points, count);
+    }
+
+    size_t clip(const SegmentBatch& in, const Bounds2& rect, SegmentBatch& out) {
+        const size_t first = out.size();
+        out.resize(first + in.size());
+        const size_t end = dispatch().clip(in, in.size(), rect, out, first);
+        out.resize(end);
+        return end - first;
+    }
+
+    const char* active_isa() {
+        return dispatch().isa;
+    }
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "segment_batch.h"
+#include <cstddef>
+
+// Bulk transform, bounds and clipping over geometry arrays, with AVX2, SSE2
+// and scalar variants; the best one for the running CPU is picked on first
+// use. Every variant evaluates the same expressions (no FMA contraction), so
+// results match bit for bit across machines.
+namespace BatchKernels {
+    // In place, structure of arrays
+    void transform(const Affine2& m, double* xs, double* ys, size_t count);
+    // In place, interleaved points
+    void transform(const Affine2& m, Vec2* points, size_t count);
+    // Both ends of every segment
+    void transform(const Affine2& m, SegmentBatch& batch);
+
+    Bounds2 bounds(const double* xs, const double* ys, size_t count);
+    Bounds2 bounds(const Vec2* points, size_t count);
+    // Bounds of the transformed points, without writing them anywhere
+    Bounds2 transformed_bounds(const Affine2& m, const Vec2* points, size_t count);
+
+    // Liang-Barsky: appends the part of each segment inside rect (edges
+    // included) to out, with its contour index; segments entirely outside
+    // are dropped. Ends already inside come through unchanged. Returns the
+    // number of segments appended.
+    size_t clip(const SegmentBatch& in, const Bounds2& rect, SegmentBatch& out);
+
+    const char* active_isa();
+}
@@ -0,0 +1,105 @@
+#include "containment.h"
+#include "spatial_grid.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    double abs_area(const Contour& contour) {
+        const auto& pts = contour.points;
+        const size_t n = pts.size();
+        if (n < 3) return 0.0;
+        double twice = 0.0;
+        for (size_t i = 1; i + 1 < n; ++i) {
+            twice += (pts[i].x - pts[0].x) * (pts[i + 1].y - pts[0].y) -
+                     (pts[i].y - pts[0].y) * (pts[i + 1].x - pts[0].x);
+        }
+        return std::fabs(twice) * 0.5;
+    }
+}
+
+std::vector<uint8_t> ContainmentTree::hole_flags() const {
+    std::vector<uint8_t> flags(depth.size());
+    for (size_t i = 0; i < depth.size(); ++i) {
+        flags[i] = static_cast<uint8_t>(depth[i] & 1);
+    }
+    return flags;
+}
+
+namespace Containment {
+
+    bool contains_point(const Contour& contour, double x, double y) {
+        const auto& pts = contour.points;
+        const size_t n = pts.size();
+        bool inside = false;
+        for (size_t i = 0, j = n - 1; i < n; j = i++) {
+            const Vec2& a = pts[i];
+            const Vec2& b = pts[j];
+            if ((a.y > y) != (b.y > y) && x < a.x + (y - a.y) * (b.x - a.x) / (b.y - a.y)) {
+                inside = !inside;
+            }
+        }
+        return inside;
+    }
+
+    ContainmentTree build(const Drawing& drawing, ThreadPool& pool) {
+        const size_t count = drawing.contours.size();
+        ContainmentTree tree;
+        tree.parent.assign(count, ContainmentTree::NO_PARENT);
+        tree.depth.assign(count, 0);
+        if (count == 0) return tree;
+
+        // Only closed contours with some area can enclose anything
+        std::vector<uint32_t> closed;
+        std::vector<Bounds2> boxes;
+        std::vector<double> areas(count, 0.0);
+        for (uint32_t i = 0; i < count; ++i) {
+            const Contour& contour = drawing.contours[i];
+            if (!contour.closed || contour.points.size() < 3) continue;
+            areas[i] = abs_area(contour);
+            if (areas[i] <= 0.0) continue;
+            closed.push_back(i);
+            boxes.push_back(contour.bounds);
+        }
+
+        SpatialGrid grid;
+        grid.build(boxes);
+
+        pool.parallel_for(count, [&](size_t i) {
+            const Contour& contour = drawing.contours[i];
+            if (contour.points.empty()) return;
+
+            std::vector<uint32_t> candidates;
+            grid.query(contour.bounds, [&](uint32_t id) {
+                uint32_t other = closed[id];
+                if (other != i && areas[other] > areas[i] && boxes[id].contains(contour.bounds)) {
+                    candidates.push_back(other);
+                }
+            });
+            if (candidates.empty()) return;
+
+            // The smallest enclosing contour is the direct parent
+            std::sort(candidates.begin(), candidates.end(),
+                      [&](uint32_t a, uint32_t b) { return areas[a] < areas[b]; });
+            const Vec2& probe = contour.points.front();
+            for (uint32_t other : candidates) {
+                if (contains_point(drawing.contours[other], probe.x, probe.y)) {
+                    tree.parent[i] = other;
+                    break;
+                }
+            }
+        });
+
+        // A parent always has the larger area, so walking by decreasing area
+        // sees every parent before its children
+        std::vector<uint32_t> by_area(count);
+        for (uint32_t i = 0; i < count; ++i) by_area[i] = i;
+        std::sort(by_area.begin(), by_area.end(),
+                  [&](uint32_t a, uint32_t b) { return areas[a] > areas[b]; });
+        for (uint32_t i : by_area) {
+            uint32_t p = tree.parent[i];
+            if (p != ContainmentTree::NO_PARENT) tree.depth[i] = tree.depth[p] + 1;
+        }
+        return tree;
+    }
+
+}
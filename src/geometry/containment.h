@@ -0,0 +1,33 @@
+#pragma once
+
+#include "contour.h"
+#include "core/thread_pool.h"
+#include <cstdint>
+#include <vector>
+
+// Nesting of a drawing's contours. parent[i] is the smallest closed contour
+// that encloses contour i, or NO_PARENT at the top level; open contours can
+// have a parent but never are one. Depth 0 is an outline, 1 a hole in it,
+// 2 a part inside that hole, and so on.
+struct ContainmentTree {
+    static constexpr uint32_t NO_PARENT = UINT32_MAX;
+
+    std::vector<uint32_t> parent;
+    std::vector<uint32_t> depth;
+
+    size_t size() const { return parent.size(); }
+    bool is_hole(uint32_t contour) const { return (depth[contour] & 1) != 0; }
+
+    // Per-contour hole flags in the form KerfCompensator::apply takes
+    std::vector<uint8_t> hole_flags() const;
+};
+
+namespace Containment {
+    // Even-odd point-in-polygon test against a closed contour
+    bool contains_point(const Contour& contour, double x, double y);
+
+    // Candidates come from a spatial grid over the closed contours' bounds
+    // and are tried smallest first, so each contour needs point tests only
+    // until its direct parent is found. Contours are processed in parallel.
+    ContainmentTree build(const Drawing& drawing, ThreadPool& pool = ThreadPool::shared());
+}
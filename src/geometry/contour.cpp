@@ -0,0 +1,25 @@
+#include "contour.h"
+
+uint16_t Drawing::layer_index(const std::string& name) {
+    for (size_t i = 0; i < layers.size(); ++i) {
+        if (layers[i] == name) return static_cast<uint16_t>(i);
+    }
+    layers.push_back(name);
+    return static_cast<uint16_t>(layers.size() - 1);
+}
+
+Bounds2 Drawing::bounds() const {
+    Bounds2 result;
+    for (const auto& contour : contours) {
+        result.expand(contour.bounds);
+    }
+    return result;
+}
+
+size_t Drawing::point_count() const {
+    size_t count = 0;
+    for (const auto& contour : contours) {
+        count += contour.points.size();
+    }
+    return count;
+}
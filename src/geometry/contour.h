@@ -0,0 +1,70 @@
+#pragma once
+
+#include "core/memory_accounting.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct Vec2 {
+    double x, y;
+};
+
+struct Bounds2 {
+    double min_x, min_y, max_x, max_y;
+
+    Bounds2() : min_x(1e300), min_y(1e300), max_x(-1e300), max_y(-1e300) {}
+
+    bool valid() const { return min_x <= max_x; }
+
+    void expand(double x, double y) {
+        if (x < min_x) min_x = x;
+        if (y < min_y) min_y = y;
+        if (x > max_x) max_x = x;
+        if (y > max_y) max_y = y;
+    }
+
+    void expand(const Bounds2& other) {
+        if (!other.valid()) return;
+        expand(other.min_x, other.min_y);
+        expand(other.max_x, other.max_y);
+    }
+
+    bool overlaps(const Bounds2& other) const {
+        return min_x <= other.max_x && other.min_x <= max_x &&
+               min_y <= other.max_y && other.min_y <= max_y;
+    }
+
+    bool contains(const Bounds2& other) const {
+        return min_x <= other.min_x && min_y <= other.min_y &&
+               max_x >= other.max_x && max_y >= other.max_y;
+    }
+};
+
+typedef TrackedVector<Vec2, MemoryTag::DRAWING> PointList;
+
+// Flattened 2D polyline in millimetres. Closed contours do not repeat the
+// first point at the end.
+struct Contour {
+    PointList points;
+    bool closed;
+    uint16_t layer;
+    Bounds2 bounds;
+
+    Contour() : closed(false), layer(0) {}
+
+    void update_bounds() {
+        bounds = Bounds2();
+        for (const auto& p : points) bounds.expand(p.x, p.y);
+    }
+};
+
+// Common 2D input to the toolpath pipeline, whatever it was loaded from
+// (DXF entities, STEP sections, ...).
+struct Drawing {
+    std::vector<std::string> layers;
+    TrackedVector<Contour, MemoryTag::DRAWING> contours;
+
+    uint16_t layer_index(const std::string& name);
+    Bounds2 bounds() const;
+    size_t point_count() const;
+};
@@ -0,0 +1,121 @@
+#include "edit_history.h"
+#include "batch_kernels.h"
+#include <algorithm>
+
+EditHistory::EditHistory(size_t step_limit) : max_steps(std::max<size_t>(step_limit, 1)) {
+}
+
+void EditHistory::reset(const Drawing& drawing, double kerf_mm) {
+    std::vector<DrawingEntity> entities(drawing.contours.size());
+    std::vector<uint32_t> order(drawing.contours.size());
+    for (size_t i = 0; i < drawing.contours.size(); ++i) {
+        entities[i].contour = std::allocate_shared<Contour>(TrackedAllocator<Contour, MemoryTag::DRAWING>(),
+                                                            drawing.contours[i]);
+        order[i] = static_cast<uint32_t>(i);
+    }
+
+    current = DrawingState();
+    current.layers = std::make_shared<const std::vector<std::string>>(drawing.layers);
+    current.entities = EntityVector::from(entities);
+    current.order = OrderVector::from(order);
+    current.kerf_mm = kerf_mm;
+    undo_steps.clear();
+    redo_steps.clear();
+}
+
+void EditHistory::commit(DrawingState&& next, const char* label) {
+    if (undo_steps.size() == max_steps) undo_steps.erase(undo_steps.begin());
+    undo_steps.push_back(Step{std::move(current), label});
+    redo_steps.clear();
+    current = std::move(next);
+}
+
+std::vector<uint32_t> EditHistory::normalize(std::vector<uint32_t> ids) const {
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+    ids.erase(std::lower_bound(ids.begin(), ids.end(), current.entities.size()), ids.end());
+    return ids;
+}
+
+void EditHistory::move(std::vector<uint32_t> ids, double dx, double dy) {
+    ids = normalize(std::move(ids));
+    if (ids.empty()) return;
+    DrawingState next = current;
+    next.entities = current.entities.update(ids, [dx, dy](DrawingEntity& entity) {
+        entity.offset.x += dx;
+        entity.offset.y += dy;
+    });
+    commit(std::move(next), "move");
+}
+
+void EditHistory::remove(std::vector<uint32_t> ids) {
+    ids = normalize(std::move(ids));
+    if (ids.empty()) return;
+    DrawingState next = current;
+    next.entities = current.entities.update(ids, [](DrawingEntity& entity) { entity.deleted = true; });
+    commit(std::move(next), "delete");
+}
+
+void EditHistory::set_kerf(double kerf_mm) {
+    if (kerf_mm == current.kerf_mm) return;
+    DrawingState next = current;
+    next.kerf_mm = kerf_mm;
+    commit(std::move(next), "kerf");
+}
+
+void EditHistory::reorder(uint32_t from, uint32_t to) {
+    const size_t n = current.order.size();
+    if (from == to || from >= n || to >= n) return;
+
+    // Rotate the positions between the two by one
+    uint32_t first = std::min(from, to), last = std::max(from, to);
+    std::vector<uint32_t> positions, ids;
+    for (uint32_t p = first; p <= last; ++p) {
+        positions.push_back(p);
+        ids.push_back(current.order[p]);
+    }
+    if (from < to) {
+        std::rotate(ids.begin(), ids.begin() + 1, ids.end());
+    } else {
+        std::rotate(ids.begin(), ids.end() - 1, ids.end());
+    }
+
+    // update() visits slots in ascending order
+    size_t next_id = 0;
+    DrawingState next = current;
+    next.order = current.order.update(positions, [&](uint32_t& id) { id = ids[next_id++]; });
+    commit(std::move(next), "reorder");
+}
+
+bool EditHistory::undo() {
+    if (undo_steps.empty()) return false;
+    redo_steps.push_back(Step{std::move(current), undo_steps.back().label});
+    current = std::move(undo_steps.back().state);
+    undo_steps.pop_back();
+    return true;
+}
+
+bool EditHistory::redo() {
+    if (redo_steps.empty()) return false;
+    undo_steps.push_back(Step{std::move(current), redo_steps.back().label});
+    current = std::move(redo_steps.back().state);
+    redo_steps.pop_back();
+    return true;
+}
+
+Drawing EditHistory::to_drawing() const {
+    Drawing drawing;
+    if (current.layers) drawing.layers = *current.layers;
+    current.order.for_each([&](uint32_t id) {
+        const DrawingEntity& entity = current.entities[id];
+        if (entity.deleted || !entity.contour) return;
+        drawing.contours.push_back(*entity.contour);
+        if (entity.offset.x != 0.0 || entity.offset.y != 0.0) {
+            Contour& contour = drawing.contours.back();
+            BatchKernels::transform(Affine2::translation(entity.offset.x, entity.offset.y), contour.points.data(),
+                                    contour.points.size());
+            contour.bounds = BatchKernels::bounds(contour.points.data(), contour.points.size());
+        }
+    });
+    return drawing;
+}
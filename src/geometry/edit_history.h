@@ -0,0 +1,82 @@
+#pragma once
+
+#include "contour.h"
+#include "core/persistent_vector.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// One drawn entity. Geometry is shared and never edited in place; a move
+// only changes the offset, so it costs the same for a 4-point square as for
+// a 10k-point spline.
+struct DrawingEntity {
+    std::shared_ptr<const Contour> contour;
+    Vec2 offset;
+    bool deleted;   // tombstone: ids stay stable, so redo never renumbers
+
+    DrawingEntity() : offset{0.0, 0.0}, deleted(false) {}
+};
+
+typedef PersistentVector<DrawingEntity, MemoryTag::DRAWING> EntityVector;
+typedef PersistentVector<uint32_t, MemoryTag::DRAWING> OrderVector;
+
+// A complete version of the document. Copying one is O(1): both vectors
+// share their chunks with every other version still alive.
+struct DrawingState {
+    std::shared_ptr<const std::vector<std::string>> layers;
+    EntityVector entities;   // by entity id
+    OrderVector order;       // cut order, as entity ids
+    double kerf_mm;
+
+    DrawingState() : kerf_mm(0.15) {}
+};
+
+// Undo/redo over DrawingState versions. Each step keeps the version before
+// the edit; since versions share everything the edit did not touch, a step
+// costs memory for what changed only, and undo/redo just swap versions.
+class EditHistory {
+private:
+    struct Step {
+        DrawingState state;
+        const char* label;
+    };
+
+    DrawingState current;
+    std::vector<Step> undo_steps;
+    std::vector<Step> redo_steps;
+    size_t max_steps;
+
+    void commit(DrawingState&& next, const char* label);
+    // Sorted, unique, in range; ids past the end are dropped
+    std::vector<uint32_t> normalize(std::vector<uint32_t> ids) const;
+
+public:
+    explicit EditHistory(size_t step_limit = 256);
+
+    // Starts a new document; clears both stacks
+    void reset(const Drawing& drawing, double kerf_mm = 0.15);
+
+    const DrawingState& state() const { return current; }
+    size_t entity_count() const { return current.entities.size(); }
+
+    // Edits, each one undo step. Ids index the entities as loaded.
+    void move(std::vector<uint32_t> ids, double dx, double dy);
+    void remove(std::vector<uint32_t> ids);
+    void set_kerf(double kerf_mm);
+    // Moves the entity cut at order position from to position to; touches
+    // only the positions in between
+    void reorder(uint32_t from, uint32_t to);
+
+    bool undo();
+    bool redo();
+    bool can_undo() const { return !undo_steps.empty(); }
+    bool can_redo() const { return !redo_steps.empty(); }
+    const char* undo_label() const { return undo_steps.empty() ? "" : undo_steps.back().label; }
+    const char* redo_label() const { return redo_steps.empty() ? "" : redo_steps.back().label; }
+
+    // Live entities in cut order with offsets applied, for the toolpath
+    // pipeline (O(size); call once per job, not per edit)
+    Drawing to_drawing() const;
+};
@@ -0,0 +1,446 @@
+#include "geometry_cache.h"
+#include "containment.h"
+#include "polyline_simplify.h"
+#include "core/content_hash.h"
+#include "core/thread_pool.h"
+#include "core/trace.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <type_traits>
+#include <unistd.h>
+
+using namespace GeometryCacheFormat;
+
+static_assert(std::is_trivially_copyable_v<Vec2> && sizeof(Vec2) == 16, "Vec2 is stored raw");
+static_assert(std::is_trivially_copyable_v<Bounds2> && sizeof(Bounds2) == 32, "Bounds2 is stored raw");
+static_assert(sizeof(ContourRecord) == 48, "ContourRecord layout changed; bump VERSION");
+static_assert(sizeof(LodRange) == 8, "LodRange layout changed; bump VERSION");
+static_assert(sizeof(Header) % 8 == 0, "Header must keep sections 8-byte aligned");
+
+namespace {
+    size_t align_up(size_t value) {
+        return (value + SECTION_ALIGN - 1) & ~(SECTION_ALIGN - 1);
+    }
+
+    // Collects sections into one contiguous image in the on-disk layout
+    class ImageWriter {
+    private:
+        std::vector<char> image;
+        Header header;
+
+    public:
+        ImageWriter() : image(align_up(sizeof(Header)), 0) {
+            std::memset(static_cast<void*>(&header), 0, sizeof(header));
+        }
+
+        Header& get_header() { return header; }
+
+        void add(Section s, const void* data, size_t bytes) {
+            size_t offset = align_up(image.size());
+            image.resize(offset + bytes, 0);
+            if (bytes > 0) std::memcpy(image.data() + offset, data, bytes);
+            header.sections[s].offset = offset;
+            header.sections[s].bytes = bytes;
+        }
+
+        std::vector<char> finish() {
+            image.resize(align_up(image.size()), 0);
+            std::memcpy(image.data(), &header, sizeof(header));
+            return std::move(image);
+        }
+    };
+
+    std::vector<char> build_image(const GeometryKey& key, const Drawing& drawing) {
+        ImageWriter writer;
+        Header& header = writer.get_header();
+        std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.version = VERSION;
+        header.header_bytes = sizeof(Header);
+        header.byte_order = BYTE_ORDER_MARK;
+        header.content_hash = key.content_hash;
+        header.tolerance_mm = key.tolerance_mm;
+
+        std::string names;
+        for (const auto& layer : drawing.layers) {
+            names += layer;
+            names.push_back('\0');
+        }
+        header.layer_count = static_cast<uint32_t>(drawing.layers.size());
+        writer.add(LAYER_NAMES, names.data(), names.size());
+
+        std::vector<ContourRecord> records(drawing.contours.size());
+        std::vector<Bounds2> boxes(drawing.contours.size());
+        std::vector<Vec2> points;
+        points.reserve(drawing.point_count());
+        for (size_t i = 0; i < drawing.contours.size(); ++i) {
+            const Contour& contour = drawing.contours[i];
+            ContourRecord& record = records[i];
+            std::memset(static_cast<void*>(&record), 0, sizeof(record));
+            record.first_point = points.size();
+            record.point_count = static_cast<uint32_t>(contour.points.size());
+            record.layer = contour.layer;
+            record.closed = contour.closed ? 1 : 0;
+            record.bounds = contour.bounds;
+            boxes[i] = contour.bounds;
+            points.insert(points.end(), contour.points.begin(), contour.points.end());
+        }
+        header.contour_count = records.size();
+        header.point_count = points.size();
+        writer.add(CONTOURS, records.data(), records.size() * sizeof(ContourRecord));
+        writer.add(POINTS, points.data(), points.size() * sizeof(Vec2));
+
+        std::vector<float> vertices(points.size() * 2);
+        for (size_t i = 0; i < points.size(); ++i) {
+            vertices[i * 2] = static_cast<float>(points[i].x);
+            vertices[i * 2 + 1] = static_cast<float>(points[i].y);
+        }
+        writer.add(VERTICES, vertices.data(), vertices.size() * sizeof(float));
+
+        // Level 0 ranges point into VERTICES; coarser levels are simplified
+        // from the full points, not from each other, so errors do not add up
+        std::vector<LodRange> lod_ranges(LOD_LEVELS * records.size());
+        for (size_t i = 0; i < records.size(); ++i) {
+            lod_ranges[i].first_vertex = static_cast<uint32_t>(records[i].first_point);
+            lod_ranges[i].vertex_count = records[i].point_count;
+        }
+        std::vector<float> lod_vertices;
+        for (uint32_t level = 1; level < LOD_LEVELS; ++level) {
+            Drawing coarse = PolylineSimplify::simplify(drawing, LOD_TOLERANCE_MM[level]);
+            LodRange* ranges = lod_ranges.data() + level * records.size();
+            for (size_t i = 0; i < coarse.contours.size(); ++i) {
+                ranges[i].first_vertex = static_cast<uint32_t>(lod_vertices.size() / 2);
+                ranges[i].vertex_count = static_cast<uint32_t>(coarse.contours[i].points.size());
+                for (const Vec2& p : coarse.contours[i].points) {
+                    lod_vertices.push_back(static_cast<float>(p.x));
+                    lod_vertices.push_back(static_cast<float>(p.y));
+                }
+            }
+        }
+        header.lod_vertex_count = lod_vertices.size() / 2;
+        writer.add(LOD_RANGES, lod_ranges.data(), lod_ranges.size() * sizeof(LodRange));
+        writer.add(LOD_VERTICES, lod_vertices.data(), lod_vertices.size() * sizeof(float));
+
+        SpatialGrid grid;
+        grid.build(boxes);
+        header.grid_extent = grid.get_extent();
+        header.grid_cell_size = grid.get_cell_size();
+        header.grid_cols = grid.get_cols();
+        header.grid_rows = grid.get_rows();
+        writer.add(GRID_BOXES, boxes.data(), boxes.size() * sizeof(Bounds2));
+        writer.add(GRID_CELL_START, grid.get_cell_start().data(), grid.get_cell_start().size() * sizeof(uint32_t));
+        writer.add(GRID_CELL_ITEMS, grid.get_cell_items().data(), grid.get_cell_items().size() * sizeof(uint32_t));
+
+        ContainmentTree nesting = Containment::build(drawing);
+        PathOrder order = PathOrdering::nearest_neighbour(drawing, 0.0, 0.0, &nesting);
+        header.order_count = order.size();
+        writer.add(ORDER, order.order.data(), order.order.size() * sizeof(uint32_t));
+        writer.add(ORDER_REVERSED, order.reversed.data(), order.reversed.size());
+
+        return writer.finish();
+    }
+
+    // Numbers temp files, so two writers of the same entry in one process
+    // (persist_async tasks for a file saved A, B, A quickly) never share one
+    std::atomic<uint64_t> temp_serial{0};
+
+    bool write_atomically(const std::string& path, const std::vector<char>& image) {
+        std::string temp_path = path + ".tmp." + std::to_string(getpid()) + "." + std::to_string(++temp_serial);
+        {
+            std::ofstream out(temp_path, std::ios::binary | std::ios::trunc);
+            if (!out) return false;
+            out.write(image.data(), static_cast<std::streamsize>(image.size()));
+            if (!out) {
+                out.close();
+                std::remove(temp_path.c_str());
+                return false;
+            }
+        }
+        if (std::rename(temp_path.c_str(), path.c_str()) != 0) {
+            std::remove(temp_path.c_str());
+            return false;
+        }
+        return true;
+    }
+}
+
+CachedGeometry::CachedGeometry() : base(nullptr), length(0), header(nullptr) {
+}
+
+CachedGeometry::CachedGeometry(CachedGeometry&& other) noexcept
+    : file(std::move(other.file)), buffer(std::move(other.buffer)),
+      base(other.base), length(other.length), header(other.header) {
+    other.base = nullptr;
+    other.length = 0;
+    other.header = nullptr;
+}
+
+CachedGeometry& CachedGeometry::operator=(CachedGeometry&& other) noexcept {
+    if (this != &other) {
+        file = std::move(other.file);
+        buffer = std::move(other.buffer);
+        base = other.base;
+        length = other.length;
+        header = other.header;
+        other.base = nullptr;
+        other.length = 0;
+        other.header = nullptr;
+    }
+    return *this;
+}
+
+bool CachedGeometry::attach(const char* data, size_t size, const GeometryKey& key) {
+    header = nullptr;
+    if (!data || size < sizeof(Header)) return false;
+
+    const Header* h = reinterpret_cast<const Header*>(data);
+    if (std::memcmp(h->magic, MAGIC, sizeof(MAGIC)) != 0 || h->version != VERSION ||
+        h->header_bytes != sizeof(Header) || h->byte_order != BYTE_ORDER_MARK) {
+        return false;
+    }
+    if (h->content_hash != key.content_hash || h->tolerance_mm != key.tolerance_mm) return false;
+
+    for (uint32_t s = 0; s < SECTION_COUNT; ++s) {
+        const SectionEntry& entry = h->sections[s];
+        if (entry.offset % SECTION_ALIGN != 0 || entry.offset > size || entry.bytes > size - entry.offset) {
+            return false;
+        }
+    }
+
+    // Sizes must agree with the counts before anything indexes into them
+    const uint64_t cells = static_cast<uint64_t>(std::max(h->grid_cols, 0)) * std::max(h->grid_rows, 0);
+    if (h->sections[CONTOURS].bytes != h->contour_count * sizeof(ContourRecord) ||
+        h->sections[POINTS].bytes != h->point_count * sizeof(Vec2) ||
+        h->sections[VERTICES].bytes != h->point_count * 2 * sizeof(float) ||
+        h->sections[GRID_BOXES].bytes != h->contour_count * sizeof(Bounds2) ||
+        h->sections[ORDER].bytes != h->order_count * sizeof(uint32_t) ||
+        h->sections[ORDER_REVERSED].bytes != h->order_count ||
+        h->sections[LOD_RANGES].bytes != LOD_LEVELS * h->contour_count * sizeof(LodRange) ||
+        h->sections[LOD_VERTICES].bytes != h->lod_vertex_count * 2 * sizeof(float) ||
+        (h->contour_count > 0 && h->sections[GRID_CELL_START].bytes != (cells + 1) * sizeof(uint32_t)) ||
+        h->sections[GRID_CELL_ITEMS].bytes % sizeof(uint32_t) != 0) {
+        return false;
+    }
+
+    // Every index the readers follow must land inside its array
+    const char* names = data + h->sections[LAYER_NAMES].offset;
+    if (static_cast<uint64_t>(std::count(names, names + h->sections[LAYER_NAMES].bytes, '\0')) < h->layer_count) {
+        return false;
+    }
+    const ContourRecord* records = reinterpret_cast<const ContourRecord*>(data + h->sections[CONTOURS].offset);
+    for (uint64_t i = 0; i < h->contour_count; ++i) {
+        if (records[i].first_point + records[i].point_count > h->point_count) return false;
+        if (records[i].layer >= h->layer_count) return false;
+    }
+    const uint32_t* order = reinterpret_cast<const uint32_t*>(data + h->sections[ORDER].offset);
+    for (uint64_t i = 0; i < h->order_count; ++i) {
+        if (order[i] >= h->contour_count) return false;
+    }
+    if (h->contour_count > 0) {
+        const Bounds2& extent = h->grid_extent;
+        if (h->grid_cols <= 0 || h->grid_rows <= 0 || !(h->grid_cell_size > 0.0) || !std::isfinite(h->grid_cell_size) ||
+            !std::isfinite(extent.min_x) || !std::isfinite(extent.min_y)) {
+            return false;
+        }
+        const uint64_t item_count = h->sections[GRID_CELL_ITEMS].bytes / sizeof(uint32_t);
+        const uint32_t* cell_start = reinterpret_cast<const uint32_t*>(data + h->sections[GRID_CELL_START].offset);
+        if (cell_start[0] != 0 || cell_start[cells] > item_count) return false;
+        for (uint64_t c = 0; c < cells; ++c) {
+            if (cell_start[c] > cell_start[c + 1]) return false;
+        }
+        const uint32_t* items = reinterpret_cast<const uint32_t*>(data + h->sections[GRID_CELL_ITEMS].offset);
+        for (uint64_t i = 0; i < item_count; ++i) {
+            if (items[i] >= h->contour_count) return false;
+        }
+    }
+    const LodRange* ranges = reinterpret_cast<const LodRange*>(data + h->sections[LOD_RANGES].offset);
+    for (uint32_t level = 0; level < LOD_LEVELS; ++level) {
+        const uint64_t vertex_count = level == 0 ? h->point_count : h->lod_vertex_count;
+        for (uint64_t i = 0; i < h->contour_count; ++i) {
+            const LodRange& range = ranges[level * h->contour_count + i];
+            if (uint64_t(range.first_vertex) + range.vertex_count > vertex_count) return false;
+        }
+    }
+
+    base = data;
+    length = size;
+    header = h;
+    return true;
+}
+
+std::vector<std::string> CachedGeometry::layer_names() const {
+    std::vector<std::string> names;
+    const char* p = section<char>(LAYER_NAMES);
+    const char* end = p + header->sections[LAYER_NAMES].bytes;
+    while (p < end && names.size() < header->layer_count) {
+        size_t len = strnlen(p, end - p);
+        names.emplace_back(p, len);
+        p += len + 1;
+    }
+    return names;
+}
+
+const ContourRecord* CachedGeometry::contours() const {
+    return section<ContourRecord>(CONTOURS);
+}
+
+const Vec2* CachedGeometry::points() const {
+    return section<Vec2>(POINTS);
+}
+
+const float* CachedGeometry::vertices() const {
+    return section<float>(VERTICES);
+}
+
+CachedGeometry::Lod CachedGeometry::lod(uint32_t level) const {
+    if (level >= LOD_LEVELS) level = LOD_LEVELS - 1;
+    Lod result;
+    result.ranges = section<LodRange>(LOD_RANGES) + level * contour_count();
+    result.vertices = level == 0 ? vertices() : section<float>(LOD_VERTICES);
+    result.vertex_count = level == 0 ? point_count() : header->lod_vertex_count;
+    return result;
+}
+
+uint32_t CachedGeometry::lod_for_scale(double mm_per_pixel) {
+    uint32_t level = 0;
+    while (level + 1 < LOD_LEVELS && LOD_TOLERANCE_MM[level + 1] <= 0.5 * mm_per_pixel) ++level;
+    return level;
+}
+
+const uint32_t* CachedGeometry::order() const {
+    return section<uint32_t>(ORDER);
+}
+
+const uint8_t* CachedGeometry::order_reversed() const {
+    return section<uint8_t>(ORDER_REVERSED);
+}
+
+Drawing CachedGeometry::to_drawing() const {
+    Drawing drawing;
+    drawing.layers = layer_names();
+    drawing.contours.resize(contour_count());
+
+    const ContourRecord* records = contours();
+    const Vec2* all_points = points();
+    for (size_t i = 0; i < drawing.contours.size(); ++i) {
+        Contour& contour = drawing.contours[i];
+        const ContourRecord& record = records[i];
+        contour.points.assign(all_points + record.first_point, all_points + record.first_point + record.point_count);
+        contour.closed = record.closed != 0;
+        contour.layer = record.layer;
+        contour.bounds = record.bounds;
+    }
+    return drawing;
+}
+
+PathOrder CachedGeometry::to_path_order() const {
+    PathOrder result;
+    result.order.assign(order(), order() + order_count());
+    result.reversed.assign(order_reversed(), order_reversed() + order_count());
+    return result;
+}
+
+void CachedGeometry::load_grid(SpatialGrid& grid) const {
+    grid.assign(header->grid_extent, header->grid_cell_size, header->grid_cols, header->grid_rows,
+                section<Bounds2>(GRID_BOXES), contour_count(),
+                section<uint32_t>(GRID_CELL_START),
+                section<uint32_t>(GRID_CELL_ITEMS), header->sections[GRID_CELL_ITEMS].bytes / sizeof(uint32_t));
+}
+
+GeometryCache::GeometryCache(const std::string& cache_directory) : directory(cache_directory) {
+}
+
+std::string GeometryCache::default_directory() {
+    const char* xdg = std::getenv("XDG_CACHE_HOME");
+    if (xdg && *xdg) return std::string(xdg) + "/stepviewer/geometry";
+    const char* home = std::getenv("HOME");
+    if (home && *home) return std::string(home) + "/.cache/stepviewer/geometry";
+    return "/tmp/stepviewer-geometry";
+}
+
+bool GeometryCache::make_key(const std::string& source_path, double tolerance_mm, GeometryKey& out) {
+    if (!ContentHash::hash_file(source_path, out.content_hash)) return false;
+    out.tolerance_mm = tolerance_mm;
+    return true;
+}
+
+std::string GeometryCache::path_for(const GeometryKey& key) const {
+    // Tolerance in nanometres keeps file names free of decimal points
+    long long tolerance_nm = std::llround(key.tolerance_mm * 1e6);
+    return directory + "/" + ContentHash::to_hex(key.content_hash) + "-" + std::to_string(tolerance_nm) + ".geo";
+}
+
+bool GeometryCache::open(const GeometryKey& key, CachedGeometry& out) const {
+    CachedGeometry result;
+    if (!result.file.open(path_for(key))) return false;
+    if (!result.attach(result.file.data(), result.file.size(), key)) {
+        std::cerr << "Ignoring stale geometry cache entry " << path_for(key) << std::endl;
+        return false;
+    }
+    out = std::move(result);
+    return true;
+}
+
+bool GeometryCache::store(const GeometryKey& key, const Drawing& drawing, CachedGeometry& out) const {
+    TRACE_SPAN("cache.store");
+    std::vector<char> image = build_image(key, drawing);
+
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    const std::string path = path_for(key);
+    if (!error && write_atomically(path, image) && open(key, out)) {
+        return true;
+    }
+
+    // Read-only or full cache directory: keep the entry in memory instead
+    std::cerr << "Could not write geometry cache entry " << path << std::endl;
+    CachedGeometry result;
+    result.buffer = std::move(image);
+    if (!result.attach(result.buffer.data(), result.buffer.size(), key)) return false;
+    out = std::move(result);
+    return true;
+}
+
+bool GeometryCache::build_in_memory(const GeometryKey& key, const Drawing& drawing, CachedGeometry& out) const {
+    TRACE_SPAN("cache.build");
+    CachedGeometry result;
+    result.buffer = build_image(key, drawing);
+    if (!result.attach(result.buffer.data(), result.buffer.size(), key)) return false;
+    out = std::move(result);
+    return true;
+}
+
+void GeometryCache::persist_async(const GeometryKey& key, const CachedGeometry& geometry) const {
+    if (!geometry.is_valid()) return;
+    auto image = std::make_shared<std::vector<char>>(geometry.base, geometry.base + geometry.length);
+    std::string cache_directory = directory;
+    std::string path = path_for(key);
+    ThreadPool::shared().submit([image, cache_directory, path] {
+        TRACE_SPAN("cache.persist");
+        std::error_code error;
+        std::filesystem::create_directories(cache_directory, error);
+        if (error || !write_atomically(path, *image)) {
+            std::cerr << "Could not write geometry cache entry " << path << std::endl;
+        }
+    });
+}
+
+bool GeometryCache::open_or_build(const GeometryKey& key, const BuildFunction& build,
+                                  CachedGeometry& out, bool* was_hit) const {
+    if (was_hit) *was_hit = false;
+    if (open(key, out)) {
+        if (was_hit) *was_hit = true;
+        return true;
+    }
+
+    Drawing drawing;
+    if (!build(drawing)) return false;
+    return store(key, drawing, out);
+}
@@ -0,0 +1,188 @@
+#pragma once
+
+#include "contour.h"
+#include "path_order.h"
+#include "spatial_grid.h"
+#include "core/mapped_file.h"
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// On-disk layout of one cached drawing. Everything is fixed-size and
+// little-endian; sections start on 64-byte boundaries so they can be used
+// straight out of a read-only mapping (points as Vec2, vertices as float xy
+// ready for glBufferData). Bump VERSION whenever anything here changes.
+namespace GeometryCacheFormat {
+    constexpr char MAGIC[8] = {'K', '4', '0', 'G', 'E', 'O', 'M', '\0'};
+    constexpr uint32_t VERSION = 3;
+    constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+    constexpr size_t SECTION_ALIGN = 64;
+
+    // Display levels of detail. Level 0 is every point; each further level
+    // is simplified from the points so no vertex strays more than its
+    // tolerance from the flattened contour.
+    constexpr uint32_t LOD_LEVELS = 4;
+    constexpr double LOD_TOLERANCE_MM[LOD_LEVELS] = {0.0, 0.05, 0.2, 0.8};
+
+    enum Section : uint32_t {
+        LAYER_NAMES,      // NUL-terminated names, back to back
+        CONTOURS,         // ContourRecord[contour_count]
+        POINTS,           // Vec2[point_count], millimetres
+        VERTICES,         // float[point_count * 2], same indexing as POINTS
+        GRID_BOXES,       // Bounds2[contour_count]
+        GRID_CELL_START,  // uint32_t[cols * rows + 1]
+        GRID_CELL_ITEMS,  // uint32_t[...]
+        ORDER,            // uint32_t[order_count]
+        ORDER_REVERSED,   // uint8_t[order_count]
+        LOD_RANGES,       // LodRange[LOD_LEVELS * contour_count], level by level
+        LOD_VERTICES,     // float[lod_vertex_count * 2], levels 1 and up
+        SECTION_COUNT
+    };
+
+    struct SectionEntry {
+        uint64_t offset;
+        uint64_t bytes;
+    };
+
+    struct ContourRecord {
+        uint64_t first_point;
+        uint32_t point_count;
+        uint16_t layer;
+        uint8_t closed;
+        uint8_t reserved;
+        Bounds2 bounds;
+    };
+
+    // A contour's vertices within one level's vertex array
+    struct LodRange {
+        uint32_t first_vertex;
+        uint32_t vertex_count;
+    };
+
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t header_bytes;
+        uint32_t byte_order;
+        uint32_t layer_count;
+        uint64_t content_hash;
+        double tolerance_mm;
+        uint64_t contour_count;
+        uint64_t point_count;
+        uint64_t order_count;
+        uint64_t lod_vertex_count;
+        Bounds2 grid_extent;
+        double grid_cell_size;
+        int32_t grid_cols;
+        int32_t grid_rows;
+        SectionEntry sections[SECTION_COUNT];
+    };
+}
+
+// Identifies a cache entry: the source file's contents plus every setting
+// that changes the flattened result
+struct GeometryKey {
+    uint64_t content_hash;
+    double tolerance_mm;
+
+    GeometryKey() : content_hash(0), tolerance_mm(0.0) {}
+};
+
+// Read-only view of one cached drawing, backed by a file mapping (or by a
+// heap copy when the cache directory is not writable). All accessors point
+// into that storage; nothing is copied until to_drawing() is called.
+class CachedGeometry {
+private:
+    MappedFile file;
+    std::vector<char> buffer;
+    const char* base;
+    size_t length;
+    const GeometryCacheFormat::Header* header;
+
+    template <typename T>
+    const T* section(GeometryCacheFormat::Section s) const {
+        return reinterpret_cast<const T*>(base + header->sections[s].offset);
+    }
+
+    friend class GeometryCache;
+    bool attach(const char* data, size_t size, const GeometryKey& key);
+
+public:
+    CachedGeometry();
+
+    CachedGeometry(const CachedGeometry&) = delete;
+    CachedGeometry& operator=(const CachedGeometry&) = delete;
+    CachedGeometry(CachedGeometry&& other) noexcept;
+    CachedGeometry& operator=(CachedGeometry&& other) noexcept;
+
+    bool is_valid() const { return header != nullptr; }
+    bool is_mapped() const { return is_valid() && buffer.empty(); }
+    size_t byte_size() const { return length; }
+
+    size_t layer_count() const { return header->layer_count; }
+    std::vector<std::string> layer_names() const;
+
+    size_t contour_count() const { return header->contour_count; }
+    const GeometryCacheFormat::ContourRecord* contours() const;
+    size_t point_count() const { return header->point_count; }
+    const Vec2* points() const;
+    const float* vertices() const;
+    Bounds2 bounds() const { return header->grid_extent; }
+
+    // One level of detail, ready for glBufferData: vertices as float xy,
+    // ranges[i] locating contour i in them
+    struct Lod {
+        const GeometryCacheFormat::LodRange* ranges;
+        const float* vertices;
+        size_t vertex_count;
+    };
+    Lod lod(uint32_t level) const;
+    // Coarsest level whose error stays under half a pixel at this zoom
+    static uint32_t lod_for_scale(double mm_per_pixel);
+
+    size_t order_count() const { return header->order_count; }
+    const uint32_t* order() const;
+    const uint8_t* order_reversed() const;
+
+    // Owned copies for stages that edit geometry or need the containers
+    Drawing to_drawing() const;
+    PathOrder to_path_order() const;
+    void load_grid(SpatialGrid& grid) const;
+};
+
+// Content-addressed cache of flattened drawings, their spatial index and cut
+// ordering. Entries are written to a temporary name and renamed into place,
+// so a crash never leaves a half-written entry behind.
+class GeometryCache {
+private:
+    std::string directory;
+
+public:
+    typedef std::function<bool(Drawing& out)> BuildFunction;
+
+    explicit GeometryCache(const std::string& cache_directory = default_directory());
+
+    // $XDG_CACHE_HOME/stepviewer/geometry, falling back to ~/.cache
+    static std::string default_directory();
+    static bool make_key(const std::string& source_path, double tolerance_mm, GeometryKey& out);
+
+    std::string path_for(const GeometryKey& key) const;
+
+    // False on a miss, or when the entry is stale or damaged
+    bool open(const GeometryKey& key, CachedGeometry& out) const;
+
+    // Indexes and orders the drawing, writes the entry and opens it
+    bool store(const GeometryKey& key, const Drawing& drawing, CachedGeometry& out) const;
+
+    // Indexes and orders the drawing into a heap-backed entry without
+    // writing it; live reload shows this at once and persists it later
+    bool build_in_memory(const GeometryKey& key, const Drawing& drawing, CachedGeometry& out) const;
+    // Writes a copy of geometry's image on the shared pool, so the next
+    // open of the same contents is a hit
+    void persist_async(const GeometryKey& key, const CachedGeometry& geometry) const;
+
+    // Opens the entry, or runs build and stores its result on a miss
+    bool open_or_build(const GeometryKey& key, const BuildFunction& build,
+                       CachedGeometry& out, bool* was_hit = nullptr) const;
+};
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "core/memory_accounting.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct Bounds3 {
+    float min[3];
+    float max[3];
+
+    Bounds3() : min{1e30f, 1e30f, 1e30f}, max{-1e30f, -1e30f, -1e30f} {}
+
+    bool valid() const { return min[0] <= max[0]; }
+
+    void expand(float x, float y, float z) {
+        if (x < min[0]) min[0] = x;
+        if (y < min[1]) min[1] = y;
+        if (z < min[2]) min[2] = z;
+        if (x > max[0]) max[0] = x;
+        if (y > max[1]) max[1] = y;
+        if (z > max[2]) max[2] = z;
+    }
+
+    void expand(const Bounds3& other) {
+        if (!other.valid()) return;
+        expand(other.min[0], other.min[1], other.min[2]);
+        expand(other.max[0], other.max[1], other.max[2]);
+    }
+};
+
+// Indexed triangle mesh of one body, positions in millimetres (x, y, z)
+struct TriangleMesh {
+    std::string name;
+    int body;
+    TrackedVector<float, MemoryTag::MESH> positions;
+    TrackedVector<uint32_t, MemoryTag::MESH> indices;
+    Bounds3 bounds;
+
+    TriangleMesh() : body(-1) {}
+
+    size_t vertex_count() const { return positions.size() / 3; }
+    size_t triangle_count() const { return indices.size() / 3; }
+};
@@ -0,0 +1,322 @@
+#include "mesh_slicer.h"
+#include "core/trace.h"
+#include <cmath>
+#include <string>
+#include <unordered_map>
+
+namespace {
+    // Tessellators emit each face separately, so vertices along shared edges
+    // are duplicated. Sections are chained through shared edges, which needs
+    // one index per distinct position.
+    struct WeldedMesh {
+        std::vector<double> positions;
+        std::vector<uint32_t> indices;
+    };
+
+    struct QuantKey {
+        int64_t x, y, z;
+        bool operator==(const QuantKey& other) const { return x == other.x && y == other.y && z == other.z; }
+    };
+
+    struct QuantHash {
+        size_t operator()(const QuantKey& k) const {
+            uint64_t h = static_cast<uint64_t>(k.x) * 0x9E3779B97F4A7C15ull;
+            h ^= static_cast<uint64_t>(k.y) * 0xC2B2AE3D27D4EB4Full + (h << 6) + (h >> 2);
+            h ^= static_cast<uint64_t>(k.z) * 0x165667B19E3779F9ull + (h << 6) + (h >> 2);
+            return static_cast<size_t>(h);
+        }
+    };
+
+    WeldedMesh weld(const TriangleMesh& mesh, double tolerance) {
+        WeldedMesh welded;
+        const size_t vertex_count = mesh.vertex_count();
+        const double inv = 1.0 / tolerance;
+
+        std::unordered_map<QuantKey, uint32_t, QuantHash> lookup;
+        lookup.reserve(vertex_count);
+        std::vector<uint32_t> remap(vertex_count);
+        welded.positions.reserve(vertex_count * 3);
+
+        for (size_t i = 0; i < vertex_count; ++i) {
+            const float* p = &mesh.positions[i * 3];
+            QuantKey key{std::llround(p[0] * inv), std::llround(p[1] * inv), std::llround(p[2] * inv)};
+            auto [it, inserted] = lookup.emplace(key, static_cast<uint32_t>(welded.positions.size() / 3));
+            if (inserted) {
+                welded.positions.push_back(p[0]);
+                welded.positions.push_back(p[1]);
+                welded.positions.push_back(p[2]);
+            }
+            remap[i] = it->second;
+        }
+
+        welded.indices.reserve(mesh.indices.size());
+        for (size_t t = 0; t + 2 < mesh.indices.size(); t += 3) {
+            uint32_t a = remap[mesh.indices[t]];
+            uint32_t b = remap[mesh.indices[t + 1]];
+            uint32_t c = remap[mesh.indices[t + 2]];
+            // Triangles collapsed by welding have no area to section
+            if (a == b || b == c || a == c) continue;
+            welded.indices.push_back(a);
+            welded.indices.push_back(b);
+            welded.indices.push_back(c);
+        }
+        return welded;
+    }
+
+    uint64_t edge_key(uint32_t a, uint32_t b) {
+        return a < b ? (static_cast<uint64_t>(a) << 32) | b : (static_cast<uint64_t>(b) << 32) | a;
+    }
+
+    struct Segment {
+        uint64_t from;
+        uint64_t to;
+        Vec2 start;
+    };
+
+    struct PlaneFrame {
+        double o[3], u[3], v[3], n[3];
+
+        double distance(const double* p) const {
+            return (p[0] - o[0]) * n[0] + (p[1] - o[1]) * n[1] + (p[2] - o[2]) * n[2];
+        }
+    };
+
+    // Crossing point of a welded edge; always computed from the lower index
+    // so both triangles sharing the edge get bit-identical coordinates.
+    Vec2 edge_point(const WeldedMesh& mesh, const std::vector<double>& dist,
+                    const PlaneFrame& frame, uint32_t a, uint32_t b) {
+        if (a > b) std::swap(a, b);
+        const double* pa = &mesh.positions[a * 3];
+        const double* pb = &mesh.positions[b * 3];
+        double p[3];
+        if (dist[a] == 0.0 || dist[b] == 0.0) {
+            // Crossing at a vertex on the plane: use it exactly, so every edge
+            // through that vertex yields the same point
+            const double* on = dist[a] == 0.0 ? pa : pb;
+            for (int k = 0; k < 3; ++k) p[k] = on[k] - frame.o[k];
+        } else {
+            double t = dist[a] / (dist[a] - dist[b]);
+            for (int k = 0; k < 3; ++k) p[k] = pa[k] + (pb[k] - pa[k]) * t - frame.o[k];
+        }
+        return Vec2{p[0] * frame.u[0] + p[1] * frame.u[1] + p[2] * frame.u[2],
+                    p[0] * frame.v[0] + p[1] * frame.v[1] + p[2] * frame.v[2]};
+    }
+
+    // Crossings next to a vertex that sits (almost) on the plane produce
+    // runs of near-identical points; they carry no shape.
+    constexpr double MIN_POINT_GAP_SQ = 1e-12;
+
+    bool same_point(const Vec2& a, const Vec2& b) {
+        double dx = a.x - b.x, dy = a.y - b.y;
+        return dx * dx + dy * dy < MIN_POINT_GAP_SQ;
+    }
+
+    void append_point(Contour& contour, const Vec2& p) {
+        if (!contour.points.empty() && same_point(contour.points.back(), p)) return;
+        contour.points.push_back(p);
+    }
+
+    void section(const WeldedMesh& mesh, const PlaneFrame& frame, uint16_t layer,
+                 std::vector<Contour>& out, size_t& segment_count) {
+        const size_t vertex_count = mesh.positions.size() / 3;
+        std::vector<double> dist(vertex_count);
+        for (size_t i = 0; i < vertex_count; ++i) {
+            dist[i] = frame.distance(&mesh.positions[i * 3]);
+        }
+
+        // Points on the plane count as above it, so every crossing edge has
+        // strictly one vertex on each side and no special cases are needed.
+        std::vector<Segment> segments;
+        for (size_t t = 0; t < mesh.indices.size(); t += 3) {
+            const uint32_t* tri = &mesh.indices[t];
+            int below = (dist[tri[0]] < 0) | ((dist[tri[1]] < 0) << 1) | ((dist[tri[2]] < 0) << 2);
+            if (below == 0 || below == 7) continue;
+
+            // Walk the edges in winding order: the section leaves the triangle
+            // where an edge goes from below to above. Neighbours traverse shared
+            // edges in opposite directions, so segments chain head to tail.
+            uint64_t enter = 0, leave = 0;
+            uint32_t enter_a = 0, enter_b = 0;
+            for (int e = 0; e < 3; ++e) {
+                uint32_t a = tri[e];
+                uint32_t b = tri[(e + 1) % 3];
+                bool a_below = dist[a] < 0;
+                bool b_below = dist[b] < 0;
+                if (a_below == b_below) continue;
+                if (!a_below) {
+                    enter = edge_key(a, b);
+                    enter_a = a;
+                    enter_b = b;
+                } else {
+                    leave = edge_key(a, b);
+                }
+            }
+            segments.push_back(Segment{enter, leave, edge_point(mesh, dist, frame, enter_a, enter_b)});
+        }
+        segment_count += segments.size();
+        if (segments.empty()) return;
+
+        std::unordered_map<uint64_t, uint32_t> by_start;
+        std::unordered_map<uint64_t, uint32_t> by_end;
+        by_start.reserve(segments.size());
+        by_end.reserve(segments.size());
+        for (uint32_t i = 0; i < segments.size(); ++i) {
+            by_start.emplace(segments[i].from, i);
+            by_end.emplace(segments[i].to, i);
+        }
+
+        std::vector<uint8_t> used(segments.size(), 0);
+        for (uint32_t seed = 0; seed < segments.size(); ++seed) {
+            if (used[seed]) continue;
+
+            // Back up to the head of the chain so open sections come out whole
+            uint32_t head = seed;
+            for (size_t guard = 0; guard < segments.size(); ++guard) {
+                auto it = by_end.find(segments[head].from);
+                if (it == by_end.end() || used[it->second] || it->second == seed) break;
+                head = it->second;
+            }
+
+            Contour contour;
+            contour.layer = layer;
+            uint32_t current = head;
+            bool closed = false;
+            while (true) {
+                used[current] = 1;
+                append_point(contour, segments[current].start);
+
+                auto it = by_start.find(segments[current].to);
+                if (it == by_start.end()) break;
+                if (it->second == head) {
+                    closed = true;
+                    break;
+                }
+                if (used[it->second]) break;
+                current = it->second;
+            }
+
+            if (!closed) {
+                // The last segment's end point is not the start of anything
+                const Segment& tail = segments[current];
+                uint32_t a = static_cast<uint32_t>(tail.to >> 32);
+                uint32_t b = static_cast<uint32_t>(tail.to & 0xffffffffu);
+                append_point(contour, edge_point(mesh, dist, frame, a, b));
+            } else if (contour.points.size() > 1) {
+                if (same_point(contour.points.front(), contour.points.back())) contour.points.pop_back();
+            }
+
+            if (contour.points.size() < 2) continue;
+            contour.closed = closed && contour.points.size() >= 3;
+            contour.update_bounds();
+            out.push_back(std::move(contour));
+        }
+    }
+
+    bool plane_hits(const Bounds3& bounds, const PlaneFrame& frame) {
+        if (!bounds.valid()) return false;
+        bool above = false, below = false;
+        for (int corner = 0; corner < 8; ++corner) {
+            double p[3] = {
+                (corner & 1) ? bounds.max[0] : bounds.min[0],
+                (corner & 2) ? bounds.max[1] : bounds.min[1],
+                (corner & 4) ? bounds.max[2] : bounds.min[2]
+            };
+            if (frame.distance(p) < 0) below = true;
+            else above = true;
+        }
+        return above && below;
+    }
+}
+
+SlicePlane::SlicePlane(double ox, double oy, double oz, double nx, double ny, double nz)
+    : origin{ox, oy, oz}, normal{nx, ny, nz} {
+}
+
+void SlicePlane::basis(double u[3], double v[3], double n[3]) const {
+    double len = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+    if (len <= 0.0) {
+        n[0] = 0.0; n[1] = 0.0; n[2] = 1.0;
+    } else {
+        n[0] = normal[0] / len; n[1] = normal[1] / len; n[2] = normal[2] / len;
+    }
+
+    // u = helper x n, picked so a +Z normal gives u = +X and v = +Y
+    double helper[3] = {0.0, 1.0, 0.0};
+    if (std::fabs(n[1]) > 0.9) {
+        helper[1] = 0.0;
+        helper[2] = 1.0;
+    }
+    u[0] = helper[1] * n[2] - helper[2] * n[1];
+    u[1] = helper[2] * n[0] - helper[0] * n[2];
+    u[2] = helper[0] * n[1] - helper[1] * n[0];
+    double ulen = std::sqrt(u[0] * u[0] + u[1] * u[1] + u[2] * u[2]);
+    u[0] /= ulen; u[1] /= ulen; u[2] /= ulen;
+
+    v[0] = n[1] * u[2] - n[2] * u[1];
+    v[1] = n[2] * u[0] - n[0] * u[2];
+    v[2] = n[0] * u[1] - n[1] * u[0];
+}
+
+MeshSlicer::MeshSlicer(ThreadPool& worker_pool, double weld_tolerance)
+    : pool(worker_pool), weld_tolerance_mm(weld_tolerance) {
+}
+
+Drawing MeshSlicer::slice(const std::vector<TriangleMesh>& meshes, const std::vector<SlicePlane>& planes) {
+    TRACE_SPAN("slice.meshes");
+    stats = SliceStats();
+    Drawing drawing;
+    for (size_t p = 0; p < planes.size(); ++p) {
+        drawing.layer_index("Slice " + std::to_string(p + 1));
+    }
+    if (meshes.empty() || planes.empty()) return drawing;
+
+    std::vector<PlaneFrame> frames(planes.size());
+    for (size_t p = 0; p < planes.size(); ++p) {
+        PlaneFrame& frame = frames[p];
+        planes[p].basis(frame.u, frame.v, frame.n);
+        for (int k = 0; k < 3; ++k) frame.o[k] = planes[p].origin[k];
+    }
+
+    // Only weld bodies that at least one plane actually crosses
+    std::vector<uint8_t> hit(meshes.size() * planes.size(), 0);
+    std::vector<uint8_t> needed(meshes.size(), 0);
+    for (size_t m = 0; m < meshes.size(); ++m) {
+        for (size_t p = 0; p < planes.size(); ++p) {
+            if (plane_hits(meshes[m].bounds, frames[p])) {
+                hit[m * planes.size() + p] = 1;
+                needed[m] = 1;
+            }
+        }
+        stats.bodies_hit += needed[m];
+    }
+
+    std::vector<WeldedMesh> welded(meshes.size());
+    pool.parallel_for(meshes.size(), [&](size_t m) {
+        if (needed[m]) welded[m] = weld(meshes[m], weld_tolerance_mm);
+    });
+
+    // One task per body x plane; results are merged in task order so the
+    // output does not depend on scheduling.
+    const size_t task_count = meshes.size() * planes.size();
+    std::vector<std::vector<Contour>> results(task_count);
+    std::vector<size_t> segment_counts(task_count, 0);
+    pool.parallel_for(task_count, [&](size_t task) {
+        if (!hit[task]) return;
+        size_t m = task / planes.size();
+        size_t p = task % planes.size();
+        section(welded[m], frames[p], static_cast<uint16_t>(p), results[task], segment_counts[task]);
+    });
+
+    size_t total = 0;
+    for (const auto& contours : results) total += contours.size();
+    drawing.contours.reserve(total);
+    for (size_t task = 0; task < task_count; ++task) {
+        stats.segments += segment_counts[task];
+        for (auto& contour : results[task]) {
+            if (contour.closed) stats.closed_contours++;
+            else stats.open_contours++;
+            drawing.contours.push_back(std::move(contour));
+        }
+    }
+    return drawing;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "contour.h"
+#include "mesh.h"
+#include "core/thread_pool.h"
+#include <vector>
+
+// Cutting plane; section contours are expressed in the plane's own (u, v)
+// basis. For a plane with normal +Z that is plain model x and y.
+struct SlicePlane {
+    double origin[3];
+    double normal[3];
+
+    SlicePlane(double ox = 0.0, double oy = 0.0, double oz = 0.0,
+               double nx = 0.0, double ny = 0.0, double nz = 1.0);
+
+    static SlicePlane at_z(double z) { return SlicePlane(0.0, 0.0, z); }
+
+    // Orthonormal in-plane axes (normal is normalized on the fly)
+    void basis(double u[3], double v[3], double n[3]) const;
+};
+
+struct SliceStats {
+    size_t bodies_hit;
+    size_t segments;
+    size_t closed_contours;
+    size_t open_contours;
+
+    SliceStats() : bodies_hit(0), segments(0), closed_contours(0), open_contours(0) {}
+};
+
+// Sections tessellated bodies with planes and chains the intersection
+// segments into contours, producing a Drawing with one layer per plane so the
+// result goes through the same ordering and toolpath stages as a DXF.
+// Bodies x planes are processed on the worker pool.
+class MeshSlicer {
+private:
+    ThreadPool& pool;
+    double weld_tolerance_mm;
+    SliceStats stats;
+
+public:
+    explicit MeshSlicer(ThreadPool& worker_pool = ThreadPool::shared(), double weld_tolerance = 1e-4);
+
+    Drawing slice(const std::vector<TriangleMesh>& meshes, const std::vector<SlicePlane>& planes);
+
+    const SliceStats& get_stats() const { return stats; }
+};
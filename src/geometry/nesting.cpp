@@ -0,0 +1,466 @@
+#include "nesting.h"
+#include "batch_kernels.h"
+#include "core/trace.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <random>
+
+namespace {
+    constexpr double PI = 3.141592653589793;
+    constexpr double EPS = 1e-9;
+    // Non-improving steps before a searcher restarts from the best
+    constexpr int RESTART_AFTER = 3000;
+    // Search round length, and how many layouts a searcher tries between
+    // clock reads (a power of two)
+    constexpr double SLICE_S = 0.05;
+    constexpr uint64_t SLICE_CHECK_EVERY = 16;
+
+    // Padded footprint of one part at one rotation
+    struct Footprint {
+        double angle_deg;
+        double cos_a, sin_a;
+        double min_x, min_y;  // rotated bounds origin
+        double w, h;          // including spacing
+    };
+
+    struct PartShape {
+        std::vector<Footprint> rotations;
+        double area;          // unpadded bounding-box area at rotation 0
+        bool usable;
+    };
+
+    struct Genome {
+        std::vector<uint32_t> order;
+        std::vector<uint8_t> rotation;
+    };
+
+    struct Score {
+        double placed_area;
+        double used_length;
+        double moment;        // sum of right edge * area, favours big parts on the left
+
+        bool better_than(const Score& other) const {
+            if (placed_area > other.placed_area + EPS) return true;
+            if (placed_area < other.placed_area - EPS) return false;
+            if (used_length < other.used_length - EPS) return true;
+            if (used_length > other.used_length + EPS) return false;
+            return moment < other.moment - EPS;
+        }
+    };
+
+    struct Segment {
+        double y, length, x;
+    };
+
+    // Bottom-left skyline: the packed region's right frontier as a function
+    // of y, kept as contiguous segments covering [0, height)
+    class Skyline {
+    private:
+        std::vector<Segment> segments;
+        double width, height;
+
+    public:
+        Skyline(double w, double h) : width(w), height(h) {
+            segments.push_back(Segment{0.0, h, 0.0});
+        }
+
+        void reset() {
+            segments.clear();
+            segments.push_back(Segment{0.0, height, 0.0});
+        }
+
+        // Leftmost position for a w x h box, lowest on ties
+        bool find(double w, double h, double& best_x, double& best_y) const {
+            bool found = false;
+            for (size_t i = 0; i < segments.size(); ++i) {
+                double y = segments[i].y;
+                if (y + h > height + EPS) break;
+                double x = 0.0;
+                double covered = 0.0;
+                for (size_t j = i; j < segments.size() && covered < h - EPS; ++j) {
+                    x = std::max(x, segments[j].x);
+                    covered += segments[j].length;
+                }
+                if (x + w > width + EPS) continue;
+                if (!found || x + w < best_x + w - EPS || (std::fabs(x - best_x) <= EPS && y < best_y)) {
+                    best_x = x;
+                    best_y = y;
+                    found = true;
+                }
+            }
+            return found;
+        }
+
+        void add(double x, double y, double w, double h) {
+            const double top = y + h;
+            std::vector<Segment> next;
+            next.reserve(segments.size() + 2);
+            bool inserted = false;
+            for (const auto& s : segments) {
+                double s_top = s.y + s.length;
+                if (s_top <= y + EPS || s.y >= top - EPS) {
+                    if (!inserted && s.y >= top - EPS) {
+                        next.push_back(Segment{y, h, x + w});
+                        inserted = true;
+                    }
+                    next.push_back(s);
+                    continue;
+                }
+                // Overlaps the box: keep the parts outside it
+                if (s.y < y - EPS) next.push_back(Segment{s.y, y - s.y, s.x});
+                if (!inserted) {
+                    next.push_back(Segment{y, h, x + w});
+                    inserted = true;
+                }
+                if (s_top > top + EPS) next.push_back(Segment{top, s_top - top, s.x});
+            }
+            if (!inserted) next.push_back(Segment{y, h, x + w});
+
+            segments.clear();
+            for (const auto& s : next) {
+                if (!segments.empty() && std::fabs(segments.back().x - s.x) <= EPS) {
+                    segments.back().length += s.length;
+                } else {
+                    segments.push_back(s);
+                }
+            }
+        }
+    };
+
+    std::vector<PartShape> build_shapes(const Drawing& drawing, const std::vector<NestPart>& parts,
+                                        const NestSettings& settings) {
+        const int steps = std::max(1, settings.rotation_steps);
+        std::vector<PartShape> shapes(parts.size());
+        for (size_t p = 0; p < parts.size(); ++p) {
+            PartShape& shape = shapes[p];
+            shape.usable = false;
+            shape.area = 0.0;
+            for (int k = 0; k < steps; ++k) {
+                Footprint f;
+                f.angle_deg = 360.0 * k / steps;
+                f.cos_a = std::cos(f.angle_deg * PI / 180.0);
+                f.sin_a = std::sin(f.angle_deg * PI / 180.0);
+                const Affine2 rotation{f.cos_a, -f.sin_a, f.sin_a, f.cos_a, 0.0, 0.0};
+                Bounds2 b;
+                for (uint32_t c : parts[p].contours) {
+                    const PointList& points = drawing.contours[c].points;
+                    b.expand(BatchKernels::transformed_bounds(rotation, points.data(), points.size()));
+                }
+                if (!b.valid()) continue;
+                f.min_x = b.min_x;
+                f.min_y = b.min_y;
+                f.w = b.max_x - b.min_x + settings.spacing_mm;
+                f.h = b.max_y - b.min_y + settings.spacing_mm;
+                if (k == 0) shape.area = (b.max_x - b.min_x) * (b.max_y - b.min_y);
+                shape.rotations.push_back(f);
+                shape.usable = true;
+            }
+        }
+        return shapes;
+    }
+
+    class Decoder {
+    private:
+        const std::vector<PartShape>& shapes;
+        double region_w, region_h, spacing;
+        Skyline skyline;
+
+    public:
+        Decoder(const std::vector<PartShape>& part_shapes, const NestSettings& settings)
+            : shapes(part_shapes),
+              region_w(settings.bed_width_mm - settings.spacing_mm),
+              region_h(settings.bed_height_mm - settings.spacing_mm),
+              spacing(settings.spacing_mm),
+              skyline(region_w, region_h) {}
+
+        // Places parts in genome order, trying the genome's rotation first
+        Score run(const Genome& genome, std::vector<NestPlacement>* placements) {
+            skyline.reset();
+            Score score{0.0, 0.0, 0.0};
+            if (placements) placements->assign(shapes.size(), NestPlacement{0, false, 0.0, 0.0, 0.0});
+
+            for (uint32_t part : genome.order) {
+                const PartShape& shape = shapes[part];
+                if (!shape.usable) continue;
+                const size_t count = shape.rotations.size();
+                size_t first = genome.rotation[part] % count;
+
+                for (size_t k = 0; k < count; ++k) {
+                    const Footprint& f = shape.rotations[(first + k) % count];
+                    double x, y;
+                    if (!skyline.find(f.w, f.h, x, y)) continue;
+                    skyline.add(x, y, f.w, f.h);
+
+                    double right = x + f.w;
+                    score.placed_area += shape.area;
+                    score.used_length = std::max(score.used_length, right);
+                    score.moment += right * shape.area;
+                    if (placements) {
+                        NestPlacement& out = (*placements)[part];
+                        out.part = part;
+                        out.placed = true;
+                        out.angle_deg = f.angle_deg;
+                        out.offset_x = x + spacing - f.min_x;
+                        out.offset_y = y + spacing - f.min_y;
+                    }
+                    break;
+                }
+            }
+            return score;
+        }
+    };
+
+    void mutate(Genome& genome, const std::vector<PartShape>& shapes, std::mt19937_64& rng) {
+        const size_t n = genome.order.size();
+        std::uniform_int_distribution<size_t> pick(0, n - 1);
+        int ops = 1 + static_cast<int>(rng() % 3);
+        for (int op = 0; op < ops; ++op) {
+            switch (rng() % 3) {
+                case 0:
+                    std::swap(genome.order[pick(rng)], genome.order[pick(rng)]);
+                    break;
+                case 1: {
+                    // Move one part to another position
+                    size_t from = pick(rng), to = pick(rng);
+                    uint32_t part = genome.order[from];
+                    genome.order.erase(genome.order.begin() + static_cast<long>(from));
+                    genome.order.insert(genome.order.begin() + static_cast<long>(to), part);
+                    break;
+                }
+                default: {
+                    uint32_t part = genome.order[pick(rng)];
+                    size_t count = shapes[part].rotations.size();
+                    if (count > 1) genome.rotation[part] = static_cast<uint8_t>(rng() % count);
+                    break;
+                }
+            }
+        }
+    }
+
+    // Largest first, each part turned so it takes the least bed length
+    Genome initial_genome(const std::vector<PartShape>& shapes) {
+        Genome genome;
+        genome.order.resize(shapes.size());
+        genome.rotation.assign(shapes.size(), 0);
+        for (uint32_t i = 0; i < shapes.size(); ++i) {
+            genome.order[i] = i;
+            const auto& rotations = shapes[i].rotations;
+            for (size_t k = 1; k < rotations.size(); ++k) {
+                if (rotations[k].w < rotations[genome.rotation[i]].w - EPS) {
+                    genome.rotation[i] = static_cast<uint8_t>(k);
+                }
+            }
+        }
+        std::stable_sort(genome.order.begin(), genome.order.end(),
+                         [&](uint32_t a, uint32_t b) { return shapes[a].area > shapes[b].area; });
+        return genome;
+    }
+}
+
+namespace Nesting {
+
+    std::vector<NestPart> parts_from(const Drawing& drawing, const ContainmentTree& nesting) {
+        const size_t count = drawing.contours.size();
+        std::vector<uint32_t> part_of(count, UINT32_MAX);
+        std::vector<NestPart> parts;
+        for (uint32_t i = 0; i < count; ++i) {
+            if (nesting.parent[i] == ContainmentTree::NO_PARENT && !drawing.contours[i].points.empty()) {
+                part_of[i] = static_cast<uint32_t>(parts.size());
+                parts.emplace_back();
+            }
+        }
+        for (uint32_t i = 0; i < count; ++i) {
+            uint32_t root = i;
+            while (nesting.parent[root] != ContainmentTree::NO_PARENT) root = nesting.parent[root];
+            if (part_of[root] != UINT32_MAX) parts[part_of[root]].contours.push_back(i);
+        }
+        return parts;
+    }
+
+    Drawing apply(const Drawing& drawing, const std::vector<NestPart>& parts, const NestResult& result) {
+        Drawing out;
+        out.layers = drawing.layers;
+        for (const auto& placement : result.placements) {
+            if (!placement.placed || placement.part >= parts.size()) continue;
+            double c = std::cos(placement.angle_deg * PI / 180.0);
+            double s = std::sin(placement.angle_deg * PI / 180.0);
+            const Affine2 place{c, -s, s, c, placement.offset_x, placement.offset_y};
+            for (uint32_t index : parts[placement.part].contours) {
+                Contour contour = drawing.contours[index];
+                BatchKernels::transform(place, contour.points.data(), contour.points.size());
+                contour.bounds = BatchKernels::bounds(contour.points.data(), contour.points.size());
+                out.contours.push_back(std::move(contour));
+            }
+        }
+        return out;
+    }
+
+}
+
+Nester::Nester(ThreadPool& worker_pool)
+    : pool(worker_pool), running(false), cancel_requested(false), evaluations(0) {
+}
+
+Nester::~Nester() {
+    cancel();
+}
+
+bool Nester::start(const Drawing& drawing, const std::vector<NestPart>& parts,
+                   const NestSettings& nest_settings, ImprovedCallback callback) {
+    if (running.load()) return false;
+    if (runner.joinable()) runner.join();
+
+    settings = nest_settings;
+    on_improved = std::move(callback);
+    cancel_requested = false;
+    evaluations = 0;
+    {
+        std::lock_guard<std::mutex> lock(best_mutex);
+        best = NestResult();
+    }
+
+    running = true;
+    runner = std::thread(&Nester::search, this, drawing, parts);
+    return true;
+}
+
+void Nester::cancel() {
+    cancel_requested = true;
+    if (runner.joinable()) runner.join();
+}
+
+bool Nester::poll_result(NestResult& out, uint64_t known_generation) {
+    std::lock_guard<std::mutex> lock(best_mutex);
+    if (best.generation == known_generation) return false;
+    out = best;
+    out.evaluations = evaluations.load(std::memory_order_relaxed);
+    return true;
+}
+
+void Nester::search(const Drawing& drawing, std::vector<NestPart> parts) {
+    Trace::set_thread_name("nester");
+    auto start_time = std::chrono::steady_clock::now();
+    auto deadline = start_time + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                     std::chrono::duration<double>(settings.time_budget_s));
+
+    const std::vector<PartShape> shapes = build_shapes(drawing, parts, settings);
+    if (shapes.empty() || settings.bed_width_mm <= settings.spacing_mm ||
+        settings.bed_height_mm <= settings.spacing_mm) {
+        running = false;
+        return;
+    }
+
+    // Shared best, guarded by best_mutex alongside the published result
+    Genome best_genome = initial_genome(shapes);
+    Score best_score{-1.0, 0.0, 0.0};
+
+    auto publish = [&](const Genome& genome, const Score& score, Decoder& decoder) {
+        std::vector<NestPlacement> placements;
+        decoder.run(genome, &placements);
+        {
+            std::lock_guard<std::mutex> lock(best_mutex);
+            if (!score.better_than(best_score)) return;
+            best_score = score;
+            best_genome = genome;
+            best.placements = std::move(placements);
+            best.placed_count = 0;
+            for (const auto& p : best.placements) best.placed_count += p.placed ? 1 : 0;
+            best.placed_area = score.placed_area;
+            best.used_length = score.used_length + settings.spacing_mm;
+            best.generation++;
+        }
+        if (on_improved) on_improved();
+    };
+
+    // Searchers keep their state between rounds. A round runs each for a
+    // short slice and hands the pool back, so job, cache and thumbnail
+    // tasks queued meanwhile get workers before the next round; one worker
+    // is never used by the search at all.
+    struct Searcher {
+        std::mt19937_64 rng;
+        Decoder decoder;
+        Genome current;
+        Score score;
+        uint64_t evaluations;
+        int stale;
+    };
+    const size_t searcher_count = pool.size() > 1 ? pool.size() - 1 : 1;
+    std::vector<Searcher> searchers;
+    searchers.reserve(searcher_count);
+    for (size_t t = 0; t < searcher_count; ++t) {
+        searchers.push_back(Searcher{std::mt19937_64(settings.seed * 0x9E3779B97F4A7C15ull + t),
+                                     Decoder(shapes, settings), Genome(), Score{-1.0, 0.0, 0.0}, 0, 0});
+    }
+
+    auto run_slice = [&](size_t t, std::chrono::steady_clock::time_point slice_end) {
+        Searcher& s = searchers[t];
+        if (s.evaluations == 0) {
+            {
+                std::lock_guard<std::mutex> lock(best_mutex);
+                s.current = best_genome;
+            }
+            // Other searchers start from scrambled copies so they explore apart
+            if (t > 0) {
+                for (size_t k = 0; k < shapes.size() / 4 + 1; ++k) mutate(s.current, shapes, s.rng);
+            }
+            s.score = s.decoder.run(s.current, nullptr);
+            s.evaluations = 1;
+            publish(s.current, s.score, s.decoder);
+        }
+
+        Genome candidate;
+        while (!cancel_requested.load(std::memory_order_relaxed)) {
+            candidate = s.current;
+            mutate(candidate, shapes, s.rng);
+            Score candidate_score = s.decoder.run(candidate, nullptr);
+            s.evaluations++;
+
+            // Equal scores are accepted too, to drift across plateaus
+            bool improved = false;
+            if (!s.score.better_than(candidate_score)) {
+                improved = candidate_score.better_than(s.score);
+                std::swap(s.current, candidate);
+                s.score = candidate_score;
+                if (improved) {
+                    s.stale = 0;
+                    bool global = false;
+                    {
+                        std::lock_guard<std::mutex> lock(best_mutex);
+                        global = s.score.better_than(best_score);
+                    }
+                    if (global) publish(s.current, s.score, s.decoder);
+                }
+            }
+            if (!improved && ++s.stale > RESTART_AFTER) {
+                s.stale = 0;
+                std::lock_guard<std::mutex> lock(best_mutex);
+                s.current = best_genome;
+                s.score = best_score;
+            }
+
+            if ((s.evaluations & (SLICE_CHECK_EVERY - 1)) == 0) {
+                evaluations.fetch_add(SLICE_CHECK_EVERY, std::memory_order_relaxed);
+                if (std::chrono::steady_clock::now() >= slice_end) break;
+            }
+        }
+    };
+
+    const auto slice = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(SLICE_S));
+    while (!cancel_requested.load(std::memory_order_relaxed)) {
+        auto now = std::chrono::steady_clock::now();
+        if (now >= deadline) break;
+        auto slice_end = std::min(deadline, now + slice);
+        pool.parallel_for(searcher_count, [&](size_t t) { run_slice(t, slice_end); });
+    }
+
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+    {
+        std::lock_guard<std::mutex> lock(best_mutex);
+        std::cout << "Nesting: placed " << best.placed_count << "/" << parts.size() << " parts, "
+                  << best.used_length << " mm of bed, " << evaluations.load() << " layouts in "
+                  << elapsed << " s" << std::endl;
+    }
+    running = false;
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "contour.h"
+#include "containment.h"
+#include "core/thread_pool.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// One part to place: a top-level contour plus everything nested inside it
+struct NestPart {
+    std::vector<uint32_t> contours;
+};
+
+struct NestSettings {
+    double bed_width_mm;
+    double bed_height_mm;
+    double spacing_mm;      // gap kept between parts and to the bed edge
+    int rotation_steps;     // angles tried: k * 360 / rotation_steps
+    double time_budget_s;
+    uint64_t seed;
+
+    NestSettings() : bed_width_mm(300.0), bed_height_mm(200.0), spacing_mm(2.0),
+                     rotation_steps(4), time_budget_s(3.0), seed(1) {}
+};
+
+// Where a part ended up: rotate its drawing coordinates by angle_deg about
+// the origin, then translate by (offset_x, offset_y)
+struct NestPlacement {
+    uint32_t part;
+    bool placed;
+    double angle_deg;
+    double offset_x, offset_y;
+};
+
+struct NestResult {
+    std::vector<NestPlacement> placements;
+    size_t placed_count;
+    double placed_area;     // bounding-box area of placed parts, mm^2
+    double used_length;     // furthest right edge along the bed, mm
+    uint64_t evaluations;
+    uint64_t generation;    // bumped on every improvement
+
+    NestResult() : placed_count(0), placed_area(0.0), used_length(0.0), evaluations(0), generation(0) {}
+
+    double utilisation(double bed_height_mm) const {
+        return used_length > 0.0 ? placed_area / (used_length * bed_height_mm) : 0.0;
+    }
+};
+
+namespace Nesting {
+    // Every top-level contour starts a part; nested contours go with it
+    std::vector<NestPart> parts_from(const Drawing& drawing, const ContainmentTree& nesting);
+
+    // Placed parts only, moved to their bed positions
+    Drawing apply(const Drawing& drawing, const std::vector<NestPart>& parts, const NestResult& result);
+}
+
+// Packs parts onto the bed in the background. Placement is bottom-left on
+// a skyline of rotated bounding boxes, leftmost first so the used strip of
+// the sheet stays short. Up to one searcher per pool worker but one runs
+// its own local search over part order and rotation, in short rounds that
+// leave the pool to other tasks in between. Improvements are published as
+// they are found, so poll_result() gets better results while the search runs.
+class Nester {
+public:
+    // Called from a search thread after each improvement; must not block
+    typedef std::function<void()> ImprovedCallback;
+
+private:
+    ThreadPool& pool;
+    NestSettings settings;
+    std::thread runner;
+    ImprovedCallback on_improved;
+
+    std::atomic<bool> running;
+    std::atomic<bool> cancel_requested;
+    std::atomic<uint64_t> evaluations;
+
+    std::mutex best_mutex;
+    NestResult best;
+
+    void search(const Drawing& drawing, std::vector<NestPart> parts);
+
+public:
+    explicit Nester(ThreadPool& worker_pool = ThreadPool::shared());
+    ~Nester();
+
+    // Returns false if a search is still running. The drawing is copied.
+    bool start(const Drawing& drawing, const std::vector<NestPart>& parts,
+               const NestSettings& nest_settings = NestSettings(),
+               ImprovedCallback callback = nullptr);
+    void cancel();
+    bool is_running() const { return running.load(); }
+
+    // Copies the best result if it is newer than known_generation
+    bool poll_result(NestResult& out, uint64_t known_generation);
+
+    const NestSettings& get_settings() const { return settings; }
+};
@@ -0,0 +1,118 @@
+#include "path_order.h"
+#include "containment.h"
+#include "spatial_grid.h"
+#include <cmath>
+
+namespace {
+    // Entry points are indexed as contour * 2 + end (0 = first point, 1 = last)
+    Vec2 entry_point(const Contour& contour, uint32_t end) {
+        return end ? contour.points.back() : contour.points.front();
+    }
+
+    void order_layer(const Drawing& drawing, const std::vector<uint32_t>& members, const ContainmentTree* nesting,
+                     double& cursor_x, double& cursor_y, PathOrder& result) {
+        std::vector<Bounds2> entries;
+        entries.reserve(members.size() * 2);
+        for (uint32_t id : members) {
+            const Contour& contour = drawing.contours[id];
+            Vec2 first = entry_point(contour, 0);
+            Vec2 last = entry_point(contour, 1);
+            Bounds2 a, b;
+            a.expand(first.x, first.y);
+            b.expand(last.x, last.y);
+            entries.push_back(a);
+            entries.push_back(b);
+        }
+
+        SpatialGrid grid;
+        grid.build(entries);
+
+        // Children on this layer still to be cut, per member; parents are
+        // mapped back to member slots so the count can be released
+        std::vector<uint32_t> pending(members.size(), 0);
+        std::vector<uint32_t> parent_slot;
+        if (nesting) {
+            std::vector<uint32_t> slot(drawing.contours.size(), UINT32_MAX);
+            for (uint32_t local = 0; local < members.size(); ++local) slot[members[local]] = local;
+            parent_slot.assign(members.size(), UINT32_MAX);
+            for (uint32_t local = 0; local < members.size(); ++local) {
+                uint32_t parent = nesting->parent[members[local]];
+                if (parent == ContainmentTree::NO_PARENT || slot[parent] == UINT32_MAX) continue;
+                parent_slot[local] = slot[parent];
+                pending[slot[parent]]++;
+            }
+        }
+
+        std::vector<uint8_t> done(members.size(), 0);
+        auto accept = [&](uint32_t entry) {
+            uint32_t local = entry >> 1;
+            if (done[local] || pending[local]) return false;
+            // Closed contours start and end at the same place
+            return (entry & 1) == 0 || !drawing.contours[members[local]].closed;
+        };
+
+        for (size_t n = 0; n < members.size(); ++n) {
+            uint32_t entry = grid.nearest(cursor_x, cursor_y, accept);
+            if (entry == UINT32_MAX) break;
+
+            uint32_t local = entry >> 1;
+            const Contour& contour = drawing.contours[members[local]];
+            bool reversed = (entry & 1) != 0;
+            done[local] = 1;
+            if (!parent_slot.empty() && parent_slot[local] != UINT32_MAX) pending[parent_slot[local]]--;
+
+            result.order.push_back(members[local]);
+            result.reversed.push_back(reversed ? 1 : 0);
+
+            Vec2 exit = contour.closed ? contour.points.front() : entry_point(contour, reversed ? 0 : 1);
+            cursor_x = exit.x;
+            cursor_y = exit.y;
+        }
+    }
+}
+
+namespace PathOrdering {
+
+    PathOrder nearest_neighbour(const Drawing& drawing, double start_x, double start_y,
+                                const ContainmentTree* nesting) {
+        PathOrder result;
+        result.order.reserve(drawing.contours.size());
+        result.reversed.reserve(drawing.contours.size());
+
+        size_t layer_count = drawing.layers.size();
+        for (const auto& contour : drawing.contours) {
+            if (contour.layer >= layer_count) layer_count = contour.layer + 1u;
+        }
+
+        std::vector<std::vector<uint32_t>> by_layer(layer_count);
+        for (uint32_t i = 0; i < drawing.contours.size(); ++i) {
+            if (drawing.contours[i].points.empty()) continue;
+            by_layer[drawing.contours[i].layer].push_back(i);
+        }
+
+        double cursor_x = start_x;
+        double cursor_y = start_y;
+        for (const auto& members : by_layer) {
+            if (!members.empty()) {
+                order_layer(drawing, members, nesting, cursor_x, cursor_y, result);
+            }
+        }
+        return result;
+    }
+
+    double travel_distance(const Drawing& drawing, const PathOrder& order, double start_x, double start_y) {
+        double total = 0.0;
+        double x = start_x, y = start_y;
+        for (size_t i = 0; i < order.size(); ++i) {
+            const Contour& contour = drawing.contours[order.order[i]];
+            bool reversed = order.reversed[i] != 0;
+            Vec2 entry = reversed ? contour.points.back() : contour.points.front();
+            Vec2 exit = contour.closed ? entry : (reversed ? contour.points.front() : contour.points.back());
+            total += std::hypot(entry.x - x, entry.y - y);
+            x = exit.x;
+            y = exit.y;
+        }
+        return total;
+    }
+
+}
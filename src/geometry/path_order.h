@@ -0,0 +1,30 @@
+#pragma once
+
+#include "contour.h"
+#include <cstdint>
+#include <vector>
+
+struct ContainmentTree;
+
+// Cut sequence over a drawing's contours: order[i] is a contour index and
+// reversed[i] says whether it is cut end-to-start.
+struct PathOrder {
+    std::vector<uint32_t> order;
+    std::vector<uint8_t> reversed;
+
+    size_t size() const { return order.size(); }
+};
+
+namespace PathOrdering {
+    // Greedy nearest-neighbour ordering, layer by layer in layer index order,
+    // starting from (start_x, start_y). Open contours may be entered from
+    // either end; closed contours are entered at their first point. With a
+    // nesting tree, a contour is only picked once everything inside it on
+    // the same layer has been cut, so parts are not freed before their holes.
+    PathOrder nearest_neighbour(const Drawing& drawing, double start_x = 0.0, double start_y = 0.0,
+                                const ContainmentTree* nesting = nullptr);
+
+    // Total rapid travel distance the order implies, in millimetres
+    double travel_distance(const Drawing& drawing, const PathOrder& order,
+                           double start_x = 0.0, double start_y = 0.0);
+}
@@ -0,0 +1,433 @@
+#include "polygon_offset.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    constexpr double PI = 3.141592653589793;
+    // Loops smaller than this (in square steps) are rounding debris
+    constexpr double MIN_LOOP_AREA = 1.0;
+    // How far either side of a loop edge its winding is sampled, in steps:
+    // clear of the half step crossing nodes are rounded by
+    constexpr double PROBE_DISTANCE = 1.0;
+
+    struct DPoint {
+        double x, y;
+    };
+
+    int64_t cross(const IntPoint& o, const IntPoint& a, const IntPoint& b) {
+        return (a.x - o.x) * (b.y - o.y) - (a.y - o.y) * (b.x - o.x);
+    }
+
+    int sign(int64_t v) { return (v > 0) - (v < 0); }
+
+    IntPath strip_duplicates(const IntPath& path) {
+        IntPath result;
+        result.reserve(path.size());
+        for (const auto& p : path) {
+            if (result.empty() || result.back() != p) result.push_back(p);
+        }
+        while (result.size() > 1 && result.front() == result.back()) result.pop_back();
+        return result;
+    }
+
+    // Drops vertices that lie on the straight line through their neighbours
+    IntPath strip_collinear(const IntPath& path) {
+        const size_t n = path.size();
+        if (n < 3) return path;
+        IntPath result;
+        result.reserve(n);
+        for (size_t i = 0; i < n; ++i) {
+            const IntPoint& prev = path[(i + n - 1) % n];
+            const IntPoint& next = path[(i + 1) % n];
+            const IntPoint& p = path[i];
+            bool straight = cross(prev, p, next) == 0 &&
+                            (p.x - prev.x) * (next.x - p.x) + (p.y - prev.y) * (next.y - p.y) > 0;
+            if (!straight) result.push_back(p);
+        }
+        return result;
+    }
+
+    struct Crossing {
+        double t;      // position along the segment
+        uint32_t node;
+    };
+
+    struct SequenceEntry {
+        IntPoint point;
+        int64_t node;  // -1 for a vertex where the path does not meet itself
+    };
+
+    // Proper crossing of segments ab and cd (touching does not count)
+    bool segments_cross(const IntPoint& a, const IntPoint& b, const IntPoint& c, const IntPoint& d,
+                        double& t, double& u) {
+        int o1 = sign(cross(a, b, c));
+        int o2 = sign(cross(a, b, d));
+        int o3 = sign(cross(c, d, a));
+        int o4 = sign(cross(c, d, b));
+        if (o1 * o2 >= 0 || o3 * o4 >= 0) return false;
+
+        double rx = static_cast<double>(b.x - a.x), ry = static_cast<double>(b.y - a.y);
+        double sx = static_cast<double>(d.x - c.x), sy = static_cast<double>(d.y - c.y);
+        double qx = static_cast<double>(c.x - a.x), qy = static_cast<double>(c.y - a.y);
+        double denom = rx * sy - ry * sx;
+        t = (qx * sy - qy * sx) / denom;
+        u = (qx * ry - qy * rx) / denom;
+        return true;
+    }
+
+    // Position of v along segment ab if it lies strictly inside it
+    bool touches_interior(const IntPoint& a, const IntPoint& b, const IntPoint& v, double& t) {
+        if (cross(a, b, v) != 0) return false;
+        int64_t dot = (v.x - a.x) * (b.x - a.x) + (v.y - a.y) * (b.y - a.y);
+        int64_t len_sq = (b.x - a.x) * (b.x - a.x) + (b.y - a.y) * (b.y - a.y);
+        if (dot <= 0 || dot >= len_sq) return false;
+        t = static_cast<double>(dot) / static_cast<double>(len_sq);
+        return true;
+    }
+
+    // Finds where the path meets itself. Proper crossings become nodes on two
+    // segments; a vertex lying on another segment or on another vertex (how
+    // collinear overlaps show up with axis-aligned input) becomes a node
+    // shared by that vertex and the other visit.
+    void find_crossings(const IntPath& path, std::vector<std::vector<Crossing>>& per_segment,
+                        std::vector<int64_t>& vertex_node, std::vector<IntPoint>& nodes) {
+        const size_t n = path.size();
+        per_segment.assign(n, {});
+        vertex_node.assign(n, -1);
+
+        auto vertex_on_segment = [&](size_t vertex, size_t segment) {
+            double t;
+            if (vertex_node[vertex] >= 0) return;
+            if (!touches_interior(path[segment], path[(segment + 1) % n], path[vertex], t)) return;
+            uint32_t node = static_cast<uint32_t>(nodes.size());
+            nodes.push_back(path[vertex]);
+            vertex_node[vertex] = node;
+            per_segment[segment].push_back(Crossing{t, node});
+        };
+
+        auto test_pair = [&](size_t i, size_t j) {
+            if (j == i || j == (i + 1) % n || i == (j + 1) % n) return;
+            double t, u;
+            if (!segments_cross(path[i], path[(i + 1) % n], path[j], path[(j + 1) % n], t, u)) {
+                vertex_on_segment(j, i);
+                vertex_on_segment(i, j);
+                return;
+            }
+
+            const IntPoint& a = path[i];
+            const IntPoint& b = path[(i + 1) % n];
+            IntPoint p{a.x + std::llround((b.x - a.x) * t), a.y + std::llround((b.y - a.y) * t)};
+            uint32_t node = static_cast<uint32_t>(nodes.size());
+            nodes.push_back(p);
+            per_segment[i].push_back(Crossing{t, node});
+            per_segment[j].push_back(Crossing{u, node});
+        };
+
+        // Sweep over x: segments sorted by left end, tested only against
+        // those still overlapping in x
+        struct Span {
+            int64_t min_x, max_x, min_y, max_y;
+        };
+        std::vector<Span> spans(n);
+        std::vector<uint32_t> sorted(n);
+        for (uint32_t i = 0; i < n; ++i) {
+            const IntPoint& a = path[i];
+            const IntPoint& b = path[(i + 1) % n];
+            spans[i] = Span{std::min(a.x, b.x), std::max(a.x, b.x), std::min(a.y, b.y), std::max(a.y, b.y)};
+            sorted[i] = i;
+        }
+        std::sort(sorted.begin(), sorted.end(),
+                  [&](uint32_t a, uint32_t b) { return spans[a].min_x < spans[b].min_x; });
+
+        std::vector<uint32_t> active;
+        for (uint32_t i : sorted) {
+            const Span& span = spans[i];
+            size_t kept = 0;
+            for (uint32_t j : active) {
+                if (spans[j].max_x < span.min_x) continue;
+                active[kept++] = j;
+                if (spans[j].max_y < span.min_y || span.max_y < spans[j].min_y) continue;
+                test_pair(std::min(i, j), std::max(i, j));
+            }
+            active.resize(kept);
+            active.push_back(i);
+        }
+
+        // Coincident vertices (pinch points)
+        std::vector<uint32_t> by_position(n);
+        for (uint32_t i = 0; i < n; ++i) by_position[i] = i;
+        std::sort(by_position.begin(), by_position.end(), [&](uint32_t a, uint32_t b) {
+            return path[a].x != path[b].x ? path[a].x < path[b].x : path[a].y < path[b].y;
+        });
+        for (size_t k = 0; k + 1 < n; ++k) {
+            uint32_t a = by_position[k], b = by_position[k + 1];
+            if (path[a] != path[b] || vertex_node[a] >= 0 || vertex_node[b] >= 0) continue;
+            uint32_t node = static_cast<uint32_t>(nodes.size());
+            nodes.push_back(path[a]);
+            vertex_node[a] = node;
+            vertex_node[b] = node;
+        }
+
+        for (auto& crossings : per_segment) {
+            if (crossings.size() > 1) {
+                std::sort(crossings.begin(), crossings.end(),
+                          [](const Crossing& a, const Crossing& b) { return a.t < b.t; });
+            }
+        }
+    }
+
+    // Winding number of the closed path around (x, y)
+    int winding_number(const IntPath& path, double x, double y) {
+        int winding = 0;
+        const size_t n = path.size();
+        for (size_t i = 0; i < n; ++i) {
+            const IntPoint& a = path[i];
+            const IntPoint& b = path[(i + 1) % n];
+            double ay = static_cast<double>(a.y), by = static_cast<double>(b.y);
+            if ((ay <= y) == (by <= y)) continue;
+            double side = (b.x - a.x) * (y - ay) - (x - a.x) * (by - ay);
+            if (by > ay) winding += side > 0 ? 1 : 0;
+            else winding -= side < 0 ? 1 : 0;
+        }
+        return winding;
+    }
+
+    IntPath make_loop(const std::vector<SequenceEntry>& entries, size_t from) {
+        IntPath loop;
+        loop.reserve(entries.size() - from);
+        for (size_t k = from; k < entries.size(); ++k) {
+            if (loop.empty() || loop.back() != entries[k].point) loop.push_back(entries[k].point);
+        }
+        return strip_collinear(strip_duplicates(loop));
+    }
+
+    // Keeps the loops that bound the region the raw path covers at least
+    // once (positive fill, relative to the input winding, as Clipper's
+    // positive union). A loop is judged by its longest edge, sampled just
+    // to its left and right: it bounds the region if exactly one side is
+    // filled. Where the raw offset overlaps itself (a slot that closed)
+    // both sides count 2 or more and the loop goes; the outline around it
+    // has 1 inside and 0 outside, however deep the overlap in its middle.
+    IntPaths select_boundary_loops(const IntPath& raw, IntPaths& loops, int expected_sign) {
+        IntPaths result;
+        for (auto& loop : loops) {
+            if (loop.size() < 3) continue;
+            if (std::fabs(PolygonOffset::area(loop)) < MIN_LOOP_AREA) continue;
+
+            size_t longest = 0;
+            double longest_length = 0.0;
+            for (size_t i = 0; i < loop.size(); ++i) {
+                const IntPoint& a = loop[i];
+                const IntPoint& b = loop[(i + 1) % loop.size()];
+                double length = std::hypot(static_cast<double>(b.x - a.x), static_cast<double>(b.y - a.y));
+                if (length > longest_length) {
+                    longest = i;
+                    longest_length = length;
+                }
+            }
+            const IntPoint& a = loop[longest];
+            const IntPoint& b = loop[(longest + 1) % loop.size()];
+            double mx = (a.x + b.x) * 0.5, my = (a.y + b.y) * 0.5;
+            double nx = -(b.y - a.y) / longest_length * PROBE_DISTANCE;
+            double ny = (b.x - a.x) / longest_length * PROBE_DISTANCE;
+            bool left = winding_number(raw, mx + nx, my + ny) * expected_sign >= 1;
+            bool right = winding_number(raw, mx - nx, my - ny) * expected_sign >= 1;
+            if (left != right) result.push_back(std::move(loop));
+        }
+        return result;
+    }
+
+    IntPaths clean(const IntPath& input, int expected_sign) {
+        IntPath path = strip_duplicates(input);
+        IntPaths loops;
+        if (path.size() < 3) return loops;
+
+        std::vector<std::vector<Crossing>> per_segment;
+        std::vector<int64_t> vertex_node;
+        std::vector<IntPoint> nodes;
+        find_crossings(path, per_segment, vertex_node, nodes);
+
+        if (nodes.empty()) {
+            double a = PolygonOffset::area(path);
+            if (std::fabs(a) >= MIN_LOOP_AREA && (a > 0 ? 1 : -1) == expected_sign) {
+                loops.push_back(std::move(path));
+            }
+            return loops;
+        }
+
+        // Walk the curve; every time a crossing node comes round again, the
+        // stretch since its first visit is a closed loop of its own
+        std::vector<SequenceEntry> stack;
+        stack.reserve(path.size() + nodes.size() * 2);
+        std::vector<int64_t> position(nodes.size(), -1);
+
+        auto visit = [&](const SequenceEntry& entry) {
+            if (entry.node >= 0 && position[entry.node] >= 0) {
+                size_t from = static_cast<size_t>(position[entry.node]);
+                loops.push_back(make_loop(stack, from));
+                for (size_t k = from + 1; k < stack.size(); ++k) {
+                    if (stack[k].node >= 0) position[stack[k].node] = -1;
+                }
+                stack.resize(from + 1);
+                return;
+            }
+            stack.push_back(entry);
+            if (entry.node >= 0) position[entry.node] = static_cast<int64_t>(stack.size() - 1);
+        };
+
+        for (size_t i = 0; i < path.size(); ++i) {
+            visit(SequenceEntry{path[i], vertex_node[i]});
+            for (const auto& crossing : per_segment[i]) {
+                visit(SequenceEntry{nodes[crossing.node], static_cast<int64_t>(crossing.node)});
+            }
+        }
+        loops.push_back(make_loop(stack, 0));
+        return select_boundary_loops(path, loops, expected_sign);
+    }
+}
+
+namespace PolygonOffset {
+
+    double area(const IntPath& path) {
+        const size_t n = path.size();
+        if (n < 3) return 0.0;
+        // Relative to the first point so large coordinates keep precision
+        int64_t twice = 0;
+        for (size_t i = 1; i + 1 < n; ++i) {
+            twice += cross(path[0], path[i], path[i + 1]);
+        }
+        return static_cast<double>(twice) * 0.5;
+    }
+
+    IntPaths offset(const IntPath& input, double delta, const OffsetSettings& settings) {
+        IntPath path = strip_duplicates(input);
+        IntPaths result;
+        if (path.size() < 3) return result;
+
+        double signed_area = area(path);
+        if (signed_area == 0.0) return result;
+        const int winding = signed_area > 0 ? 1 : -1;
+
+        if (delta == 0.0) {
+            result.push_back(std::move(path));
+            return result;
+        }
+
+        // Unit normals pointing out of the region, one per edge
+        const size_t n = path.size();
+        std::vector<DPoint> normals(n);
+        std::vector<double> lengths(n);
+        for (size_t i = 0; i < n; ++i) {
+            const IntPoint& a = path[i];
+            const IntPoint& b = path[(i + 1) % n];
+            double dx = static_cast<double>(b.x - a.x);
+            double dy = static_cast<double>(b.y - a.y);
+            double len = std::sqrt(dx * dx + dy * dy);
+            lengths[i] = len;
+            normals[i] = DPoint{winding * dy / len, -winding * dx / len};
+        }
+
+        const double abs_delta = std::fabs(delta);
+        const double miter_min = 2.0 / (settings.miter_limit * settings.miter_limit);
+        double arc_step = PI;
+        if (settings.arc_tolerance < abs_delta) {
+            arc_step = 2.0 * std::acos(1.0 - settings.arc_tolerance / abs_delta);
+        }
+
+        std::vector<DPoint> raw;
+        raw.reserve(n * 3);
+        auto push = [&](double x, double y) { raw.push_back(DPoint{x, y}); };
+
+        for (size_t i = 0; i < n; ++i) {
+            const DPoint& n1 = normals[(i + n - 1) % n];
+            const DPoint& n2 = normals[i];
+            const double px = static_cast<double>(path[i].x);
+            const double py = static_cast<double>(path[i].y);
+
+            double sin_a = n1.x * n2.y - n1.y * n2.x;
+            double cos_a = n1.x * n2.x + n1.y * n2.y;
+
+            if (cos_a > 0.999999) {
+                // Straight through: one point on the shared offset line
+                push(px + n2.x * delta, py + n2.y * delta);
+                continue;
+            }
+
+            if (sin_a * winding * delta < 0 && cos_a > -0.999999) {
+                // Concave corner. When the two offset lines meet within
+                // half of each edge, their intersection is the answer and
+                // no loop is made (the common case on flattened curves)
+                double reach = abs_delta * std::fabs(sin_a) / (1.0 + cos_a);
+                double room = 0.5 * std::min(lengths[(i + n - 1) % n], lengths[i]);
+                if (reach <= room) {
+                    double scale = delta / (1.0 + cos_a);
+                    push(px + (n1.x + n2.x) * scale, py + (n1.y + n2.y) * scale);
+                    continue;
+                }
+                // Otherwise go back through the vertex so the overlap forms
+                // an inverted loop that cleanup drops
+                push(px + n1.x * delta, py + n1.y * delta);
+                push(px, py);
+                push(px + n2.x * delta, py + n2.y * delta);
+                continue;
+            }
+
+            JoinType join = settings.join;
+            if (join == JoinType::MITER && 1.0 + cos_a < miter_min) join = JoinType::SQUARE;
+
+            if (join == JoinType::MITER) {
+                double scale = delta / (1.0 + cos_a);
+                push(px + (n1.x + n2.x) * scale, py + (n1.y + n2.y) * scale);
+            } else if (join == JoinType::SQUARE) {
+                // Cut the corner with a line |delta| from the vertex, square
+                // to the bisector (or to the incoming edge on a full reversal)
+                DPoint bisector{n1.x + n2.x, n1.y + n2.y};
+                double blen = std::sqrt(bisector.x * bisector.x + bisector.y * bisector.y);
+                if (blen < 1e-9) {
+                    double side = delta > 0 ? winding : -winding;
+                    bisector = DPoint{-n1.y * side, n1.x * side};
+                } else {
+                    bisector = DPoint{bisector.x / blen, bisector.y / blen};
+                }
+                // Any direction along each offset line works; the solve below
+                // picks the signed distance to the cut line
+                DPoint t1{n1.y, -n1.x};
+                DPoint t2{n2.y, -n2.x};
+                double along1 = (1.0 - (n1.x * bisector.x + n1.y * bisector.y)) /
+                                (t1.x * bisector.x + t1.y * bisector.y);
+                double along2 = (1.0 - (n2.x * bisector.x + n2.y * bisector.y)) /
+                                (t2.x * bisector.x + t2.y * bisector.y);
+                along1 = std::clamp(along1, -1e3, 1e3) * delta;
+                along2 = std::clamp(along2, -1e3, 1e3) * delta;
+                push(px + n1.x * delta + t1.x * along1, py + n1.y * delta + t1.y * along1);
+                push(px + n2.x * delta + t2.x * along2, py + n2.y * delta + t2.y * along2);
+            } else {
+                double sweep = std::atan2(sin_a, cos_a);
+                if (std::fabs(sweep) < 1e-9) sweep = PI * winding;
+                int steps = std::max(1, static_cast<int>(std::ceil(std::fabs(sweep) / arc_step)));
+                for (int k = 0; k <= steps; ++k) {
+                    double angle = sweep * k / steps;
+                    double c = std::cos(angle), s = std::sin(angle);
+                    double nx = n1.x * c - n1.y * s;
+                    double ny = n1.x * s + n1.y * c;
+                    push(px + nx * delta, py + ny * delta);
+                }
+            }
+        }
+
+        IntPath rounded;
+        rounded.reserve(raw.size());
+        for (const auto& p : raw) {
+            IntPoint q{std::llround(p.x), std::llround(p.y)};
+            if (rounded.empty() || rounded.back() != q) rounded.push_back(q);
+        }
+        return clean(rounded, winding);
+    }
+
+    IntPaths clean_self_intersections(const IntPath& path) {
+        double a = area(path);
+        if (a == 0.0) return IntPaths();
+        return clean(path, a > 0 ? 1 : -1);
+    }
+
+}
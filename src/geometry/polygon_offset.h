@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+struct IntPoint {
+    int64_t x, y;
+
+    bool operator==(const IntPoint& other) const { return x == other.x && y == other.y; }
+    bool operator!=(const IntPoint& other) const { return !(*this == other); }
+};
+
+// Closed polygon in integer machine coordinates (K40 steps); the last point
+// connects back to the first and is not repeated.
+typedef std::vector<IntPoint> IntPath;
+typedef std::vector<IntPath> IntPaths;
+
+enum class JoinType {
+    MITER,   // sharp corners, squared off beyond miter_limit
+    ROUND,   // arcs within arc_tolerance of the true offset
+    SQUARE   // corners cut off at the offset distance
+};
+
+struct OffsetSettings {
+    JoinType join;
+    double miter_limit;      // in multiples of the offset distance
+    double arc_tolerance;    // steps
+
+    OffsetSettings() : join(JoinType::ROUND), miter_limit(2.0), arc_tolerance(0.25) {}
+};
+
+// Clipper-style offsetting of closed polygons in integer coordinates. The
+// raw offset is split at its self-intersections into simple loops, and only
+// loops bounding the area it covers at least once are kept: swallowtails at
+// concave corners, collapsed necks and slots that closed up are dropped.
+namespace PolygonOffset {
+    // Signed area, positive for counter-clockwise
+    double area(const IntPath& path);
+
+    // Offsets the region enclosed by path; delta > 0 grows it, delta < 0
+    // shrinks it, whichever way the path winds. Output loops keep the input
+    // winding. An inward offset can split a region or remove it entirely.
+    IntPaths offset(const IntPath& path, double delta, const OffsetSettings& settings = OffsetSettings());
+
+    // Splits a closed, possibly self-intersecting path into simple loops
+    // and keeps those wound like the input (see offset)
+    IntPaths clean_self_intersections(const IntPath& path);
+}
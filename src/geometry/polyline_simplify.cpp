@@ -0,0 +1,82 @@
+#include "polyline_simplify.h"
+#include "simplify_kernels.h"
+#include "core/trace.h"
+#include <utility>
+#include <vector>
+
+namespace PolylineSimplify {
+
+    namespace {
+        // Marks the points of (first, last) that must stay. Index count stands
+        // for points[0], so a closed contour's last span can end on its start.
+        void mark(const Vec2* points, size_t count, size_t first, size_t last, double tolerance_sq,
+                  std::vector<uint8_t>& keep, std::vector<std::pair<size_t, size_t>>& spans) {
+            spans.emplace_back(first, last);
+            while (!spans.empty()) {
+                auto [from, to] = spans.back();
+                spans.pop_back();
+                if (to - from < 2) continue;
+
+                double distance_sq = 0.0;
+                size_t farthest = from + 1 + SimplifyKernels::farthest_from_segment(
+                    points + from + 1, to - from - 1, points[from], points[to == count ? 0 : to], distance_sq);
+                if (distance_sq <= tolerance_sq) continue;
+
+                keep[farthest] = 1;
+                spans.emplace_back(from, farthest);
+                spans.emplace_back(farthest, to);
+            }
+        }
+    }
+
+    void simplify(const Vec2* points, size_t count, bool closed, double tolerance, PointList& out) {
+        if (count <= 2 || tolerance <= 0.0) {
+            out.insert(out.end(), points, points + count);
+            return;
+        }
+
+        const double tolerance_sq = tolerance * tolerance;
+        std::vector<uint8_t> keep(count, 0);
+        std::vector<std::pair<size_t, size_t>> spans;
+        keep[0] = 1;
+        if (closed) {
+            // Split at the point farthest from the start; both halves then
+            // have two distinct ends
+            double distance_sq = 0.0;
+            size_t split = 1 + SimplifyKernels::farthest_from_segment(points + 1, count - 1, points[0], points[0],
+                                                                      distance_sq);
+            keep[split] = 1;
+            mark(points, count, 0, split, tolerance_sq, keep, spans);
+            mark(points, count, split, count, tolerance_sq, keep, spans);
+        } else {
+            keep[count - 1] = 1;
+            mark(points, count, 0, count - 1, tolerance_sq, keep, spans);
+        }
+
+        for (size_t i = 0; i < count; ++i) {
+            if (keep[i]) out.push_back(points[i]);
+        }
+    }
+
+    Drawing simplify(const Drawing& drawing, double tolerance, SimplifyStats* stats, ThreadPool& pool) {
+        TRACE_SPAN("geometry.simplify");
+        Drawing result;
+        result.layers = drawing.layers;
+        result.contours.resize(drawing.contours.size());
+
+        pool.parallel_for(drawing.contours.size(), [&](size_t i) {
+            const Contour& source = drawing.contours[i];
+            Contour& contour = result.contours[i];
+            contour.closed = source.closed;
+            contour.layer = source.layer;
+            contour.bounds = source.bounds;   // extreme points may go, but never past these
+            simplify(source.points.data(), source.points.size(), source.closed, tolerance, contour.points);
+        });
+
+        if (stats) {
+            stats->points_in = drawing.point_count();
+            stats->points_out = result.point_count();
+        }
+        return result;
+    }
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "contour.h"
+#include "core/thread_pool.h"
+#include <cstddef>
+
+struct SimplifyStats {
+    size_t points_in;
+    size_t points_out;
+};
+
+// Douglas-Peucker simplification with an error bound: every dropped point
+// lies within tolerance of the simplified polyline, endpoints are kept, and
+// so is the shape of each contour (closed stays closed, nothing is dropped
+// entirely). The farthest-point search runs on SimplifyKernels.
+namespace PolylineSimplify {
+    // Appends the simplified copy of points[0, count) to out
+    void simplify(const Vec2* points, size_t count, bool closed, double tolerance, PointList& out);
+
+    // Every contour, one per task on the pool; layers and order are kept
+    Drawing simplify(const Drawing& drawing, double tolerance, SimplifyStats* stats = nullptr,
+                     ThreadPool& pool = ThreadPool::shared());
+}
@@ -0,0 +1,56 @@
+#include "segment_batch.h"
+#include <cmath>
+
+namespace {
+    constexpr double PI = 3.141592653589793;
+}
+
+Affine2 Affine2::rotation_deg(double degrees) {
+    const double radians = degrees * PI / 180.0;
+    const double c = std::cos(radians), s = std::sin(radians);
+    return Affine2{c, -s, s, c, 0.0, 0.0};
+}
+
+void SegmentBatch::clear() {
+    x0.clear();
+    y0.clear();
+    x1.clear();
+    y1.clear();
+    contour.clear();
+}
+
+void SegmentBatch::reserve(size_t count) {
+    x0.reserve(count);
+    y0.reserve(count);
+    x1.reserve(count);
+    y1.reserve(count);
+    contour.reserve(count);
+}
+
+void SegmentBatch::resize(size_t count) {
+    x0.resize(count);
+    y0.resize(count);
+    x1.resize(count);
+    y1.resize(count);
+    contour.resize(count);
+}
+
+void SegmentBatch::push_back(Vec2 a, Vec2 b, uint32_t contour_index) {
+    x0.push_back(a.x);
+    y0.push_back(a.y);
+    x1.push_back(b.x);
+    y1.push_back(b.y);
+    contour.push_back(contour_index);
+}
+
+SegmentBatch SegmentBatch::from(const Drawing& drawing) {
+    SegmentBatch batch;
+    batch.reserve(drawing.point_count());
+    for (size_t i = 0; i < drawing.contours.size(); ++i) {
+        const PointList& points = drawing.contours[i].points;
+        const uint32_t index = static_cast<uint32_t>(i);
+        for (size_t k = 1; k < points.size(); ++k) batch.push_back(points[k - 1], points[k], index);
+        if (drawing.contours[i].closed && points.size() > 2) batch.push_back(points.back(), points[0], index);
+    }
+    return batch;
+}
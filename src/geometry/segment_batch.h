@@ -0,0 +1,43 @@
+#pragma once
+
+#include "contour.h"
+#include <cstddef>
+#include <cstdint>
+
+// 2D affine map: x' = a x + b y + tx, y' = c x + d y + ty
+struct Affine2 {
+    double a, b, c, d, tx, ty;
+
+    static Affine2 identity() { return Affine2{1.0, 0.0, 0.0, 1.0, 0.0, 0.0}; }
+    static Affine2 translation(double x, double y) { return Affine2{1.0, 0.0, 0.0, 1.0, x, y}; }
+    static Affine2 scale(double sx, double sy) { return Affine2{sx, 0.0, 0.0, sy, 0.0, 0.0}; }
+    static Affine2 rotation_deg(double degrees);
+
+    // This map followed by next
+    Affine2 then(const Affine2& next) const {
+        return Affine2{next.a * a + next.b * c, next.a * b + next.b * d,
+                       next.c * a + next.d * c, next.c * b + next.d * d,
+                       next.a * tx + next.b * ty + next.tx, next.c * tx + next.d * ty + next.ty};
+    }
+
+    Vec2 apply(Vec2 p) const { return Vec2{a * p.x + b * p.y + tx, c * p.x + d * p.y + ty}; }
+};
+
+// Line segments as structure of arrays, so batch kernels load four x0s (or
+// y0s, ...) with one instruction instead of gathering them from Vec2 pairs.
+// contour[i] is the drawing contour segment i came from.
+struct SegmentBatch {
+    TrackedVector<double, MemoryTag::DRAWING> x0, y0, x1, y1;
+    TrackedVector<uint32_t, MemoryTag::DRAWING> contour;
+
+    size_t size() const { return x0.size(); }
+    bool empty() const { return x0.empty(); }
+
+    void clear();
+    void reserve(size_t count);
+    void resize(size_t count);
+    void push_back(Vec2 a, Vec2 b, uint32_t contour_index);
+
+    // Every edge of every contour, closing edges included
+    static SegmentBatch from(const Drawing& drawing);
+};
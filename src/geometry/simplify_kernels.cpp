@@ -0,0 +1,171 @@
+#include "simplify_kernels.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SIMPLIFY_KERNELS_X86 1
+#endif
+
+namespace SimplifyKernels {
+
+    namespace {
+        typedef size_t (*FarthestFn)(const Vec2*, size_t, Vec2, Vec2, double&);
+
+        // Segment a-b as origin, direction and 1/|direction|^2 (0 when a == b,
+        // which turns the distance into plain distance to a)
+        struct Segment {
+            double ax, ay, ex, ey, inv_length_sq;
+
+            Segment(Vec2 a, Vec2 b) : ax(a.x), ay(a.y), ex(b.x - a.x), ey(b.y - a.y) {
+                double length_sq = ex * ex + ey * ey;
+                inv_length_sq = length_sq > 0.0 ? 1.0 / length_sq : 0.0;
+            }
+
+            double distance_sq(Vec2 p) const {
+                double px = p.x - ax, py = p.y - ay;
+                double t = (px * ex + py * ey) * inv_length_sq;
+                t = t < 0.0 ? 0.0 : (t > 1.0 ? 1.0 : t);
+                double dx = px - t * ex, dy = py - t * ey;
+                return dx * dx + dy * dy;
+            }
+        };
+
+        size_t farthest_scalar_from(const Vec2* points, size_t start, size_t count, const Segment& segment,
+                                    size_t best, double& best_sq) {
+            for (size_t i = start; i < count; ++i) {
+                double d = segment.distance_sq(points[i]);
+                if (d > best_sq) {
+                    best_sq = d;
+                    best = i;
+                }
+            }
+            return best;
+        }
+
+        size_t farthest_scalar(const Vec2* points, size_t count, Vec2 a, Vec2 b, double& distance_sq) {
+            distance_sq = -1.0;
+            return farthest_scalar_from(points, 0, count, Segment(a, b), 0, distance_sq);
+        }
+
+#ifdef SIMPLIFY_KERNELS_X86
+        // Lanes hold points i and i+1; indices are kept as doubles so the
+        // compare mask selects them directly
+        size_t farthest_sse2(const Vec2* points, size_t count, Vec2 a, Vec2 b, double& distance_sq) {
+            const Segment segment(a, b);
+            const __m128d ax = _mm_set1_pd(segment.ax), ay = _mm_set1_pd(segment.ay);
+            const __m128d ex = _mm_set1_pd(segment.ex), ey = _mm_set1_pd(segment.ey);
+            const __m128d inv = _mm_set1_pd(segment.inv_length_sq);
+            const __m128d zero = _mm_setzero_pd(), one = _mm_set1_pd(1.0), step = _mm_set1_pd(2.0);
+
+            __m128d best = _mm_set1_pd(-1.0);
+            __m128d best_index = zero;
+            __m128d index = _mm_set_pd(1.0, 0.0);
+
+            size_t i = 0;
+            for (; i + 2 <= count; i += 2) {
+                __m128d p0 = _mm_loadu_pd(&points[i].x);
+                __m128d p1 = _mm_loadu_pd(&points[i + 1].x);
+                __m128d px = _mm_sub_pd(_mm_unpacklo_pd(p0, p1), ax);
+                __m128d py = _mm_sub_pd(_mm_unpackhi_pd(p0, p1), ay);
+                __m128d t = _mm_mul_pd(_mm_add_pd(_mm_mul_pd(px, ex), _mm_mul_pd(py, ey)), inv);
+                t = _mm_min_pd(_mm_max_pd(t, zero), one);
+                __m128d dx = _mm_sub_pd(px, _mm_mul_pd(t, ex));
+                __m128d dy = _mm_sub_pd(py, _mm_mul_pd(t, ey));
+                __m128d d = _mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy));
+
+                __m128d farther = _mm_cmpgt_pd(d, best);
+                best = _mm_or_pd(_mm_and_pd(farther, d), _mm_andnot_pd(farther, best));
+                best_index = _mm_or_pd(_mm_and_pd(farther, index), _mm_andnot_pd(farther, best_index));
+                index = _mm_add_pd(index, step);
+            }
+
+            double lanes[2], lane_index[2];
+            _mm_storeu_pd(lanes, best);
+            _mm_storeu_pd(lane_index, best_index);
+            size_t result = static_cast<size_t>(lane_index[0]);
+            distance_sq = lanes[0];
+            if (lanes[1] > distance_sq || (lanes[1] == distance_sq && lane_index[1] < lane_index[0])) {
+                distance_sq = lanes[1];
+                result = static_cast<size_t>(lane_index[1]);
+            }
+            return farthest_scalar_from(points, i, count, segment, result, distance_sq);
+        }
+
+        // Four points per step. Unpacking two loads of two points each gives
+        // x and y vectors in the lane order i, i+2, i+1, i+3.
+        __attribute__((target("avx2")))
+        size_t farthest_avx2(const Vec2* points, size_t count, Vec2 a, Vec2 b, double& distance_sq) {
+            const Segment segment(a, b);
+            const __m256d ax = _mm256_set1_pd(segment.ax), ay = _mm256_set1_pd(segment.ay);
+            const __m256d ex = _mm256_set1_pd(segment.ex), ey = _mm256_set1_pd(segment.ey);
+            const __m256d inv = _mm256_set1_pd(segment.inv_length_sq);
+            const __m256d zero = _mm256_setzero_pd(), one = _mm256_set1_pd(1.0), step = _mm256_set1_pd(4.0);
+
+            __m256d best = _mm256_set1_pd(-1.0);
+            __m256d best_index = zero;
+            __m256d index = _mm256_set_pd(3.0, 1.0, 2.0, 0.0);
+
+            size_t i = 0;
+            for (; i + 4 <= count; i += 4) {
+                __m256d p01 = _mm256_loadu_pd(&points[i].x);
+                __m256d p23 = _mm256_loadu_pd(&points[i + 2].x);
+                __m256d px = _mm256_sub_pd(_mm256_unpacklo_pd(p01, p23), ax);
+                __m256d py = _mm256_sub_pd(_mm256_unpackhi_pd(p01, p23), ay);
+                __m256d t = _mm256_mul_pd(_mm256_add_pd(_mm256_mul_pd(px, ex), _mm256_mul_pd(py, ey)), inv);
+                t = _mm256_min_pd(_mm256_max_pd(t, zero), one);
+                __m256d dx = _mm256_sub_pd(px, _mm256_mul_pd(t, ex));
+                __m256d dy = _mm256_sub_pd(py, _mm256_mul_pd(t, ey));
+                __m256d d = _mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy));
+
+                __m256d farther = _mm256_cmp_pd(d, best, _CMP_GT_OQ);
+                best = _mm256_blendv_pd(best, d, farther);
+                best_index = _mm256_blendv_pd(best_index, index, farther);
+                index = _mm256_add_pd(index, step);
+            }
+
+            double lanes[4], lane_index[4];
+            _mm256_storeu_pd(lanes, best);
+            _mm256_storeu_pd(lane_index, best_index);
+            size_t lane = 0;
+            for (size_t k = 1; k < 4; ++k) {
+                if (lanes[k] > lanes[lane] || (lanes[k] == lanes[lane] && lane_index[k] < lane_index[lane])) {
+                    lane = k;
+                }
+            }
+            distance_sq = lanes[lane];
+            return farthest_scalar_from(points, i, count, segment, static_cast<size_t>(lane_index[lane]),
+                                        distance_sq);
+        }
+#endif
+
+        struct Dispatch {
+            FarthestFn farthest;
+            const char* isa;
+
+            Dispatch() : farthest(farthest_scalar), isa("scalar") {
+#ifdef SIMPLIFY_KERNELS_X86
+                __builtin_cpu_init();
+                if (__builtin_cpu_supports("avx2")) {
+                    farthest = farthest_avx2;
+                    isa = "avx2";
+                } else if (__builtin_cpu_supports("sse2")) {
+                    farthest = farthest_sse2;
+                    isa = "sse2";
+                }
+#endif
+            }
+        };
+
+        const Dispatch& dispatch() {
+            static const Dispatch instance;
+            return instance;
+        }
+    }
+
+    size_t farthest_from_segment(const Vec2* points, size_t count, Vec2 a, Vec2 b, double& distance_sq) {
+        return dispatch().farthest(points, count, a, b, distance_sq);
+    }
+
+    const char* active_isa() {
+        return dispatch().isa;
+    }
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "contour.h"
+#include <cstddef>
+
+// Distance kernels for polyline simplification, with AVX2, SSE2 and scalar
+// variants; the best one for the running CPU is picked on first use. All
+// variants evaluate the same expression in the same order, so they agree
+// bit for bit and simplification does not depend on the machine.
+namespace SimplifyKernels {
+    // Index in [0, count) of the point farthest from segment a-b, with its
+    // squared distance; the first one wins ties. count must be > 0.
+    size_t farthest_from_segment(const Vec2* points, size_t count, Vec2 a, Vec2 b, double& distance_sq);
+
+    const char* active_isa();
+}
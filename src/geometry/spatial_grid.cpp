@@ -0,0 +1,171 @@
+#include "spatial_grid.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    constexpr int MAX_CELLS = 1 << 22;
+
+    double box_distance_sq(const Bounds2& box, double x, double y) {
+        double dx = std::max({box.min_x - x, 0.0, x - box.max_x});
+        double dy = std::max({box.min_y - y, 0.0, y - box.max_y});
+        return dx * dx + dy * dy;
+    }
+}
+
+SpatialGrid::SpatialGrid() : cell_size(1.0), inv_cell(1.0), cols(0), rows(0) {
+}
+
+int SpatialGrid::cell_x(double x) const {
+    double c = std::clamp((x - extent.min_x) * inv_cell, 0.0, static_cast<double>(cols - 1));
+    return static_cast<int>(c);
+}
+
+int SpatialGrid::cell_y(double y) const {
+    double r = std::clamp((y - extent.min_y) * inv_cell, 0.0, static_cast<double>(rows - 1));
+    return static_cast<int>(r);
+}
+
+void SpatialGrid::clear() {
+    extent = Bounds2();
+    cols = rows = 0;
+    boxes.clear();
+    cell_start.clear();
+    cell_items.clear();
+}
+
+void SpatialGrid::build(const std::vector<Bounds2>& item_boxes, double target_per_cell) {
+    clear();
+    boxes = item_boxes;
+    if (boxes.empty()) return;
+
+    for (const auto& box : boxes) {
+        extent.expand(box);
+    }
+
+    double cells_wanted = std::clamp(static_cast<double>(boxes.size()) / target_per_cell, 1.0,
+                                     static_cast<double>(MAX_CELLS));
+    // Line-like extents (all items on one axis) still get square cells
+    // sized for the item count rather than one huge or millions of tiny ones
+    double span = std::max({extent.max_x - extent.min_x, extent.max_y - extent.min_y, 1e-9});
+    double width = std::max(extent.max_x - extent.min_x, span / cells_wanted);
+    double height = std::max(extent.max_y - extent.min_y, span / cells_wanted);
+    cell_size = std::sqrt(width * height / cells_wanted);
+    inv_cell = 1.0 / cell_size;
+
+    cols = std::max(1, static_cast<int>(std::ceil(width * inv_cell)));
+    rows = std::max(1, static_cast<int>(std::ceil(height * inv_cell)));
+    while (static_cast<int64_t>(cols) * rows > MAX_CELLS) {
+        cell_size *= 1.5;
+        inv_cell = 1.0 / cell_size;
+        cols = std::max(1, static_cast<int>(std::ceil(width * inv_cell)));
+        rows = std::max(1, static_cast<int>(std::ceil(height * inv_cell)));
+    }
+
+    // Two passes: count per cell, then scatter ids
+    const size_t cell_count = static_cast<size_t>(cols) * rows;
+    cell_start.assign(cell_count + 1, 0);
+    for (const auto& box : boxes) {
+        int x0 = cell_x(box.min_x), x1 = cell_x(box.max_x);
+        int y0 = cell_y(box.min_y), y1 = cell_y(box.max_y);
+        for (int cy = y0; cy <= y1; ++cy) {
+            for (int cx = x0; cx <= x1; ++cx) {
+                cell_start[static_cast<size_t>(cy) * cols + cx + 1]++;
+            }
+        }
+    }
+    for (size_t i = 0; i < cell_count; ++i) {
+        cell_start[i + 1] += cell_start[i];
+    }
+
+    cell_items.resize(cell_start[cell_count]);
+    std::vector<uint32_t> fill(cell_start.begin(), cell_start.end() - 1);
+    for (uint32_t id = 0; id < boxes.size(); ++id) {
+        const Bounds2& box = boxes[id];
+        int x0 = cell_x(box.min_x), x1 = cell_x(box.max_x);
+        int y0 = cell_y(box.min_y), y1 = cell_y(box.max_y);
+        for (int cy = y0; cy <= y1; ++cy) {
+            for (int cx = x0; cx <= x1; ++cx) {
+                cell_items[fill[static_cast<size_t>(cy) * cols + cx]++] = id;
+            }
+        }
+    }
+}
+
+void SpatialGrid::assign(const Bounds2& grid_extent, double grid_cell_size, int grid_cols, int grid_rows,
+                         const Bounds2* item_boxes, size_t item_count,
+                         const uint32_t* starts, const uint32_t* items, size_t items_count) {
+    clear();
+    if (item_count == 0) return;
+
+    extent = grid_extent;
+    cell_size = grid_cell_size;
+    inv_cell = 1.0 / grid_cell_size;
+    cols = grid_cols;
+    rows = grid_rows;
+    boxes.assign(item_boxes, item_boxes + item_count);
+    cell_start.assign(starts, starts + static_cast<size_t>(cols) * rows + 1);
+    cell_items.assign(items, items + items_count);
+}
+
+void SpatialGrid::query(const Bounds2& box, const std::function<void(uint32_t)>& fn) const {
+    if (boxes.empty() || !box.overlaps(extent)) return;
+
+    int x0 = cell_x(box.min_x), x1 = cell_x(box.max_x);
+    int y0 = cell_y(box.min_y), y1 = cell_y(box.max_y);
+
+    for (int cy = y0; cy <= y1; ++cy) {
+        for (int cx = x0; cx <= x1; ++cx) {
+            size_t cell = static_cast<size_t>(cy) * cols + cx;
+            for (uint32_t i = cell_start[cell]; i < cell_start[cell + 1]; ++i) {
+                uint32_t id = cell_items[i];
+                const Bounds2& item = boxes[id];
+                if (!item.overlaps(box)) continue;
+
+                // Report each item only from the first cell it shares with
+                // the query, so no visited set is needed.
+                if (cx != std::max(x0, cell_x(item.min_x)) || cy != std::max(y0, cell_y(item.min_y))) continue;
+                fn(id);
+            }
+        }
+    }
+}
+
+uint32_t SpatialGrid::nearest(double x, double y, const std::function<bool(uint32_t)>& accept) const {
+    if (boxes.empty()) return UINT32_MAX;
+
+    const int qx = cell_x(x);
+    const int qy = cell_y(y);
+    const int max_ring = std::max({qx, cols - 1 - qx, qy, rows - 1 - qy});
+
+    uint32_t best = UINT32_MAX;
+    double best_dist = 1e300;
+
+    for (int ring = 0; ring <= max_ring; ++ring) {
+        int x0 = qx - ring, x1 = qx + ring;
+        int y0 = qy - ring, y1 = qy + ring;
+
+        for (int cy = std::max(y0, 0); cy <= std::min(y1, rows - 1); ++cy) {
+            bool edge_row = cy == y0 || cy == y1;
+            int step = edge_row ? 1 : std::max(1, x1 - x0);
+            for (int cx = x0; cx <= x1; cx += step) {
+                if (cx < 0 || cx >= cols) continue;
+
+                size_t cell = static_cast<size_t>(cy) * cols + cx;
+                for (uint32_t i = cell_start[cell]; i < cell_start[cell + 1]; ++i) {
+                    uint32_t id = cell_items[i];
+                    double d = box_distance_sq(boxes[id], x, y);
+                    if (d < best_dist && accept(id)) {
+                        best_dist = d;
+                        best = id;
+                    }
+                }
+            }
+        }
+
+        // Anything in ring + 1 is at least ring * cell_size away
+        double reach = ring * cell_size;
+        if (best != UINT32_MAX && best_dist <= reach * reach) break;
+    }
+
+    return best;
+}
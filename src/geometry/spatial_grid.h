@@ -0,0 +1,51 @@
+#pragma once
+
+#include "contour.h"
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// Bulk-loaded uniform grid over item bounding boxes. Cells are stored in
+// compressed form (per-cell offsets into one flat id list). Queries do not
+// mutate the grid and are safe to run from several threads at once.
+class SpatialGrid {
+private:
+    Bounds2 extent;
+    double cell_size;
+    double inv_cell;
+    int cols, rows;
+    std::vector<Bounds2> boxes;
+    std::vector<uint32_t> cell_start; // cols * rows + 1 offsets into cell_items
+    std::vector<uint32_t> cell_items;
+
+    int cell_x(double x) const;
+    int cell_y(double y) const;
+
+public:
+    SpatialGrid();
+
+    // target_per_cell controls the cell size relative to item density
+    void build(const std::vector<Bounds2>& item_boxes, double target_per_cell = 2.0);
+    void clear();
+
+    // Calls fn(id) once for every item whose box overlaps the query box
+    void query(const Bounds2& box, const std::function<void(uint32_t)>& fn) const;
+
+    // Item nearest to (x, y) by box distance among those accepted by the
+    // predicate; returns UINT32_MAX when none is accepted.
+    uint32_t nearest(double x, double y, const std::function<bool(uint32_t)>& accept) const;
+
+    size_t item_count() const { return boxes.size(); }
+    const Bounds2& item_bounds(uint32_t id) const { return boxes[id]; }
+    int get_cols() const { return cols; }
+    int get_rows() const { return rows; }
+    double get_cell_size() const { return cell_size; }
+    const Bounds2& get_extent() const { return extent; }
+    const std::vector<uint32_t>& get_cell_start() const { return cell_start; }
+    const std::vector<uint32_t>& get_cell_items() const { return cell_items; }
+
+    // Restores a grid from arrays previously taken from the getters above
+    void assign(const Bounds2& grid_extent, double grid_cell_size, int grid_cols, int grid_rows,
+                const Bounds2* item_boxes, size_t item_count,
+                const uint32_t* starts, const uint32_t* items, size_t items_count);
+};
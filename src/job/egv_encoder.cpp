@@ -0,0 +1,296 @@
+#include "egv_encoder.h"
+#include "core/trace.h"
+#include <algorithm>
+#include <cstdlib>
+
+namespace Lhymicro {
+    namespace {
+        // Writes the distance code into out (at most 3 bytes after the 'z's)
+        inline size_t encode_distance(char* out, int32_t distance) {
+            size_t n = 0;
+            if (distance >= 52) {
+                out[n++] = static_cast<char>('0' + distance / 100);
+                out[n++] = static_cast<char>('0' + (distance / 10) % 10);
+                out[n++] = static_cast<char>('0' + distance % 10);
+            } else if (distance >= 26) {
+                out[n++] = '|';
+                out[n++] = static_cast<char>('a' + distance - 26);
+            } else if (distance > 0) {
+                out[n++] = static_cast<char>('a' + distance - 1);
+            }
+            return n;
+        }
+    }
+
+    void append_distance(std::string& out, int32_t distance) {
+        if (distance <= 0) return;
+
+        if (distance >= 255) {
+            out.append(static_cast<size_t>(distance / 255), 'z');
+            distance %= 255;
+        }
+        char code[4];
+        out.append(code, encode_distance(code, distance));
+    }
+}
+
+EgvEncoder::EgvEncoder(const Options& encoder_options)
+    : options(encoder_options), chunk_bytes(30 * 64), bytes_emitted(0), x(0), y(0), compact(false), laser(false),
+      x_dir(Lhymicro::RIGHT), y_dir(Lhymicro::BOTTOM), last_move_start(0), last_move_end(SIZE_MAX),
+      last_move_letter(0), last_move_distance(0) {
+}
+
+void EgvEncoder::set_sink(CommandSink command_sink, size_t chunk) {
+    sink = command_sink;
+    chunk_bytes = chunk > 0 ? chunk : 30;
+}
+
+void EgvEncoder::maybe_flush() {
+    if (!sink || buffer.size() < chunk_bytes) return;
+
+    size_t aligned = buffer.size() - buffer.size() % chunk_bytes;
+    sink(buffer.substr(0, aligned));
+    buffer.erase(0, aligned);
+    last_move_end = SIZE_MAX;
+    bytes_emitted += aligned;
+}
+
+void EgvEncoder::emit_move(char direction, int32_t distance) {
+    if (options.coalesce_moves) {
+        // Anything appended since the last move (mode, beam or direction
+        // codes) moved the buffer end, so only back-to-back moves merge
+        if (buffer.size() == last_move_end && direction == last_move_letter && distance > 0) {
+            buffer.resize(last_move_start);
+            distance += last_move_distance;
+        }
+        last_move_start = buffer.size();
+        last_move_letter = direction;
+        last_move_distance = distance;
+    }
+
+    if (distance >= 255) {
+        emit(direction);
+        Lhymicro::append_distance(buffer, distance);
+    } else {
+        // Common short move: one append instead of a push_back per byte
+        char code[5];
+        code[0] = direction;
+        buffer.append(code, 1 + Lhymicro::encode_distance(code + 1, distance));
+    }
+
+    if (options.coalesce_moves) last_move_end = distance > 0 ? buffer.size() : SIZE_MAX;
+}
+
+void EgvEncoder::set_direction(char direction) {
+    if (direction == Lhymicro::RIGHT || direction == Lhymicro::LEFT) {
+        if (x_dir == direction) return;
+        x_dir = direction;
+    } else {
+        if (y_dir == direction) return;
+        y_dir = direction;
+    }
+    emit(direction);
+}
+
+void EgvEncoder::set_laser(bool on) {
+    if (laser == on) return;
+    laser = on;
+    emit(on ? Lhymicro::LASER_ON : Lhymicro::LASER_OFF);
+}
+
+void EgvEncoder::rapid_to(int32_t to_x, int32_t to_y) {
+    if (compact) end_cut();
+
+    int32_t dx = to_x - x;
+    int32_t dy = to_y - y;
+    if (dx == 0 && dy == 0) return;
+
+    emit('I');
+    if (dx != 0) emit_move(dx > 0 ? Lhymicro::RIGHT : Lhymicro::LEFT, std::abs(dx));
+    if (dy != 0) emit_move(dy > 0 ? Lhymicro::BOTTOM : Lhymicro::TOP, std::abs(dy));
+    buffer += "S1P\n";
+
+    x = to_x;
+    y = to_y;
+    maybe_flush();
+}
+
+void EgvEncoder::begin_cut(const SpeedCode& speed) {
+    if (compact) {
+        if (speed.code == speed_code) return;
+        end_cut();
+    }
+
+    speed_code = speed.code;
+    emit('I');
+    buffer += speed_code;
+    emit('N');
+    emit(x_dir);
+    emit(y_dir);
+    buffer += "S1E";
+
+    compact = true;
+    laser = false;
+    maybe_flush();
+}
+
+void EgvEncoder::end_cut() {
+    if (!compact) return;
+    set_laser(false);
+    buffer += "FNSE-\n";
+    compact = false;
+    maybe_flush();
+}
+
+void EgvEncoder::compact_line(int32_t dx, int32_t dy) {
+    int32_t adx = std::abs(dx);
+    int32_t ady = std::abs(dy);
+    char hx = dx > 0 ? Lhymicro::RIGHT : Lhymicro::LEFT;
+    char hy = dy > 0 ? Lhymicro::BOTTOM : Lhymicro::TOP;
+
+    if (ady == 0) {
+        if (adx == 0) return;
+        x_dir = hx;
+        emit_move(hx, adx);
+        return;
+    }
+    if (adx == 0) {
+        y_dir = hy;
+        emit_move(hy, ady);
+        return;
+    }
+
+    set_direction(hx);
+    set_direction(hy);
+
+    if (adx == ady) {
+        emit_move(Lhymicro::DIAGONAL, adx);
+        return;
+    }
+
+    // Bresenham over the major axis, grouping steps into runs of either
+    // straight (major axis only) or diagonal moves.
+    bool x_major = adx > ady;
+    int32_t major = x_major ? adx : ady;
+    int32_t minor = x_major ? ady : adx;
+    char major_letter = x_major ? hx : hy;
+
+    int32_t error = major / 2;
+    bool run_diagonal = false;
+    int32_t run_length = 0;
+
+    for (int32_t i = 0; i < major; ++i) {
+        error -= minor;
+        bool diagonal = error < 0;
+        if (diagonal) error += major;
+
+        if (run_length > 0 && diagonal != run_diagonal) {
+            emit_move(run_diagonal ? Lhymicro::DIAGONAL : major_letter, run_length);
+            run_length = 0;
+        }
+        run_diagonal = diagonal;
+        run_length++;
+    }
+    if (run_length > 0) {
+        emit_move(run_diagonal ? Lhymicro::DIAGONAL : major_letter, run_length);
+    }
+}
+
+// The beam is off, so the path between the ends is free: one diagonal run
+// and one straight run cost a few bytes where the straight line may need
+// dozens of alternating runs
+void EgvEncoder::travel_line(int32_t dx, int32_t dy) {
+    int32_t adx = std::abs(dx);
+    int32_t ady = std::abs(dy);
+    char hx = dx > 0 ? Lhymicro::RIGHT : Lhymicro::LEFT;
+    char hy = dy > 0 ? Lhymicro::BOTTOM : Lhymicro::TOP;
+
+    if (adx == 0 || ady == 0) {
+        compact_line(dx, dy);
+        return;
+    }
+    set_direction(hx);
+    set_direction(hy);
+    int32_t diagonal = std::min(adx, ady);
+    emit_move(Lhymicro::DIAGONAL, diagonal);
+    if (adx > ady) {
+        emit_move(hx, adx - diagonal);
+    } else if (ady > adx) {
+        emit_move(hy, ady - diagonal);
+    }
+}
+
+void EgvEncoder::cut_to(int32_t to_x, int32_t to_y) {
+    set_laser(true);
+    compact_line(to_x - x, to_y - y);
+    x = to_x;
+    y = to_y;
+    maybe_flush();
+}
+
+void EgvEncoder::move_to(int32_t to_x, int32_t to_y) {
+    set_laser(false);
+    if (options.diagonal_travel) {
+        travel_line(to_x - x, to_y - y);
+    } else {
+        compact_line(to_x - x, to_y - y);
+    }
+    x = to_x;
+    y = to_y;
+    maybe_flush();
+}
+
+void EgvEncoder::encode_toolpath(const Toolpath& toolpath, std::vector<uint64_t>* move_end_bytes) {
+    TRACE_SPAN("egv.encode");
+    std::vector<SpeedCode> layer_codes;
+    layer_codes.reserve(toolpath.layers.size());
+    for (const auto& layer : toolpath.layers) {
+        layer_codes.push_back(SpeedCodes::for_speed(layer.speed_mm_s));
+    }
+
+    if (move_end_bytes) {
+        move_end_bytes->clear();
+        move_end_bytes->reserve(toolpath.size());
+    }
+
+    auto cuts = [&](size_t i) { return toolpath.laser_on[i] && toolpath.layer[i] < layer_codes.size(); };
+
+    for (size_t i = 0; i < toolpath.size(); ++i) {
+        if (cuts(i)) {
+            begin_cut(layer_codes[toolpath.layer[i]]);
+            cut_to(toolpath.x[i], toolpath.y[i]);
+        } else if (compact && i + 1 < toolpath.size() && cuts(i + 1) &&
+                   layer_codes[toolpath.layer[i + 1]].code == speed_code &&
+                   std::abs(toolpath.x[i] - x) <= options.compact_travel_steps &&
+                   std::abs(toolpath.y[i] - y) <= options.compact_travel_steps) {
+            move_to(toolpath.x[i], toolpath.y[i]);
+        } else {
+            rapid_to(toolpath.x[i], toolpath.y[i]);
+        }
+        if (move_end_bytes) {
+            // A merged code can be shorter than the one it replaced (254 + 1
+            // steps is "z"), so earlier ends are pulled back to stay sorted
+            const uint64_t end = total_bytes();
+            for (auto it = move_end_bytes->rbegin(); it != move_end_bytes->rend() && *it > end; ++it) *it = end;
+            move_end_bytes->push_back(end);
+        }
+    }
+}
+
+void EgvEncoder::finish() {
+    end_cut();
+    if (sink && !buffer.empty()) {
+        sink(buffer);
+        bytes_emitted += buffer.size();
+        buffer.clear();
+        last_move_end = SIZE_MAX;
+    }
+}
+
+std::string EgvEncoder::take() {
+    std::string out;
+    out.swap(buffer);
+    last_move_end = SIZE_MAX;
+    bytes_emitted += out.size();
+    return out;
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include "toolpath.h"
+#include "speed_code.h"
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Lhymicro-GL (EGV) command letters understood by the M2 Nano
+namespace Lhymicro {
+    constexpr char RIGHT = 'B';
+    constexpr char LEFT = 'T';
+    constexpr char TOP = 'L';
+    constexpr char BOTTOM = 'R';
+    constexpr char DIAGONAL = 'M';
+    constexpr char LASER_ON = 'D';
+    constexpr char LASER_OFF = 'U';
+
+    // 1..25 -> a..y, 26..51 -> '|' a..z, 52..254 -> three digits, 255 -> 'z'
+    void append_distance(std::string& out, int32_t distance);
+}
+
+// Turns moves into a Lhymicro-GL command stream. Rapid moves are sent in
+// default mode; cutting happens in compact mode, which is entered with a
+// speed code and left with "FNSE-". Output can be streamed through a sink
+// in packet-aligned chunks while encoding is still in progress.
+class EgvEncoder {
+public:
+    typedef std::function<void(const std::string&)> CommandSink;
+
+    // Stream size optimizations; none of them changes where the head goes
+    // or where the beam is on
+    struct Options {
+        // Consecutive moves with the same letter are sent as one distance,
+        // so collinear runs that straddle move boundaries cost one code
+        bool coalesce_moves;
+        // Beam-off compact moves go diagonally first, then straight, instead
+        // of following the line
+        bool diagonal_travel;
+        // Travels up to this many steps between two cuts at the same speed
+        // stay in compact mode with the beam off instead of leaving it for a
+        // rapid (mode switch plus speed code, ~40 bytes); 0 disables
+        int32_t compact_travel_steps;
+
+        Options() : coalesce_moves(true), diagonal_travel(true), compact_travel_steps(80) {}
+
+        // Byte-for-byte the stream of the original encoder, for comparisons
+        static Options unoptimized() {
+            Options options;
+            options.coalesce_moves = false;
+            options.diagonal_travel = false;
+            options.compact_travel_steps = 0;
+            return options;
+        }
+    };
+
+private:
+    Options options;
+    std::string buffer;
+    CommandSink sink;
+    size_t chunk_bytes;
+    uint64_t bytes_emitted;
+
+    int32_t x, y;
+    bool compact;
+    bool laser;
+    char x_dir, y_dir;
+    std::string speed_code;
+
+    // Last move written, while it is still the tail of the buffer: a next
+    // move with the same letter rewrites it with the summed distance
+    size_t last_move_start;
+    size_t last_move_end;
+    char last_move_letter;
+    int32_t last_move_distance;
+
+    void emit(char c) { buffer.push_back(c); }
+    void emit_move(char direction, int32_t distance);
+    void set_direction(char direction);
+    void set_laser(bool on);
+    void compact_line(int32_t dx, int32_t dy);
+    void travel_line(int32_t dx, int32_t dy);
+    void maybe_flush();
+
+public:
+    explicit EgvEncoder(const Options& encoder_options = Options());
+
+    // Chunks handed to the sink are multiples of chunk_bytes, so packet
+    // padding only ever appears at the very end of the stream.
+    void set_sink(CommandSink command_sink, size_t chunk = 30 * 64);
+
+    void rapid_to(int32_t to_x, int32_t to_y);
+    void begin_cut(const SpeedCode& speed);
+    void end_cut();
+
+    // Compact-mode moves; begin_cut() must have been called
+    void cut_to(int32_t to_x, int32_t to_y);
+    void move_to(int32_t to_x, int32_t to_y);
+
+    // With move_end_bytes, records total_bytes() after each move so stream
+    // progress can be mapped back to toolpath positions. When coalescing
+    // rewrites a move's last code, its recorded end is off by a byte or two.
+    void encode_toolpath(const Toolpath& toolpath, std::vector<uint64_t>* move_end_bytes = nullptr);
+
+    // Leaves compact mode and hands any remaining bytes to the sink
+    void finish();
+
+    const std::string& commands() const { return buffer; }
+    std::string take();
+    uint64_t total_bytes() const { return bytes_emitted + buffer.size(); }
+
+    int32_t get_x() const { return x; }
+    int32_t get_y() const { return y; }
+    bool in_compact_mode() const { return compact; }
+    const std::string& current_speed_code() const { return speed_code; }
+};
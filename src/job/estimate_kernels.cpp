@@ -0,0 +1,333 @@
+#include "estimate_kernels.h"
+#include <cmath>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define ESTIMATE_KERNELS_X86 1
+#endif
+
+namespace EstimateKernels {
+
+    namespace {
+        typedef void (*GeometryFn)(const int32_t*, const int32_t*, size_t, float, float*, float*, float*);
+        typedef void (*JunctionsFn)(const uint8_t*, const float*, const float*, const float*, const float*, size_t,
+                                    const JunctionCosts&, float*, float*);
+        typedef void (*MoveTimesFn)(const float*, const float*, const float*, const float*, const float*, size_t,
+                                    float*);
+
+        // min/max with the operand order of minps/maxps, so the scalar and
+        // vector paths pick the same value
+        inline float lower(float a, float b) { return a < b ? a : b; }
+        inline float higher(float a, float b) { return a > b ? a : b; }
+
+        void geometry_scalar_from(const int32_t* x, const int32_t* y, size_t start, size_t count, float mm_per_step,
+                                  float* length_mm, float* dir_x, float* dir_y) {
+            for (size_t i = start; i < count; ++i) {
+                float dx = static_cast<float>(x[i] - (i > 0 ? x[i - 1] : 0));
+                float dy = static_cast<float>(y[i] - (i > 0 ? y[i - 1] : 0));
+                float length = std::sqrt(dx * dx + dy * dy);
+                float inv = length > 0.0f ? 1.0f / length : 0.0f;
+                dir_x[i] = dx * inv;
+                dir_y[i] = dy * inv;
+                length_mm[i] = length * mm_per_step;
+            }
+        }
+
+        void geometry_scalar(const int32_t* x, const int32_t* y, size_t count, float mm_per_step,
+                             float* length_mm, float* dir_x, float* dir_y) {
+            geometry_scalar_from(x, y, 0, count, mm_per_step, length_mm, dir_x, dir_y);
+        }
+
+        void junctions_scalar_from(const uint8_t* laser_on, const float* dir_x, const float* dir_y,
+                                   const float* length_mm, const float* cruise, size_t start, size_t count,
+                                   const JunctionCosts& costs, float* exit_speed, float* penalty_s) {
+            for (size_t i = start; i + 1 < count; ++i) {
+                junction(laser_on, dir_x, dir_y, length_mm, cruise, i, costs, exit_speed[i], penalty_s[i]);
+            }
+            if (count > 0 && start < count) {
+                exit_speed[count - 1] = 0.0f;
+                penalty_s[count - 1] = 0.0f;
+            }
+        }
+
+        void junctions_scalar(const uint8_t* laser_on, const float* dir_x, const float* dir_y, const float* length_mm,
+                              const float* cruise, size_t count, const JunctionCosts& costs,
+                              float* exit_speed, float* penalty_s) {
+            junctions_scalar_from(laser_on, dir_x, dir_y, length_mm, cruise, 0, count, costs, exit_speed, penalty_s);
+        }
+
+        void move_times_scalar_from(const float* length_mm, const float* cruise, const float* accel,
+                                    const float* exit_speed, const float* penalty_s, size_t start, size_t count,
+                                    float* seconds) {
+            for (size_t i = start; i < count; ++i) {
+                float entry = i > 0 ? exit_speed[i - 1] : 0.0f;
+                seconds[i] = move_time(length_mm[i], entry, exit_speed[i], cruise[i], accel[i], penalty_s[i]);
+            }
+        }
+
+        void move_times_scalar(const float* length_mm, const float* cruise, const float* accel,
+                               const float* exit_speed, const float* penalty_s, size_t count, float* seconds) {
+            move_times_scalar_from(length_mm, cruise, accel, exit_speed, penalty_s, 0, count, seconds);
+        }
+
+#ifdef ESTIMATE_KERNELS_X86
+        // Four moves per step; move 0 (from the origin) and the tail go
+        // through the scalar loop
+        void geometry_sse2(const int32_t* x, const int32_t* y, size_t count, float mm_per_step,
+                           float* length_mm, float* dir_x, float* dir_y) {
+            if (count == 0) return;
+            geometry_scalar_from(x, y, 0, 1, mm_per_step, length_mm, dir_x, dir_y);
+            const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f), scale = _mm_set1_ps(mm_per_step);
+
+            size_t i = 1;
+            for (; i + 4 <= count; i += 4) {
+                __m128i ix = _mm_sub_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(x + i)),
+                                           _mm_loadu_si128(reinterpret_cast<const __m128i*>(x + i - 1)));
+                __m128i iy = _mm_sub_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(y + i)),
+                                           _mm_loadu_si128(reinterpret_cast<const __m128i*>(y + i - 1)));
+                __m128 dx = _mm_cvtepi32_ps(ix), dy = _mm_cvtepi32_ps(iy);
+                __m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)));
+                __m128 inv = _mm_and_ps(_mm_cmpgt_ps(length, zero), _mm_div_ps(one, length));
+                _mm_storeu_ps(dir_x + i, _mm_mul_ps(dx, inv));
+                _mm_storeu_ps(dir_y + i, _mm_mul_ps(dy, inv));
+                _mm_storeu_ps(length_mm + i, _mm_mul_ps(length, scale));
+            }
+            geometry_scalar_from(x, y, i, count, mm_per_step, length_mm, dir_x, dir_y);
+        }
+
+        // Junctions i..i+3 read moves i..i+4; the cut flags are compared as
+        // bytes and widened into lane masks
+        void junctions_sse2(const uint8_t* laser_on, const float* dir_x, const float* dir_y, const float* length_mm,
+                            const float* cruise, size_t count, const JunctionCosts& costs,
+                            float* exit_speed, float* penalty_s) {
+            const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f);
+            const __m128 threshold = _mm_set1_ps(costs.corner_cos_threshold);
+            const __m128 direction_cost = _mm_set1_ps(costs.direction_change_s);
+            const __m128 mode_cost = _mm_set1_ps(costs.mode_switch_s);
+
+            size_t i = 0;
+            for (; i + 5 <= count; i += 4) {
+                int32_t on0, on1;
+                std::memcpy(&on0, laser_on + i, 4);
+                std::memcpy(&on1, laser_on + i + 1, 4);
+                __m128i same_bytes = _mm_cmpeq_epi8(_mm_cvtsi32_si128(on0), _mm_cvtsi32_si128(on1));
+                same_bytes = _mm_unpacklo_epi8(same_bytes, same_bytes);
+                __m128 same = _mm_and_ps(_mm_castsi128_ps(_mm_unpacklo_epi16(same_bytes, same_bytes)), one);
+
+                __m128 len0 = _mm_loadu_ps(length_mm + i), len1 = _mm_loadu_ps(length_mm + i + 1);
+                __m128 dot = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(dir_x + i), _mm_loadu_ps(dir_x + i + 1)),
+                                        _mm_mul_ps(_mm_loadu_ps(dir_y + i), _mm_loadu_ps(dir_y + i + 1)));
+                __m128 zero_length = _mm_or_ps(_mm_cmpeq_ps(len0, zero), _mm_cmpeq_ps(len1, zero));
+                __m128 cos_angle = _mm_or_ps(_mm_and_ps(zero_length, one), _mm_andnot_ps(zero_length, dot));
+
+                __m128 vc = _mm_min_ps(_mm_loadu_ps(cruise + i), _mm_loadu_ps(cruise + i + 1));
+                _mm_storeu_ps(exit_speed + i, _mm_mul_ps(_mm_mul_ps(vc, _mm_max_ps(cos_angle, zero)), same));
+                __m128 corner = _mm_and_ps(_mm_cmplt_ps(cos_angle, threshold), direction_cost);
+                _mm_storeu_ps(penalty_s + i, _mm_add_ps(corner, _mm_mul_ps(_mm_sub_ps(one, same), mode_cost)));
+            }
+            junctions_scalar_from(laser_on, dir_x, dir_y, length_mm, cruise, i, count, costs, exit_speed, penalty_s);
+        }
+
+        void move_times_sse2(const float* length_mm, const float* cruise, const float* accel,
+                             const float* exit_speed, const float* penalty_s, size_t count, float* seconds) {
+            if (count == 0) return;
+            move_times_scalar_from(length_mm, cruise, accel, exit_speed, penalty_s, 0, 1, seconds);
+            const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f);
+            const __m128 two = _mm_set1_ps(2.0f), half = _mm_set1_ps(0.5f);
+
+            size_t i = 1;
+            for (; i + 4 <= count; i += 4) {
+                __m128 length = _mm_loadu_ps(length_mm + i);
+                __m128 v0 = _mm_loadu_ps(exit_speed + i - 1), v1 = _mm_loadu_ps(exit_speed + i);
+                __m128 vc = _mm_loadu_ps(cruise + i), a = _mm_loadu_ps(accel + i);
+                __m128 inv_a = _mm_div_ps(one, a);
+                __m128 v0_sq = _mm_mul_ps(v0, v0), v1_sq = _mm_mul_ps(v1, v1);
+
+                __m128 peak = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_mul_ps(two, a), length), v0_sq), v1_sq);
+                peak = _mm_min_ps(_mm_sqrt_ps(_mm_mul_ps(peak, half)), vc);
+                peak = _mm_max_ps(peak, _mm_max_ps(v0, v1));
+                __m128 peak_sq = _mm_mul_ps(peak, peak);
+
+                __m128 accel_dist = _mm_mul_ps(_mm_mul_ps(_mm_sub_ps(peak_sq, v0_sq), half), inv_a);
+                __m128 decel_dist = _mm_mul_ps(_mm_mul_ps(_mm_sub_ps(peak_sq, v1_sq), half), inv_a);
+                __m128 cruise_dist = _mm_max_ps(zero, _mm_sub_ps(_mm_sub_ps(length, accel_dist), decel_dist));
+
+                __m128 t = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(peak, v0), inv_a), _mm_mul_ps(_mm_sub_ps(peak, v1), inv_a));
+                t = _mm_add_ps(t, _mm_div_ps(cruise_dist, vc));
+                _mm_storeu_ps(seconds + i, _mm_add_ps(t, _mm_loadu_ps(penalty_s + i)));
+            }
+            move_times_scalar_from(length_mm, cruise, accel, exit_speed, penalty_s, i, count, seconds);
+        }
+
+        // The same passes eight moves at a time
+        __attribute__((target("avx2")))
+        void geometry_avx2(const int32_t* x, const int32_t* y, size_t count, float mm_per_step,
+                           float* length_mm, float* dir_x, float* dir_y) {
+            if (count == 0) return;
+            geometry_scalar_from(x, y, 0, 1, mm_per_step, length_mm, dir_x, dir_y);
+            const __m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1.0f);
+            const __m256 scale = _mm256_set1_ps(mm_per_step);
+
+            size_t i = 1;
+            for (; i + 8 <= count; i += 8) {
+                __m256i ix = _mm256_sub_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(x + i)),
+                                              _mm256_loadu_si256(reinterpret_cast<const __m256i*>(x + i - 1)));
+                __m256i iy = _mm256_sub_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(y + i)),
+                                              _mm256_loadu_si256(reinterpret_cast<const __m256i*>(y + i - 1)));
+                __m256 dx = _mm256_cvtepi32_ps(ix), dy = _mm256_cvtepi32_ps(iy);
+                __m256 length = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)));
+                __m256 inv = _mm256_and_ps(_mm256_cmp_ps(length, zero, _CMP_GT_OQ), _mm256_div_ps(one, length));
+                _mm256_storeu_ps(dir_x + i, _mm256_mul_ps(dx, inv));
+                _mm256_storeu_ps(dir_y + i, _mm256_mul_ps(dy, inv));
+                _mm256_storeu_ps(length_mm + i, _mm256_mul_ps(length, scale));
+            }
+            geometry_scalar_from(x, y, i, count, mm_per_step, length_mm, dir_x, dir_y);
+        }
+
+        __attribute__((target("avx2")))
+        void junctions_avx2(const uint8_t* laser_on, const float* dir_x, const float* dir_y, const float* length_mm,
+                            const float* cruise, size_t count, const JunctionCosts& costs,
+                            float* exit_speed, float* penalty_s) {
+            const __m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1.0f);
+            const __m256 threshold = _mm256_set1_ps(costs.corner_cos_threshold);
+            const __m256 direction_cost = _mm256_set1_ps(costs.direction_change_s);
+            const __m256 mode_cost = _mm256_set1_ps(costs.mode_switch_s);
+
+            size_t i = 0;
+            for (; i + 9 <= count; i += 8) {
+                __m256i on0 = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(laser_on + i)));
+                __m256i on1 = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(laser_on + i + 1)));
+                __m256 same = _mm256_and_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(on0, on1)), one);
+
+                __m256 len0 = _mm256_loadu_ps(length_mm + i), len1 = _mm256_loadu_ps(length_mm + i + 1);
+                __m256 dot = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(dir_x + i), _mm256_loadu_ps(dir_x + i + 1)),
+                                           _mm256_mul_ps(_mm256_loadu_ps(dir_y + i), _mm256_loadu_ps(dir_y + i + 1)));
+                __m256 zero_length = _mm256_or_ps(_mm256_cmp_ps(len0, zero, _CMP_EQ_OQ),
+                                                  _mm256_cmp_ps(len1, zero, _CMP_EQ_OQ));
+                __m256 cos_angle = _mm256_blendv_ps(dot, one, zero_length);
+
+                __m256 vc = _mm256_min_ps(_mm256_loadu_ps(cruise + i), _mm256_loadu_ps(cruise + i + 1));
+                _mm256_storeu_ps(exit_speed + i,
+                                 _mm256_mul_ps(_mm256_mul_ps(vc, _mm256_max_ps(cos_angle, zero)), same));
+                __m256 corner = _mm256_and_ps(_mm256_cmp_ps(cos_angle, threshold, _CMP_LT_OQ), direction_cost);
+                _mm256_storeu_ps(penalty_s + i,
+                                 _mm256_add_ps(corner, _mm256_mul_ps(_mm256_sub_ps(one, same), mode_cost)));
+            }
+            junctions_scalar_from(laser_on, dir_x, dir_y, length_mm, cruise, i, count, costs, exit_speed, penalty_s);
+        }
+
+        __attribute__((target("avx2")))
+        void move_times_avx2(const float* length_mm, const float* cruise, const float* accel,
+                             const float* exit_speed, const float* penalty_s, size_t count, float* seconds) {
+            if (count == 0) return;
+            move_times_scalar_from(length_mm, cruise, accel, exit_speed, penalty_s, 0, 1, seconds);
+            const __m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1.0f);
+            const __m256 two = _mm256_set1_ps(2.0f), half = _mm256_set1_ps(0.5f);
+
+            size_t i = 1;
+            for (; i + 8 <= count; i += 8) {
+                __m256 length = _mm256_loadu_ps(length_mm + i);
+                __m256 v0 = _mm256_loadu_ps(exit_speed + i - 1), v1 = _mm256_loadu_ps(exit_speed + i);
+                __m256 vc = _mm256_loadu_ps(cruise + i), a = _mm256_loadu_ps(accel + i);
+                __m256 inv_a = _mm256_div_ps(one, a);
+                __m256 v0_sq = _mm256_mul_ps(v0, v0), v1_sq = _mm256_mul_ps(v1, v1);
+
+                __m256 peak = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(two, a), length), v0_sq), v1_sq);
+                peak = _mm256_min_ps(_mm256_sqrt_ps(_mm256_mul_ps(peak, half)), vc);
+                peak = _mm256_max_ps(peak, _mm256_max_ps(v0, v1));
+                __m256 peak_sq = _mm256_mul_ps(peak, peak);
+
+                __m256 accel_dist = _mm256_mul_ps(_mm256_mul_ps(_mm256_sub_ps(peak_sq, v0_sq), half), inv_a);
+                __m256 decel_dist = _mm256_mul_ps(_mm256_mul_ps(_mm256_sub_ps(peak_sq, v1_sq), half), inv_a);
+                __m256 cruise_dist = _mm256_max_ps(zero, _mm256_sub_ps(_mm256_sub_ps(length, accel_dist), decel_dist));
+
+                __m256 t = _mm256_add_ps(_mm256_mul_ps(_mm256_sub_ps(peak, v0), inv_a),
+                                         _mm256_mul_ps(_mm256_sub_ps(peak, v1), inv_a));
+                t = _mm256_add_ps(t, _mm256_div_ps(cruise_dist, vc));
+                _mm256_storeu_ps(seconds + i, _mm256_add_ps(t, _mm256_loadu_ps(penalty_s + i)));
+            }
+            move_times_scalar_from(length_mm, cruise, accel, exit_speed, penalty_s, i, count, seconds);
+        }
+#endif
+
+        struct Dispatch {
+            GeometryFn geometry;
+            JunctionsFn junctions;
+            MoveTimesFn move_times;
+            const char* isa;
+
+            Dispatch() : geometry(geometry_scalar), junctions(junctions_scalar), move_times(move_times_scalar),
+                         isa("scalar") {
+#ifdef ESTIMATE_KERNELS_X86
+                __builtin_cpu_init();
+                if (__builtin_cpu_supports("avx2")) {
+                    geometry = geometry_avx2;
+                    junctions = junctions_avx2;
+                    move_times = move_times_avx2;
+                    isa = "avx2";
+                } else if (__builtin_cpu_supports("sse2")) {
+                    geometry = geometry_sse2;
+                    junctions = junctions_sse2;
+                    move_times = move_times_sse2;
+                    isa = "sse2";
+                }
+#endif
+            }
+        };
+
+        const Dispatch& dispatch() {
+            static const Dispatch instance;
+            return instance;
+        }
+    }
+
+    void move_geometry(const int32_t* x, const int32_t* y, size_t count, float mm_per_step,
+                       float* length_mm, float* dir_x, float* dir_y) {
+        dispatch().geometry(x, y, count, mm_per_step, length_mm, dir_x, dir_y);
+    }
+
+    void junctions(const uint8_t* laser_on, const float* dir_x, const float* dir_y, const float* length_mm,
+                   const float* cruise, size_t count, const JunctionCosts& costs,
+                   float* exit_speed, float* penalty_s) {
+        dispatch().junctions(laser_on, dir_x, dir_y, length_mm, cruise, count, costs, exit_speed, penalty_s);
+    }
+
+    void move_times(const float* length_mm, const float* cruise, const float* accel, const float* exit_speed,
+                    const float* penalty_s, size_t count, float* seconds) {
+        dispatch().move_times(length_mm, cruise, accel, exit_speed, penalty_s, count, seconds);
+    }
+
+    // Corners with a zero-length move on either side count as straight
+    void junction(const uint8_t* laser_on, const float* dir_x, const float* dir_y, const float* length_mm,
+                  const float* cruise, size_t i, const JunctionCosts& costs, float& exit_speed, float& penalty_s) {
+        const float same_mode = laser_on[i] == laser_on[i + 1] ? 1.0f : 0.0f;
+        float dot = dir_x[i] * dir_x[i + 1] + dir_y[i] * dir_y[i + 1];
+        float cos_angle = (length_mm[i] == 0.0f || length_mm[i + 1] == 0.0f) ? 1.0f : dot;
+
+        exit_speed = lower(cruise[i], cruise[i + 1]) * higher(cos_angle, 0.0f) * same_mode;
+        penalty_s = (cos_angle < costs.corner_cos_threshold ? costs.direction_change_s : 0.0f) +
+                    (1.0f - same_mode) * costs.mode_switch_s;
+    }
+
+    // Trapezoidal profile from entry to exit with cruise speed cruise. When
+    // the move is too short to reach it the peak speed is lowered instead.
+    float move_time(float length_mm, float entry, float exit, float cruise, float accel, float penalty_s) {
+        float inv_a = 1.0f / accel;
+        float entry_sq = entry * entry, exit_sq = exit * exit;
+        float peak = 2.0f * accel * length_mm + entry_sq + exit_sq;
+        peak = lower(std::sqrt(peak * 0.5f), cruise);
+        peak = higher(peak, higher(entry, exit));
+        float peak_sq = peak * peak;
+
+        float accel_dist = (peak_sq - entry_sq) * 0.5f * inv_a;
+        float decel_dist = (peak_sq - exit_sq) * 0.5f * inv_a;
+        float cruise_dist = higher(0.0f, length_mm - accel_dist - decel_dist);
+
+        return (peak - entry) * inv_a + (peak - exit) * inv_a + cruise_dist / cruise + penalty_s;
+    }
+
+    const char* active_isa() {
+        return dispatch().isa;
+    }
+}
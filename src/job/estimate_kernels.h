@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Per-move passes of the job time estimator, with AVX2, SSE2 and scalar
+// variants; the best one for the running CPU is picked on first use. Every
+// variant evaluates the same expressions in the same order as the single
+// move functions, so an incremental update after a speed change lands on
+// exactly the times a full pass would give.
+namespace EstimateKernels {
+    // Length in mm and unit direction of each move from the step targets;
+    // move 0 starts at the origin. Zero-length moves get direction (0, 0).
+    void move_geometry(const int32_t* x, const int32_t* y, size_t count, float mm_per_step,
+                       float* length_mm, float* dir_x, float* dir_y);
+
+    struct JunctionCosts {
+        float corner_cos_threshold; // sharper corners pay direction_change_s
+        float direction_change_s;
+        float mode_switch_s;        // cut <-> travel
+    };
+
+    // Speed carried from move i into move i + 1 and the fixed cost of that
+    // corner; the last move ends at rest. junction() takes one i with a
+    // move after it.
+    void junctions(const uint8_t* laser_on, const float* dir_x, const float* dir_y, const float* length_mm,
+                   const float* cruise, size_t count, const JunctionCosts& costs,
+                   float* exit_speed, float* penalty_s);
+    void junction(const uint8_t* laser_on, const float* dir_x, const float* dir_y, const float* length_mm,
+                  const float* cruise, size_t i, const JunctionCosts& costs, float& exit_speed, float& penalty_s);
+
+    // Trapezoidal profile time of each move, entering at the previous
+    // move's exit speed (0 for move 0), plus its junction penalty
+    void move_times(const float* length_mm, const float* cruise, const float* accel, const float* exit_speed,
+                    const float* penalty_s, size_t count, float* seconds);
+    float move_time(float length_mm, float entry, float exit, float cruise, float accel, float penalty_s);
+
+    const char* active_isa();
+}
@@ -0,0 +1,46 @@
+#include "job_monitor.h"
+#include <algorithm>
+
+JobMonitor::JobMonitor(FrameScheduler* frame_scheduler)
+    : toolpath(nullptr), bytes_total(0), packet_base(0),
+      scheduler(frame_scheduler), dropped(0) {
+}
+
+void JobMonitor::attach(K40Comms& comms) {
+    comms.set_progress_hook([this](uint64_t packets_sent) { on_packets_sent(packets_sent); });
+}
+
+void JobMonitor::begin(const Toolpath& job, std::vector<uint64_t> end_bytes, uint64_t total_bytes,
+                       uint64_t packets_sent) {
+    // The comms thread sees these through the queue mutex taken by submit()
+    toolpath = &job;
+    move_end_bytes = std::move(end_bytes);
+    bytes_total = total_bytes;
+    packet_base = packets_sent;
+}
+
+void JobMonitor::on_packets_sent(uint64_t packets_sent) {
+    if (!toolpath || packets_sent < packet_base) return;
+
+    JobProgress progress;
+    progress.bytes_total = bytes_total;
+    progress.bytes_done = std::min((packets_sent - packet_base) * K40Protocol::PAYLOAD_SIZE, bytes_total);
+
+    // A move is done once every byte up to its end has been accepted
+    auto done = std::upper_bound(move_end_bytes.begin(), move_end_bytes.end(), progress.bytes_done);
+    progress.moves_done = static_cast<uint32_t>(done - move_end_bytes.begin());
+    if (progress.moves_done > 0) {
+        progress.head_x = toolpath->x[progress.moves_done - 1];
+        progress.head_y = toolpath->y[progress.moves_done - 1];
+    } else {
+        progress.head_x = 0;
+        progress.head_y = 0;
+    }
+
+    if (!channel.try_push(progress)) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    // Coalesced: only the first sample since the last frame wakes the UI
+    if (scheduler) scheduler->request_frame();
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "toolpath.h"
+#include "comms/k40_comms.h"
+#include "core/frame_scheduler.h"
+#include "core/spsc_ring.h"
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+// One progress sample, produced on the comms thread
+struct JobProgress {
+    uint64_t bytes_done;    // command bytes accepted by the controller
+    uint64_t bytes_total;
+    uint32_t moves_done;    // toolpath moves whose commands were all accepted
+    int32_t head_x;         // steps, end of the last completed move
+    int32_t head_y;
+
+    double fraction() const { return bytes_total ? static_cast<double>(bytes_done) / bytes_total : 0.0; }
+};
+
+// Carries live job progress from the comms thread to the UI. The comms side
+// maps accepted packets to toolpath moves and pushes into a lock-free ring;
+// when the ring is full the sample is dropped (each one supersedes the
+// last), so a stalled UI never holds up the USB stream. The UI drains the
+// ring once per frame.
+class JobMonitor {
+public:
+    typedef SpscRing<JobProgress, 256> Channel;
+
+private:
+    const Toolpath* toolpath;
+    std::vector<uint64_t> move_end_bytes;
+    uint64_t bytes_total;
+    uint64_t packet_base;
+    FrameScheduler* scheduler;
+
+    Channel channel;
+    std::atomic<uint64_t> dropped;
+
+public:
+    explicit JobMonitor(FrameScheduler* frame_scheduler = nullptr);
+
+    // Installs the progress hook; comms must be stopped
+    void attach(K40Comms& comms);
+
+    // Call before submitting the job's commands. end_bytes comes from
+    // EgvEncoder::encode_toolpath; packets_sent is the comms total so far.
+    // The toolpath must outlive the job.
+    void begin(const Toolpath& job, std::vector<uint64_t> end_bytes, uint64_t total_bytes,
+               uint64_t packets_sent);
+
+    // Comms thread
+    void on_packets_sent(uint64_t packets_sent);
+
+    // UI thread: newest sample since the last call, if any
+    bool poll(JobProgress& latest) { return channel.pop_latest(latest); }
+
+    uint64_t dropped_samples() const { return dropped.load(std::memory_order_relaxed); }
+};
@@ -0,0 +1,254 @@
+#include "job_queue.h"
+#include "egv_encoder.h"
+#include "toolpath_builder.h"
+#include "toolpath_optimizer.h"
+#include "geometry/containment.h"
+#include "geometry/polyline_simplify.h"
+#include "core/mapped_file.h"
+#include "core/trace.h"
+#include <algorithm>
+#include <iostream>
+
+namespace {
+    constexpr int PREPARE_STAGES = static_cast<int>(JobStage::READY) - static_cast<int>(JobStage::PARSING);
+
+    std::string file_name(const std::string& path) {
+        size_t slash = path.find_last_of('/');
+        return slash == std::string::npos ? path : path.substr(slash + 1);
+    }
+}
+
+void JobQueue::Notifier::notify() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (callback) callback();
+}
+
+void JobQueue::Notifier::detach() {
+    std::lock_guard<std::mutex> lock(mutex);
+    callback = nullptr;
+}
+
+JobQueue::JobQueue(K40Comms* machine, JobMonitor* job_monitor, ChangedCallback changed, ThreadPool& worker_pool)
+    : pool(worker_pool), comms(machine), monitor(job_monitor), notifier(std::make_shared<Notifier>()),
+      next_id(1), auto_advance(false) {
+    notifier->callback = changed;
+}
+
+JobQueue::~JobQueue() {
+    notifier->detach();
+    std::lock_guard<std::mutex> lock(jobs_mutex);
+    for (auto& job : jobs) job->cancelled.store(true);
+}
+
+uint32_t JobQueue::add(const std::string& path, const JobSettings& settings) {
+    auto job = std::make_shared<Job>();
+    job->path = path;
+    job->settings = settings;
+    {
+        std::lock_guard<std::mutex> lock(jobs_mutex);
+        job->id = next_id++;
+        jobs.push_back(job);
+    }
+    job->stage.store(JobStage::PARSING, std::memory_order_release);
+    ThreadPool* worker_pool = &pool;
+    std::shared_ptr<Notifier> notify = notifier;
+    pool.submit([job, worker_pool, notify] { run_stage(job, worker_pool, notify); });
+    return job->id;
+}
+
+// One stage per task: a job that is ordering does not hold up another
+// job's parse, and pool threads are free for parallel_for in between
+void JobQueue::run_stage(std::shared_ptr<Job> job, ThreadPool* pool, std::shared_ptr<Notifier> notifier) {
+    if (job->cancelled.load()) return;
+    if (!prepare_stage(*job)) {
+        std::cerr << "Job " << job->id << " (" << file_name(job->path) << ") failed while "
+                  << stage_name(job->stage.load()) << ": " << job->error << std::endl;
+        job->stage.store(JobStage::FAILED, std::memory_order_release);
+        notifier->notify();
+        return;
+    }
+
+    JobStage next = static_cast<JobStage>(static_cast<int>(job->stage.load()) + 1);
+    if (next == JobStage::READY) {
+        std::cout << "Job " << job->id << " (" << file_name(job->path) << ") ready: " << job->toolpath.size()
+                  << " moves, " << job->total_bytes << " bytes" << std::endl;
+    }
+    job->stage.store(next, std::memory_order_release);
+    notifier->notify();
+    if (next != JobStage::READY) {
+        pool->submit([job, pool, notifier] { run_stage(job, pool, notifier); });
+    }
+}
+
+bool JobQueue::prepare_stage(Job& job) {
+    switch (job.stage.load()) {
+        case JobStage::PARSING: {
+            TRACE_SPAN("job.parse");
+            // Read, not mapped: the file may be saved over while queued
+            std::string contents;
+            if (!read_file_copy(job.path, contents)) {
+                job.error = "Cannot open " + job.path;
+                return false;
+            }
+            DxfReader reader(job.settings.read);
+            if (!reader.parse(contents.data(), contents.size(), job.drawing)) {
+                job.error = reader.get_error();
+                return false;
+            }
+            // Points closer together than the machine can step only cost
+            // time in every later stage; half a step is below what it can cut
+            if (job.settings.simplify_mm > 0.0) {
+                job.drawing = PolylineSimplify::simplify(job.drawing, job.settings.simplify_mm);
+            }
+            return true;
+        }
+        case JobStage::OFFSETTING: {
+            TRACE_SPAN("job.offset");
+            if (!job.settings.compensate_kerf) return true;
+            ContainmentTree nesting = Containment::build(job.drawing);
+            KerfCompensator compensator(job.settings.kerf);
+            job.drawing = compensator.apply(job.drawing, nesting.hole_flags());
+            return true;
+        }
+        case JobStage::ORDERING: {
+            TRACE_SPAN("job.order");
+            // Again after offsetting: kerf changes which contours nest
+            ContainmentTree nesting = Containment::build(job.drawing);
+            job.order = PathOrdering::nearest_neighbour(job.drawing, 0.0, 0.0, &nesting);
+            return true;
+        }
+        case JobStage::BUILDING: {
+            TRACE_SPAN("job.build");
+            job.toolpath = ToolpathBuilder::build(job.drawing, job.order, job.settings.layer_speeds,
+                                                  job.settings.default_speed_mm_s);
+            if (job.settings.optimize) job.toolpath = ToolpathOptimizer::optimize(job.toolpath);
+            // Only the toolpath and commands are kept while jobs wait
+            job.drawing = Drawing();
+            job.order = PathOrder();
+            if (job.toolpath.size() == 0) {
+                job.error = "nothing to cut";
+                return false;
+            }
+            return true;
+        }
+        case JobStage::ENCODING: {
+            TRACE_SPAN("job.encode");
+            EgvEncoder encoder(job.settings.optimize ? EgvEncoder::Options() : EgvEncoder::Options::unoptimized());
+            encoder.encode_toolpath(job.toolpath, &job.move_end_bytes);
+            encoder.finish();
+            job.total_bytes = encoder.total_bytes();
+            job.packets = K40Protocol::packetize(encoder.take());
+            return true;
+        }
+        default:
+            return true;
+    }
+}
+
+bool JobQueue::start_next() {
+    if (!comms || streaming) return false;
+    if (comms->get_state() == K40Comms::State::STOPPED) return false;
+
+    std::shared_ptr<Job> next;
+    {
+        std::lock_guard<std::mutex> lock(jobs_mutex);
+        for (auto& job : jobs) {
+            if (job->stage.load(std::memory_order_acquire) == JobStage::READY) {
+                next = job;
+                break;
+            }
+        }
+    }
+    if (!next) return false;
+
+    // The job that failed is already marked; this one starts afresh
+    comms->clear_error();
+
+    // Everything is prepared; this is only a queue insert
+    if (monitor) {
+        monitor->begin(next->toolpath, std::move(next->move_end_bytes), next->total_bytes,
+                       comms->get_stats().packets_sent);
+    }
+    comms->submit_packets(next->packets);
+    next->packets = std::vector<K40Protocol::Packet>();
+    next->stage.store(JobStage::STREAMING, std::memory_order_release);
+    streaming = next;
+    monitored = next;
+    std::cout << "Job " << next->id << " (" << file_name(next->path) << ") streaming, "
+              << next->total_bytes << " bytes" << std::endl;
+    return true;
+}
+
+bool JobQueue::update() {
+    bool finished = false;
+    if (streaming && comms) {
+        if (comms->get_state() == K40Comms::State::ERROR) {
+            streaming->error = "machine error";
+            streaming->stage.store(JobStage::FAILED, std::memory_order_release);
+            finished = true;
+        } else if (comms->pending_packets() == 0) {
+            // Accepted, not burnt: the controller still buffers a few packets,
+            // which covers the hand-off to the next job
+            streaming->stage.store(JobStage::DONE, std::memory_order_release);
+            std::cout << "Job " << streaming->id << " (" << file_name(streaming->path) << ") done" << std::endl;
+            finished = true;
+        }
+        if (finished) streaming.reset();
+    }
+    // A machine error halts auto advance until a job is started by hand
+    if (auto_advance && !streaming && !(comms && comms->get_state() == K40Comms::State::ERROR)) start_next();
+    return finished;
+}
+
+void JobQueue::clear_finished() {
+    std::lock_guard<std::mutex> lock(jobs_mutex);
+    for (auto it = jobs.begin(); it != jobs.end();) {
+        JobStage stage = (*it)->stage.load(std::memory_order_acquire);
+        if ((stage == JobStage::DONE || stage == JobStage::FAILED) && *it != monitored) {
+            it = jobs.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+std::vector<JobStatus> JobQueue::snapshot() const {
+    std::vector<JobStatus> out;
+    std::lock_guard<std::mutex> lock(jobs_mutex);
+    for (const auto& job : jobs) {
+        JobStatus status;
+        status.id = job->id;
+        status.name = file_name(job->path);
+        status.stage = job->stage.load(std::memory_order_acquire);
+        int done = static_cast<int>(status.stage) - static_cast<int>(JobStage::PARSING);
+        status.prepared = status.stage >= JobStage::READY ? 1.0f
+                        : static_cast<float>(std::max(done, 0)) / PREPARE_STAGES;
+        // Outputs are only read once the stage that writes them is past
+        bool built = status.stage >= JobStage::ENCODING && status.stage != JobStage::FAILED;
+        status.moves = built ? job->toolpath.size() : 0;
+        status.bytes = status.stage >= JobStage::READY && status.stage != JobStage::FAILED ? job->total_bytes : 0;
+        if (status.stage == JobStage::FAILED) status.error = job->error;
+        out.push_back(std::move(status));
+    }
+    return out;
+}
+
+const Toolpath* JobQueue::streaming_toolpath() const {
+    return streaming ? &streaming->toolpath : nullptr;
+}
+
+const char* JobQueue::stage_name(JobStage stage) {
+    switch (stage) {
+        case JobStage::QUEUED: return "queued";
+        case JobStage::PARSING: return "parsing";
+        case JobStage::OFFSETTING: return "offsetting";
+        case JobStage::ORDERING: return "ordering";
+        case JobStage::BUILDING: return "building";
+        case JobStage::ENCODING: return "encoding";
+        case JobStage::READY: return "ready";
+        case JobStage::STREAMING: return "streaming";
+        case JobStage::DONE: return "done";
+        case JobStage::FAILED: return "failed";
+    }
+    return "unknown";
+}
@@ -0,0 +1,151 @@
+#pragma once
+
+#include "toolpath.h"
+#include "kerf_compensator.h"
+#include "job_monitor.h"
+#include "comms/k40_comms.h"
+#include "core/thread_pool.h"
+#include "dxf/dxf_reader.h"
+#include "geometry/path_order.h"
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+enum class JobStage : uint8_t {
+    QUEUED,
+    PARSING,      // read, flatten and simplify the DXF
+    OFFSETTING,   // kerf compensation
+    ORDERING,     // nesting and cut order
+    BUILDING,     // toolpath
+    ENCODING,     // Lhymicro-GL commands, packetized
+    READY,        // fully prepared, waiting for the machine
+    STREAMING,
+    DONE,
+    FAILED
+};
+
+struct JobSettings {
+    DxfReadSettings read;
+    bool compensate_kerf;
+    KerfSettings kerf;
+    std::vector<double> layer_speeds;   // mm/s by drawing layer
+    double default_speed_mm_s;
+    bool optimize;                      // ToolpathOptimizer and encoder options
+    double simplify_mm;                 // PolylineSimplify tolerance; 0 keeps every point
+
+    JobSettings() : compensate_kerf(true), default_speed_mm_s(20.0), optimize(true),
+                    simplify_mm(K40Units::MM_PER_STEP / 2) {}
+};
+
+// What the UI shows for one job
+struct JobStatus {
+    uint32_t id;
+    std::string name;
+    JobStage stage;
+    float prepared;        // 0..1 through the preparation stages
+    size_t moves;          // once built
+    uint64_t bytes;        // once encoded
+    std::string error;
+};
+
+// Jobs waiting for one machine. Each job runs its preparation stages as a
+// chain of tasks on the pool, so while one job streams to the laser the
+// following ones are parsed, offset, ordered and encoded in the background,
+// each in whatever stage it has reached. Starting the next job only submits
+// commands that already exist.
+//
+// add(), start_next(), update() and snapshot() are for the UI thread; stage
+// tasks only touch their own job.
+class JobQueue {
+public:
+    // Called from a pool thread after every stage; must not block
+    typedef std::function<void()> ChangedCallback;
+
+private:
+    struct Job {
+        uint32_t id;
+        std::string path;
+        JobSettings settings;
+        std::atomic<JobStage> stage;
+        std::atomic<bool> cancelled;
+        std::string error;
+
+        // Stage outputs; each is written by one stage and read by the next
+        Drawing drawing;
+        PathOrder order;
+        Toolpath toolpath;
+        std::vector<K40Protocol::Packet> packets;
+        std::vector<uint64_t> move_end_bytes;
+        uint64_t total_bytes;
+
+        Job() : id(0), stage(JobStage::QUEUED), cancelled(false), total_bytes(0) {}
+    };
+
+    // Shared with the stage tasks; detached by the destructor so no callback
+    // runs once the queue is gone, even from a stage still in progress
+    struct Notifier {
+        std::mutex mutex;
+        ChangedCallback callback;
+
+        void notify();
+        void detach();
+    };
+
+    ThreadPool& pool;
+    K40Comms* comms;
+    JobMonitor* monitor;
+    std::shared_ptr<Notifier> notifier;
+
+    mutable std::mutex jobs_mutex;
+    std::deque<std::shared_ptr<Job>> jobs;
+    std::shared_ptr<Job> streaming;
+    std::shared_ptr<Job> monitored;   // the monitor points at its toolpath
+    uint32_t next_id;
+    bool auto_advance;
+
+    // Runs the job's current stage and queues the next one. Tasks hold the
+    // job, not the queue, so destroying the queue mid-chain is safe.
+    static void run_stage(std::shared_ptr<Job> job, ThreadPool* pool, std::shared_ptr<Notifier> notifier);
+    static bool prepare_stage(Job& job);
+
+public:
+    // comms and monitor may be null: jobs are still prepared, but only
+    // stream once a machine is attached. Stop comms before destroying a
+    // queue that is streaming; the monitor reads the job's toolpath from
+    // the comms thread.
+    JobQueue(K40Comms* machine, JobMonitor* job_monitor, ChangedCallback changed = nullptr,
+             ThreadPool& worker_pool = ThreadPool::shared());
+    ~JobQueue();
+
+    JobQueue(const JobQueue&) = delete;
+    JobQueue& operator=(const JobQueue&) = delete;
+
+    // Queues a DXF and starts preparing it at once; returns its id
+    uint32_t add(const std::string& path, const JobSettings& settings = JobSettings());
+
+    // Streams the first ready job if the machine is free, clearing a
+    // machine error left by an aborted job; false otherwise
+    bool start_next();
+    // With auto advance, update() starts the first ready job whenever the
+    // machine is free, so the next job follows the moment the current one
+    // has been accepted by the controller. After a machine error the next
+    // job waits for start_next().
+    void set_auto_advance(bool enabled) { auto_advance = enabled; }
+
+    // Once per frame: notices the streaming job finishing; true if it did
+    bool update();
+
+    // Drops finished and failed jobs, except the one the monitor still shows
+    void clear_finished();
+
+    std::vector<JobStatus> snapshot() const;
+    const Toolpath* streaming_toolpath() const;
+    bool is_streaming() const { return streaming != nullptr; }
+
+    static const char* stage_name(JobStage stage);
+};
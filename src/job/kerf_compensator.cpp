@@ -0,0 +1,62 @@
+#include "kerf_compensator.h"
+#include "toolpath.h"
+
+namespace {
+    IntPath to_steps(const Contour& contour) {
+        IntPath path;
+        path.reserve(contour.points.size());
+        for (const auto& p : contour.points) {
+            path.push_back(IntPoint{K40Units::mm_to_steps(p.x), K40Units::mm_to_steps(p.y)});
+        }
+        return path;
+    }
+
+    Contour to_contour(const IntPath& path, uint16_t layer) {
+        Contour contour;
+        contour.closed = true;
+        contour.layer = layer;
+        contour.points.reserve(path.size());
+        for (const auto& p : path) {
+            contour.points.push_back(Vec2{K40Units::steps_to_mm(static_cast<int32_t>(p.x)),
+                                          K40Units::steps_to_mm(static_cast<int32_t>(p.y))});
+        }
+        contour.update_bounds();
+        return contour;
+    }
+}
+
+KerfCompensator::KerfCompensator(const KerfSettings& kerf_settings, ThreadPool& worker_pool)
+    : pool(worker_pool), settings(kerf_settings) {
+}
+
+Drawing KerfCompensator::apply(const Drawing& drawing, const std::vector<uint8_t>& is_hole) const {
+    const double delta_steps = settings.kerf_mm * 0.5 * K40Units::STEPS_PER_MM;
+    const size_t count = drawing.contours.size();
+
+    std::vector<std::vector<Contour>> results(count);
+    pool.parallel_for(count, [&](size_t i) {
+        const Contour& contour = drawing.contours[i];
+        if (!contour.closed || contour.points.size() < 3 || delta_steps == 0.0) {
+            results[i].push_back(contour);
+            return;
+        }
+
+        bool hole = i < is_hole.size() && is_hole[i];
+        IntPaths offset = PolygonOffset::offset(to_steps(contour), hole ? -delta_steps : delta_steps,
+                                                settings.offset);
+        results[i].reserve(offset.size());
+        for (const auto& path : offset) {
+            results[i].push_back(to_contour(path, contour.layer));
+        }
+    });
+
+    Drawing out;
+    out.layers = drawing.layers;
+    size_t total = 0;
+    for (const auto& r : results) total += r.size();
+    out.contours.reserve(total);
+    for (auto& r : results) {
+        for (auto& contour : r) out.contours.push_back(std::move(contour));
+    }
+    return out;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "geometry/contour.h"
+#include "geometry/polygon_offset.h"
+#include "core/thread_pool.h"
+#include <vector>
+
+struct KerfSettings {
+    double kerf_mm;          // full beam width; each side moves by half of it
+    OffsetSettings offset;
+
+    KerfSettings() : kerf_mm(0.15) {}
+};
+
+// Moves closed contours half a kerf away from the material that is kept,
+// so parts come out at drawn size: outlines grow, holes shrink. Offsetting
+// is done in integer machine steps, one contour per task on the pool. Open
+// contours pass through unchanged.
+class KerfCompensator {
+private:
+    ThreadPool& pool;
+    KerfSettings settings;
+
+public:
+    explicit KerfCompensator(const KerfSettings& kerf_settings = KerfSettings(),
+                             ThreadPool& worker_pool = ThreadPool::shared());
+
+    void set_settings(const KerfSettings& kerf_settings) { settings = kerf_settings; }
+    const KerfSettings& get_settings() const { return settings; }
+
+    // is_hole[i] marks contour i as a hole (shrinks instead of growing); an
+    // empty vector treats every closed contour as an outline. A contour can
+    // split in two or vanish, so the output may differ in count.
+    Drawing apply(const Drawing& drawing, const std::vector<uint8_t>& is_hole = {}) const;
+};
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "speed_code.h"
+
+// Kinematic model of a K40 used for time estimation. Moves follow a
+// trapezoidal velocity profile with a per-gear acceleration; the head slows
+// down at corners and pays a fixed cost for direction-code changes and for
+// switching between cutting and rapid travel.
+struct MotionModel {
+    double travel_speed_mm_s;
+    double gear_accel_mm_s2[4];
+    double direction_change_s;  // controller latency when the direction code changes
+    double mode_switch_s;       // leaving/entering cut mode around a rapid move
+    double corner_cos_threshold; // cos(angle) above which a junction counts as straight
+
+    MotionModel()
+        : travel_speed_mm_s(150.0),
+          gear_accel_mm_s2{1500.0, 2500.0, 4000.0, 6000.0},
+          direction_change_s(0.0015),
+          mode_switch_s(0.12),
+          corner_cos_threshold(0.9999) {}
+
+    double accel_for_speed(double mm_per_second) const {
+        return gear_accel_mm_s2[SpeedCodes::gear_for_speed(mm_per_second) - 1];
+    }
+};
@@ -0,0 +1,47 @@
+#include "speed_code.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace SpeedCodes {
+
+    namespace {
+        // Period model for the M2 board: ticks = B + M * (ms per 1000 steps)
+        constexpr double PERIOD_B = 5120.0;
+        constexpr double PERIOD_M = 11148.0;
+        constexpr double MM_PER_KILOSTEP = 25.4;
+    }
+
+    int gear_for_speed(double mm_per_second) {
+        if (mm_per_second <= 25.4) return 1;
+        if (mm_per_second <= 60.0) return 2;
+        if (mm_per_second <= 127.0) return 3;
+        return 4;
+    }
+
+    double speed_for_value(uint16_t value) {
+        double period_ms = (65536.0 - value - PERIOD_B) / PERIOD_M;
+        if (period_ms <= 0.0) return MAX_SPEED_MM_S;
+        return MM_PER_KILOSTEP / period_ms;
+    }
+
+    SpeedCode for_speed(double mm_per_second) {
+        SpeedCode result;
+        result.requested_mm_s = mm_per_second;
+
+        double speed = std::clamp(mm_per_second, MIN_SPEED_MM_S, MAX_SPEED_MM_S);
+        double period_ms = MM_PER_KILOSTEP / speed;
+        double ticks = std::round(PERIOD_B + PERIOD_M * period_ms);
+        ticks = std::clamp(ticks, 1.0, 65535.0);
+
+        result.value = static_cast<uint16_t>(65536.0 - ticks);
+        result.actual_mm_s = speed_for_value(result.value);
+        result.gear = gear_for_speed(result.actual_mm_s);
+
+        char buffer[16];
+        std::snprintf(buffer, sizeof(buffer), "CV%03d%03d%dC",
+                      result.value >> 8, result.value & 0xFF, result.gear);
+        result.code = buffer;
+        return result;
+    }
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// M2 Nano speed codes. The board does not take a speed; it takes a step
+// period counted down from 65536, so requested speeds are quantized and
+// grouped into one of four acceleration gears.
+struct SpeedCode {
+    double requested_mm_s;
+    double actual_mm_s;
+    uint16_t value;
+    int gear;         // 1..4, selects the controller's acceleration ramp
+    std::string code; // e.g. "CV2341142C"
+};
+
+namespace SpeedCodes {
+    constexpr double MIN_SPEED_MM_S = 5.0;
+    constexpr double MAX_SPEED_MM_S = 500.0;
+
+    SpeedCode for_speed(double mm_per_second);
+    double speed_for_value(uint16_t value);
+    int gear_for_speed(double mm_per_second);
+}
@@ -0,0 +1,181 @@
+#include "time_estimator.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+TimeEstimator::TimeEstimator(const MotionModel& motion) : model(motion), toolpath(nullptr) {
+}
+
+void TimeEstimator::compute_geometry() {
+    const size_t n = toolpath->size();
+    length_mm.resize(n);
+    dir_x.resize(n);
+    dir_y.resize(n);
+    EstimateKernels::move_geometry(toolpath->x.data(), toolpath->y.data(), n, static_cast<float>(K40Units::MM_PER_STEP),
+                                   length_mm.data(), dir_x.data(), dir_y.data());
+}
+
+void TimeEstimator::compute_speeds() {
+    const size_t n = toolpath->size();
+    const size_t layer_count = toolpath->layers.size();
+
+    // Per-layer lookup tables with travel in the last slot; the per-move
+    // pass is then a plain gather
+    std::vector<float> layer_speed(layer_count + 1);
+    std::vector<float> layer_accel(layer_count + 1);
+    for (size_t l = 0; l < layer_count; ++l) {
+        SpeedCode code = SpeedCodes::for_speed(toolpath->layers[l].speed_mm_s);
+        layer_speed[l] = static_cast<float>(code.actual_mm_s);
+        layer_accel[l] = static_cast<float>(model.accel_for_speed(code.actual_mm_s));
+    }
+    layer_speed[layer_count] = static_cast<float>(model.travel_speed_mm_s);
+    layer_accel[layer_count] = static_cast<float>(model.accel_for_speed(model.travel_speed_mm_s));
+
+    cruise.resize(n);
+    accel.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+        size_t slot = toolpath->laser_on[i] ? std::min<size_t>(toolpath->layer[i], layer_count) : layer_count;
+        cruise[i] = layer_speed[slot];
+        accel[i] = layer_accel[slot];
+    }
+}
+
+EstimateKernels::JunctionCosts TimeEstimator::junction_costs() const {
+    EstimateKernels::JunctionCosts costs;
+    costs.corner_cos_threshold = static_cast<float>(model.corner_cos_threshold);
+    costs.direction_change_s = static_cast<float>(model.direction_change_s);
+    costs.mode_switch_s = static_cast<float>(model.mode_switch_s);
+    return costs;
+}
+
+void TimeEstimator::compute_junction(size_t i) {
+    if (i + 1 >= toolpath->size()) {
+        exit_speed[i] = 0.0f;
+        penalty_s[i] = 0.0f;
+        return;
+    }
+    EstimateKernels::junction(toolpath->laser_on.data(), dir_x.data(), dir_y.data(), length_mm.data(), cruise.data(),
+                              i, junction_costs(), exit_speed[i], penalty_s[i]);
+}
+
+void TimeEstimator::compute_junctions() {
+    const size_t n = toolpath->size();
+    exit_speed.resize(n);
+    penalty_s.resize(n);
+    EstimateKernels::junctions(toolpath->laser_on.data(), dir_x.data(), dir_y.data(), length_mm.data(), cruise.data(),
+                               n, junction_costs(), exit_speed.data(), penalty_s.data());
+}
+
+float TimeEstimator::compute_move_time(size_t i) const {
+    float entry = i > 0 ? exit_speed[i - 1] : 0.0f;
+    return EstimateKernels::move_time(length_mm[i], entry, exit_speed[i], cruise[i], accel[i], penalty_s[i]);
+}
+
+void TimeEstimator::accumulate_totals() {
+    const size_t n = toolpath->size();
+    current = JobEstimate();
+    current.moves = n;
+    current.layer_s.assign(toolpath->layers.size(), 0.0);
+
+    for (size_t i = 0; i < n; ++i) {
+        double t = move_s[i];
+        if (toolpath->laser_on[i]) {
+            current.cut_s += t;
+            current.cut_mm += length_mm[i];
+            if (toolpath->layer[i] < current.layer_s.size()) {
+                current.layer_s[toolpath->layer[i]] += t;
+            }
+        } else {
+            current.travel_s += t;
+            current.travel_mm += length_mm[i];
+        }
+    }
+    current.total_s = current.cut_s + current.travel_s;
+}
+
+const JobEstimate& TimeEstimator::estimate(const Toolpath& path) {
+    toolpath = &path;
+    const size_t n = path.size();
+
+    compute_geometry();
+    compute_speeds();
+    compute_junctions();
+
+    move_s.resize(n);
+    EstimateKernels::move_times(length_mm.data(), cruise.data(), accel.data(), exit_speed.data(), penalty_s.data(), n,
+                                move_s.data());
+
+    layer_moves.assign(path.layers.size(), {});
+    for (size_t i = 0; i < n; ++i) {
+        if (path.laser_on[i] && path.layer[i] < layer_moves.size()) {
+            layer_moves[path.layer[i]].push_back(static_cast<uint32_t>(i));
+        }
+    }
+
+    accumulate_totals();
+    return current;
+}
+
+const JobEstimate& TimeEstimator::update_layer_speed(uint16_t layer, double speed_mm_s) {
+    if (!toolpath || layer >= layer_moves.size()) return current;
+
+    SpeedCode code = SpeedCodes::for_speed(speed_mm_s);
+    float speed = static_cast<float>(code.actual_mm_s);
+    float layer_accel = static_cast<float>(model.accel_for_speed(code.actual_mm_s));
+
+    const std::vector<uint32_t>& moves = layer_moves[layer];
+    for (uint32_t i : moves) {
+        cruise[i] = speed;
+        accel[i] = layer_accel;
+    }
+
+    // A move's time depends on the junctions on both sides, and each junction
+    // on both neighbours' cruise speeds, so touch i-1..i+1 around every move.
+    for (uint32_t i : moves) {
+        if (i > 0) compute_junction(i - 1);
+        compute_junction(i);
+    }
+
+    const size_t n = toolpath->size();
+    auto refresh = [&](size_t i) {
+        float updated = compute_move_time(i);
+        double delta = static_cast<double>(updated) - move_s[i];
+        if (delta == 0.0) return;
+        move_s[i] = updated;
+
+        if (toolpath->laser_on[i]) {
+            current.cut_s += delta;
+            if (toolpath->layer[i] < current.layer_s.size()) {
+                current.layer_s[toolpath->layer[i]] += delta;
+            }
+        } else {
+            current.travel_s += delta;
+        }
+        current.total_s += delta;
+    };
+
+    for (uint32_t i : moves) {
+        if (i > 0) refresh(i - 1);
+        refresh(i);
+        if (i + 1 < n) refresh(i + 1);
+    }
+
+    return current;
+}
+
+std::string TimeEstimator::format_duration(double seconds) {
+    long total = static_cast<long>(std::llround(std::max(0.0, seconds)));
+    long hours = total / 3600;
+    long minutes = (total / 60) % 60;
+    long secs = total % 60;
+
+    char buffer[32];
+    if (hours > 0) {
+        std::snprintf(buffer, sizeof(buffer), "%ldh %02ldm %02lds", hours, minutes, secs);
+    } else if (minutes > 0) {
+        std::snprintf(buffer, sizeof(buffer), "%ldm %02lds", minutes, secs);
+    } else {
+        std::snprintf(buffer, sizeof(buffer), "%lds", secs);
+    }
+    return buffer;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "toolpath.h"
+#include "motion_model.h"
+#include "estimate_kernels.h"
+#include <string>
+#include <vector>
+
+struct JobEstimate {
+    double total_s;
+    double cut_s;
+    double travel_s;
+    double cut_mm;
+    double travel_mm;
+    size_t moves;
+    std::vector<double> layer_s; // cutting time per toolpath layer
+
+    JobEstimate() : total_s(0), cut_s(0), travel_s(0), cut_mm(0), travel_mm(0), moves(0) {}
+};
+
+// Estimates job duration over a Toolpath. The first estimate() runs the
+// geometry, junction and move-time passes over per-move arrays through
+// EstimateKernels; afterwards update_layer_speed() only recomputes the
+// moves of that layer and their neighbours, one at a time.
+class TimeEstimator {
+private:
+    MotionModel model;
+    const Toolpath* toolpath;
+
+    // Per-move state, index-aligned with the toolpath
+    std::vector<float> length_mm;
+    std::vector<float> dir_x, dir_y;
+    std::vector<float> cruise;     // mm/s after speed-code quantization
+    std::vector<float> accel;      // mm/s^2
+    std::vector<float> exit_speed; // junction speed into the next move
+    std::vector<float> penalty_s;
+    std::vector<float> move_s;
+
+    std::vector<std::vector<uint32_t>> layer_moves;
+    JobEstimate current;
+
+    void compute_geometry();
+    void compute_speeds();
+    EstimateKernels::JunctionCosts junction_costs() const;
+    void compute_junction(size_t i);
+    void compute_junctions();
+    float compute_move_time(size_t i) const;
+    void accumulate_totals();
+
+public:
+    explicit TimeEstimator(const MotionModel& motion = MotionModel());
+
+    const JobEstimate& estimate(const Toolpath& path);
+    const JobEstimate& update_layer_speed(uint16_t layer, double speed_mm_s);
+
+    const JobEstimate& get_estimate() const { return current; }
+    void set_model(const MotionModel& motion) { model = motion; }
+
+    // "14m 32s", "1h 03m 10s", "45s"
+    static std::string format_duration(double seconds);
+};
@@ -0,0 +1,28 @@
+#include "toolpath.h"
+
+uint16_t Toolpath::add_layer(const std::string& name, double speed_mm_s) {
+    layers.emplace_back(name, speed_mm_s);
+    return static_cast<uint16_t>(layers.size() - 1);
+}
+
+void Toolpath::add_move(int32_t to_x, int32_t to_y, bool cut, uint16_t layer_index) {
+    x.push_back(to_x);
+    y.push_back(to_y);
+    laser_on.push_back(cut ? 1 : 0);
+    layer.push_back(layer_index);
+}
+
+void Toolpath::reserve(size_t moves) {
+    x.reserve(moves);
+    y.reserve(moves);
+    laser_on.reserve(moves);
+    layer.reserve(moves);
+}
+
+void Toolpath::clear() {
+    x.clear();
+    y.clear();
+    laser_on.clear();
+    layer.clear();
+    layers.clear();
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "core/memory_accounting.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// K40 controllers move in steps of 1/1000 inch
+namespace K40Units {
+    constexpr double MM_PER_STEP = 0.0254;
+    constexpr double STEPS_PER_MM = 1.0 / MM_PER_STEP;
+
+    inline int32_t mm_to_steps(double mm) {
+        return static_cast<int32_t>(mm * STEPS_PER_MM + (mm >= 0 ? 0.5 : -0.5));
+    }
+    inline double steps_to_mm(int32_t steps) { return steps * MM_PER_STEP; }
+}
+
+struct ToolpathLayer {
+    std::string name;
+    double speed_mm_s;
+
+    ToolpathLayer(const std::string& n = "", double speed = 20.0) : name(n), speed_mm_s(speed) {}
+};
+
+// Machine-ordered move list in K40 step coordinates, stored as parallel
+// arrays so passes over it (estimation, encoding) stay cache friendly.
+// Each move starts where the previous one ended; the first starts at the origin.
+class Toolpath {
+public:
+    TrackedVector<int32_t, MemoryTag::JOB> x;
+    TrackedVector<int32_t, MemoryTag::JOB> y;
+    TrackedVector<uint8_t, MemoryTag::JOB> laser_on; // 1 = cut, 0 = travel
+    TrackedVector<uint16_t, MemoryTag::JOB> layer;
+    std::vector<ToolpathLayer> layers;
+
+    uint16_t add_layer(const std::string& name, double speed_mm_s);
+    void add_move(int32_t to_x, int32_t to_y, bool cut, uint16_t layer_index);
+    void reserve(size_t moves);
+    void clear();
+
+    size_t size() const { return x.size(); }
+    bool empty() const { return x.empty(); }
+};
@@ -0,0 +1,71 @@
+#include "toolpath_builder.h"
+#include <utility>
+
+namespace ToolpathBuilder {
+
+    Toolpath build(const Drawing& drawing, const PathOrder& order,
+                   const std::vector<double>& layer_speeds, double default_speed_mm_s) {
+        Toolpath toolpath;
+
+        size_t layer_count = drawing.layers.size();
+        for (const auto& contour : drawing.contours) {
+            if (contour.layer >= layer_count) layer_count = contour.layer + 1u;
+        }
+        for (size_t i = 0; i < layer_count; ++i) {
+            const std::string name = i < drawing.layers.size() ? drawing.layers[i] : std::to_string(i);
+            double speed = i < layer_speeds.size() ? layer_speeds[i] : default_speed_mm_s;
+            toolpath.add_layer(name, speed);
+        }
+
+        size_t moves = 0;
+        for (uint32_t id : order.order) {
+            moves += drawing.contours[id].points.size() + 1;
+        }
+        toolpath.reserve(moves);
+
+        const Bounds2 extent = drawing.bounds();
+        const double left = extent.valid() ? extent.min_x : 0.0;
+        const double top = extent.valid() ? extent.max_y : 0.0;
+
+        int32_t last_x = 0, last_y = 0;
+        for (size_t i = 0; i < order.size(); ++i) {
+            const Contour& contour = drawing.contours[order.order[i]];
+            if (contour.points.empty()) continue;
+
+            const size_t count = contour.points.size();
+            const bool reversed = order.reversed[i] != 0;
+            const uint16_t layer = contour.layer;
+
+            auto point_at = [&](size_t k) {
+                const Vec2& p = contour.points[reversed ? count - 1 - k : k];
+                return std::pair<int32_t, int32_t>(K40Units::mm_to_steps(p.x - left),
+                                                 K40Units::mm_to_steps(top - p.y));
+            };
+
+            auto [sx, sy] = point_at(0);
+            if (sx != last_x || sy != last_y || toolpath.empty()) {
+                toolpath.add_move(sx, sy, false, layer);
+            }
+            last_x = sx;
+            last_y = sy;
+
+            for (size_t k = 1; k < count; ++k) {
+                auto [px, py] = point_at(k);
+                // Points closer than one step collapse onto the same position
+                if (px == last_x && py == last_y) continue;
+                toolpath.add_move(px, py, true, layer);
+                last_x = px;
+                last_y = py;
+            }
+
+            if (contour.closed && (last_x != sx || last_y != sy)) {
+                toolpath.add_move(sx, sy, true, layer);
+                last_x = sx;
+                last_y = sy;
+            }
+        }
+
+        return toolpath;
+    }
+
+}
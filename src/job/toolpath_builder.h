@@ -0,0 +1,17 @@
+#pragma once
+
+#include "toolpath.h"
+#include "geometry/contour.h"
+#include "geometry/path_order.h"
+#include <vector>
+
+// Turns an ordered vector drawing (millimetres, y up) into a machine
+// toolpath (steps, y down). The top-left of the drawing bounds lands on the
+// machine origin. Each contour becomes one travel move to its entry point
+// followed by cut moves; closed contours return to where they started.
+namespace ToolpathBuilder {
+    // layer_speeds[i] is the cut speed for drawing layer i; missing entries
+    // fall back to default_speed_mm_s.
+    Toolpath build(const Drawing& drawing, const PathOrder& order,
+                   const std::vector<double>& layer_speeds, double default_speed_mm_s = 20.0);
+}
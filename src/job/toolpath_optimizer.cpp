@@ -0,0 +1,61 @@
+#include "toolpath_optimizer.h"
+#include "core/trace.h"
+
+namespace ToolpathOptimizer {
+
+    Toolpath optimize(const Toolpath& toolpath, ToolpathOptimizeStats* stats) {
+        TRACE_SPAN("toolpath.optimize");
+        ToolpathOptimizeStats counts = {};
+        counts.moves_in = toolpath.size();
+
+        Toolpath out;
+        out.layers = toolpath.layers;
+        out.reserve(toolpath.size());
+
+        // Where the last kept move started and ended
+        int64_t start_x = 0, start_y = 0;
+        int64_t end_x = 0, end_y = 0;
+
+        for (size_t i = 0; i < toolpath.size(); ++i) {
+            const int64_t to_x = toolpath.x[i], to_y = toolpath.y[i];
+            const bool cut = toolpath.laser_on[i] != 0;
+            const uint16_t layer = toolpath.layer[i];
+
+            if (to_x == end_x && to_y == end_y) {
+                counts.zero_length++;
+                continue;
+            }
+
+            const size_t last = out.empty() ? 0 : out.size() - 1;
+            if (!out.empty() && out.laser_on[last] == cut && (!cut || out.layer[last] == layer)) {
+                bool fold = !cut;
+                if (cut) {
+                    // Same direction: no turn between the two, and not a reversal
+                    const int64_t ax = end_x - start_x, ay = end_y - start_y;
+                    const int64_t bx = to_x - end_x, by = to_y - end_y;
+                    fold = ax * by - ay * bx == 0 && ax * bx + ay * by > 0;
+                }
+                if (fold) {
+                    out.x[last] = static_cast<int32_t>(to_x);
+                    out.y[last] = static_cast<int32_t>(to_y);
+                    out.layer[last] = layer;
+                    end_x = to_x;
+                    end_y = to_y;
+                    (cut ? counts.collinear : counts.travels)++;
+                    continue;
+                }
+            }
+
+            out.add_move(static_cast<int32_t>(to_x), static_cast<int32_t>(to_y), cut, layer);
+            start_x = end_x;
+            start_y = end_y;
+            end_x = to_x;
+            end_y = to_y;
+        }
+
+        counts.moves_out = out.size();
+        if (stats) *stats = counts;
+        return out;
+    }
+
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "toolpath.h"
+#include <cstddef>
+
+struct ToolpathOptimizeStats {
+    size_t moves_in;
+    size_t moves_out;
+    size_t zero_length;      // moves that went nowhere
+    size_t collinear;        // cut moves folded into the previous one
+    size_t travels;          // travel moves folded into the next travel
+};
+
+// Shrinks a toolpath before encoding without changing what gets cut.
+// Zero-length moves are dropped, a cut that continues the previous cut in
+// the same direction (same layer) extends it, and back-to-back travels
+// become one straight travel since the beam is off anyway. Fewer moves mean
+// fewer mode and direction codes in the Lhymicro-GL stream.
+namespace ToolpathOptimizer {
+    Toolpath optimize(const Toolpath& toolpath, ToolpathOptimizeStats* stats = nullptr);
+}
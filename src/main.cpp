@@ -1,18 +1,337 @@
 #include "window_data.h"
 #include "base_window.h"
-#include "ui/layout.h"
+#include "ui/static_layout.h"
 #include "ui/box.h"
 #include "ui/layout_manager.h"
+#include "ui/file_browser.h"
+#include "step/step_importer.h"
+#include "dxf/dxf_reader.h"
+#include "geometry/geometry_cache.h"
+#include "geometry/nesting.h"
+#include "job/toolpath_builder.h"
+#include "job/job_queue.h"
+#include "comms/simulated_k40.h"
+#include "comms/usb_transport.h"
+#include "viewport/burn_preview.h"
+#include "viewport/scene.h"
+#include "viewport/thumbnail_view.h"
+#include "core/content_hash.h"
+#include "core/file_watcher.h"
+#include "core/mapped_file.h"
+#include "core/memory_accounting.h"
+#include "core/thread_pool.h"
+#include "core/trace.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <future>
 #include <iostream>
+#include <memory>
+
+// File passed on the command line, loaded once the window is up
+static std::string startup_file;
+// --nest: pack the loaded drawing's parts onto the bed
+static bool nest_on_load = false;
+// --trace <path>: record spans from startup and write them here on exit;
+// SIGUSR1 starts recording, and a second SIGUSR1 dumps to the same path
+static std::string trace_path = "step_viewer_trace.json";
+static bool trace_on_exit = false;
+// --swap-interval <n>: eglSwapInterval (default 1)
+// --defer-submit <margin_us>: start frames just before the predicted vblank
+static int swap_interval = 1;
+static int defer_margin_us = -1;
+// --software: draw on the CPU into wl_shm buffers even when EGL works
+static bool software_rendering = false;
+// --no-watch: do not reload the DXF when it changes on disk
+static bool watch_drawing = true;
+static FileWatcher* drawing_watcher = nullptr;
+// Flattened entities of the last two reads of the watched DXF. A cache hit
+// on startup fills the current one in the background; reloads wait for it.
+// Only the reload in flight touches them.
+static DxfEntityMemo dxf_memos[2];
+static int dxf_memo_current = 0;
+static std::future<void> dxf_memo_seeding;
+// A reload of the watched DXF parsed on the pool; the current drawing stays
+// up until main_loop takes the result. A save during one queues another.
+struct DrawingReload {
+    bool ok;
+    CachedGeometry geometry;
+
+    DrawingReload() : ok(false) {}
+};
+static std::future<DrawingReload> drawing_reload;
+static bool reload_again = false;
+// --queue <file.dxf> (repeatable): jobs prepared in the background
+// --laser sim|usb: machine the queue streams to; on its own it starts an
+// empty queue, for files added from the browser
+// --auto-advance: start each job as soon as it is ready and the machine is free
+static std::vector<std::string> queued_files;
+static std::string laser_name = "sim";
+static bool laser_given = false;
+static bool auto_advance = false;
+static Transport* laser_link = nullptr;
+static K40Comms* laser = nullptr;
+static JobMonitor* job_monitor = nullptr;
+static JobQueue* job_queue = nullptr;
+// --monitor: second window showing the job preview full size
+static bool open_monitor = false;
+static BaseWindow* main_window = nullptr;
+// --browse <folder>: file browser panel with the folder's DXFs; clicking
+// one queues it (with --queue or --laser) or opens it
+static std::string browse_folder;
+static ThumbnailCache* thumbnail_cache = nullptr;
+static FileBrowser* file_browser = nullptr;
+
+// Shared by both windows; they render with the same GL context (or both
+// in software)
+static BurnPreview* preview = nullptr;
+
+// Main window: title bar and close button over the main content
+static constexpr auto MAIN_LAYOUT = parse_layout({"titlebar closebtn", "maincontent"});
+static constexpr LayoutCell TITLEBAR = MAIN_LAYOUT.cell("titlebar");
+static constexpr LayoutCell CLOSEBTN = MAIN_LAYOUT.cell("closebtn");
+static constexpr LayoutCell MAINCONTENT = MAIN_LAYOUT.cell("maincontent");
+
+static void on_trace_signal(int) {
+    if (Trace::enabled()) {
+        Trace::request_dump();
+    } else {
+        Trace::enable(true);
+    }
+}
+
+static bool has_extension(const std::string& path, const std::string& extension) {
+    if (path.size() < extension.size()) return false;
+    std::string tail = path.substr(path.size() - extension.size());
+    for (auto& c : tail) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    return tail == extension;
+}
+
+// Parses the loaded contents only to record their entities in memo, so the
+// first reload after a cache hit re-flattens just what changed
+static void seed_memo_async(std::string contents, const DxfReadSettings& settings, DxfEntityMemo* memo) {
+    auto done = std::make_shared<std::promise<void>>();
+    dxf_memo_seeding = done->get_future();
+    auto shared_contents = std::make_shared<std::string>(std::move(contents));
+    ThreadPool::shared().submit([shared_contents, settings, memo, done] {
+        TRACE_SPAN("load.seed_memo");
+        DxfReader reader(settings);
+        reader.set_memo(nullptr, memo);
+        Drawing drawing;
+        if (!reader.parse(shared_contents->data(), shared_contents->size(), drawing)) {
+            memo->entries.clear();
+        }
+        done->set_value();
+    });
+}
+
+// Opens a DXF through the geometry cache; a hit maps the previous result
+// instead of parsing and flattening again. With a memo, the entities are
+// recorded for later reloads, after the load on a hit. The file is read
+// once, and those bytes are both hashed for the key and parsed: a save in
+// between cannot file new geometry under the old hash, and a truncate
+// cannot fault a mapping.
+static bool load_drawing(const std::string& path, Scene* scene, DxfEntityMemo* memo = nullptr) {
+    TRACE_SPAN("load.dxf");
+    auto start = std::chrono::steady_clock::now();
+    DxfReadSettings settings;
+
+    std::string contents;
+    if (!read_file_copy(path, contents)) {
+        std::cerr << "Cannot read " << path << std::endl;
+        return false;
+    }
+    GeometryKey key;
+    key.content_hash = ContentHash::hash64(contents.data(), contents.size());
+    key.tolerance_mm = settings.tolerance_mm;
+
+    GeometryCache cache;
+    CachedGeometry geometry;
+    bool hit = false;
+    std::string error;
+    bool ok = cache.open_or_build(key, [&](Drawing& drawing) {
+        DxfReader reader(settings);
+        reader.set_memo(nullptr, memo);
+        if (!reader.parse(contents.data(), contents.size(), drawing)) {
+            error = reader.get_error();
+            return false;
+        }
+        return true;
+    }, geometry, &hit);
+
+    if (!ok) {
+        std::cerr << "Failed to load " << path << ": " << error << std::endl;
+        return false;
+    }
+    if (hit && memo) seed_memo_async(std::move(contents), settings, memo);
+
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Loaded " << geometry.contour_count() << " contours (" << geometry.point_count() << " points) "
+              << (hit ? "from cache" : "from DXF") << " in " << ms << " ms" << std::endl;
+    scene->set_drawing(std::move(geometry));
+    MemoryAccounting::log_summary(std::cout);
+    return true;
+}
+
+// Re-reads a watched DXF after it changed on disk, on a pool thread. Only
+// entities whose content hash is new are flattened again; the result is
+// shown from memory and written to the geometry cache in the background. A
+// file that fails to parse (still being written, say) leaves the current
+// drawing up. It is read into memory, not mapped, as the writer may
+// truncate it under us.
+static bool reload_drawing(const std::string& path, std::future<void>& seeding, CachedGeometry& geometry) {
+    TRACE_SPAN("load.reload");
+    // Even on a cache hit: no later reload would wait for the seeding
+    if (seeding.valid()) seeding.get();
+    auto start = std::chrono::steady_clock::now();
+    DxfReadSettings settings;
+
+    std::string contents;
+    if (!read_file_copy(path, contents)) {
+        std::cerr << "Cannot read " << path << std::endl;
+        return false;
+    }
+    GeometryKey key;
+    key.content_hash = ContentHash::hash64(contents.data(), contents.size());
+    key.tolerance_mm = settings.tolerance_mm;
+
+    // Reverted to contents seen before: the cache already has them
+    GeometryCache cache;
+    if (cache.open(key, geometry)) {
+        std::cout << "Reloaded " << path << " from cache" << std::endl;
+        return true;
+    }
+
+    DxfEntityMemo& previous = dxf_memos[dxf_memo_current];
+    DxfEntityMemo& next = dxf_memos[dxf_memo_current ^ 1];
+    DxfReader reader(settings);
+    reader.set_memo(&previous, &next);
+    Drawing drawing;
+    if (!reader.parse(contents.data(), contents.size(), drawing)) {
+        std::cerr << "Reload of " << path << " failed, keeping the current drawing: " << reader.get_error()
+                  << std::endl;
+        return false;
+    }
+    dxf_memo_current ^= 1;
+    previous.entries.clear();
+
+    if (!cache.build_in_memory(key, drawing, geometry)) return false;
+    cache.persist_async(key, geometry);
+
+    const DxfReadStats& stats = reader.get_stats();
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Reloaded " << path << ": " << stats.entities - stats.reused << " changed, " << stats.removed
+              << " removed, " << stats.reused << " unchanged in " << ms << " ms" << std::endl;
+    return true;
+}
+
+// Starts reload_drawing on the pool; a memo seeding still running is handed
+// over, so the reload waits for it instead of the UI thread
+static void start_reload(const std::string& path) {
+    auto result = std::make_shared<std::promise<DrawingReload>>();
+    drawing_reload = result->get_future();
+    auto seeding = std::make_shared<std::future<void>>(std::move(dxf_memo_seeding));
+    FrameScheduler* scheduler = &main_window->get_frame_scheduler();
+    ThreadPool::shared().submit([path, result, seeding, scheduler] {
+        DrawingReload reload;
+        reload.ok = reload_drawing(path, *seeding, reload.geometry);
+        result->set_value(std::move(reload));
+        scheduler->request_frame();
+    });
+}
+
+// Loads a DXF and, with --watch, points the watcher at it so later saves
+// reload this drawing. The memos described the previous file and start over.
+static bool open_drawing(const std::string& path, Scene* scene) {
+    if (!watch_drawing) return load_drawing(path, scene);
+
+    // A reload of the previous file in flight is dropped
+    if (drawing_reload.valid()) drawing_reload.get();
+    reload_again = false;
+    if (dxf_memo_seeding.valid()) dxf_memo_seeding.get();
+    dxf_memos[0].entries.clear();
+    dxf_memos[1].entries.clear();
+    bool loaded = load_drawing(path, scene, &dxf_memos[dxf_memo_current]);
+
+    FrameScheduler& scheduler = main_window->get_frame_scheduler();
+    if (!drawing_watcher) drawing_watcher = new FileWatcher();
+    scheduler.unwatch(drawing_watcher->fd());
+    if (drawing_watcher->watch(path)) scheduler.watch(drawing_watcher->fd());
+    return loaded;
+}
+
+// Opens the laser and queues the --queue files, if any. Jobs are prepared while the
+// UI comes up; a laser that fails to open leaves them prepared but unsent.
+static void start_job_queue(BaseWindow& window) {
+    if (laser_name == "usb") {
+        laser_link = new UsbTransport();
+    } else {
+        laser_link = new SimulatedK40();
+    }
+    laser = new K40Comms(laser_link);
+    job_monitor = new JobMonitor(&window.get_frame_scheduler());
+    job_monitor->attach(*laser);
+    if (laser->start()) {
+        std::cout << "Laser: " << laser_link->name() << std::endl;
+    }
+
+    FrameScheduler* scheduler = &window.get_frame_scheduler();
+    job_queue = new JobQueue(laser, job_monitor, [scheduler] { scheduler->request_frame(); });
+    job_queue->set_auto_advance(auto_advance);
+    for (const auto& path : queued_files) {
+        job_queue->add(path);
+    }
+}
+
+// The laser stops first: the monitor reads the streaming job's toolpath
+static void stop_job_queue() {
+    delete laser;
+    delete job_queue;
+    delete job_monitor;
+    delete laser_link;
+}
+
+static Color job_color(JobStage stage) {
+    switch (stage) {
+        case JobStage::READY: return Color(0.3f, 0.7f, 0.3f);
+        case JobStage::STREAMING: return Color(0.9f, 0.6f, 0.2f);
+        case JobStage::DONE: return Color(0.45f, 0.45f, 0.45f);
+        case JobStage::FAILED: return Color(0.8f, 0.2f, 0.2f);
+        default: return Color(0.2f, 0.6f, 0.9f);
+    }
+}
 
 // Main loop function called by window
 int main_loop(const WindowData& data) {
     static bool initialized = false;
     static LayoutManager* layout_manager = nullptr;
-    static Layout* main_layout = nullptr;
+    static StaticLayout<2> main_layout(MAIN_LAYOUT);
     static Box* test_box1 = nullptr;
     static Box* test_box2 = nullptr;
     static Box* test_box3 = nullptr;
+    static Box* progress_track = nullptr;
+    static Box* progress_fill = nullptr;
+    // Job queue panel: one bar per job, filled as it is prepared
+    static const size_t QUEUE_ROWS = 8;
+    static Box* queue_tracks[QUEUE_ROWS] = {};
+    static Box* queue_fills[QUEUE_ROWS] = {};
+    static float queue_streamed = 0.0f;
+    // File browser rows: the rows in view, thumbnails drawn over them
+    static const size_t BROWSER_ROWS = 16;
+    static const float BROWSER_ROW_HEIGHT = 104.0f;
+    static const float BROWSER_WIDTH = 260.0f;
+    static Box* browser_rows[BROWSER_ROWS] = {};
+    static ThumbnailView* thumbnail_view = nullptr;
+    static StepImporter* step_importer = nullptr;
+    static Scene* scene = nullptr;
+    static Nester* nester = nullptr;
+    static Drawing nest_source;
+    static std::vector<NestPart> nest_parts;
+    static uint64_t nest_generation = 0;
+    static Toolpath nest_toolpath;
+    static bool importing = false;
     
     // Initialize on first call
     if (!initialized) {
@@ -24,18 +343,15 @@ int main_loop(const WindowData& data) {
         float top_bar_height = 40.0f * scale_factor;
         float resize_border_width = 8.0f; // 8px resize border
         
-        // Create layout: top row "box box" (title + close), bottom row "box" (main content)
-        main_layout = create_layout(0, 0, data.screen_width, data.screen_height);
-        main_layout->add_row("titlebar closebtn");
-        main_layout->add_row("maincontent");
-        main_layout->set_custom_row_height(0, top_bar_height);
-        main_layout->set_custom_col_width(0, 1, 70.0f); // Close button 70px wide
-        main_layout->recalculate();
+        main_layout.set_area(0, 0, data.screen_width, data.screen_height);
+        main_layout.set_custom_row_height(0, top_bar_height);
+        main_layout.set_custom_col_width(CLOSEBTN, 70.0f); // Close button 70px wide
+        main_layout.recalculate();
         
         // Get areas for each element
-        auto titlebar_area = main_layout->get_element_area(0, 0);
-        auto closebtn_area = main_layout->get_element_area(0, 1);
-        auto maincontent_area = main_layout->get_element_area(1, 0);
+        auto titlebar_area = main_layout.get_element_area(TITLEBAR);
+        auto closebtn_area = main_layout.get_element_area(CLOSEBTN);
+        auto maincontent_area = main_layout.get_element_area(MAINCONTENT);
         
         std::cout << "Title bar area: " << titlebar_area.x << "," << titlebar_area.y << " " << titlebar_area.width << "x" << titlebar_area.height << std::endl;
         std::cout << "Close button area: " << closebtn_area.x << "," << closebtn_area.y << " " << closebtn_area.width << "x" << closebtn_area.height << std::endl;
@@ -56,17 +372,101 @@ int main_loop(const WindowData& data) {
                               "Main Content Area", "center", true,
                               Color(0.2f, 0.2f, 0.2f), Color(1.0f, 1.0f, 1.0f));
         
-        layout_manager->register_layout(main_layout);
         layout_manager->register_box(test_box1);
         layout_manager->register_box(test_box2);
         layout_manager->register_box(test_box3);
         
+        // Import progress bar, centered in the main content area
+        progress_track = create_box(0, 0, 0, 0, nullptr, "", "center", false,
+                                    Color(0.15f, 0.15f, 0.15f), Color(1.0f, 1.0f, 1.0f));
+        progress_fill = create_box(0, 0, 0, 0, nullptr, "", "center", false,
+                                   Color(0.2f, 0.6f, 0.9f), Color(1.0f, 1.0f, 1.0f));
+        layout_manager->register_box(progress_track);
+        layout_manager->register_box(progress_fill);
+        
+        // Clicking the queue panel starts the next ready job
+        for (size_t i = 0; i < QUEUE_ROWS; ++i) {
+            queue_tracks[i] = create_box(0, 0, 0, 0, [](const TouchData& touch, const BoxArea&) {
+                                             if (touch.released && job_queue) job_queue->start_next();
+                                         }, "", "center", false,
+                                         Color(0.15f, 0.15f, 0.15f), Color(1.0f, 1.0f, 1.0f));
+            queue_fills[i] = create_box(0, 0, 0, 0, nullptr, "", "center", false,
+                                        Color(0.2f, 0.6f, 0.9f), Color(1.0f, 1.0f, 1.0f));
+            layout_manager->register_box(queue_tracks[i]);
+            layout_manager->register_box(queue_fills[i]);
+        }
+        
+        scene = new Scene();
+        step_importer = new StepImporter();
+        nester = new Nester();
+        DisplayConnection& connection = main_window->get_connection();
+        preview = new BurnPreview(connection.is_software() ? nullptr : &connection.get_shader_cache());
+        if (!browse_folder.empty()) {
+            FrameScheduler* scheduler = &main_window->get_frame_scheduler();
+            thumbnail_cache = new ThumbnailCache([scheduler] { scheduler->request_frame(); });
+            file_browser = new FileBrowser(*thumbnail_cache, BROWSER_ROW_HEIGHT);
+            thumbnail_view = new ThumbnailView(connection.is_software() ? nullptr : &connection.get_shader_cache());
+            for (size_t i = 0; i < BROWSER_ROWS; ++i) {
+                browser_rows[i] = create_box(0, 0, 0, 0, [i](const TouchData& touch, const BoxArea&) {
+                                                 size_t index = file_browser->get_first_visible() + i;
+                                                 if (!touch.released || index >= file_browser->size()) return;
+                                                 const std::string& path = file_browser->entry(index).key.path;
+                                                 if (job_queue) {
+                                                     job_queue->add(path);
+                                                 } else {
+                                                     open_drawing(path, scene);
+                                                 }
+                                             }, "", "center", false,
+                                             Color(0.18f, 0.18f, 0.18f), Color(1.0f, 1.0f, 1.0f));
+                layout_manager->register_box(browser_rows[i]);
+            }
+            size_t found = file_browser->open(browse_folder);
+            std::cout << "Browsing " << browse_folder << ": " << found << " DXF files" << std::endl;
+        }
+        if (has_extension(startup_file, ".dxf")) {
+            bool loaded = open_drawing(startup_file, scene);
+            if (loaded && nest_on_load) {
+                nest_source = scene->get_drawing().to_drawing();
+                nest_parts = Nesting::parts_from(nest_source, Containment::build(nest_source));
+                std::cout << "Nesting " << nest_parts.size() << " parts" << std::endl;
+                // Runs on a search thread: the scheduler is captured here,
+                // as the current-window pointer belongs to the UI thread
+                FrameScheduler* scheduler = &main_window->get_frame_scheduler();
+                nester->start(nest_source, nest_parts, NestSettings(), [scheduler] {
+                    scheduler->request_frame();
+                });
+            }
+        } else if (!startup_file.empty()) {
+            std::cout << "Loading STEP file: " << startup_file << std::endl;
+            step_importer->start(startup_file);
+        }
+        
         initialized = true;
     }
     
+    // The watcher's fd woke this frame if the DXF was rewritten; the reload
+    // requests a frame when its drawing is ready
+    if (drawing_watcher && drawing_watcher->take_change()) {
+        if (drawing_reload.valid()) {
+            reload_again = true;
+        } else {
+            start_reload(drawing_watcher->path());
+        }
+    }
+    if (drawing_reload.valid() && drawing_reload.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+        DrawingReload reload = drawing_reload.get();
+        if (reload.ok) scene->set_drawing(std::move(reload.geometry));
+        if (reload_again) {
+            reload_again = false;
+            start_reload(drawing_watcher->path());
+        }
+    }
+
     // Handle window resize
     if (data.window_resized) {
         layout_manager->handle_window_resize(data.screen_width, data.screen_height);
+        main_layout.set_area(0, 0, data.screen_width, data.screen_height);
+        main_layout.recalculate();
     }
     
     // Check for resize zones
@@ -170,23 +570,247 @@ int main_loop(const WindowData& data) {
         layout_manager->handle_touch_for_all(touch_data);
     }
     
+    // Collect finished meshes from the background import (never blocks)
+    std::vector<TriangleMesh> new_meshes;
+    if (step_importer->poll_meshes(new_meshes) > 0) {
+        for (auto& mesh : new_meshes) {
+            scene->add_mesh(std::move(mesh));
+        }
+    }
+    
+    // Update import progress bar
+    if (step_importer->is_running()) {
+        const BoxArea& content = test_box3->get_area();
+        float bar_width = content.width * 0.6f;
+        float bar_height = 20.0f;
+        BoxArea track = {content.x + (content.width - bar_width) / 2.0f,
+                         content.y + (content.height - bar_height) / 2.0f,
+                         bar_width, bar_height};
+        BoxArea fill = track;
+        fill.width = track.width * step_importer->get_progress().fraction();
+        progress_track->set_area(track);
+        progress_fill->set_area(fill);
+        
+        // Keep frames coming until the import finishes
+        BaseWindow* window = BaseWindow::get_current_instance();
+        if (window) window->get_frame_scheduler().request_frame();
+        importing = true;
+    } else {
+        progress_track->set_area({0, 0, 0, 0});
+        progress_fill->set_area({0, 0, 0, 0});
+        if (importing) {
+            importing = false;
+            MemoryAccounting::log_summary(std::cout);
+        }
+    }
+    
+    // Job queue: hand the machine to the next job, follow the streaming one
+    // on the preview, and lay out the panel from the latest states
+    if (job_queue) {
+        const Toolpath* before = job_queue->streaming_toolpath();
+        job_queue->update();
+        const Toolpath* streaming = job_queue->streaming_toolpath();
+        if (streaming && streaming != before) {
+            preview->begin(*streaming);
+            queue_streamed = 0.0f;
+        }
+        JobProgress progress;
+        if (streaming && job_monitor->poll(progress)) {
+            preview->update(progress);
+            queue_streamed = static_cast<float>(progress.fraction());
+        }
+        
+        // Preparing jobs fill up as their stages finish; the streaming one
+        // shows how much the controller has accepted
+        std::vector<JobStatus> jobs = job_queue->snapshot();
+        const BoxArea& content = test_box3->get_area();
+        float row_width = content.width * 0.3f;
+        float row_height = 12.0f;
+        for (size_t i = 0; i < QUEUE_ROWS; ++i) {
+            if (i >= jobs.size()) {
+                queue_tracks[i]->set_area({0, 0, 0, 0});
+                queue_fills[i]->set_area({0, 0, 0, 0});
+                continue;
+            }
+            BoxArea track = {content.x + 10.0f, content.y + 10.0f + i * (row_height + 4.0f), row_width, row_height};
+            BoxArea fill = track;
+            fill.width = track.width * (jobs[i].stage == JobStage::STREAMING ? queue_streamed : jobs[i].prepared);
+            queue_tracks[i]->set_area(track);
+            queue_fills[i]->set_area(fill);
+            queue_fills[i]->set_color(job_color(jobs[i].stage));
+        }
+    }
+    
+    // File browser down the right of the content area; rows in view ask
+    // for their thumbnails, the rest of the folder fills in behind them
+    if (file_browser) {
+        const BoxArea& content = test_box3->get_area();
+        BoxArea panel = {content.x + content.width - BROWSER_WIDTH, content.y + 10.0f, BROWSER_WIDTH - 10.0f,
+                         content.height - 20.0f};
+        file_browser->set_area(panel);
+        if (data.scroll_y != 0.0f && file_browser->entry_at(data.mouse_x, data.mouse_y) >= 0) {
+            file_browser->scroll_by(data.scroll_y);
+        }
+        file_browser->update();
+        for (size_t i = 0; i < BROWSER_ROWS; ++i) {
+            size_t index = file_browser->get_first_visible() + i;
+            if (i >= file_browser->get_visible_count()) {
+                browser_rows[i]->set_area({0, 0, 0, 0});
+                continue;
+            }
+            // One pixel between rows; unreadable files in red
+            BoxArea row = file_browser->row_area(index);
+            row.height = std::max(row.height - 1.0f, 0.0f);
+            browser_rows[i]->set_area(row);
+            browser_rows[i]->set_color(file_browser->entry(index).failed ? Color(0.45f, 0.15f, 0.15f)
+                                                                          : Color(0.18f, 0.18f, 0.18f));
+        }
+    }
+    
+    // Show the best nest so far; the search wakes us on every improvement
+    NestResult nest;
+    if (nester->poll_result(nest, nest_generation)) {
+        TRACE_SPAN("nest.preview");
+        nest_generation = nest.generation;
+        Drawing placed = Nesting::apply(nest_source, nest_parts, nest);
+        ContainmentTree nesting = Containment::build(placed);
+        PathOrder order = PathOrdering::nearest_neighbour(placed, 0.0, 0.0, &nesting);
+        nest_toolpath = ToolpathBuilder::build(placed, order, {});
+        if (preview->begin(nest_toolpath)) {
+            JobProgress all = {};
+            all.moves_done = static_cast<uint32_t>(nest_toolpath.size());
+            preview->update(all);
+        }
+    }
+    
     // Render everything
-    layout_manager->render_all();
+    {
+        TRACE_SPAN("render");
+        layout_manager->render_all();
+        if (preview->is_active()) {
+            preview->render(test_box3->get_area());
+        }
+        // Thumbnails of fully visible rows; textures upload on first draw
+        if (file_browser) {
+            const float inset = 4.0f;
+            for (size_t i = 0; i < file_browser->get_visible_count(); ++i) {
+                size_t index = file_browser->get_first_visible() + i;
+                const BrowserEntry& entry = file_browser->entry(index);
+                BoxArea row = file_browser->row_area(index);
+                if (!entry.thumbnail || row.height < BROWSER_ROW_HEIGHT - 0.5f) continue;
+                float side = BROWSER_ROW_HEIGHT - 2.0f * inset;
+                thumbnail_view->draw(*entry.thumbnail, {row.x + inset, row.y + inset, side, side},
+                                     Color(0.9f, 0.9f, 0.9f, 1.0f));
+            }
+            thumbnail_view->end_frame();
+        }
+    }
+    
+    if (Trace::take_dump_request()) {
+        Trace::dump(trace_path);
+        MemoryAccounting::log_summary(std::cout);
+    }
     
     // Return 0 for success, -1 for failure (which closes window)
     return data.should_exit ? -1 : 0;
 }
 
+// Job monitor window: the burn preview fitted to the whole window
+int monitor_loop(const WindowData& data) {
+    if (main_window->should_close()) {
+        BaseWindow::get_current_instance()->close();
+        return 0;
+    }
+    if (preview && preview->is_active()) {
+        preview->render({0.0f, 0.0f, data.screen_width, data.screen_height});
+    }
+    return 0;
+}
+
 // Entry point that creates window and starts the loop
 int main(int argc, char* argv[]) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--nest") {
+            nest_on_load = true;
+        } else if (arg == "--trace" && i + 1 < argc) {
+            trace_path = argv[++i];
+            trace_on_exit = true;
+            Trace::enable(true);
+        } else if (arg == "--no-watch") {
+            watch_drawing = false;
+        } else if (arg == "--queue" && i + 1 < argc) {
+            queued_files.push_back(argv[++i]);
+        } else if (arg == "--laser" && i + 1 < argc) {
+            laser_name = argv[++i];
+            laser_given = true;
+        } else if (arg == "--auto-advance") {
+            auto_advance = true;
+        } else if (arg == "--monitor") {
+            open_monitor = true;
+        } else if (arg == "--swap-interval" && i + 1 < argc) {
+            swap_interval = std::atoi(argv[++i]);
+        } else if (arg == "--defer-submit" && i + 1 < argc) {
+            defer_margin_us = std::atoi(argv[++i]);
+        } else if (arg == "--browse" && i + 1 < argc) {
+            browse_folder = argv[++i];
+        } else if (arg == "--software") {
+            software_rendering = true;
+        } else {
+            startup_file = arg;
+        }
+    }
+    
+    Trace::set_thread_name("main");
+    std::signal(SIGUSR1, on_trace_signal);
+    
     BaseWindow window(800, 600, "STEP Viewer");
+    main_window = &window;
+    window.get_connection().set_software_rendering(software_rendering);
+    window.set_swap_interval(swap_interval);
+    if (defer_margin_us >= 0) {
+        window.set_submit_deferral(true, defer_margin_us);
+    }
     
     if (!window.initialize()) {
         std::cerr << "Failed to initialize window" << std::endl;
         return -1;
     }
     
+    if (!queued_files.empty() || laser_given) {
+        start_job_queue(window);
+    }
+    
+    // Same connection and GL context, so the preview's buffer is shared.
+    // Swap interval 0 keeps it from halving the main window's frame rate.
+    BaseWindow* monitor = nullptr;
+    if (open_monitor) {
+        monitor = new BaseWindow(480, 360, "Job Monitor", &window.get_connection());
+        monitor->set_swap_interval(0);
+        if (monitor->initialize()) {
+            monitor->set_main_callback(monitor_loop);
+        } else {
+            std::cerr << "Failed to open job monitor window" << std::endl;
+            delete monitor;
+            monitor = nullptr;
+        }
+    }
+    
     // Start window with main_loop as callback
     window.run_with_callback(main_loop);
+    delete monitor;
+    delete drawing_watcher;
+    // Both call back into the window's scheduler or touch the memos
+    if (drawing_reload.valid()) drawing_reload.wait();
+    if (dxf_memo_seeding.valid()) dxf_memo_seeding.wait();
+    // Before the window: thumbnail workers call back into its scheduler
+    delete file_browser;
+    delete thumbnail_cache;
+    stop_job_queue();
+    MemoryAccounting::log_summary(std::cout);
+    
+    if (trace_on_exit) {
+        Trace::dump(trace_path);
+    }
     return 0;
 }
\ No newline at end of file
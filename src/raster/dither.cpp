@@ -0,0 +1,136 @@
+#include "dither.h"
+#include "dither_kernels.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+    constexpr int ERROR_PAD = 2;
+
+    const uint8_t BAYER_8X8[8][8] = {
+        { 0, 32,  8, 40,  2, 34, 10, 42},
+        {48, 16, 56, 24, 50, 18, 58, 26},
+        {12, 44,  4, 36, 14, 46,  6, 38},
+        {60, 28, 52, 20, 62, 30, 54, 22},
+        { 3, 35, 11, 43,  1, 33,  9, 41},
+        {51, 19, 59, 27, 49, 17, 57, 25},
+        {15, 47,  7, 39, 13, 45,  5, 37},
+        {63, 31, 55, 23, 61, 29, 53, 21}
+    };
+}
+
+DitherMode dither_mode_from_string(const std::string& name) {
+    if (name == "ordered" || name == "bayer") return DitherMode::ORDERED;
+    if (name == "floyd" || name == "floyd-steinberg") return DitherMode::FLOYD_STEINBERG;
+    if (name == "jarvis") return DitherMode::JARVIS;
+    return DitherMode::THRESHOLD;
+}
+
+Ditherer::Ditherer(DitherMode dither_mode, int row_width, uint8_t threshold_level)
+    : mode(dither_mode), width(std::max(0, row_width)), threshold(threshold_level), row_index(0) {
+
+    if (mode == DitherMode::ORDERED) {
+        // Expand the matrix to full rows so the SIMD threshold kernel can
+        // compare against it directly.
+        threshold_rows.resize(static_cast<size_t>(8) * width);
+        for (int r = 0; r < 8; ++r) {
+            for (int x = 0; x < width; ++x) {
+                threshold_rows[static_cast<size_t>(r) * width + x] =
+                    static_cast<uint8_t>(BAYER_8X8[r][x & 7] * 4 + 2);
+            }
+        }
+    } else if (mode == DitherMode::THRESHOLD) {
+        threshold_rows.assign(width, threshold);
+    } else {
+        for (auto& row : error_rows) {
+            row.assign(width + 2 * ERROR_PAD, 0);
+        }
+        work.resize(width);
+    }
+}
+
+void Ditherer::reset() {
+    row_index = 0;
+    for (auto& row : error_rows) {
+        std::fill(row.begin(), row.end(), 0);
+    }
+}
+
+void Ditherer::process_row(const uint8_t* gray, uint64_t* bits) {
+    switch (mode) {
+        case DitherMode::THRESHOLD:
+            DitherKernels::threshold_row(gray, threshold_rows.data(), width, bits);
+            break;
+        case DitherMode::ORDERED:
+            DitherKernels::threshold_row(gray, threshold_rows.data() + static_cast<size_t>(row_index & 7) * width,
+                                         width, bits);
+            break;
+        case DitherMode::FLOYD_STEINBERG:
+        case DitherMode::JARVIS:
+            DitherKernels::add_error_row(gray, error_rows[0].data() + ERROR_PAD, width, work.data());
+            diffuse_row(bits);
+            break;
+    }
+    row_index++;
+}
+
+void Ditherer::diffuse_row(uint64_t* bits) {
+    std::memset(bits, 0, words_per_row() * sizeof(uint64_t));
+
+    // Serpentine scan avoids the directional "worm" artifacts
+    const bool reverse = (row_index & 1) != 0;
+    const int s = reverse ? -1 : 1;
+    int x = reverse ? width - 1 : 0;
+
+    int16_t* next1 = error_rows[1].data() + ERROR_PAD;
+    int16_t* next2 = error_rows[2].data() + ERROR_PAD;
+    int carry1 = 0;
+    int carry2 = 0;
+
+    if (mode == DitherMode::FLOYD_STEINBERG) {
+        // The next row is still zero here, so its three taps are accumulated
+        // in registers and each slot is written exactly once.
+        int behind = 0; // next1[x - s]
+        int below = 0;  // next1[x]
+        for (int n = 0; n < width; ++n, x += s) {
+            int value = work[x] + carry1;
+            int burn = value < threshold;
+            int err = value - (burn ? 0 : 255);
+            bits[x >> 6] |= static_cast<uint64_t>(burn) << (x & 63);
+
+            carry1 = err * 7 / 16;
+            next1[x - s] = static_cast<int16_t>(behind + err * 3 / 16);
+            behind = below + err * 5 / 16;
+            below = err / 16;
+        }
+        next1[x - s] = static_cast<int16_t>(behind);
+        next1[x] = static_cast<int16_t>(below);
+    } else {
+        for (int n = 0; n < width; ++n, x += s) {
+            int value = work[x] + carry1;
+            carry1 = carry2;
+            carry2 = 0;
+
+            int burn = value < threshold;
+            int err = value - (burn ? 0 : 255);
+            bits[x >> 6] |= static_cast<uint64_t>(burn) << (x & 63);
+
+            int e1 = err / 48, e3 = err * 3 / 48, e5 = err * 5 / 48, e7 = err * 7 / 48;
+            carry1 += e7;
+            carry2 += e5;
+            next1[x - 2 * s] += static_cast<int16_t>(e3);
+            next1[x - s] += static_cast<int16_t>(e5);
+            next1[x] += static_cast<int16_t>(e7);
+            next1[x + s] += static_cast<int16_t>(e5);
+            next1[x + 2 * s] += static_cast<int16_t>(e3);
+            next2[x - 2 * s] += static_cast<int16_t>(e1);
+            next2[x - s] += static_cast<int16_t>(e3);
+            next2[x] += static_cast<int16_t>(e5);
+            next2[x + s] += static_cast<int16_t>(e3);
+            next2[x + 2 * s] += static_cast<int16_t>(e1);
+        }
+    }
+
+    std::swap(error_rows[0], error_rows[1]);
+    std::swap(error_rows[1], error_rows[2]);
+    std::fill(error_rows[2].begin(), error_rows[2].end(), 0);
+}
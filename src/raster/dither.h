@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum class DitherMode {
+    THRESHOLD,
+    ORDERED,         // 8x8 Bayer matrix
+    FLOYD_STEINBERG,
+    JARVIS           // Jarvis-Judice-Ninke
+};
+
+DitherMode dither_mode_from_string(const std::string& name);
+
+// Converts grayscale rows (0 = black = burn) to packed 1-bit rows one row
+// at a time. Error-diffusion modes keep only the error rows they need, so
+// memory is O(width) regardless of image height.
+class Ditherer {
+private:
+    DitherMode mode;
+    int width;
+    uint8_t threshold;
+    int row_index;
+
+    std::vector<uint8_t> threshold_rows; // 8 rows for ORDERED, 1 otherwise
+    std::vector<int16_t> error_rows[3];  // current, next, next+1 (padded by 2)
+    std::vector<int16_t> work;
+
+    void diffuse_row(uint64_t* bits);
+
+public:
+    Ditherer(DitherMode dither_mode, int row_width, uint8_t threshold_level = 128);
+
+    // bits must hold (width + 63) / 64 words
+    void process_row(const uint8_t* gray, uint64_t* bits);
+    void reset();
+
+    int get_width() const { return width; }
+    size_t words_per_row() const { return static_cast<size_t>((width + 63) / 64); }
+};
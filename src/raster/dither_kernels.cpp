@@ -0,0 +1,137 @@
+#include "dither_kernels.h"
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define DITHER_KERNELS_X86 1
+#endif
+
+namespace DitherKernels {
+
+    namespace {
+        typedef void (*ThresholdFn)(const uint8_t*, const uint8_t*, int, uint64_t*);
+        typedef void (*AddErrorFn)(const uint8_t*, const int16_t*, int, int16_t*);
+
+        inline void set_bits32(uint64_t* bits, int x, uint32_t mask) {
+            // x is a multiple of 32, so the mask lands in one half of a word
+            bits[x >> 6] |= static_cast<uint64_t>(mask) << (x & 63);
+        }
+
+        void threshold_tail(const uint8_t* gray, const uint8_t* thresholds, int start, int width, uint64_t* bits) {
+            for (int x = start; x < width; ++x) {
+                if (gray[x] < thresholds[x]) {
+                    bits[x >> 6] |= uint64_t(1) << (x & 63);
+                }
+            }
+        }
+
+        void threshold_row_scalar(const uint8_t* gray, const uint8_t* thresholds, int width, uint64_t* bits) {
+            std::memset(bits, 0, ((width + 63) / 64) * sizeof(uint64_t));
+            threshold_tail(gray, thresholds, 0, width, bits);
+        }
+
+        void add_error_row_scalar(const uint8_t* gray, const int16_t* error, int width, int16_t* out) {
+            for (int x = 0; x < width; ++x) {
+                int value = gray[x] + error[x];
+                out[x] = static_cast<int16_t>(value > 32767 ? 32767 : (value < -32768 ? -32768 : value));
+            }
+        }
+
+#ifdef DITHER_KERNELS_X86
+        void threshold_row_sse2(const uint8_t* gray, const uint8_t* thresholds, int width, uint64_t* bits) {
+            std::memset(bits, 0, ((width + 63) / 64) * sizeof(uint64_t));
+
+            int x = 0;
+            for (; x + 32 <= width; x += 32) {
+                __m128i g0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(gray + x));
+                __m128i t0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(thresholds + x));
+                __m128i g1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(gray + x + 16));
+                __m128i t1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(thresholds + x + 16));
+                // gray >= threshold  <=>  max(gray, threshold) == gray
+                uint32_t ge0 = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_max_epu8(g0, t0), g0)));
+                uint32_t ge1 = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_max_epu8(g1, t1), g1)));
+                set_bits32(bits, x, ~(ge0 | (ge1 << 16)));
+            }
+            threshold_tail(gray, thresholds, x, width, bits);
+        }
+
+        void add_error_row_sse2(const uint8_t* gray, const int16_t* error, int width, int16_t* out) {
+            const __m128i zero = _mm_setzero_si128();
+            int x = 0;
+            for (; x + 16 <= width; x += 16) {
+                __m128i g = _mm_loadu_si128(reinterpret_cast<const __m128i*>(gray + x));
+                __m128i e0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(error + x));
+                __m128i e1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(error + x + 8));
+                __m128i lo = _mm_adds_epi16(_mm_unpacklo_epi8(g, zero), e0);
+                __m128i hi = _mm_adds_epi16(_mm_unpackhi_epi8(g, zero), e1);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x), lo);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x + 8), hi);
+            }
+            add_error_row_scalar(gray + x, error + x, width - x, out + x);
+        }
+
+        __attribute__((target("avx2")))
+        void threshold_row_avx2(const uint8_t* gray, const uint8_t* thresholds, int width, uint64_t* bits) {
+            std::memset(bits, 0, ((width + 63) / 64) * sizeof(uint64_t));
+
+            int x = 0;
+            for (; x + 32 <= width; x += 32) {
+                __m256i g = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(gray + x));
+                __m256i t = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(thresholds + x));
+                uint32_t ge = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_max_epu8(g, t), g)));
+                set_bits32(bits, x, ~ge);
+            }
+            threshold_tail(gray, thresholds, x, width, bits);
+        }
+
+        __attribute__((target("avx2")))
+        void add_error_row_avx2(const uint8_t* gray, const int16_t* error, int width, int16_t* out) {
+            int x = 0;
+            for (; x + 16 <= width; x += 16) {
+                __m256i g = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(gray + x)));
+                __m256i e = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(error + x));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + x), _mm256_adds_epi16(g, e));
+            }
+            add_error_row_scalar(gray + x, error + x, width - x, out + x);
+        }
+#endif
+
+        struct Dispatch {
+            ThresholdFn threshold;
+            AddErrorFn add_error;
+            const char* isa;
+
+            Dispatch() : threshold(threshold_row_scalar), add_error(add_error_row_scalar), isa("scalar") {
+#ifdef DITHER_KERNELS_X86
+                __builtin_cpu_init();
+                if (__builtin_cpu_supports("avx2")) {
+                    threshold = threshold_row_avx2;
+                    add_error = add_error_row_avx2;
+                    isa = "avx2";
+                } else if (__builtin_cpu_supports("sse2")) {
+                    threshold = threshold_row_sse2;
+                    add_error = add_error_row_sse2;
+                    isa = "sse2";
+                }
+#endif
+            }
+        };
+
+        const Dispatch& dispatch() {
+            static const Dispatch instance;
+            return instance;
+        }
+    }
+
+    void threshold_row(const uint8_t* gray, const uint8_t* thresholds, int width, uint64_t* bits) {
+        dispatch().threshold(gray, thresholds, width, bits);
+    }
+
+    void add_error_row(const uint8_t* gray, const int16_t* error, int width, int16_t* out) {
+        dispatch().add_error(gray, error, width, out);
+    }
+
+    const char* active_isa() {
+        return dispatch().isa;
+    }
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstdint>
+
+// Row kernels for the raster pipeline. Each has AVX2, SSE2 and scalar
+// variants; the best one for the running CPU is picked on first use.
+// Bit rows are packed LSB-first into 64-bit words, 1 = burn.
+namespace DitherKernels {
+    // bits[x] = gray[x] < thresholds[x]
+    void threshold_row(const uint8_t* gray, const uint8_t* thresholds, int width, uint64_t* bits);
+
+    // out[x] = gray[x] + error[x], saturated to int16
+    void add_error_row(const uint8_t* gray, const int16_t* error, int width, int16_t* out);
+
+    const char* active_isa();
+}
@@ -0,0 +1,133 @@
+#include "raster_engraver.h"
+#include <algorithm>
+#include <cmath>
+
+void extract_runs(const uint64_t* bits, int width, std::vector<RasterRun>& runs) {
+    runs.clear();
+    const int words = (width + 63) / 64;
+
+    bool in_run = false;
+    uint32_t run_start = 0;
+
+    for (int w = 0; w < words; ++w) {
+        uint64_t word = bits[w];
+        uint32_t base = static_cast<uint32_t>(w) * 64;
+        uint32_t pos = 0;
+
+        // Walk the word by jumping to the next transition instead of per bit
+        while (pos < 64) {
+            uint64_t remaining = word >> pos;
+            if (!in_run) {
+                if (remaining == 0) break;
+                pos += static_cast<uint32_t>(__builtin_ctzll(remaining));
+                run_start = base + pos;
+                in_run = true;
+            } else {
+                uint64_t inverted = ~remaining;
+                if (pos > 0) inverted &= ~uint64_t(0) >> pos;
+                if (inverted == 0) break;
+                pos += static_cast<uint32_t>(__builtin_ctzll(inverted));
+                runs.push_back({run_start, base + pos});
+                in_run = false;
+            }
+        }
+    }
+
+    if (in_run) {
+        runs.push_back({run_start, static_cast<uint32_t>(width)});
+    }
+}
+
+ImageRowSource::ImageRowSource(const uint8_t* gray, int width, int height, int stride,
+                               int out_width, int out_height)
+    : pixels(gray), src_width(width), src_height(height), src_stride(stride),
+      column_map(std::max(0, out_width)), dst_height(std::max(1, out_height)) {
+    for (int x = 0; x < out_width; ++x) {
+        column_map[x] = static_cast<uint32_t>(std::min<int64_t>(
+            static_cast<int64_t>(x) * src_width / out_width, src_width - 1));
+    }
+}
+
+void ImageRowSource::operator()(int row, uint8_t* gray) const {
+    int src_row = static_cast<int>(std::min<int64_t>(static_cast<int64_t>(row) * src_height / dst_height,
+                                                     src_height - 1));
+    const uint8_t* line = pixels + static_cast<size_t>(src_row) * src_stride;
+    for (size_t x = 0; x < column_map.size(); ++x) {
+        gray[x] = line[column_map[x]];
+    }
+}
+
+RasterEngraver::RasterEngraver(const RasterSettings& raster_settings) : settings(raster_settings) {
+}
+
+void RasterEngraver::emit_row(EgvEncoder& encoder, int32_t y, const std::vector<RasterRun>& runs,
+                              const std::vector<int32_t>& x_steps, bool reverse) {
+    const int32_t overscan = settings.overscan_steps;
+    int32_t left = std::max(0, x_steps[runs.front().start] - overscan);
+    int32_t right = x_steps[runs.back().end] + overscan;
+
+    if (!reverse) {
+        encoder.move_to(left, y);
+        for (const auto& run : runs) {
+            encoder.move_to(x_steps[run.start], y);
+            encoder.cut_to(x_steps[run.end], y);
+        }
+        encoder.move_to(right, y);
+    } else {
+        encoder.move_to(right, y);
+        for (auto it = runs.rbegin(); it != runs.rend(); ++it) {
+            encoder.move_to(x_steps[it->end], y);
+            encoder.cut_to(x_steps[it->start], y);
+        }
+        encoder.move_to(left, y);
+    }
+}
+
+RasterStats RasterEngraver::engrave(const RowSource& source, int width, int height, EgvEncoder& encoder) {
+    RasterStats stats = {};
+    if (width <= 0 || height <= 0) return stats;
+
+    const double steps_per_pixel = 1000.0 / settings.dpi;
+
+    // Pixel edge -> machine step lookup, shared by every row
+    std::vector<int32_t> x_steps(width + 1);
+    for (int x = 0; x <= width; ++x) {
+        x_steps[x] = settings.origin_x + static_cast<int32_t>(std::lround(x * steps_per_pixel));
+    }
+
+    Ditherer ditherer(settings.mode, width, settings.threshold);
+    std::vector<uint8_t> gray(width);
+    std::vector<uint64_t> bits(ditherer.words_per_row());
+    std::vector<RasterRun> runs;
+    SpeedCode speed = SpeedCodes::for_speed(settings.speed_mm_s);
+    bool reverse = false;
+
+    for (int row = 0; row < height; ++row) {
+        source(row, gray.data());
+        ditherer.process_row(gray.data(), bits.data());
+        extract_runs(bits.data(), width, runs);
+        stats.rows++;
+
+        if (runs.empty()) continue;
+
+        int32_t y = settings.origin_y + static_cast<int32_t>(std::lround(row * steps_per_pixel));
+        if (!encoder.in_compact_mode()) {
+            int32_t start_x = reverse ? x_steps[runs.back().end] + settings.overscan_steps
+                                      : std::max(0, x_steps[runs.front().start] - settings.overscan_steps);
+            encoder.rapid_to(start_x, y);
+            encoder.begin_cut(speed);
+        }
+
+        emit_row(encoder, y, runs, x_steps, reverse);
+        if (settings.bidirectional) reverse = !reverse;
+
+        stats.engraved_rows++;
+        stats.runs += runs.size();
+        for (const auto& run : runs) {
+            stats.burn_pixels += run.end - run.start;
+        }
+    }
+
+    encoder.end_cut();
+    return stats;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "dither.h"
+#include "job/egv_encoder.h"
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// Half-open pixel range [start, end) to burn on one scanline
+struct RasterRun {
+    uint32_t start;
+    uint32_t end;
+};
+
+// Run-length encodes a packed bit row
+void extract_runs(const uint64_t* bits, int width, std::vector<RasterRun>& runs);
+
+// Fills one grayscale row (width bytes) of the engrave-resolution image
+typedef std::function<void(int row, uint8_t* gray)> RowSource;
+
+// Nearest-neighbour scaler from a source bitmap to the engrave resolution.
+// Rows are produced on demand so the expanded image never exists in memory.
+class ImageRowSource {
+private:
+    const uint8_t* pixels;
+    int src_width, src_height, src_stride;
+    std::vector<uint32_t> column_map;
+    int dst_height;
+
+public:
+    ImageRowSource(const uint8_t* gray, int width, int height, int stride, int out_width, int out_height);
+    void operator()(int row, uint8_t* gray) const;
+};
+
+struct RasterSettings {
+    DitherMode mode;
+    uint8_t threshold;
+    double dpi;
+    double speed_mm_s;
+    bool bidirectional;
+    int32_t overscan_steps; // extra travel at each end for the acceleration ramp
+    int32_t origin_x, origin_y;
+
+    RasterSettings() : mode(DitherMode::FLOYD_STEINBERG), threshold(128), dpi(600.0),
+                       speed_mm_s(150.0), bidirectional(true), overscan_steps(40),
+                       origin_x(0), origin_y(0) {}
+};
+
+struct RasterStats {
+    int rows;
+    int engraved_rows;
+    uint64_t runs;
+    uint64_t burn_pixels;
+};
+
+// Streams an image through dither -> RLE scanlines -> EGV encoder, one row
+// at a time. Empty rows are skipped; with bidirectional scanning every other
+// engraved row is swept right-to-left.
+class RasterEngraver {
+private:
+    RasterSettings settings;
+
+    void emit_row(EgvEncoder& encoder, int32_t y, const std::vector<RasterRun>& runs,
+                  const std::vector<int32_t>& x_steps, bool reverse);
+
+public:
+    explicit RasterEngraver(const RasterSettings& raster_settings = RasterSettings());
+
+    RasterStats engrave(const RowSource& source, int width, int height, EgvEncoder& encoder);
+};
@@ -0,0 +1,103 @@
+#include "thumbnail.h"
+#include "core/mapped_file.h"
+#include "dxf/dxf_reader.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+namespace {
+    // Keeps the stronger of the two, so crossings do not saturate
+    inline void plot(Thumbnail& out, int x, int y, float coverage) {
+        if (x < 0 || y < 0 || x >= out.width || y >= out.height || coverage <= 0.0f) return;
+        uint8_t value = static_cast<uint8_t>(std::min(coverage, 1.0f) * 255.0f + 0.5f);
+        uint8_t& pixel = out.coverage[static_cast<size_t>(y) * out.width + x];
+        pixel = std::max(pixel, value);
+    }
+
+    // Xiaolin Wu, pixel centres at integers
+    void line(Thumbnail& out, float x0, float y0, float x1, float y1) {
+        const bool steep = std::fabs(y1 - y0) > std::fabs(x1 - x0);
+        if (steep) {
+            std::swap(x0, y0);
+            std::swap(x1, y1);
+        }
+        if (x0 > x1) {
+            std::swap(x0, x1);
+            std::swap(y0, y1);
+        }
+        const float dx = x1 - x0;
+        const float gradient = dx == 0.0f ? 0.0f : (y1 - y0) / dx;
+        const int first = static_cast<int>(std::floor(x0 + 0.5f)), last = static_cast<int>(std::floor(x1 + 0.5f));
+        for (int x = first; x <= last; ++x) {
+            float y = y0 + gradient * (static_cast<float>(x) - x0);
+            int minor = static_cast<int>(std::floor(y));
+            float f = y - static_cast<float>(minor);
+            if (steep) {
+                plot(out, minor, x, 1.0f - f);
+                plot(out, minor + 1, x, f);
+            } else {
+                plot(out, x, minor, 1.0f - f);
+                plot(out, x, minor + 1, f);
+            }
+        }
+    }
+}
+
+namespace ThumbnailRaster {
+
+    void rasterize(const Drawing& drawing, int size, Thumbnail& out) {
+        out.width = out.height = std::max(size, 1);
+        out.contours = static_cast<uint32_t>(drawing.contours.size());
+        out.coverage.assign(static_cast<size_t>(out.width) * out.height, 0);
+
+        const Bounds2 bounds = drawing.bounds();
+        if (!bounds.valid()) return;
+
+        // One pixel of margin; y flipped so the top of the drawing is row 0
+        const double span = std::max({bounds.max_x - bounds.min_x, bounds.max_y - bounds.min_y, 1e-9});
+        const double fit = (out.width - 3) / span;
+        const double ox = 1.0 + ((out.width - 3) - (bounds.max_x - bounds.min_x) * fit) * 0.5;
+        const double oy = 1.0 + ((out.height - 3) - (bounds.max_y - bounds.min_y) * fit) * 0.5;
+        auto px = [&](const Vec2& p) { return static_cast<float>(ox + (p.x - bounds.min_x) * fit); };
+        auto py = [&](const Vec2& p) { return static_cast<float>(oy + (bounds.max_y - p.y) * fit); };
+
+        for (const Contour& contour : drawing.contours) {
+            const size_t n = contour.points.size();
+            if (n == 1) {
+                plot(out, static_cast<int>(px(contour.points[0]) + 0.5f), static_cast<int>(py(contour.points[0]) + 0.5f),
+                     1.0f);
+            }
+            for (size_t i = 1; i < n; ++i) {
+                line(out, px(contour.points[i - 1]), py(contour.points[i - 1]), px(contour.points[i]), py(contour.points[i]));
+            }
+            if (contour.closed && n > 2) {
+                line(out, px(contour.points[n - 1]), py(contour.points[n - 1]), px(contour.points[0]), py(contour.points[0]));
+            }
+        }
+    }
+
+    bool render_file(const std::string& path, int size, Thumbnail& out, std::string& error) {
+        DxfReadSettings settings;
+        settings.tolerance_mm = READ_TOLERANCE_MM;
+        // Read, not mapped: designers overwrite files in the open folder,
+        // and a truncate under a mapping faults with SIGBUS
+        std::string contents;
+        if (!read_file_copy(path, contents)) {
+            error = "Cannot open " + path;
+            return false;
+        }
+        DxfReader reader(settings);
+        Drawing drawing;
+        if (!reader.parse(contents.data(), contents.size(), drawing)) {
+            error = reader.get_error();
+            return false;
+        }
+        rasterize(drawing, size, out);
+        return true;
+    }
+
+    uint64_t next_id() {
+        static std::atomic<uint64_t> counter{1};
+        return counter.fetch_add(1, std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "geometry/contour.h"
+#include "core/memory_accounting.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Small preview of a drawing for the file browser: line coverage, 0 (empty)
+// to 255, with the drawing fitted in at its own aspect ratio. Row 0 is the
+// top of the drawing. Immutable once built, so caches share it freely.
+struct Thumbnail {
+    uint64_t id;          // unique within the process; keys texture caches
+    int width, height;
+    uint32_t contours;
+    TrackedVector<uint8_t, MemoryTag::UI> coverage;
+
+    Thumbnail() : id(0), width(0), height(0), contours(0) {}
+    size_t byte_size() const { return coverage.size(); }
+};
+
+namespace ThumbnailRaster {
+    constexpr int DEFAULT_SIZE = 96;
+    // Flattening this coarse is invisible at thumbnail size and leaves
+    // reading a large DXF mostly parsing
+    constexpr double READ_TOLERANCE_MM = 0.25;
+
+    // Antialiased one-pixel lines along every contour, fitted into
+    // size x size
+    void rasterize(const Drawing& drawing, int size, Thumbnail& out);
+
+    // Reads a DXF with READ_TOLERANCE_MM and rasterizes it
+    bool render_file(const std::string& path, int size, Thumbnail& out, std::string& error);
+
+    // Fresh Thumbnail::id
+    uint64_t next_id();
+}
@@ -0,0 +1,266 @@
+#include "thumbnail_cache.h"
+#include "core/content_hash.h"
+#include "core/mapped_file.h"
+#include "core/trace.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace ThumbnailCacheFormat;
+
+namespace {
+    uint64_t path_hash(const std::string& path) {
+        return ContentHash::hash64(path.data(), path.size());
+    }
+
+    bool read_entry(const std::string& file, const ThumbnailKey& key, Thumbnail& out) {
+        MappedFile mapped;
+        if (!mapped.open(file) || mapped.size() < sizeof(Header)) return false;
+        Header header;
+        std::memcpy(&header, mapped.data(), sizeof(header));
+        const size_t pixels = static_cast<size_t>(header.width) * header.height;
+        if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION ||
+            header.mtime_ns != key.mtime_ns || header.size != key.size || header.path_hash != path_hash(key.path) ||
+            mapped.size() != sizeof(Header) + pixels) {
+            return false;
+        }
+        out.width = static_cast<int>(header.width);
+        out.height = static_cast<int>(header.height);
+        out.contours = header.contours;
+        const uint8_t* data = reinterpret_cast<const uint8_t*>(mapped.data() + sizeof(Header));
+        out.coverage.assign(data, data + pixels);
+        return true;
+    }
+
+    std::atomic<uint64_t> temp_serial{0};
+
+    // Temporary name and rename, as for the geometry cache
+    bool write_entry(const std::string& directory, const std::string& file, const ThumbnailKey& key,
+                     const Thumbnail& thumbnail) {
+        Header header;
+        std::memset(static_cast<void*>(&header), 0, sizeof(header));
+        std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.version = VERSION;
+        header.width = static_cast<uint32_t>(thumbnail.width);
+        header.height = static_cast<uint32_t>(thumbnail.height);
+        header.contours = thumbnail.contours;
+        header.mtime_ns = key.mtime_ns;
+        header.size = key.size;
+        header.path_hash = path_hash(key.path);
+
+        std::error_code error;
+        std::filesystem::create_directories(directory, error);
+        if (error) return false;
+        std::string temp_path = file + ".tmp." + std::to_string(getpid()) + "." + std::to_string(++temp_serial);
+        {
+            std::ofstream out(temp_path, std::ios::binary | std::ios::trunc);
+            if (!out) return false;
+            out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            out.write(reinterpret_cast<const char*>(thumbnail.coverage.data()),
+                      static_cast<std::streamsize>(thumbnail.coverage.size()));
+            if (!out) {
+                out.close();
+                std::remove(temp_path.c_str());
+                return false;
+            }
+        }
+        if (std::rename(temp_path.c_str(), file.c_str()) != 0) {
+            std::remove(temp_path.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    std::string entry_path(const std::string& directory, const std::string& source, int size) {
+        return directory + "/" + ContentHash::to_hex(path_hash(source)) + "-" + std::to_string(size) + ".thumb";
+    }
+}
+
+ThumbnailCache::ThumbnailCache(ChangedCallback changed, int thumbnail_size, size_t memory_budget,
+                               const std::string& cache_directory, ThreadPool& worker_pool, size_t workers)
+    : pool(worker_pool), max_workers(workers ? workers : std::max<size_t>(1, worker_pool.size() / 2)),
+      state(std::make_shared<State>()) {
+    state->running = 0;
+    state->cached_bytes = 0;
+    state->closed = false;
+    state->stats = ThumbnailCacheStats();
+    state->callback = changed;
+    state->directory = cache_directory;
+    state->thumbnail_size = thumbnail_size;
+    state->memory_budget = memory_budget;
+}
+
+ThumbnailCache::~ThumbnailCache() {
+    {
+        std::lock_guard<std::mutex> lock(state->callback_mutex);
+        state->callback = nullptr;
+    }
+    std::lock_guard<std::mutex> lock(state->mutex);
+    state->closed = true;
+    state->wanted.clear();
+}
+
+std::string ThumbnailCache::default_directory() {
+    const char* xdg = std::getenv("XDG_CACHE_HOME");
+    if (xdg && *xdg) return std::string(xdg) + "/stepviewer/thumbnails";
+    const char* home = std::getenv("HOME");
+    if (home && *home) return std::string(home) + "/.cache/stepviewer/thumbnails";
+    return "/tmp/stepviewer-thumbnails";
+}
+
+bool ThumbnailCache::make_key(const std::string& path, ThumbnailKey& out) {
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0) return false;
+    out.path = path;
+    out.mtime_ns = static_cast<int64_t>(info.st_mtim.tv_sec) * 1000000000ll + info.st_mtim.tv_nsec;
+    out.size = static_cast<uint64_t>(info.st_size);
+    return true;
+}
+
+std::string ThumbnailCache::path_for(const ThumbnailKey& key) const {
+    return entry_path(state->directory, key.path, state->thumbnail_size);
+}
+
+std::shared_ptr<const Thumbnail> ThumbnailCache::request(const ThumbnailKey& key, bool urgent, bool* failed) {
+    if (failed) *failed = false;
+    bool start_worker = false;
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        auto found = state->index.find(key.path);
+        if (found != state->index.end()) {
+            auto entry = found->second;
+            if (entry->key.same_version(key)) {
+                state->lru.splice(state->lru.begin(), state->lru, entry);
+                ++state->stats.memory_hits;
+                if (failed) *failed = !entry->thumbnail;
+                return entry->thumbnail;
+            }
+            // The file changed since: make it again
+            if (entry->thumbnail) state->cached_bytes -= entry->thumbnail->byte_size();
+            state->lru.erase(entry);
+            state->index.erase(found);
+        }
+
+        if (state->queued.count(key.path)) {
+            if (!urgent) return nullptr;
+            // Already waiting: move it to the front
+            auto waiting = std::find_if(state->wanted.begin(), state->wanted.end(),
+                                        [&](const ThumbnailKey& other) { return other.path == key.path; });
+            if (waiting == state->wanted.end() || waiting == state->wanted.begin()) return nullptr;
+            ThumbnailKey moved = std::move(*waiting);
+            state->wanted.erase(waiting);
+            state->wanted.push_front(std::move(moved));
+            return nullptr;
+        }
+
+        state->queued.insert(key.path);
+        if (urgent) {
+            state->wanted.push_front(key);
+        } else {
+            state->wanted.push_back(key);
+        }
+        if (state->running < max_workers) {
+            ++state->running;
+            start_worker = true;
+        }
+    }
+    if (start_worker) {
+        std::shared_ptr<State> shared = state;
+        pool.submit([shared] { drain(shared); });
+    }
+    return nullptr;
+}
+
+void ThumbnailCache::cancel_pending() {
+    std::lock_guard<std::mutex> lock(state->mutex);
+    for (const ThumbnailKey& key : state->wanted) state->queued.erase(key.path);
+    state->wanted.clear();
+}
+
+ThumbnailCacheStats ThumbnailCache::stats() const {
+    std::lock_guard<std::mutex> lock(state->mutex);
+    ThumbnailCacheStats result = state->stats;
+    result.cached = state->lru.size();
+    result.cached_bytes = state->cached_bytes;
+    result.queued = state->wanted.size();
+    return result;
+}
+
+// One worker: takes the newest request until none are left, so a handful
+// of tasks serve any number of requests without flooding the pool
+void ThumbnailCache::drain(std::shared_ptr<State> state) {
+    while (true) {
+        ThumbnailKey key;
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            if (state->closed || state->wanted.empty()) {
+                --state->running;
+                return;
+            }
+            key = std::move(state->wanted.front());
+            state->wanted.pop_front();
+        }
+
+        auto thumbnail = std::make_shared<Thumbnail>();
+        bool from_disk = false;
+        bool ok = make(*state, key, *thumbnail, from_disk);
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            state->queued.erase(key.path);
+            if (ok) {
+                ++(from_disk ? state->stats.disk_hits : state->stats.rendered);
+            } else {
+                ++state->stats.failed;
+            }
+            if (!state->closed) insert(*state, key, ok ? std::move(thumbnail) : nullptr);
+        }
+
+        std::lock_guard<std::mutex> lock(state->callback_mutex);
+        if (state->callback) state->callback();
+    }
+}
+
+bool ThumbnailCache::make(State& state, const ThumbnailKey& key, Thumbnail& out, bool& from_disk) {
+    TRACE_SPAN("thumbnail.make");
+    const std::string file = entry_path(state.directory, key.path, state.thumbnail_size);
+    out.id = ThumbnailRaster::next_id();
+    from_disk = read_entry(file, key, out);
+    if (from_disk) return true;
+
+    std::string error;
+    if (!ThumbnailRaster::render_file(key.path, state.thumbnail_size, out, error)) {
+        std::cerr << "No thumbnail for " << key.path << ": " << error << std::endl;
+        return false;
+    }
+    if (!write_entry(state.directory, file, key, out)) {
+        std::cerr << "Could not write thumbnail cache entry " << file << std::endl;
+    }
+    return true;
+}
+
+void ThumbnailCache::insert(State& state, const ThumbnailKey& key, std::shared_ptr<const Thumbnail> thumbnail) {
+    auto found = state.index.find(key.path);
+    if (found != state.index.end()) {
+        if (found->second->thumbnail) state.cached_bytes -= found->second->thumbnail->byte_size();
+        state.lru.erase(found->second);
+        state.index.erase(found);
+    }
+    if (thumbnail) state.cached_bytes += thumbnail->byte_size();
+    state.lru.push_front(Entry{key, std::move(thumbnail)});
+    state.index[key.path] = state.lru.begin();
+
+    // Holders of an evicted thumbnail keep it; the cache only lets go
+    while (state.cached_bytes > state.memory_budget && state.lru.size() > 1) {
+        Entry& oldest = state.lru.back();
+        if (oldest.thumbnail) state.cached_bytes -= oldest.thumbnail->byte_size();
+        state.index.erase(oldest.key.path);
+        state.lru.pop_back();
+    }
+}
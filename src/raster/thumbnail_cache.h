@@ -0,0 +1,132 @@
+#pragma once
+
+#include "thumbnail.h"
+#include "core/thread_pool.h"
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+// Identifies one version of a file: a thumbnail is stale once the file's
+// modification time or size changes
+struct ThumbnailKey {
+    std::string path;
+    int64_t mtime_ns;
+    uint64_t size;
+
+    ThumbnailKey() : mtime_ns(0), size(0) {}
+    bool same_version(const ThumbnailKey& other) const { return mtime_ns == other.mtime_ns && size == other.size; }
+};
+
+// On-disk layout of one cached thumbnail: this header, then the coverage
+// bytes. One file per source path, overwritten when the source changes.
+namespace ThumbnailCacheFormat {
+    constexpr char MAGIC[8] = {'K', '4', '0', 'T', 'H', 'M', 'B', '\0'};
+    constexpr uint32_t VERSION = 1;
+
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t width;
+        uint32_t height;
+        uint32_t contours;
+        int64_t mtime_ns;
+        uint64_t size;
+        uint64_t path_hash;
+    };
+}
+
+struct ThumbnailCacheStats {
+    size_t memory_hits;
+    size_t disk_hits;
+    size_t rendered;
+    size_t failed;
+    size_t cached;        // thumbnails held in memory
+    size_t cached_bytes;
+    size_t queued;
+};
+
+// Thumbnails for the file browser. Missing ones are made on the worker pool
+// (read from the disk cache, or parsed and rasterized and then written to
+// it) and kept in memory up to a byte budget, least recently used first
+// out. Requests are served newest first, so rows that just scrolled into
+// view overtake a folder's worth of prefetching. At most max_workers pool
+// threads work on thumbnails at a time.
+//
+// request() and cancel_pending() are for the UI thread; the changed
+// callback runs on a pool thread after each thumbnail and must not block.
+class ThumbnailCache {
+public:
+    typedef std::function<void()> ChangedCallback;
+
+    static constexpr size_t DEFAULT_MEMORY_BUDGET = 16u << 20;
+
+private:
+    struct Entry {
+        ThumbnailKey key;
+        std::shared_ptr<const Thumbnail> thumbnail;   // null if the file failed to read
+    };
+
+    // Shared with the pool tasks, which may outlive the cache
+    struct State {
+        std::mutex mutex;
+        std::list<Entry> lru;   // most recently used first
+        std::unordered_map<std::string, std::list<Entry>::iterator> index;
+        std::deque<ThumbnailKey> wanted;
+        std::unordered_set<std::string> queued;   // wanted or being made
+        size_t running;
+        size_t cached_bytes;
+        bool closed;
+        ThumbnailCacheStats stats;
+
+        std::mutex callback_mutex;
+        ChangedCallback callback;
+
+        std::string directory;
+        int thumbnail_size;
+        size_t memory_budget;
+    };
+
+    ThreadPool& pool;
+    size_t max_workers;
+    std::shared_ptr<State> state;
+
+    static void drain(std::shared_ptr<State> state);
+    static bool make(State& state, const ThumbnailKey& key, Thumbnail& out, bool& from_disk);
+    // Caller holds state.mutex
+    static void insert(State& state, const ThumbnailKey& key, std::shared_ptr<const Thumbnail> thumbnail);
+
+public:
+    explicit ThumbnailCache(ChangedCallback changed = nullptr,
+                            int thumbnail_size = ThumbnailRaster::DEFAULT_SIZE,
+                            size_t memory_budget = DEFAULT_MEMORY_BUDGET,
+                            const std::string& cache_directory = default_directory(),
+                            ThreadPool& worker_pool = ThreadPool::shared(), size_t workers = 0);
+    ~ThumbnailCache();
+
+    ThumbnailCache(const ThumbnailCache&) = delete;
+    ThumbnailCache& operator=(const ThumbnailCache&) = delete;
+
+    // $XDG_CACHE_HOME/stepviewer/thumbnails, falling back to ~/.cache
+    static std::string default_directory();
+    // False if the file cannot be stat'ed
+    static bool make_key(const std::string& path, ThumbnailKey& out);
+
+    std::string path_for(const ThumbnailKey& key) const;
+
+    // The thumbnail if it is in memory, marked recently used. Otherwise
+    // queues it (an urgent request goes ahead of everything queued so far)
+    // and returns null. failed is set for files that could not be read.
+    std::shared_ptr<const Thumbnail> request(const ThumbnailKey& key, bool urgent, bool* failed = nullptr);
+
+    // Drops requests no worker has started yet
+    void cancel_pending();
+
+    ThumbnailCacheStats stats() const;
+    int thumbnail_size() const { return state->thumbnail_size; }
+};
@@ -0,0 +1,97 @@
+#include "shm_buffers.h"
+#include <iostream>
+#include <sys/mman.h>
+#include <unistd.h>
+
+static const struct wl_buffer_listener buffer_listener = {
+    ShmBuffers::buffer_release
+};
+
+ShmBuffers::ShmBuffers(struct wl_shm* shm_global, struct wl_display* wl_display, struct wl_event_queue* event_queue)
+    : shm(shm_global), display(wl_display), queue(event_queue), pool(nullptr), fd(-1), memory(nullptr), size(0),
+      width(0), height(0) {
+    for (Buffer& buffer : buffers) {
+        buffer.buffer = nullptr;
+        buffer.busy = false;
+    }
+}
+
+ShmBuffers::~ShmBuffers() {
+    release_all();
+}
+
+void ShmBuffers::release_all() {
+    // Destroying a buffer the compositor still shows is fine: it keeps
+    // its own mapping of the pool until the surface gets a new one
+    for (Buffer& buffer : buffers) {
+        if (buffer.buffer) wl_buffer_destroy(buffer.buffer);
+        buffer.buffer = nullptr;
+        buffer.busy = false;
+        buffer.target = SoftTarget();
+    }
+    if (pool) wl_shm_pool_destroy(pool);
+    if (memory) munmap(memory, size);
+    if (fd >= 0) close(fd);
+    pool = nullptr;
+    memory = nullptr;
+    fd = -1;
+    size = 0;
+    width = height = 0;
+}
+
+bool ShmBuffers::allocate(int w, int h) {
+    release_all();
+    const int stride = w * 4;
+    const size_t buffer_size = static_cast<size_t>(stride) * h;
+    size = buffer_size * BUFFER_COUNT;
+
+    fd = memfd_create("stepviewer-shm", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (fd < 0 || ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        std::cerr << "Failed to create " << size << " byte shm pool" << std::endl;
+        release_all();
+        return false;
+    }
+    memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (memory == MAP_FAILED) {
+        memory = nullptr;
+        std::cerr << "Failed to map shm pool" << std::endl;
+        release_all();
+        return false;
+    }
+
+    pool = wl_shm_create_pool(shm, fd, static_cast<int32_t>(size));
+    for (int i = 0; i < BUFFER_COUNT; ++i) {
+        Buffer& buffer = buffers[i];
+        buffer.buffer = wl_shm_pool_create_buffer(pool, static_cast<int32_t>(buffer_size * i), w, h, stride,
+                                                  WL_SHM_FORMAT_XRGB8888);
+        wl_proxy_set_queue(reinterpret_cast<struct wl_proxy*>(buffer.buffer), queue);
+        wl_buffer_add_listener(buffer.buffer, &buffer_listener, &buffer);
+        buffer.busy = false;
+        buffer.target.pixels = reinterpret_cast<uint32_t*>(static_cast<char*>(memory) + buffer_size * i);
+        buffer.target.width = w;
+        buffer.target.height = h;
+        buffer.target.stride = w;
+    }
+    width = w;
+    height = h;
+    return true;
+}
+
+ShmBuffers::Buffer* ShmBuffers::acquire(int w, int h) {
+    if (w <= 0 || h <= 0) return nullptr;
+    if (w != width || h != height) {
+        if (!allocate(w, h)) return nullptr;
+    }
+
+    wl_display_dispatch_queue_pending(display, queue);
+    while (true) {
+        for (Buffer& buffer : buffers) {
+            if (!buffer.busy) return &buffer;
+        }
+        if (wl_display_dispatch_queue(display, queue) < 0) return nullptr;
+    }
+}
+
+void ShmBuffers::buffer_release(void* data, struct wl_buffer* buffer) {
+    static_cast<Buffer*>(data)->busy = false;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "viewport/soft_canvas.h"
+#include <wayland-client.h>
+#include <cstddef>
+
+// Two XRGB8888 wl_buffers in one memfd-backed wl_shm pool, for windows drawn
+// by the software renderer. A buffer is busy from the commit that attaches
+// it until the compositor releases it; the renderer only draws into one that
+// is not. Release events go to the window's own event queue, as with EGL.
+class ShmBuffers {
+public:
+    struct Buffer {
+        struct wl_buffer* buffer;
+        bool busy;
+        SoftTarget target;
+    };
+
+    static constexpr int BUFFER_COUNT = 2;
+
+private:
+    struct wl_shm* shm;
+    struct wl_display* display;
+    struct wl_event_queue* queue;
+    struct wl_shm_pool* pool;
+    int fd;
+    void* memory;
+    size_t size;
+    int width, height;
+    Buffer buffers[BUFFER_COUNT];
+
+    bool allocate(int w, int h);
+    void release_all();
+
+public:
+    ShmBuffers(struct wl_shm* shm_global, struct wl_display* wl_display, struct wl_event_queue* event_queue);
+    ~ShmBuffers();
+
+    ShmBuffers(const ShmBuffers&) = delete;
+    ShmBuffers& operator=(const ShmBuffers&) = delete;
+
+    // A buffer of w x h the compositor is not reading, reallocating both on
+    // a size change. Waits for a release when both are busy; null on error.
+    Buffer* acquire(int w, int h);
+
+    static void buffer_release(void* data, struct wl_buffer* buffer);
+};
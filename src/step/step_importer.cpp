@@ -0,0 +1,268 @@
+#include "step_importer.h"
+#include "core/trace.h"
+#include <iostream>
+#include <unordered_map>
+
+#ifdef HAVE_OPENCASCADE
+#include <BRepMesh_IncrementalMesh.hxx>
+#include <BRep_Tool.hxx>
+#include <IFSelect_ReturnStatus.hxx>
+#include <Poly_Triangulation.hxx>
+#include <STEPControl_Reader.hxx>
+#include <TopExp_Explorer.hxx>
+#include <TopLoc_Location.hxx>
+#include <TopoDS.hxx>
+#include <TopoDS_Face.hxx>
+#include <TopoDS_Shape.hxx>
+#endif
+
+#ifdef HAVE_OPENCASCADE
+namespace {
+    // Solids, plus shells and faces that do not belong to a solid
+    std::vector<TopoDS_Shape> collect_bodies(const TopoDS_Shape& root) {
+        std::vector<TopoDS_Shape> bodies;
+        for (TopExp_Explorer it(root, TopAbs_SOLID); it.More(); it.Next()) {
+            bodies.push_back(it.Current());
+        }
+        for (TopExp_Explorer it(root, TopAbs_SHELL, TopAbs_SOLID); it.More(); it.Next()) {
+            bodies.push_back(it.Current());
+        }
+        for (TopExp_Explorer it(root, TopAbs_FACE, TopAbs_SHELL); it.More(); it.Next()) {
+            bodies.push_back(it.Current());
+        }
+        return bodies;
+    }
+
+    void extract_triangles(const TopoDS_Shape& body, TriangleMesh& mesh) {
+        for (TopExp_Explorer it(body, TopAbs_FACE); it.More(); it.Next()) {
+            const TopoDS_Face& face = TopoDS::Face(it.Current());
+            TopLoc_Location location;
+            Handle(Poly_Triangulation) triangulation = BRep_Tool::Triangulation(face, location);
+            if (triangulation.IsNull()) continue;
+
+            const gp_Trsf transform = location.Transformation();
+            const uint32_t base = static_cast<uint32_t>(mesh.vertex_count());
+            const bool reversed = face.Orientation() == TopAbs_REVERSED;
+
+            for (int i = 1; i <= triangulation->NbNodes(); ++i) {
+                gp_Pnt p = triangulation->Node(i).Transformed(transform);
+                float x = static_cast<float>(p.X());
+                float y = static_cast<float>(p.Y());
+                float z = static_cast<float>(p.Z());
+                mesh.positions.push_back(x);
+                mesh.positions.push_back(y);
+                mesh.positions.push_back(z);
+                mesh.bounds.expand(x, y, z);
+            }
+
+            for (int i = 1; i <= triangulation->NbTriangles(); ++i) {
+                int a, b, c;
+                triangulation->Triangle(i).Get(a, b, c);
+                if (reversed) std::swap(b, c);
+                mesh.indices.push_back(base + static_cast<uint32_t>(a - 1));
+                mesh.indices.push_back(base + static_cast<uint32_t>(b - 1));
+                mesh.indices.push_back(base + static_cast<uint32_t>(c - 1));
+            }
+        }
+    }
+}
+#endif
+
+float StepImporter::Progress::fraction() const {
+    switch (stage) {
+        case Stage::READING: return 0.05f;
+        case Stage::TRANSFERRING: return 0.2f;
+        case Stage::TESSELLATING:
+            return bodies_total > 0 ? 0.3f + 0.7f * static_cast<float>(bodies_done) / bodies_total : 0.3f;
+        case Stage::DONE: return 1.0f;
+        default: return 0.0f;
+    }
+}
+
+StepImporter::StepImporter(ThreadPool& worker_pool)
+    : pool(worker_pool), stage(Stage::IDLE), bodies_total(0), bodies_done(0),
+      cancel_requested(false) {
+}
+
+StepImporter::~StepImporter() {
+    cancel();
+    if (loader.joinable()) {
+        loader.join();
+    }
+}
+
+bool StepImporter::is_available() {
+#ifdef HAVE_OPENCASCADE
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool StepImporter::start(const std::string& path, const StepImportSettings& import_settings) {
+    if (is_running()) return false;
+    if (loader.joinable()) loader.join();
+
+    if (!is_available()) {
+        std::cerr << "STEP import unavailable: built without OpenCASCADE" << std::endl;
+        stage = Stage::FAILED;
+        return false;
+    }
+
+    settings = import_settings;
+    cancel_requested = false;
+    bodies_total = 0;
+    bodies_done = 0;
+    start_time = std::chrono::steady_clock::now();
+    {
+        std::lock_guard<std::mutex> lock(results_mutex);
+        finished.clear();
+        error_message.clear();
+    }
+
+    stage = Stage::READING;
+    loader = std::thread(&StepImporter::load, this, path);
+    return true;
+}
+
+void StepImporter::cancel() {
+    // The loader notices between bodies; OpenCASCADE's file parse itself
+    // cannot be interrupted, so this never waits for the thread.
+    cancel_requested = true;
+}
+
+bool StepImporter::is_running() const {
+    Stage current = stage.load();
+    return current == Stage::READING || current == Stage::TRANSFERRING || current == Stage::TESSELLATING;
+}
+
+size_t StepImporter::poll_meshes(std::vector<TriangleMesh>& out) {
+    std::unique_lock<std::mutex> lock(results_mutex, std::try_to_lock);
+    if (!lock.owns_lock() || finished.empty()) return 0;
+
+    size_t count = finished.size();
+    for (auto& mesh : finished) {
+        out.push_back(std::move(mesh));
+    }
+    finished.clear();
+    return count;
+}
+
+StepImporter::Progress StepImporter::get_progress() const {
+    Progress progress;
+    progress.stage = stage.load();
+    progress.bodies_total = bodies_total.load();
+    progress.bodies_done = bodies_done.load();
+    progress.elapsed_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+    return progress;
+}
+
+std::string StepImporter::get_error() {
+    std::lock_guard<std::mutex> lock(results_mutex);
+    return error_message;
+}
+
+void StepImporter::publish(TriangleMesh&& mesh) {
+    std::lock_guard<std::mutex> lock(results_mutex);
+    finished.push_back(std::move(mesh));
+}
+
+void StepImporter::fail(const std::string& message) {
+    std::cerr << "STEP import failed: " << message << std::endl;
+    {
+        std::lock_guard<std::mutex> lock(results_mutex);
+        error_message = message;
+    }
+    stage = Stage::FAILED;
+}
+
+void StepImporter::load(const std::string& path) {
+    Trace::set_thread_name("step-loader");
+#ifdef HAVE_OPENCASCADE
+    STEPControl_Reader reader;
+    bool read_ok;
+    {
+        TRACE_SPAN("step.read");
+        read_ok = reader.ReadFile(path.c_str()) == IFSelect_RetDone;
+    }
+    if (!read_ok) {
+        fail("cannot read " + path);
+        return;
+    }
+    if (cancel_requested) { stage = Stage::CANCELLED; return; }
+
+    stage = Stage::TRANSFERRING;
+    {
+        TRACE_SPAN("step.transfer");
+        reader.TransferRoots();
+    }
+    TopoDS_Shape root = reader.OneShape();
+    if (root.IsNull()) {
+        fail("no shapes in " + path);
+        return;
+    }
+
+    std::vector<TopoDS_Shape> bodies = collect_bodies(root);
+    bodies_total = static_cast<int>(bodies.size());
+
+    // Assembly instances share one TShape; meshing it concurrently from
+    // two workers would race, so each unique TShape is one task that meshes
+    // once and then extracts every instance placed from it.
+    std::unordered_map<const void*, size_t> unique_index;
+    std::vector<std::vector<size_t>> instances;
+    for (size_t i = 0; i < bodies.size(); ++i) {
+        const void* key = bodies[i].TShape().get();
+        auto inserted = unique_index.emplace(key, instances.size());
+        if (inserted.second) instances.emplace_back();
+        instances[inserted.first->second].push_back(i);
+    }
+
+    stage = Stage::TESSELLATING;
+    std::cout << "STEP: " << bodies.size() << " bodies (" << instances.size() << " unique), tessellating on "
+              << pool.size() << " workers" << std::endl;
+
+    pool.parallel_for(instances.size(), [&](size_t u) {
+        if (cancel_requested) return;
+        TRACE_SPAN("step.tessellate");
+
+        const TopoDS_Shape& first = bodies[instances[u].front()];
+        BRepMesh_IncrementalMesh mesher(first, settings.linear_deflection_mm, false,
+                                        settings.angular_deflection_rad, false);
+
+        for (size_t body : instances[u]) {
+            if (cancel_requested) return;
+
+            TriangleMesh mesh;
+            mesh.body = static_cast<int>(body);
+            mesh.name = "Body " + std::to_string(body + 1);
+            extract_triangles(bodies[body], mesh);
+
+            publish(std::move(mesh));
+            bodies_done++;
+        }
+    });
+
+    if (cancel_requested) {
+        stage = Stage::CANCELLED;
+        return;
+    }
+
+    stage = Stage::DONE;
+    std::cout << "STEP import finished in " << get_progress().elapsed_s << "s" << std::endl;
+#else
+    fail("cannot read " + path + ": built without OpenCASCADE");
+#endif
+}
+
+const char* StepImporter::stage_name(Stage stage) {
+    switch (stage) {
+        case Stage::IDLE: return "idle";
+        case Stage::READING: return "reading";
+        case Stage::TRANSFERRING: return "transferring";
+        case Stage::TESSELLATING: return "tessellating";
+        case Stage::DONE: return "done";
+        case Stage::FAILED: return "failed";
+        case Stage::CANCELLED: return "cancelled";
+    }
+    return "unknown";
+}
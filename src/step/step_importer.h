@@ -0,0 +1,81 @@
+#pragma once
+
+#include "geometry/mesh.h"
+#include "core/thread_pool.h"
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct StepImportSettings {
+    double linear_deflection_mm;
+    double angular_deflection_rad;
+
+    StepImportSettings() : linear_deflection_mm(0.1), angular_deflection_rad(0.5) {}
+};
+
+// Loads a STEP file entirely off the UI thread. A loader thread parses the
+// file with OpenCASCADE and splits it into bodies; bodies are tessellated on
+// the worker pool and finished meshes are queued for the UI to collect with
+// poll_meshes(), which never blocks.
+class StepImporter {
+public:
+    enum class Stage {
+        IDLE,
+        READING,
+        TRANSFERRING,
+        TESSELLATING,
+        DONE,
+        FAILED,
+        CANCELLED
+    };
+
+    struct Progress {
+        Stage stage;
+        int bodies_total;
+        int bodies_done;
+        double elapsed_s;
+
+        // 0..1 over the whole import; reading is weighted as the first 30%
+        float fraction() const;
+    };
+
+private:
+    ThreadPool& pool;
+    StepImportSettings settings;
+    std::thread loader;
+
+    std::atomic<Stage> stage;
+    std::atomic<int> bodies_total;
+    std::atomic<int> bodies_done;
+    std::atomic<bool> cancel_requested;
+    std::chrono::steady_clock::time_point start_time;
+
+    std::mutex results_mutex;
+    std::vector<TriangleMesh> finished;
+    std::string error_message;
+
+    void load(const std::string& path);
+    void publish(TriangleMesh&& mesh);
+    void fail(const std::string& message);
+
+public:
+    explicit StepImporter(ThreadPool& worker_pool = ThreadPool::shared());
+    ~StepImporter();
+
+    // Returns false if an import is still running or STEP support is not built in
+    bool start(const std::string& path, const StepImportSettings& import_settings = StepImportSettings());
+    void cancel();
+
+    // Moves meshes finished since the last call into out; never blocks the caller
+    size_t poll_meshes(std::vector<TriangleMesh>& out);
+
+    Progress get_progress() const;
+    bool is_running() const;
+    std::string get_error();
+
+    static bool is_available();
+    static const char* stage_name(Stage stage);
+};
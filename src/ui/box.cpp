@@ -1,5 +1,6 @@
 #include "box.h"
-#include <GLES2/gl2.h>
+#include "viewport/gl_state.h"
+#include "viewport/soft_canvas.h"
 #include <iostream>
 
 int Box::next_id = 0;
@@ -26,13 +27,23 @@ void Box::handle_touch(const TouchData& touch_data) {
 }
 
 void Box::render() {
-    glScissor((int)area.x, (int)area.y, (int)area.width, (int)area.height);
-    glEnable(GL_SCISSOR_TEST);
-    
-    glClearColor(bg_color.r, bg_color.g, bg_color.b, bg_color.a);
-    glClear(GL_COLOR_BUFFER_BIT);
+    if (SoftCanvas* canvas = SoftCanvas::current()) {
+        // Same pixels as the scissored clear below: the area is in GL window
+        // coordinates (origin bottom left), and a clear replaces rather than
+        // blends, which on an opaque surface means alpha is ignored
+        int x = (int)area.x, y = (int)area.y, w = (int)area.width, h = (int)area.height;
+        canvas->fill_rect(x, canvas->get_height() - y - h, w, h,
+                          SoftCanvas::pixel(bg_color.r, bg_color.g, bg_color.b, 1.0f));
+        return;
+    }
+
+    // Scissoring stays on across boxes; LayoutManager::render_all turns it
+    // off once after the last one
+    GlState::scissor((int)area.x, (int)area.y, (int)area.width, (int)area.height);
+    GlState::enable(GL_SCISSOR_TEST, true);
     
-    glDisable(GL_SCISSOR_TEST);
+    GlState::clear_color(bg_color.r, bg_color.g, bg_color.b, bg_color.a);
+    GlState::clear(GL_COLOR_BUFFER_BIT);
 }
 
 Box* create_box(float x, float y, float width, float height, 
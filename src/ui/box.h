@@ -1,6 +1,7 @@
 #pragma once
 
 #include "touch_handler.h"
+#include "core/memory_accounting.h"
 #include <string>
 #include <functional>
 
@@ -45,6 +46,9 @@ public:
     const BoxArea& get_area() const { return area; }
     int get_id() const { return id; }
     void set_area(const BoxArea& new_area) { area = new_area; }
+    void set_color(const Color& bg) { bg_color = bg; }
+    
+    MEMORY_TAGGED_NEW(MemoryTag::UI)
 };
 
 Box* create_box(float x, float y, float width, float height, 
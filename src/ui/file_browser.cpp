@@ -0,0 +1,100 @@
+#include "file_browser.h"
+#include "core/trace.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <filesystem>
+#include <iostream>
+
+namespace {
+    bool is_dxf(const std::filesystem::path& path) {
+        std::string extension = path.extension().string();
+        for (auto& c : extension) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        return extension == ".dxf";
+    }
+}
+
+FileBrowser::FileBrowser(ThumbnailCache& thumbnail_cache, float row_pixels)
+    : cache(thumbnail_cache), area{0, 0, 0, 0}, row_height(std::max(row_pixels, 1.0f)), scroll(0.0f),
+      first_visible(0), visible_count(0) {
+}
+
+size_t FileBrowser::open(const std::string& folder_path) {
+    TRACE_SPAN("browser.open");
+    for (auto& entry : entries) entry.thumbnail.reset();
+    entries.clear();
+    cache.cancel_pending();
+    folder = folder_path;
+    scroll = 0.0f;
+
+    std::error_code error;
+    for (const auto& item : std::filesystem::directory_iterator(folder_path, error)) {
+        if (!item.is_regular_file(error) || !is_dxf(item.path())) continue;
+        BrowserEntry entry;
+        if (!ThumbnailCache::make_key(item.path().string(), entry.key)) continue;
+        entry.name = item.path().filename().string();
+        entries.push_back(std::move(entry));
+    }
+    if (error) {
+        std::cerr << "Cannot list " << folder_path << ": " << error.message() << std::endl;
+    }
+    std::sort(entries.begin(), entries.end(),
+              [](const BrowserEntry& a, const BrowserEntry& b) { return a.name < b.name; });
+
+    // The whole folder behind whatever is on screen, so scrolling later
+    // mostly finds thumbnails ready
+    for (const auto& entry : entries) cache.request(entry.key, false);
+    update();
+    return entries.size();
+}
+
+void FileBrowser::set_area(const BoxArea& browser_area) {
+    area = browser_area;
+    clamp_scroll();
+}
+
+void FileBrowser::scroll_by(float pixels) {
+    scroll += pixels;
+    clamp_scroll();
+}
+
+void FileBrowser::clamp_scroll() {
+    float limit = std::max(0.0f, entries.size() * row_height - area.height);
+    scroll = std::clamp(scroll, 0.0f, limit);
+}
+
+void FileBrowser::update() {
+    size_t first = 0, count = 0;
+    if (!entries.empty() && area.height > 0) {
+        first = std::min(static_cast<size_t>(scroll / row_height), entries.size() - 1);
+        size_t last = static_cast<size_t>(std::ceil((scroll + area.height) / row_height));
+        count = std::min(last, entries.size()) - first;
+    }
+
+    // Rows that scrolled away give their thumbnails back to the cache
+    for (size_t i = first_visible; i < first_visible + visible_count && i < entries.size(); ++i) {
+        if (i < first || i >= first + count) entries[i].thumbnail.reset();
+    }
+    first_visible = first;
+    visible_count = count;
+
+    // Last row first: each urgent request goes to the front of the queue,
+    // so the top row ends up first in line
+    for (size_t i = first + count; i-- > first;) {
+        BrowserEntry& entry = entries[i];
+        if (entry.thumbnail) continue;
+        entry.thumbnail = cache.request(entry.key, true, &entry.failed);
+    }
+}
+
+BoxArea FileBrowser::row_area(size_t index) const {
+    float top = std::max(area.y + index * row_height - scroll, area.y);
+    float bottom = std::min(area.y + (index + 1) * row_height - scroll, area.y + area.height);
+    return BoxArea{area.x, top, area.width, std::max(bottom - top, 0.0f)};
+}
+
+int FileBrowser::entry_at(float x, float y) const {
+    if (x < area.x || x > area.x + area.width || y < area.y || y > area.y + area.height) return -1;
+    size_t index = static_cast<size_t>((y - area.y + scroll) / row_height);
+    return index < entries.size() ? static_cast<int>(index) : -1;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "box.h"
+#include "raster/thumbnail_cache.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+struct BrowserEntry {
+    std::string name;
+    ThumbnailKey key;
+    // Held only while the row is in view; the cache keeps the rest
+    std::shared_ptr<const Thumbnail> thumbnail;
+    bool failed;
+
+    BrowserEntry() : failed(false) {}
+};
+
+// Scrolling list of the DXFs in one folder, one row per file with its
+// thumbnail. Opening a folder only lists and stats it, so the rows show at
+// once; thumbnails arrive from the ThumbnailCache as they are made. Rows
+// in view are asked for first every frame, the whole folder is queued
+// behind them when it is opened. UI thread only.
+class FileBrowser {
+private:
+    ThumbnailCache& cache;
+    std::string folder;
+    std::vector<BrowserEntry> entries;
+    BoxArea area;
+    float row_height;
+    float scroll;
+    size_t first_visible;
+    size_t visible_count;
+
+    void clamp_scroll();
+
+public:
+    FileBrowser(ThumbnailCache& thumbnail_cache, float row_pixels);
+
+    // Lists the folder's .dxf files by name; the number found
+    size_t open(const std::string& folder_path);
+    const std::string& get_folder() const { return folder; }
+
+    void set_area(const BoxArea& browser_area);
+    // Positive scrolls towards the end of the list
+    void scroll_by(float pixels);
+
+    // Once per frame: fetches thumbnails for the rows in view and drops
+    // those of rows that left it
+    void update();
+
+    size_t size() const { return entries.size(); }
+    const BrowserEntry& entry(size_t index) const { return entries[index]; }
+    size_t get_first_visible() const { return first_visible; }
+    size_t get_visible_count() const { return visible_count; }
+    // Row's area, cut to the browser's; less than a full row for rows
+    // partly scrolled out
+    BoxArea row_area(size_t index) const;
+    float get_row_height() const { return row_height; }
+    // Entry under a window point, or -1
+    int entry_at(float x, float y) const;
+};
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "core/memory_accounting.h"
 #include <vector>
 #include <string>
 #include <memory>
@@ -14,6 +15,7 @@ struct LayoutElement {
     void* element_ptr; // Points to Box* or Layout*
 };
 
+// Rows defined at runtime; screens fixed at compile time use StaticLayout
 class Layout {
 private:
     LayoutArea area;
@@ -46,6 +48,8 @@ public:
                                  float parent_width, float parent_height,
                                  float ratio_x, float ratio_y, 
                                  float ratio_width, float ratio_height);
+    
+    MEMORY_TAGGED_NEW(MemoryTag::UI)
 };
 
 Layout* create_layout(float x = 0, float y = 0, float width = 1.0f, float height = 1.0f);
\ No newline at end of file
@@ -1,4 +1,6 @@
 #include "layout_manager.h"
+#include "viewport/gl_state.h"
+#include "viewport/soft_canvas.h"
 
 LayoutManager::LayoutManager(float win_width, float win_height) 
     : window_width(win_width), window_height(win_height) {
@@ -53,6 +55,7 @@ void LayoutManager::render_all() {
     for (auto* box : boxes) {
         box->render();
     }
+    if (!SoftCanvas::current()) GlState::enable(GL_SCISSOR_TEST, false);
 }
 
 void LayoutManager::handle_touch_for_all(const TouchData& touch_data) {
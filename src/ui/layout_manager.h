@@ -24,4 +24,6 @@ public:
     void handle_touch_for_all(const TouchData& touch_data);
     
     void clear_all();
+    
+    MEMORY_TAGGED_NEW(MemoryTag::UI)
 };
\ No newline at end of file
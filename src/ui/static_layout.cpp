@@ -0,0 +1,43 @@
+#include "static_layout.h"
+
+namespace LayoutMath {
+    void place_cells(const LayoutArea& area, size_t rows, const uint8_t* cols, const float* row_heights,
+                     const float* col_widths, LayoutArea* cells) {
+        float total_custom_height = 0.0f;
+        int auto_rows = 0;
+        for (size_t r = 0; r < rows; ++r) {
+            if (row_heights[r] > 0) {
+                total_custom_height += row_heights[r];
+            } else {
+                auto_rows++;
+            }
+        }
+        float auto_row_height = auto_rows > 0 ? (area.height - total_custom_height) / static_cast<float>(auto_rows) : 0.0f;
+
+        float current_y = area.y;
+        for (size_t r = 0; r < rows; ++r) {
+            const float* widths = col_widths + r * LAYOUT_MAX_COLS;
+            LayoutArea* row_cells = cells + r * LAYOUT_MAX_COLS;
+            float row_height = row_heights[r] > 0 ? row_heights[r] : auto_row_height;
+
+            float total_custom_width = 0.0f;
+            int auto_cols = 0;
+            for (size_t c = 0; c < cols[r]; ++c) {
+                if (widths[c] > 0) {
+                    total_custom_width += widths[c];
+                } else {
+                    auto_cols++;
+                }
+            }
+            float auto_col_width = auto_cols > 0 ? (area.width - total_custom_width) / static_cast<float>(auto_cols) : 0.0f;
+
+            float current_x = area.x;
+            for (size_t c = 0; c < cols[r]; ++c) {
+                float col_width = widths[c] > 0 ? widths[c] : auto_col_width;
+                row_cells[c] = {current_x, area.height - current_y - row_height, col_width, row_height};
+                current_x += col_width;
+            }
+            current_y += row_height;
+        }
+    }
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include "layout.h"
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// Layouts known at compile time. The row strings are the same ones
+// Layout::add_row takes ("titlebar closebtn"), but they are split by
+// constexpr code into a fixed table, and elements are addressed by a
+// LayoutCell resolved from their name at compile time. StaticLayout then
+// does the row/column math on plain arrays: building or recalculating it
+// parses nothing, compares no strings and allocates nothing.
+//
+//     constexpr auto SCREEN = parse_layout({"titlebar closebtn", "maincontent"});
+//     constexpr LayoutCell CLOSE = SCREEN.cell("closebtn");
+//     static StaticLayout<2> layout(SCREEN);
+
+constexpr size_t LAYOUT_MAX_COLS = 16;
+
+struct LayoutCell {
+    uint8_t row, col;
+};
+
+template <size_t Rows>
+struct LayoutTable {
+    uint8_t cols[Rows];
+    std::string_view names[Rows][LAYOUT_MAX_COLS];
+
+    // The nth cell (row by row) with this name. An unknown name fails to
+    // compile when called in a constant expression.
+    constexpr LayoutCell cell(std::string_view name, size_t nth = 0) const {
+        for (size_t r = 0; r < Rows; ++r) {
+            for (size_t c = 0; c < cols[r]; ++c) {
+                if (names[r][c] == name && nth-- == 0) {
+                    return LayoutCell{static_cast<uint8_t>(r), static_cast<uint8_t>(c)};
+                }
+            }
+        }
+        throw "no layout element with this name";
+    }
+};
+
+// Splits each row on spaces, as Layout::add_row does
+template <size_t Rows>
+constexpr LayoutTable<Rows> parse_layout(const std::string_view (&rows)[Rows]) {
+    static_assert(Rows > 0 && Rows <= 255, "a layout needs 1 to 255 rows");
+    LayoutTable<Rows> table{};
+    for (size_t r = 0; r < Rows; ++r) {
+        const std::string_view row = rows[r];
+        size_t start = 0;
+        while (start < row.size()) {
+            if (row[start] == ' ' || row[start] == '\t') {
+                ++start;
+                continue;
+            }
+            size_t end = start;
+            while (end < row.size() && row[end] != ' ' && row[end] != '\t') ++end;
+            if (table.cols[r] == LAYOUT_MAX_COLS) throw "layout row has more than LAYOUT_MAX_COLS elements";
+            table.names[r][table.cols[r]++] = row.substr(start, end - start);
+            start = end;
+        }
+    }
+    return table;
+}
+
+namespace LayoutMath {
+    // Places rows top to bottom and columns left to right, the same way
+    // Layout::recalculate does: sizes <= 0 share what the fixed ones leave.
+    // col_widths and cells hold LAYOUT_MAX_COLS entries per row.
+    void place_cells(const LayoutArea& area, size_t rows, const uint8_t* cols, const float* row_heights,
+                     const float* col_widths, LayoutArea* cells);
+}
+
+template <size_t Rows>
+class StaticLayout {
+private:
+    LayoutArea area;
+    uint8_t cols[Rows];
+    float row_heights[Rows];
+    float col_widths[Rows][LAYOUT_MAX_COLS];
+    LayoutArea cells[Rows][LAYOUT_MAX_COLS];
+
+public:
+    constexpr explicit StaticLayout(const LayoutTable<Rows>& table, LayoutArea layout_area = {0, 0, 1.0f, 1.0f})
+        : area(layout_area), cols{}, row_heights{}, col_widths{}, cells{} {
+        for (size_t r = 0; r < Rows; ++r) {
+            cols[r] = table.cols[r];
+            row_heights[r] = -1.0f;
+            for (size_t c = 0; c < LAYOUT_MAX_COLS; ++c) col_widths[r][c] = -1.0f;
+        }
+    }
+
+    void set_area(float x, float y, float width, float height) { area = {x, y, width, height}; }
+    void set_custom_row_height(size_t row, float height) {
+        if (row < Rows) row_heights[row] = height;
+    }
+    void set_custom_col_width(LayoutCell cell, float width) {
+        if (cell.row < Rows && cell.col < cols[cell.row]) col_widths[cell.row][cell.col] = width;
+    }
+
+    void recalculate() { LayoutMath::place_cells(area, Rows, cols, row_heights, &col_widths[0][0], &cells[0][0]); }
+    LayoutArea get_element_area(LayoutCell cell) const {
+        if (cell.row < Rows && cell.col < cols[cell.row]) return cells[cell.row][cell.col];
+        return {0, 0, 0, 0};
+    }
+
+    const LayoutArea& get_area() const { return area; }
+};
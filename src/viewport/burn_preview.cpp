@@ -0,0 +1,198 @@
+#include "burn_preview.h"
+#include "gl_state.h"
+#include "soft_canvas.h"
+#include <algorithm>
+#include <iostream>
+
+namespace {
+    const char* VERTEX_SHADER =
+        "attribute vec2 position;\n"
+        "attribute float burn;\n"
+        "uniform vec2 scale;\n"
+        "uniform vec2 offset;\n"
+        "uniform float point_size;\n"
+        "varying float v_burn;\n"
+        "void main() {\n"
+        "    v_burn = burn;\n"
+        "    gl_PointSize = point_size;\n"
+        "    gl_Position = vec4(position * scale + offset, 0.0, 1.0);\n"
+        "}\n";
+
+    const char* FRAGMENT_SHADER =
+        "precision mediump float;\n"
+        "varying float v_burn;\n"
+        "void main() {\n"
+        "    // Cuts in orange, travel faint, the head (burn > 1) in white\n"
+        "    vec4 travel = vec4(0.5, 0.5, 0.5, 0.25);\n"
+        "    vec4 cut = vec4(1.0, 0.55, 0.1, 1.0);\n"
+        "    gl_FragColor = v_burn > 1.5 ? vec4(1.0) : mix(travel, cut, v_burn);\n"
+        "}\n";
+}
+
+BurnPreview::BurnPreview(ShaderCache* shader_cache)
+    : shaders(shader_cache), program(0), buffer(0), attr_position(-1), attr_burn(-1), uniform_scale(-1),
+      uniform_offset(-1), uniform_point_size(-1), toolpath(nullptr), uploaded_moves(0),
+      head_x(0), head_y(0), min_x(0), min_y(0), max_x(0), max_y(0) {
+}
+
+BurnPreview::~BurnPreview() {
+    if (buffer) glDeleteBuffers(1, &buffer);
+}
+
+bool BurnPreview::init_program() {
+    if (program) return true;
+
+    program = shaders->program("burn_preview", VERTEX_SHADER, FRAGMENT_SHADER);
+    if (!program) return false;
+
+    attr_position = glGetAttribLocation(program, "position");
+    attr_burn = glGetAttribLocation(program, "burn");
+    uniform_scale = glGetUniformLocation(program, "scale");
+    uniform_offset = glGetUniformLocation(program, "offset");
+    uniform_point_size = glGetUniformLocation(program, "point_size");
+    return true;
+}
+
+bool BurnPreview::begin(const Toolpath& job) {
+    reset();
+    if (shaders && !init_program()) return false;
+
+    toolpath = &job;
+    min_x = min_y = max_x = max_y = 0;
+    for (size_t i = 0; i < job.size(); ++i) {
+        min_x = std::min(min_x, job.x[i]);
+        max_x = std::max(max_x, job.x[i]);
+        min_y = std::min(min_y, job.y[i]);
+        max_y = std::max(max_y, job.y[i]);
+    }
+    if (!shaders) return true;
+
+    // Storage for every move up front; updates only ever fill it in
+    if (!buffer) glGenBuffers(1, &buffer);
+    GlState::bind_array_buffer(buffer);
+    glBufferData(GL_ARRAY_BUFFER,
+                 static_cast<GLsizeiptr>(std::max<size_t>(job.size(), 1) * 2 * FLOATS_PER_VERTEX * sizeof(float)),
+                 nullptr, GL_DYNAMIC_DRAW);
+    GlState::count_calls(1);
+    return true;
+}
+
+void BurnPreview::reset() {
+    toolpath = nullptr;
+    uploaded_moves = 0;
+    head_x = head_y = 0;
+}
+
+void BurnPreview::update(const JobProgress& progress) {
+    if (!toolpath) return;
+    head_x = progress.head_x;
+    head_y = progress.head_y;
+
+    size_t target = std::min<size_t>(progress.moves_done, toolpath->size());
+    if (target <= uploaded_moves) return;
+    if (!shaders) {
+        // Nothing to upload: render_soft reads the toolpath itself
+        uploaded_moves = target;
+        return;
+    }
+
+    const size_t count = target - uploaded_moves;
+    staging.resize(count * 2 * FLOATS_PER_VERTEX);
+    float* out = staging.data();
+    for (size_t i = uploaded_moves; i < target; ++i) {
+        float burn = toolpath->laser_on[i] ? 1.0f : 0.0f;
+        *out++ = static_cast<float>(i ? toolpath->x[i - 1] : 0);
+        *out++ = static_cast<float>(i ? toolpath->y[i - 1] : 0);
+        *out++ = burn;
+        *out++ = static_cast<float>(toolpath->x[i]);
+        *out++ = static_cast<float>(toolpath->y[i]);
+        *out++ = burn;
+    }
+
+    const GLintptr offset = static_cast<GLintptr>(uploaded_moves * 2 * FLOATS_PER_VERTEX * sizeof(float));
+    GlState::bind_array_buffer(buffer);
+    glBufferSubData(GL_ARRAY_BUFFER, offset, static_cast<GLsizeiptr>(staging.size() * sizeof(float)),
+                    staging.data());
+    GlState::count_calls(1);
+    uploaded_moves = target;
+}
+
+void BurnPreview::render(const BoxArea& area) const {
+    if (!shaders) {
+        render_soft(area);
+        return;
+    }
+    if (!toolpath || !program || area.width <= 0 || area.height <= 0) return;
+
+    // Fit the job extent into the area, keeping the aspect ratio; machine
+    // y grows downwards
+    float span_x = static_cast<float>(std::max(max_x - min_x, 1));
+    float span_y = static_cast<float>(std::max(max_y - min_y, 1));
+    float fit = std::min(area.width / span_x, area.height / span_y) * 0.95f;
+    float sx = 2.0f * fit / area.width;
+    float sy = -2.0f * fit / area.height;
+    float ox = -(min_x + max_x) * 0.5f * sx;
+    float oy = -(min_y + max_y) * 0.5f * sy;
+
+    // The window viewport comes from the shadow instead of a glGet stall
+    GLint previous_viewport[4];
+    bool restore_viewport = GlState::get_viewport(previous_viewport);
+    GlState::viewport(static_cast<GLint>(area.x), static_cast<GLint>(area.y),
+                      static_cast<GLsizei>(area.width), static_cast<GLsizei>(area.height));
+
+    // Program and buffer stay bound for the next frame; only the tracker
+    // needs to know
+    GlState::use_program(program);
+    glUniform2f(uniform_scale, sx, sy);
+    glUniform2f(uniform_offset, ox, oy);
+    glUniform1f(uniform_point_size, 8.0f);
+    GlState::count_calls(3);
+
+    if (uploaded_moves > 0) {
+        const GLsizei stride = static_cast<GLsizei>(FLOATS_PER_VERTEX * sizeof(float));
+        GlState::bind_array_buffer(buffer);
+        glEnableVertexAttribArray(attr_position);
+        glEnableVertexAttribArray(attr_burn);
+        glVertexAttribPointer(attr_position, 2, GL_FLOAT, GL_FALSE, stride, nullptr);
+        glVertexAttribPointer(attr_burn, 1, GL_FLOAT, GL_FALSE, stride,
+                              reinterpret_cast<const void*>(2 * sizeof(float)));
+        GlState::draw_arrays(GL_LINES, 0, static_cast<GLsizei>(uploaded_moves * 2));
+        glDisableVertexAttribArray(attr_position);
+        glDisableVertexAttribArray(attr_burn);
+        GlState::count_calls(6);
+    }
+
+    // Head marker from constant attributes, no buffer needed
+    glVertexAttrib2f(attr_position, static_cast<float>(head_x), static_cast<float>(head_y));
+    glVertexAttrib1f(attr_burn, 2.0f);
+    GlState::count_calls(2);
+    GlState::draw_arrays(GL_POINTS, 0, 1);
+
+    if (restore_viewport) {
+        GlState::viewport(previous_viewport[0], previous_viewport[1], previous_viewport[2], previous_viewport[3]);
+    }
+}
+
+// The GL path's fit, worked through to window pixels: area is in GL window
+// coordinates (origin bottom left), the canvas has its origin top left
+void BurnPreview::render_soft(const BoxArea& area) const {
+    SoftCanvas* canvas = SoftCanvas::current();
+    if (!canvas || !toolpath || area.width <= 0 || area.height <= 0) return;
+
+    float span_x = static_cast<float>(std::max(max_x - min_x, 1));
+    float span_y = static_cast<float>(std::max(max_y - min_y, 1));
+    float fit = std::min(area.width / span_x, area.height / span_y) * 0.95f;
+    float ox = area.x + area.width * 0.5f - (min_x + max_x) * 0.5f * fit;
+    float oy = canvas->get_height() - (area.y + area.height * 0.5f) - (min_y + max_y) * 0.5f * fit;
+
+    const uint32_t travel = SoftCanvas::pixel(0.5f, 0.5f, 0.5f, 0.25f);
+    const uint32_t cut = SoftCanvas::pixel(1.0f, 0.55f, 0.1f, 1.0f);
+    float px = ox, py = oy;
+    for (size_t i = 0; i < uploaded_moves; ++i) {
+        float x = toolpath->x[i] * fit + ox, y = toolpath->y[i] * fit + oy;
+        canvas->line(px, py, x, y, toolpath->laser_on[i] ? cut : travel);
+        px = x;
+        py = y;
+    }
+    canvas->dot(head_x * fit + ox, head_y * fit + oy, 8.0f, SoftCanvas::pixel(1.0f, 1.0f, 1.0f, 1.0f));
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "job/job_monitor.h"
+#include "job/toolpath.h"
+#include "ui/box.h"
+#include "shader_cache.h"
+#include <GLES2/gl2.h>
+#include <cstdint>
+#include <vector>
+
+// Live view of a running job: moves already sent are drawn from a vertex
+// buffer sized for the whole toolpath when the job starts and filled in as
+// progress arrives. Each update uploads only the newly completed range with
+// glBufferSubData, so cost per frame follows the progress made, not the job
+// size. UI thread only (needs the GL context). Without a shader cache it
+// draws into the current SoftCanvas instead, straight from the toolpath.
+class BurnPreview {
+private:
+    ShaderCache* shaders;
+    GLuint program;
+    GLuint buffer;
+    GLint attr_position;
+    GLint attr_burn;
+    GLint uniform_scale;
+    GLint uniform_offset;
+    GLint uniform_point_size;
+
+    const Toolpath* toolpath;
+    size_t uploaded_moves;
+    int32_t head_x, head_y;
+    int32_t min_x, min_y, max_x, max_y;
+    TrackedVector<float, MemoryTag::GPU_STAGING> staging;
+
+    bool init_program();
+    void render_soft(const BoxArea& area) const;
+
+public:
+    // Two vertices per move: x, y (steps) and burn (1 = laser on)
+    static constexpr size_t FLOATS_PER_VERTEX = 3;
+
+    // Null shader_cache = software rendering
+    explicit BurnPreview(ShaderCache* shader_cache);
+    ~BurnPreview();
+
+    BurnPreview(const BurnPreview&) = delete;
+    BurnPreview& operator=(const BurnPreview&) = delete;
+
+    // Allocates the buffer for the whole job; nothing is uploaded yet
+    bool begin(const Toolpath& job);
+    void reset();
+
+    // Uploads moves completed since the last update
+    void update(const JobProgress& progress);
+
+    // Draws the burned path and head marker fitted into area (window pixels)
+    void render(const BoxArea& area) const;
+
+    bool is_active() const { return toolpath != nullptr; }
+    size_t get_uploaded_moves() const { return uploaded_moves; }
+};
@@ -0,0 +1,283 @@
+#include "viewport/gl_api.h"
+// wayland-egl.h first: it makes EGLNativeWindowType a wl_egl_window pointer
+#include <wayland-egl.h>
+#include <EGL/egl.h>
+#include <GLES2/gl2.h>
+#include <dlfcn.h>
+#include <iostream>
+
+namespace {
+    enum LibraryId { LIB_EGL, LIB_GLES, LIB_WAYLAND_EGL, LIBRARY_COUNT };
+
+    struct Library {
+        const char* soname;
+        void* handle;
+    };
+
+    Library libraries[LIBRARY_COUNT] = {
+        {"libEGL.so.1", nullptr},
+        {"libGLESv2.so.2", nullptr},
+        {"libwayland-egl.so.1", nullptr},
+    };
+
+    // Every entry point the app calls, with the library it comes from
+#define GL_API_FUNCTIONS(X) \
+    X(LIB_EGL, eglChooseConfig) \
+    X(LIB_EGL, eglCreateContext) \
+    X(LIB_EGL, eglCreateWindowSurface) \
+    X(LIB_EGL, eglDestroyContext) \
+    X(LIB_EGL, eglDestroySurface) \
+    X(LIB_EGL, eglGetDisplay) \
+    X(LIB_EGL, eglGetProcAddress) \
+    X(LIB_EGL, eglInitialize) \
+    X(LIB_EGL, eglMakeCurrent) \
+    X(LIB_EGL, eglSwapBuffers) \
+    X(LIB_EGL, eglSwapInterval) \
+    X(LIB_EGL, eglTerminate) \
+    X(LIB_GLES, glActiveTexture) \
+    X(LIB_GLES, glAttachShader) \
+    X(LIB_GLES, glBindBuffer) \
+    X(LIB_GLES, glBindTexture) \
+    X(LIB_GLES, glBlendFunc) \
+    X(LIB_GLES, glBufferData) \
+    X(LIB_GLES, glBufferSubData) \
+    X(LIB_GLES, glClear) \
+    X(LIB_GLES, glClearColor) \
+    X(LIB_GLES, glCompileShader) \
+    X(LIB_GLES, glCreateProgram) \
+    X(LIB_GLES, glCreateShader) \
+    X(LIB_GLES, glDeleteBuffers) \
+    X(LIB_GLES, glDeleteProgram) \
+    X(LIB_GLES, glDeleteShader) \
+    X(LIB_GLES, glDeleteTextures) \
+    X(LIB_GLES, glDisable) \
+    X(LIB_GLES, glDisableVertexAttribArray) \
+    X(LIB_GLES, glDrawArrays) \
+    X(LIB_GLES, glEnable) \
+    X(LIB_GLES, glEnableVertexAttribArray) \
+    X(LIB_GLES, glGenBuffers) \
+    X(LIB_GLES, glGenTextures) \
+    X(LIB_GLES, glGetAttribLocation) \
+    X(LIB_GLES, glGetIntegerv) \
+    X(LIB_GLES, glGetProgramiv) \
+    X(LIB_GLES, glGetShaderInfoLog) \
+    X(LIB_GLES, glGetShaderiv) \
+    X(LIB_GLES, glGetString) \
+    X(LIB_GLES, glGetUniformLocation) \
+    X(LIB_GLES, glLinkProgram) \
+    X(LIB_GLES, glPixelStorei) \
+    X(LIB_GLES, glScissor) \
+    X(LIB_GLES, glShaderSource) \
+    X(LIB_GLES, glTexImage2D) \
+    X(LIB_GLES, glTexParameteri) \
+    X(LIB_GLES, glUniform1f) \
+    X(LIB_GLES, glUniform1i) \
+    X(LIB_GLES, glUniform2f) \
+    X(LIB_GLES, glUniform4f) \
+    X(LIB_GLES, glUseProgram) \
+    X(LIB_GLES, glVertexAttrib1f) \
+    X(LIB_GLES, glVertexAttrib2f) \
+    X(LIB_GLES, glVertexAttribPointer) \
+    X(LIB_GLES, glViewport) \
+    X(LIB_WAYLAND_EGL, wl_egl_window_create) \
+    X(LIB_WAYLAND_EGL, wl_egl_window_destroy) \
+    X(LIB_WAYLAND_EGL, wl_egl_window_resize)
+
+    struct Functions {
+#define GL_API_MEMBER(library, name) decltype(&::name) name;
+        GL_API_FUNCTIONS(GL_API_MEMBER)
+#undef GL_API_MEMBER
+    };
+
+    Functions functions;
+    bool loaded = false;
+
+    template <typename Fn>
+    bool resolve(LibraryId library, const char* name, Fn& out) {
+        out = reinterpret_cast<Fn>(dlsym(libraries[library].handle, name));
+        if (!out) {
+            std::cerr << libraries[library].soname << " has no " << name << std::endl;
+            return false;
+        }
+        return true;
+    }
+}
+
+bool GlApi::load() {
+    if (loaded) return true;
+
+    // The handles stay open for the life of the process
+    for (Library& library : libraries) {
+        if (!library.handle) library.handle = dlopen(library.soname, RTLD_NOW | RTLD_LOCAL);
+        if (!library.handle) {
+            std::cerr << "Cannot load " << library.soname << ": " << dlerror() << std::endl;
+            return false;
+        }
+    }
+
+    bool ok = true;
+#define GL_API_RESOLVE(library, name) ok = resolve(library, #name, functions.name) && ok;
+    GL_API_FUNCTIONS(GL_API_RESOLVE)
+#undef GL_API_RESOLVE
+    loaded = ok;
+    return ok;
+}
+
+bool GlApi::is_loaded() {
+    return loaded;
+}
+
+// The same signatures the headers declare, so callers need no changes
+extern "C" {
+
+EGLBoolean eglChooseConfig(EGLDisplay dpy, const EGLint* attrib_list, EGLConfig* configs, EGLint config_size,
+                           EGLint* num_config) {
+    return functions.eglChooseConfig(dpy, attrib_list, configs, config_size, num_config);
+}
+
+EGLContext eglCreateContext(EGLDisplay dpy, EGLConfig config, EGLContext share_context, const EGLint* attrib_list) {
+    return functions.eglCreateContext(dpy, config, share_context, attrib_list);
+}
+
+EGLSurface eglCreateWindowSurface(EGLDisplay dpy, EGLConfig config, EGLNativeWindowType win,
+                                  const EGLint* attrib_list) {
+    return functions.eglCreateWindowSurface(dpy, config, win, attrib_list);
+}
+
+EGLBoolean eglDestroyContext(EGLDisplay dpy, EGLContext ctx) {
+    return functions.eglDestroyContext(dpy, ctx);
+}
+
+EGLBoolean eglDestroySurface(EGLDisplay dpy, EGLSurface surface) {
+    return functions.eglDestroySurface(dpy, surface);
+}
+
+EGLDisplay eglGetDisplay(EGLNativeDisplayType display_id) {
+    return functions.eglGetDisplay(display_id);
+}
+
+__eglMustCastToProperFunctionPointerType eglGetProcAddress(const char* procname) {
+    return functions.eglGetProcAddress(procname);
+}
+
+EGLBoolean eglInitialize(EGLDisplay dpy, EGLint* major, EGLint* minor) {
+    return functions.eglInitialize(dpy, major, minor);
+}
+
+EGLBoolean eglMakeCurrent(EGLDisplay dpy, EGLSurface draw, EGLSurface read, EGLContext ctx) {
+    return functions.eglMakeCurrent(dpy, draw, read, ctx);
+}
+
+EGLBoolean eglSwapBuffers(EGLDisplay dpy, EGLSurface surface) {
+    return functions.eglSwapBuffers(dpy, surface);
+}
+
+EGLBoolean eglSwapInterval(EGLDisplay dpy, EGLint interval) {
+    return functions.eglSwapInterval(dpy, interval);
+}
+
+EGLBoolean eglTerminate(EGLDisplay dpy) {
+    return functions.eglTerminate(dpy);
+}
+
+void glActiveTexture(GLenum texture) { functions.glActiveTexture(texture); }
+void glAttachShader(GLuint program, GLuint shader) { functions.glAttachShader(program, shader); }
+void glBindBuffer(GLenum target, GLuint buffer) { functions.glBindBuffer(target, buffer); }
+void glBindTexture(GLenum target, GLuint texture) { functions.glBindTexture(target, texture); }
+void glBlendFunc(GLenum sfactor, GLenum dfactor) { functions.glBlendFunc(sfactor, dfactor); }
+
+void glBufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage) {
+    functions.glBufferData(target, size, data, usage);
+}
+
+void glBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data) {
+    functions.glBufferSubData(target, offset, size, data);
+}
+
+void glClear(GLbitfield mask) { functions.glClear(mask); }
+
+void glClearColor(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha) {
+    functions.glClearColor(red, green, blue, alpha);
+}
+
+void glCompileShader(GLuint shader) { functions.glCompileShader(shader); }
+GLuint glCreateProgram(void) { return functions.glCreateProgram(); }
+GLuint glCreateShader(GLenum type) { return functions.glCreateShader(type); }
+void glDeleteBuffers(GLsizei n, const GLuint* buffers) { functions.glDeleteBuffers(n, buffers); }
+void glDeleteProgram(GLuint program) { functions.glDeleteProgram(program); }
+void glDeleteShader(GLuint shader) { functions.glDeleteShader(shader); }
+void glDeleteTextures(GLsizei n, const GLuint* textures) { functions.glDeleteTextures(n, textures); }
+void glDisable(GLenum cap) { functions.glDisable(cap); }
+void glDisableVertexAttribArray(GLuint index) { functions.glDisableVertexAttribArray(index); }
+void glDrawArrays(GLenum mode, GLint first, GLsizei count) { functions.glDrawArrays(mode, first, count); }
+void glEnable(GLenum cap) { functions.glEnable(cap); }
+void glEnableVertexAttribArray(GLuint index) { functions.glEnableVertexAttribArray(index); }
+void glGenBuffers(GLsizei n, GLuint* buffers) { functions.glGenBuffers(n, buffers); }
+void glGenTextures(GLsizei n, GLuint* textures) { functions.glGenTextures(n, textures); }
+
+GLint glGetAttribLocation(GLuint program, const GLchar* name) {
+    return functions.glGetAttribLocation(program, name);
+}
+
+void glGetIntegerv(GLenum pname, GLint* data) { functions.glGetIntegerv(pname, data); }
+
+void glGetProgramiv(GLuint program, GLenum pname, GLint* params) {
+    functions.glGetProgramiv(program, pname, params);
+}
+
+void glGetShaderInfoLog(GLuint shader, GLsizei bufSize, GLsizei* length, GLchar* infoLog) {
+    functions.glGetShaderInfoLog(shader, bufSize, length, infoLog);
+}
+
+void glGetShaderiv(GLuint shader, GLenum pname, GLint* params) { functions.glGetShaderiv(shader, pname, params); }
+const GLubyte* glGetString(GLenum name) { return functions.glGetString(name); }
+
+GLint glGetUniformLocation(GLuint program, const GLchar* name) {
+    return functions.glGetUniformLocation(program, name);
+}
+
+void glLinkProgram(GLuint program) { functions.glLinkProgram(program); }
+void glPixelStorei(GLenum pname, GLint param) { functions.glPixelStorei(pname, param); }
+
+void glScissor(GLint x, GLint y, GLsizei width, GLsizei height) { functions.glScissor(x, y, width, height); }
+
+void glShaderSource(GLuint shader, GLsizei count, const GLchar* const* string, const GLint* length) {
+    functions.glShaderSource(shader, count, string, length);
+}
+
+void glTexImage2D(GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLint border,
+                  GLenum format, GLenum type, const void* pixels) {
+    functions.glTexImage2D(target, level, internalformat, width, height, border, format, type, pixels);
+}
+
+void glTexParameteri(GLenum target, GLenum pname, GLint param) { functions.glTexParameteri(target, pname, param); }
+void glUniform1f(GLint location, GLfloat v0) { functions.glUniform1f(location, v0); }
+void glUniform1i(GLint location, GLint v0) { functions.glUniform1i(location, v0); }
+void glUniform2f(GLint location, GLfloat v0, GLfloat v1) { functions.glUniform2f(location, v0, v1); }
+
+void glUniform4f(GLint location, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3) {
+    functions.glUniform4f(location, v0, v1, v2, v3);
+}
+
+void glUseProgram(GLuint program) { functions.glUseProgram(program); }
+void glVertexAttrib1f(GLuint index, GLfloat x) { functions.glVertexAttrib1f(index, x); }
+void glVertexAttrib2f(GLuint index, GLfloat x, GLfloat y) { functions.glVertexAttrib2f(index, x, y); }
+
+void glVertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride,
+                           const void* pointer) {
+    functions.glVertexAttribPointer(index, size, type, normalized, stride, pointer);
+}
+
+void glViewport(GLint x, GLint y, GLsizei width, GLsizei height) { functions.glViewport(x, y, width, height); }
+
+struct wl_egl_window* wl_egl_window_create(struct wl_surface* surface, int width, int height) {
+    return functions.wl_egl_window_create(surface, width, height);
+}
+
+void wl_egl_window_destroy(struct wl_egl_window* egl_window) { functions.wl_egl_window_destroy(egl_window); }
+
+void wl_egl_window_resize(struct wl_egl_window* egl_window, int width, int height, int dx, int dy) {
+    functions.wl_egl_window_resize(egl_window, width, height, dx, dy);
+}
+
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+// EGL, GLES 2 and wayland-egl are opened with dlopen instead of linked, so
+// the binary still starts on a machine without them and the connection can
+// fall back to software rendering. gl_api.cpp defines the entry points the
+// app calls (eglGetDisplay, glClear, wl_egl_window_create, ...) as forwards
+// into the loaded libraries; none of them may run before load() succeeds.
+namespace GlApi {
+    // Opens the three libraries and resolves every entry point. Reports
+    // what is missing on std::cerr and returns false; once it has
+    // succeeded, later calls return true straight away.
+    bool load();
+    bool is_loaded();
+}
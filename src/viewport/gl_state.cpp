@@ -0,0 +1,175 @@
+#include "gl_state.h"
+#include <cstdio>
+
+namespace {
+    // Tracked capabilities, by slot
+    enum Capability { SCISSOR, BLEND, CAPABILITY_COUNT };
+
+    // -1 = unknown, so the first set after invalidate() always goes through
+    struct Shadow {
+        int enabled[CAPABILITY_COUNT];
+        GLenum blend_source, blend_destination;
+        float clear[4];
+        GLint scissor[4];
+        GLint viewport[4];
+        GLuint program;
+        GLuint array_buffer;
+        bool known_blend, known_clear, known_scissor, known_viewport, known_program, known_array_buffer;
+    };
+
+    uint64_t frames = 0;
+    uint64_t total_calls = 0, total_skipped = 0, total_draws = 0;
+
+    int slot_for(GLenum capability) {
+        switch (capability) {
+            case GL_SCISSOR_TEST: return SCISSOR;
+            case GL_BLEND: return BLEND;
+        }
+        return -1;
+    }
+
+    Shadow unknown_shadow() {
+        Shadow unknown = {};
+        for (int& state : unknown.enabled) state = -1;
+        return unknown;
+    }
+
+    Shadow shadow = unknown_shadow();
+
+    bool same4(const GLint* a, GLint x, GLint y, GLint z, GLint w) {
+        return a[0] == x && a[1] == y && a[2] == z && a[3] == w;
+    }
+}
+
+namespace GlState {
+    namespace detail {
+        GlFrameStats frame = {};
+    }
+    using detail::frame;
+
+    void enable(GLenum capability, bool on) {
+        int slot = slot_for(capability);
+        if (slot >= 0) {
+            if (shadow.enabled[slot] == (on ? 1 : 0)) {
+                frame.skipped++;
+                return;
+            }
+            shadow.enabled[slot] = on ? 1 : 0;
+        }
+        if (on) {
+            glEnable(capability);
+        } else {
+            glDisable(capability);
+        }
+        frame.calls++;
+    }
+
+    void blend_func(GLenum source, GLenum destination) {
+        if (shadow.known_blend && shadow.blend_source == source && shadow.blend_destination == destination) {
+            frame.skipped++;
+            return;
+        }
+        shadow.known_blend = true;
+        shadow.blend_source = source;
+        shadow.blend_destination = destination;
+        glBlendFunc(source, destination);
+        frame.calls++;
+    }
+
+    void clear_color(float r, float g, float b, float a) {
+        float* c = shadow.clear;
+        if (shadow.known_clear && c[0] == r && c[1] == g && c[2] == b && c[3] == a) {
+            frame.skipped++;
+            return;
+        }
+        shadow.known_clear = true;
+        c[0] = r; c[1] = g; c[2] = b; c[3] = a;
+        glClearColor(r, g, b, a);
+        frame.calls++;
+    }
+
+    void scissor(GLint x, GLint y, GLsizei width, GLsizei height) {
+        if (shadow.known_scissor && same4(shadow.scissor, x, y, width, height)) {
+            frame.skipped++;
+            return;
+        }
+        shadow.known_scissor = true;
+        shadow.scissor[0] = x; shadow.scissor[1] = y; shadow.scissor[2] = width; shadow.scissor[3] = height;
+        glScissor(x, y, width, height);
+        frame.calls++;
+    }
+
+    void viewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+        if (shadow.known_viewport && same4(shadow.viewport, x, y, width, height)) {
+            frame.skipped++;
+            return;
+        }
+        shadow.known_viewport = true;
+        shadow.viewport[0] = x; shadow.viewport[1] = y; shadow.viewport[2] = width; shadow.viewport[3] = height;
+        glViewport(x, y, width, height);
+        frame.calls++;
+    }
+
+    bool get_viewport(GLint out[4]) {
+        if (!shadow.known_viewport) return false;
+        for (int i = 0; i < 4; i++) out[i] = shadow.viewport[i];
+        return true;
+    }
+
+    void use_program(GLuint program) {
+        if (shadow.known_program && shadow.program == program) {
+            frame.skipped++;
+            return;
+        }
+        shadow.known_program = true;
+        shadow.program = program;
+        glUseProgram(program);
+        frame.calls++;
+    }
+
+    void bind_array_buffer(GLuint buffer) {
+        if (shadow.known_array_buffer && shadow.array_buffer == buffer) {
+            frame.skipped++;
+            return;
+        }
+        shadow.known_array_buffer = true;
+        shadow.array_buffer = buffer;
+        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+        frame.calls++;
+    }
+
+    void clear(GLbitfield mask) {
+        glClear(mask);
+        frame.calls++;
+        frame.draws++;
+    }
+
+    void draw_arrays(GLenum mode, GLint first, GLsizei count) {
+        glDrawArrays(mode, first, count);
+        frame.calls++;
+        frame.draws++;
+    }
+
+    void invalidate() {
+        shadow = unknown_shadow();
+    }
+
+    GlFrameStats end_frame() {
+        GlFrameStats finished = frame;
+        total_calls += finished.calls;
+        total_skipped += finished.skipped;
+        total_draws += finished.draws;
+        frames++;
+        frame = GlFrameStats();
+        return finished;
+    }
+
+    void log_summary(std::ostream& out) {
+        if (frames == 0) return;
+        char line[160];
+        std::snprintf(line, sizeof(line), "GL per frame: %.1f calls, %.1f redundant skipped, %.1f draws over %llu frames",
+                      total_calls / double(frames), total_skipped / double(frames), total_draws / double(frames),
+                      static_cast<unsigned long long>(frames));
+        out << line << std::endl;
+    }
+}
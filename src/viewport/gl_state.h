@@ -0,0 +1,44 @@
+#pragma once
+
+#include <GLES2/gl2.h>
+#include <cstdint>
+#include <ostream>
+
+struct GlFrameStats {
+    uint32_t calls;     // GL calls issued (state, draws, uploads)
+    uint32_t skipped;   // state changes dropped as redundant
+    uint32_t draws;     // glClear / glDrawArrays / glDrawElements
+};
+
+// Shadow of the GL state the UI changes every frame. All windows render with
+// one context, so one shadow covers the process; setters only reach GL when
+// the value actually changes. Code that changes tracked state behind its back
+// must call invalidate(). UI thread only.
+namespace GlState {
+    void enable(GLenum capability, bool on);   // GL_SCISSOR_TEST, GL_BLEND
+    void blend_func(GLenum source, GLenum destination);
+    void clear_color(float r, float g, float b, float a);
+    void scissor(GLint x, GLint y, GLsizei width, GLsizei height);
+    void viewport(GLint x, GLint y, GLsizei width, GLsizei height);
+    // Shadowed viewport without a glGet round trip; false if unknown
+    bool get_viewport(GLint out[4]);
+    void use_program(GLuint program);
+    void bind_array_buffer(GLuint buffer);
+
+    void clear(GLbitfield mask);
+    void draw_arrays(GLenum mode, GLint first, GLsizei count);
+
+    // Forgets the shadow; the next setter of each kind always reaches GL
+    void invalidate();
+
+    // Counters of the frame just finished, then starts a new frame
+    GlFrameStats end_frame();
+    // Per-frame averages since startup
+    void log_summary(std::ostream& out);
+
+    namespace detail {
+        extern GlFrameStats frame;
+    }
+    // For untracked calls (uniforms, attributes, uploads) so totals stay honest
+    inline void count_calls(uint32_t n) { detail::frame.calls += n; }
+}
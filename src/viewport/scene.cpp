@@ -0,0 +1,24 @@
+#include "scene.h"
+
+Scene::Scene() : triangles(0), revision(0) {
+}
+
+void Scene::add_mesh(TriangleMesh&& mesh) {
+    bounds.expand(mesh.bounds);
+    triangles += mesh.triangle_count();
+    meshes.push_back(std::move(mesh));
+    revision++;
+}
+
+void Scene::set_drawing(CachedGeometry&& geometry) {
+    drawing = std::move(geometry);
+    revision++;
+}
+
+void Scene::clear() {
+    meshes.clear();
+    drawing = CachedGeometry();
+    bounds = Bounds3();
+    triangles = 0;
+    revision++;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "geometry/geometry_cache.h"
+#include "geometry/mesh.h"
+#include <cstdint>
+#include <vector>
+
+// Geometry shown in the main content area. Owned by the UI thread; loaders
+// hand finished meshes over and the revision tells the renderer what changed.
+class Scene {
+private:
+    std::vector<TriangleMesh> meshes;
+    CachedGeometry drawing;
+    Bounds3 bounds;
+    size_t triangles;
+    uint64_t revision;
+
+public:
+    Scene();
+
+    void add_mesh(TriangleMesh&& mesh);
+    void clear();
+
+    // 2D drawing shown flat on the bed; the renderer reads its vertex
+    // arrays in place
+    void set_drawing(CachedGeometry&& geometry);
+
+    const std::vector<TriangleMesh>& get_meshes() const { return meshes; }
+    const CachedGeometry& get_drawing() const { return drawing; }
+    const Bounds3& get_bounds() const { return bounds; }
+    size_t triangle_count() const { return triangles; }
+    uint64_t get_revision() const { return revision; }
+};
@@ -0,0 +1,203 @@
+#include "shader_cache.h"
+#include "core/content_hash.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+    // File layout: header, then the driver's opaque program binary
+    struct BinaryHeader {
+        uint32_t magic;
+        uint32_t format;
+        uint32_t length;
+    };
+    constexpr uint32_t BINARY_MAGIC = 0x53564231;   // "SVB1"
+
+    GLuint compile(const std::string& name, GLenum type, const char* source) {
+        GLuint shader = glCreateShader(type);
+        glShaderSource(shader, 1, &source, nullptr);
+        glCompileShader(shader);
+        GLint ok = 0;
+        glGetShaderiv(shader, GL_COMPILE_STATUS, &ok);
+        if (!ok) {
+            char log[512];
+            glGetShaderInfoLog(shader, sizeof(log), nullptr, log);
+            std::cerr << "ShaderCache: " << name << " shader compile failed: " << log << std::endl;
+            glDeleteShader(shader);
+            return 0;
+        }
+        return shader;
+    }
+
+    std::string gl_string(GLenum name) {
+        const GLubyte* value = glGetString(name);
+        return value ? reinterpret_cast<const char*>(value) : "";
+    }
+}
+
+ShaderCache::ShaderCache()
+    : loader(nullptr), binary_probed(false), get_program_binary(nullptr), program_binary(nullptr),
+      binary_loads(0), binary_stores(0) {
+}
+
+void ShaderCache::enable_binary_cache(const std::string& directory, GlProcLoader proc_loader) {
+    binary_directory = directory;
+    loader = proc_loader;
+    binary_probed = false;
+}
+
+std::string ShaderCache::default_directory() {
+    const char* xdg = std::getenv("XDG_CACHE_HOME");
+    if (xdg && *xdg) return std::string(xdg) + "/stepviewer/shaders";
+    const char* home = std::getenv("HOME");
+    if (home && *home) return std::string(home) + "/.cache/stepviewer/shaders";
+    return "/tmp/stepviewer-shaders";
+}
+
+bool ShaderCache::probe_binary_support() {
+    if (binary_probed) return get_program_binary && program_binary;
+    binary_probed = true;
+    if (binary_directory.empty() || !loader) return false;
+
+    // Needs a current context, which program() callers already guarantee
+    std::string extensions(1, ' ');
+    extensions += gl_string(GL_EXTENSIONS);
+    extensions += ' ';
+    GLint formats = 0;
+    if (extensions.find(" GL_OES_get_program_binary ") != std::string::npos) {
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS_OES, &formats);
+    }
+    if (formats <= 0) {
+        std::cout << "ShaderCache: program binaries not supported, compiling every run" << std::endl;
+        return false;
+    }
+
+    get_program_binary = reinterpret_cast<PFNGLGETPROGRAMBINARYOESPROC>(loader("glGetProgramBinaryOES"));
+    program_binary = reinterpret_cast<PFNGLPROGRAMBINARYOESPROC>(loader("glProgramBinaryOES"));
+    if (!get_program_binary || !program_binary) {
+        get_program_binary = nullptr;
+        program_binary = nullptr;
+        return false;
+    }
+
+    // A driver update changes the binary format without telling us, so the
+    // driver identity is part of every key
+    driver = gl_string(GL_VENDOR) + "\n" + gl_string(GL_RENDERER) + "\n" + gl_string(GL_VERSION);
+    std::error_code error;
+    std::filesystem::create_directories(binary_directory, error);
+    return true;
+}
+
+std::string ShaderCache::binary_path(const std::string& name, const char* vertex_source,
+                                     const char* fragment_source) const {
+    std::string key = driver + "\n" + name + "\n" + vertex_source + "\n" + fragment_source;
+    return binary_directory + "/" + ContentHash::to_hex(ContentHash::hash64(key.data(), key.size())) + ".bin";
+}
+
+GLuint ShaderCache::load_binary(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return 0;
+    BinaryHeader header;
+    if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)) || header.magic != BINARY_MAGIC) return 0;
+    std::vector<char> binary(header.length);
+    if (!in.read(binary.data(), static_cast<std::streamsize>(binary.size()))) return 0;
+
+    GLuint linked = glCreateProgram();
+    program_binary(linked, header.format, binary.data(), static_cast<GLint>(binary.size()));
+    GLint ok = 0;
+    glGetProgramiv(linked, GL_LINK_STATUS, &ok);
+    if (!ok) {
+        // Rejected (driver changed in a way the key missed); recompile and overwrite
+        glDeleteProgram(linked);
+        return 0;
+    }
+    binary_loads++;
+    return linked;
+}
+
+void ShaderCache::store_binary(const std::string& path, GLuint linked) {
+    GLint length = 0;
+    glGetProgramiv(linked, GL_PROGRAM_BINARY_LENGTH_OES, &length);
+    if (length <= 0) return;
+
+    std::vector<char> image(sizeof(BinaryHeader) + static_cast<size_t>(length));
+    BinaryHeader header = {BINARY_MAGIC, 0, 0};
+    GLsizei written = 0;
+    get_program_binary(linked, length, &written, &header.format, image.data() + sizeof(BinaryHeader));
+    if (written <= 0) return;
+    header.length = static_cast<uint32_t>(written);
+    std::memcpy(image.data(), &header, sizeof(header));
+    image.resize(sizeof(BinaryHeader) + static_cast<size_t>(written));
+
+    // Same temp-and-rename as the geometry cache, so a crash never leaves a
+    // truncated binary behind
+    std::string temp_path = path + ".tmp." + std::to_string(getpid());
+    {
+        std::ofstream out(temp_path, std::ios::binary | std::ios::trunc);
+        if (!out) return;
+        out.write(image.data(), static_cast<std::streamsize>(image.size()));
+        if (!out) {
+            out.close();
+            std::remove(temp_path.c_str());
+            return;
+        }
+    }
+    if (std::rename(temp_path.c_str(), path.c_str()) != 0) {
+        std::remove(temp_path.c_str());
+        return;
+    }
+    binary_stores++;
+}
+
+GLuint ShaderCache::program(const std::string& name, const char* vertex_source, const char* fragment_source) {
+    auto found = programs.find(name);
+    if (found != programs.end()) return found->second;
+
+    std::string path;
+    if (probe_binary_support()) {
+        path = binary_path(name, vertex_source, fragment_source);
+        if (GLuint cached = load_binary(path)) {
+            programs.emplace(name, cached);
+            return cached;
+        }
+    }
+
+    GLuint vs = compile(name, GL_VERTEX_SHADER, vertex_source);
+    GLuint fs = compile(name, GL_FRAGMENT_SHADER, fragment_source);
+    if (!vs || !fs) {
+        if (vs) glDeleteShader(vs);
+        if (fs) glDeleteShader(fs);
+        return 0;
+    }
+
+    GLuint linked = glCreateProgram();
+    glAttachShader(linked, vs);
+    glAttachShader(linked, fs);
+    glLinkProgram(linked);
+    glDeleteShader(vs);
+    glDeleteShader(fs);
+
+    GLint ok = 0;
+    glGetProgramiv(linked, GL_LINK_STATUS, &ok);
+    if (!ok) {
+        std::cerr << "ShaderCache: " << name << " program link failed" << std::endl;
+        glDeleteProgram(linked);
+        return 0;
+    }
+
+    if (!path.empty()) store_binary(path, linked);
+    programs.emplace(name, linked);
+    return linked;
+}
+
+void ShaderCache::clear() {
+    for (const auto& entry : programs) {
+        glDeleteProgram(entry.second);
+    }
+    programs.clear();
+}
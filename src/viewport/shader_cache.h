@@ -0,0 +1,61 @@
+#pragma once
+
+#include <GLES2/gl2.h>
+#include <GLES2/gl2ext.h>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+// Linked GLES2 programs for one EGL context, looked up by name. Every window
+// renders with the process-wide context, so a program built for one window is
+// reused by the others instead of being compiled again per renderer.
+//
+// With the binary cache enabled, linked programs are also saved through
+// GL_OES_get_program_binary, keyed by driver and sources, so later runs load
+// them instead of compiling. A stale or rejected binary falls back to compiling.
+class ShaderCache {
+public:
+    typedef void (*GlProc)();
+    typedef GlProc (*GlProcLoader)(const char* name);
+
+private:
+    std::unordered_map<std::string, GLuint> programs;
+
+    // Binary cache; resolved lazily, the first time a context is current
+    std::string binary_directory;
+    GlProcLoader loader;
+    bool binary_probed;
+    PFNGLGETPROGRAMBINARYOESPROC get_program_binary;
+    PFNGLPROGRAMBINARYOESPROC program_binary;
+    std::string driver;   // vendor, renderer and version; part of every key
+
+    size_t binary_loads;
+    size_t binary_stores;
+
+    bool probe_binary_support();
+    std::string binary_path(const std::string& name, const char* vertex_source, const char* fragment_source) const;
+    GLuint load_binary(const std::string& path);
+    void store_binary(const std::string& path, GLuint linked);
+
+public:
+    ShaderCache();
+
+    ShaderCache(const ShaderCache&) = delete;
+    ShaderCache& operator=(const ShaderCache&) = delete;
+
+    // Compiles and links on first use; 0 if either stage fails (logged)
+    GLuint program(const std::string& name, const char* vertex_source, const char* fragment_source);
+
+    // Persist linked programs under directory. The loader resolves extension
+    // entry points (eglGetProcAddress); without the extension this is a no-op.
+    void enable_binary_cache(const std::string& directory, GlProcLoader proc_loader);
+    static std::string default_directory();
+
+    // Deletes every program; the owning context must be current
+    void clear();
+
+    size_t size() const { return programs.size(); }
+    size_t get_binary_loads() const { return binary_loads; }
+    size_t get_binary_stores() const { return binary_stores; }
+};
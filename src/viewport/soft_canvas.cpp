@@ -0,0 +1,260 @@
+#include "soft_canvas.h"
+#include "span_kernels.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+SoftCanvas* SoftCanvas::current_canvas = nullptr;
+
+namespace {
+    inline uint64_t mix(uint64_t hash, uint64_t value) {
+        hash = (hash ^ value) * 0xff51afd7ed558ccdull;
+        return hash ^ (hash >> 32);
+    }
+
+    inline uint32_t float_bits(float value) {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+
+    // Premultiplied pixel scaled by coverage (0..256)
+    inline uint32_t scale(uint32_t pixel, uint32_t coverage) {
+        uint32_t rb = (((pixel & 0x00ff00ffu) * coverage) >> 8) & 0x00ff00ffu;
+        uint32_t ag = (((pixel >> 8) & 0x00ff00ffu) * coverage) & 0xff00ff00u;
+        return rb | ag;
+    }
+
+    inline float fraction(float value) { return value - std::floor(value); }
+}
+
+SoftCanvas::SoftCanvas() : width(0), height(0), tiles_x(0), tiles_y(0) {
+}
+
+uint32_t SoftCanvas::pixel(float r, float g, float b, float a) {
+    auto channel = [](float value) {
+        return static_cast<uint32_t>(std::lround(std::clamp(value, 0.0f, 1.0f) * 255.0f));
+    };
+    a = std::clamp(a, 0.0f, 1.0f);
+    return channel(a) << 24 | channel(r * a) << 16 | channel(g * a) << 8 | channel(b * a);
+}
+
+void SoftCanvas::begin_frame(int frame_width, int frame_height, uint32_t clear_pixel) {
+    width = std::max(frame_width, 0);
+    height = std::max(frame_height, 0);
+    tiles_x = (width + TILE_SIZE - 1) / TILE_SIZE;
+    tiles_y = (height + TILE_SIZE - 1) / TILE_SIZE;
+    commands.clear();
+    // The frame size is part of every hash, so a resize repaints everything
+    frame_hashes.assign(static_cast<size_t>(tiles_x) * tiles_y, mix(mix(0, width), height));
+    fill_rect(0, 0, width, height, clear_pixel | 0xff000000u);
+}
+
+void SoftCanvas::add(const Command& command) {
+    if (command.min_x > command.max_x || command.min_y > command.max_y) return;
+    commands.push_back(command);
+
+    uint64_t hash = mix(mix(command.type, command.pixel), command.min_x | uint64_t(command.min_y) << 32);
+    hash = mix(hash, command.max_x | uint64_t(command.max_y) << 32);
+    hash = mix(hash, float_bits(command.x0) | uint64_t(float_bits(command.y0)) << 32);
+    hash = mix(hash, float_bits(command.x1) | uint64_t(float_bits(command.y1)) << 32);
+    hash = mix(hash, command.content);
+    for (int ty = command.min_y / TILE_SIZE; ty <= command.max_y / TILE_SIZE; ++ty) {
+        uint64_t* row = frame_hashes.data() + static_cast<size_t>(ty) * tiles_x;
+        for (int tx = command.min_x / TILE_SIZE; tx <= command.max_x / TILE_SIZE; ++tx) row[tx] = mix(row[tx], hash);
+    }
+}
+
+void SoftCanvas::fill_rect(int x, int y, int w, int h, uint32_t pixel) {
+    if ((pixel >> 24) == 0) return;
+    Command command = {FILL, pixel, 0, 0, 0, 0,
+                       std::max(x, 0), std::max(y, 0), std::min(x + w, width) - 1, std::min(y + h, height) - 1,
+                       nullptr, 0, 0};
+    add(command);
+}
+
+void SoftCanvas::line(float x0, float y0, float x1, float y1, uint32_t pixel) {
+    if ((pixel >> 24) == 0 || !std::isfinite(x0 + y0 + x1 + y1)) return;
+    // Window coordinates put pixel centres at +0.5; the rasterizer wants
+    // them on integers
+    x0 -= 0.5f;
+    y0 -= 0.5f;
+    x1 -= 0.5f;
+    y1 -= 0.5f;
+    // Touched pixels, one extra each way for the antialiasing; clamped
+    // before conversion so far-off ends cannot overflow
+    auto low = [](float a, float b, int limit) {
+        return static_cast<int>(std::floor(std::clamp(std::min(a, b), -2.0f, limit + 2.0f))) - 1;
+    };
+    auto high = [](float a, float b, int limit) {
+        return static_cast<int>(std::ceil(std::clamp(std::max(a, b), -2.0f, limit + 2.0f))) + 1;
+    };
+    Command command = {LINE, pixel, x0, y0, x1, y1,
+                       std::max(low(x0, x1, width), 0), std::max(low(y0, y1, height), 0),
+                       std::min(high(x0, x1, width), width - 1), std::min(high(y0, y1, height), height - 1),
+                       nullptr, 0, 0};
+    add(command);
+}
+
+void SoftCanvas::dot(float x, float y, float size, uint32_t pixel) {
+    int half = std::max(1, static_cast<int>(size * 0.5f));
+    int cx = static_cast<int>(std::floor(x)), cy = static_cast<int>(std::floor(y));
+    fill_rect(cx - half, cy - half, 2 * half, 2 * half, pixel);
+}
+
+void SoftCanvas::mask(int x, int y, int w, int h, const uint8_t* coverage, int stride, uint64_t content,
+                      uint32_t pixel) {
+    if ((pixel >> 24) == 0 || !coverage) return;
+    Command command = {MASK, pixel, static_cast<float>(x), static_cast<float>(y), 0, 0,
+                       std::max(x, 0), std::max(y, 0), std::min(x + w, width) - 1, std::min(y + h, height) - 1,
+                       coverage, stride, content};
+    add(command);
+}
+
+void SoftCanvas::draw(const Command& command, const DamageRect& clip, SoftTarget& target) const {
+    if (command.max_x < clip.x || command.min_x >= clip.x + clip.width ||
+        command.max_y < clip.y || command.min_y >= clip.y + clip.height) {
+        return;
+    }
+    if (command.type == LINE) {
+        draw_line(command, clip, target);
+        return;
+    }
+    if (command.type == MASK) {
+        draw_mask(command, clip, target);
+        return;
+    }
+
+    const int x0 = std::max(command.min_x, clip.x), x1 = std::min(command.max_x + 1, clip.x + clip.width);
+    const int y0 = std::max(command.min_y, clip.y), y1 = std::min(command.max_y + 1, clip.y + clip.height);
+    const bool opaque = (command.pixel >> 24) == 0xff;
+    for (int y = y0; y < y1; ++y) {
+        uint32_t* row = target.pixels + static_cast<size_t>(y) * target.stride + x0;
+        if (opaque) {
+            SpanKernels::fill(row, x1 - x0, command.pixel);
+        } else {
+            SpanKernels::blend(row, x1 - x0, command.pixel);
+        }
+    }
+}
+
+// Xiaolin Wu: two pixels per step along the major axis, weighted by how far
+// the line passes from each; the end pixels also by how much of them the
+// line covers. Only steps whose pixels can fall inside clip are walked.
+void SoftCanvas::draw_line(const Command& command, const DamageRect& clip, SoftTarget& target) const {
+    float x0 = command.x0, y0 = command.y0, x1 = command.x1, y1 = command.y1;
+    const bool steep = std::fabs(y1 - y0) > std::fabs(x1 - x0);
+    if (steep) {
+        std::swap(x0, y0);
+        std::swap(x1, y1);
+    }
+    if (x0 > x1) {
+        std::swap(x0, x1);
+        std::swap(y0, y1);
+    }
+    const float dx = x1 - x0;
+    const float gradient = dx == 0.0f ? 0.0f : (y1 - y0) / dx;
+
+    const int first = static_cast<int>(std::floor(x0 + 0.5f)), last = static_cast<int>(std::floor(x1 + 0.5f));
+    const int major_low = steep ? clip.y : clip.x;
+    const int major_high = steep ? clip.y + clip.height : clip.x + clip.width;
+    const int minor_low = steep ? clip.x : clip.y;
+    const int minor_high = steep ? clip.x + clip.width : clip.y + clip.height;
+    const float first_gap = 1.0f - fraction(x0 + 0.5f), last_gap = fraction(x1 + 0.5f);
+
+    auto plot = [&](int major, int minor, float coverage) {
+        if (minor < minor_low || minor >= minor_high || coverage <= 0.0f) return;
+        uint32_t weight = static_cast<uint32_t>(coverage * 256.0f + 0.5f);
+        if (weight == 0) return;
+        int px = steep ? minor : major, py = steep ? major : minor;
+        uint32_t& dst = target.pixels[static_cast<size_t>(py) * target.stride + px];
+        dst = SpanKernels::blend_pixel(dst, scale(command.pixel, std::min(weight, 256u)));
+    };
+
+    for (int x = std::max(first, major_low); x <= std::min(last, major_high - 1); ++x) {
+        float weight = 1.0f;
+        if (first == last) {
+            weight = x1 - x0;
+        } else if (x == first) {
+            weight = first_gap;
+        } else if (x == last) {
+            weight = last_gap;
+        }
+        float y = y0 + gradient * (static_cast<float>(x) - x0);
+        if (!(y >= minor_low - 2.0f && y < minor_high + 1.0f)) continue;
+        int minor = static_cast<int>(std::floor(y));
+        float f = y - static_cast<float>(minor);
+        plot(x, minor, (1.0f - f) * weight);
+        plot(x, minor + 1, f * weight);
+    }
+}
+
+void SoftCanvas::draw_mask(const Command& command, const DamageRect& clip, SoftTarget& target) const {
+    const int x0 = std::max(command.min_x, clip.x), x1 = std::min(command.max_x + 1, clip.x + clip.width);
+    const int y0 = std::max(command.min_y, clip.y), y1 = std::min(command.max_y + 1, clip.y + clip.height);
+    const int origin_x = static_cast<int>(command.x0), origin_y = static_cast<int>(command.y0);
+    for (int y = y0; y < y1; ++y) {
+        const uint8_t* source = command.coverage + static_cast<size_t>(y - origin_y) * command.coverage_stride;
+        uint32_t* row = target.pixels + static_cast<size_t>(y) * target.stride;
+        for (int x = x0; x < x1; ++x) {
+            uint32_t coverage = source[x - origin_x];
+            if (coverage == 0) continue;
+            row[x] = SpanKernels::blend_pixel(row[x], scale(command.pixel, coverage + (coverage >> 7)));
+        }
+    }
+}
+
+void SoftCanvas::collect(const std::vector<uint8_t>& mask, std::vector<DamageRect>& rects) const {
+    rects.clear();
+    for (int ty = 0; ty < tiles_y; ++ty) {
+        const size_t row_start = rects.size();
+        const int y = ty * TILE_SIZE, h = std::min(TILE_SIZE, height - y);
+        for (int tx = 0; tx < tiles_x;) {
+            if (!mask[static_cast<size_t>(ty) * tiles_x + tx]) {
+                ++tx;
+                continue;
+            }
+            int end = tx;
+            while (end < tiles_x && mask[static_cast<size_t>(ty) * tiles_x + end]) ++end;
+            const int x = tx * TILE_SIZE, w = std::min(end * TILE_SIZE, width) - x;
+
+            // The same run on the row above grows down instead
+            bool merged = false;
+            for (size_t i = 0; i < row_start; ++i) {
+                DamageRect& above = rects[i];
+                if (above.x == x && above.width == w && above.y + above.height == y) {
+                    above.height += h;
+                    merged = true;
+                    break;
+                }
+            }
+            if (!merged) rects.push_back(DamageRect{x, y, w, h});
+            tx = end;
+        }
+    }
+}
+
+void SoftCanvas::render(SoftTarget& target, std::vector<DamageRect>& repainted, std::vector<DamageRect>& damage) {
+    const size_t tile_count = frame_hashes.size();
+    // 0 marks a tile as unknown, so no real hash may be 0
+    for (uint64_t& hash : frame_hashes) hash |= hash == 0;
+    if (target.tile_hashes.size() != tile_count || target.width != width || target.height != height) {
+        target.tile_hashes.assign(tile_count, 0);
+    }
+    if (presented_hashes.size() != tile_count) presented_hashes.assign(tile_count, 0);
+
+    repaint_mask.resize(tile_count);
+    damage_mask.resize(tile_count);
+    for (size_t t = 0; t < tile_count; ++t) {
+        repaint_mask[t] = target.tile_hashes[t] != frame_hashes[t];
+        damage_mask[t] = presented_hashes[t] != frame_hashes[t];
+    }
+    collect(repaint_mask, repainted);
+    collect(damage_mask, damage);
+
+    for (const DamageRect& rect : repainted) {
+        for (const Command& command : commands) draw(command, rect, target);
+    }
+    target.tile_hashes = frame_hashes;
+    presented_hashes = frame_hashes;
+}
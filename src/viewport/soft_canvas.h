@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Pixels the software renderer draws into: one wl_shm buffer, say. Each
+// target remembers what every tile of it currently shows, so a frame only
+// repaints the tiles that differ, however old the buffer's contents are.
+struct SoftTarget {
+    uint32_t* pixels;
+    int width, height;
+    int stride;                        // in pixels
+    std::vector<uint64_t> tile_hashes; // 0 = unknown
+
+    SoftTarget() : pixels(nullptr), width(0), height(0), stride(0) {}
+};
+
+struct DamageRect {
+    int x, y, width, height;
+};
+
+// Software replacement for the GL drawing the UI does, for machines without
+// a working EGL. Drawing calls only record commands; render() then hashes
+// the commands touching each 64x64 tile, repaints the tiles whose hash the
+// target does not already hold, and reports as damage the tiles that changed
+// since the previous frame presented. An unchanged frame costs the hashing
+// and nothing else. Coordinates are window pixels, origin top left.
+// UI thread only.
+class SoftCanvas {
+public:
+    static constexpr int TILE_SIZE = 64;
+
+private:
+    enum CommandType : uint8_t { FILL, LINE, MASK };
+
+    struct Command {
+        CommandType type;
+        uint32_t pixel;                   // premultiplied ARGB
+        float x0, y0, x1, y1;             // LINE: ends, pixel centres at integers
+        int min_x, min_y, max_x, max_y;   // pixels touched, inclusive, clamped to the frame
+        const uint8_t* coverage;          // MASK: top left pixel at (x0, y0)
+        int coverage_stride;
+        uint64_t content;                 // MASK: identifies what coverage holds
+    };
+
+    int width, height;
+    int tiles_x, tiles_y;
+    std::vector<Command> commands;
+    std::vector<uint64_t> frame_hashes;
+    std::vector<uint64_t> presented_hashes;
+    std::vector<uint8_t> repaint_mask, damage_mask;
+
+    static SoftCanvas* current_canvas;
+
+    void add(const Command& command);
+    void draw(const Command& command, const DamageRect& clip, SoftTarget& target) const;
+    void draw_line(const Command& command, const DamageRect& clip, SoftTarget& target) const;
+    void draw_mask(const Command& command, const DamageRect& clip, SoftTarget& target) const;
+    // Tiles set in mask, merged into rectangles
+    void collect(const std::vector<uint8_t>& mask, std::vector<DamageRect>& rects) const;
+
+public:
+    SoftCanvas();
+
+    // Starts recording a frame of this size, cleared to pixel
+    void begin_frame(int frame_width, int frame_height, uint32_t clear_pixel);
+
+    // Whole pixels [x, x + w) x [y, y + h); translucent colours blend
+    void fill_rect(int x, int y, int w, int h, uint32_t pixel);
+    // Antialiased, one pixel wide
+    void line(float x0, float y0, float x1, float y1, uint32_t pixel);
+    // Square marker centred on (x, y)
+    void dot(float x, float y, float size, uint32_t pixel);
+    // pixel scaled by 8-bit coverage, one per pixel from (x, y). Only
+    // content is hashed, so it must change whenever the coverage does, and
+    // coverage must stay valid until render().
+    void mask(int x, int y, int w, int h, const uint8_t* coverage, int stride, uint64_t content, uint32_t pixel);
+
+    // Brings target (at least the frame's size) up to date with the
+    // recorded frame. repainted gets the rectangles drawn into target,
+    // damage those that differ from the previously rendered frame (what the
+    // compositor must be told).
+    void render(SoftTarget& target, std::vector<DamageRect>& repainted, std::vector<DamageRect>& damage);
+
+    int get_width() const { return width; }
+    int get_height() const { return height; }
+    size_t command_count() const { return commands.size(); }
+
+    static uint32_t pixel(float r, float g, float b, float a);
+
+    // Canvas the current frame draws into, or null when drawing with GL
+    static SoftCanvas* current() { return current_canvas; }
+    static void set_current(SoftCanvas* canvas) { current_canvas = canvas; }
+};
@@ -0,0 +1,125 @@
+#include "span_kernels.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SPAN_KERNELS_X86 1
+#endif
+
+namespace SpanKernels {
+
+    namespace {
+        typedef void (*SpanFn)(uint32_t*, int, uint32_t);
+
+        void fill_scalar(uint32_t* dst, int count, uint32_t pixel) {
+            for (int i = 0; i < count; ++i) dst[i] = pixel;
+        }
+
+        void blend_tail(uint32_t* dst, int start, int count, uint32_t pixel) {
+            for (int i = start; i < count; ++i) dst[i] = blend_pixel(dst[i], pixel);
+        }
+
+        void blend_scalar(uint32_t* dst, int count, uint32_t pixel) {
+            blend_tail(dst, 0, count, pixel);
+        }
+
+#ifdef SPAN_KERNELS_X86
+        void fill_sse2(uint32_t* dst, int count, uint32_t pixel) {
+            const __m128i value = _mm_set1_epi32(static_cast<int>(pixel));
+            int i = 0;
+            for (; i + 4 <= count; i += 4) _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), value);
+            fill_scalar(dst + i, count - i, pixel);
+        }
+
+        // Channels widened to 16 bits: t = d * inverse + 128, then
+        // (t + (t >> 8)) >> 8 divides by 255 exactly as blend_pixel does
+        inline __m128i scale_sse2(__m128i d16, __m128i inverse, __m128i half) {
+            __m128i t = _mm_add_epi16(_mm_mullo_epi16(d16, inverse), half);
+            return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+        }
+
+        void blend_sse2(uint32_t* dst, int count, uint32_t pixel) {
+            const __m128i source = _mm_set1_epi32(static_cast<int>(pixel));
+            const __m128i inverse = _mm_set1_epi16(static_cast<short>(255 - (pixel >> 24)));
+            const __m128i half = _mm_set1_epi16(128), zero = _mm_setzero_si128();
+            int i = 0;
+            for (; i + 4 <= count; i += 4) {
+                __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+                __m128i lo = scale_sse2(_mm_unpacklo_epi8(d, zero), inverse, half);
+                __m128i hi = scale_sse2(_mm_unpackhi_epi8(d, zero), inverse, half);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_add_epi8(_mm_packus_epi16(lo, hi), source));
+            }
+            blend_tail(dst, i, count, pixel);
+        }
+
+        __attribute__((target("avx2")))
+        void fill_avx2(uint32_t* dst, int count, uint32_t pixel) {
+            const __m256i value = _mm256_set1_epi32(static_cast<int>(pixel));
+            int i = 0;
+            for (; i + 8 <= count; i += 8) _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), value);
+            fill_scalar(dst + i, count - i, pixel);
+        }
+
+        __attribute__((target("avx2")))
+        inline __m256i scale_avx2(__m256i d16, __m256i inverse, __m256i half) {
+            __m256i t = _mm256_add_epi16(_mm256_mullo_epi16(d16, inverse), half);
+            return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+        }
+
+        // Unpack and pack both work within 128-bit lanes, so the pixels come
+        // back in their original order
+        __attribute__((target("avx2")))
+        void blend_avx2(uint32_t* dst, int count, uint32_t pixel) {
+            const __m256i source = _mm256_set1_epi32(static_cast<int>(pixel));
+            const __m256i inverse = _mm256_set1_epi16(static_cast<short>(255 - (pixel >> 24)));
+            const __m256i half = _mm256_set1_epi16(128), zero = _mm256_setzero_si256();
+            int i = 0;
+            for (; i + 8 <= count; i += 8) {
+                __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + i));
+                __m256i lo = scale_avx2(_mm256_unpacklo_epi8(d, zero), inverse, half);
+                __m256i hi = scale_avx2(_mm256_unpackhi_epi8(d, zero), inverse, half);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i),
+                                    _mm256_add_epi8(_mm256_packus_epi16(lo, hi), source));
+            }
+            blend_tail(dst, i, count, pixel);
+        }
+#endif
+
+        struct Dispatch {
+            SpanFn fill;
+            SpanFn blend;
+            const char* isa;
+
+            Dispatch() : fill(fill_scalar), blend(blend_scalar), isa("scalar") {
+#ifdef SPAN_KERNELS_X86
+                __builtin_cpu_init();
+                if (__builtin_cpu_supports("avx2")) {
+                    fill = fill_avx2;
+                    blend = blend_avx2;
+                    isa = "avx2";
+                } else if (__builtin_cpu_supports("sse2")) {
+                    fill = fill_sse2;
+                    blend = blend_sse2;
+                    isa = "sse2";
+                }
+#endif
+            }
+        };
+
+        const Dispatch& dispatch() {
+            static const Dispatch instance;
+            return instance;
+        }
+    }
+
+    void fill(uint32_t* dst, int count, uint32_t pixel) {
+        dispatch().fill(dst, count, pixel);
+    }
+
+    void blend(uint32_t* dst, int count, uint32_t pixel) {
+        dispatch().blend(dst, count, pixel);
+    }
+
+    const char* active_isa() {
+        return dispatch().isa;
+    }
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+
+// Pixel span kernels for the software renderer. Pixels are 32-bit
+// premultiplied ARGB (0xAARRGGBB). Each kernel has AVX2, SSE2 and scalar
+// variants; the best one for the running CPU is picked on first use, and all
+// of them produce identical pixels.
+namespace SpanKernels {
+    // dst[0, count) = pixel
+    void fill(uint32_t* dst, int count, uint32_t pixel);
+
+    // Source-over of one premultiplied colour: dst = pixel + dst * (255 - alpha) / 255
+    void blend(uint32_t* dst, int count, uint32_t pixel);
+
+    // One pixel of blend(), for antialiased edges
+    inline uint32_t blend_pixel(uint32_t dst, uint32_t pixel) {
+        const uint32_t inverse = 255 - (pixel >> 24);
+        uint32_t result = 0;
+        for (int shift = 0; shift < 32; shift += 8) {
+            uint32_t t = ((dst >> shift) & 0xff) * inverse + 128;
+            result |= (((pixel >> shift) & 0xff) + ((t + (t >> 8)) >> 8)) << shift;
+        }
+        return result;
+    }
+
+    const char* active_isa();
+}
@@ -0,0 +1,136 @@
+#include "thumbnail_view.h"
+#include "gl_state.h"
+#include "soft_canvas.h"
+#include <algorithm>
+#include <vector>
+
+namespace {
+    const char* VERTEX_SHADER =
+        "attribute vec2 position;\n"
+        "varying vec2 v_uv;\n"
+        "void main() {\n"
+        "    // Row 0 of the thumbnail is its top\n"
+        "    v_uv = vec2(position.x * 0.5 + 0.5, 0.5 - position.y * 0.5);\n"
+        "    gl_Position = vec4(position, 0.0, 1.0);\n"
+        "}\n";
+
+    const char* FRAGMENT_SHADER =
+        "precision mediump float;\n"
+        "uniform vec4 color;\n"
+        "uniform sampler2D coverage;\n"
+        "varying vec2 v_uv;\n"
+        "void main() {\n"
+        "    gl_FragColor = vec4(color.rgb, color.a * texture2D(coverage, v_uv).r);\n"
+        "}\n";
+
+    const float QUAD[] = {-1.0f, -1.0f, 1.0f, -1.0f, -1.0f, 1.0f, 1.0f, 1.0f};
+}
+
+ThumbnailView::ThumbnailView(ShaderCache* shader_cache)
+    : shaders(shader_cache), program(0), quad(0), attr_position(-1), uniform_color(-1), uniform_texture(-1),
+      frame(0), uploads(0) {
+}
+
+ThumbnailView::~ThumbnailView() {
+    for (auto& entry : textures) glDeleteTextures(1, &entry.second.name);
+    if (quad) glDeleteBuffers(1, &quad);
+}
+
+bool ThumbnailView::init_program() {
+    if (program) return true;
+
+    program = shaders->program("thumbnail", VERTEX_SHADER, FRAGMENT_SHADER);
+    if (!program) return false;
+
+    attr_position = glGetAttribLocation(program, "position");
+    uniform_color = glGetUniformLocation(program, "color");
+    uniform_texture = glGetUniformLocation(program, "coverage");
+    glGenBuffers(1, &quad);
+    GlState::bind_array_buffer(quad);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(QUAD), QUAD, GL_STATIC_DRAW);
+    GlState::count_calls(2);
+    return true;
+}
+
+GLuint ThumbnailView::texture_for(const Thumbnail& thumbnail) {
+    auto found = textures.find(thumbnail.id);
+    if (found != textures.end()) {
+        found->second.last_frame = frame;
+        return found->second.name;
+    }
+
+    // Rows are a byte apart; luminance lands in .r
+    Texture texture = {0, frame};
+    glGenTextures(1, &texture.name);
+    glBindTexture(GL_TEXTURE_2D, texture.name);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE, thumbnail.width, thumbnail.height, 0, GL_LUMINANCE,
+                 GL_UNSIGNED_BYTE, thumbnail.coverage.data());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    GlState::count_calls(8);
+    ++uploads;
+    textures.emplace(thumbnail.id, texture);
+    return texture.name;
+}
+
+void ThumbnailView::end_frame() {
+    ++frame;
+    if (textures.size() <= MAX_TEXTURES) return;
+
+    // Least recently drawn first, sparing the ones still on screen
+    std::vector<std::pair<uint64_t, uint64_t>> by_age;
+    for (const auto& entry : textures) by_age.push_back({entry.second.last_frame, entry.first});
+    std::sort(by_age.begin(), by_age.end());
+    size_t excess = textures.size() - MAX_TEXTURES;
+    for (size_t i = 0; i < by_age.size() && excess > 0; ++i, --excess) {
+        if (by_age[i].first + KEEP_FRAMES >= frame) break;
+        auto found = textures.find(by_age[i].second);
+        glDeleteTextures(1, &found->second.name);
+        GlState::count_calls(1);
+        textures.erase(found);
+    }
+}
+
+void ThumbnailView::draw(const Thumbnail& thumbnail, const BoxArea& area, const Color& color) {
+    if (thumbnail.coverage.empty() || area.width <= 0 || area.height <= 0) return;
+
+    if (!shaders) {
+        // One texel per pixel, centred: same placement as the GL path when
+        // the area is thumbnail sized. y flipped as for Box::render.
+        SoftCanvas* canvas = SoftCanvas::current();
+        if (!canvas) return;
+        int x = static_cast<int>(area.x + (area.width - thumbnail.width) * 0.5f);
+        int y = canvas->get_height() - static_cast<int>(area.y + (area.height + thumbnail.height) * 0.5f);
+        canvas->mask(x, y, thumbnail.width, thumbnail.height, thumbnail.coverage.data(), thumbnail.width,
+                     thumbnail.id, SoftCanvas::pixel(color.r, color.g, color.b, color.a));
+        return;
+    }
+    if (!init_program()) return;
+
+    GLuint texture = texture_for(thumbnail);
+    GLint previous_viewport[4];
+    bool restore_viewport = GlState::get_viewport(previous_viewport);
+    GlState::viewport(static_cast<GLint>(area.x), static_cast<GLint>(area.y),
+                      static_cast<GLsizei>(area.width), static_cast<GLsizei>(area.height));
+
+    GlState::use_program(program);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glUniform1i(uniform_texture, 0);
+    glUniform4f(uniform_color, color.r, color.g, color.b, color.a);
+    GlState::count_calls(4);
+
+    GlState::bind_array_buffer(quad);
+    glEnableVertexAttribArray(attr_position);
+    glVertexAttribPointer(attr_position, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+    GlState::draw_arrays(GL_TRIANGLE_STRIP, 0, 4);
+    glDisableVertexAttribArray(attr_position);
+    GlState::count_calls(3);
+
+    if (restore_viewport) {
+        GlState::viewport(previous_viewport[0], previous_viewport[1], previous_viewport[2], previous_viewport[3]);
+    }
+}
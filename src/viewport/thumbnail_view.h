@@ -0,0 +1,56 @@
+#pragma once
+
+#include "raster/thumbnail.h"
+#include "ui/box.h"
+#include "shader_cache.h"
+#include <GLES2/gl2.h>
+#include <cstdint>
+#include <unordered_map>
+
+// Draws file browser thumbnails. A thumbnail's texture is uploaded the first
+// time it is drawn, that is when its row scrolls into view, and deleted once
+// it has gone undrawn for a while with more than MAX_TEXTURES alive. UI
+// thread only (needs the GL context). Without a shader cache it draws into
+// the current SoftCanvas instead and keeps no textures.
+class ThumbnailView {
+private:
+    struct Texture {
+        GLuint name;
+        uint64_t last_frame;
+    };
+
+    ShaderCache* shaders;
+    GLuint program;
+    GLuint quad;
+    GLint attr_position;
+    GLint uniform_color;
+    GLint uniform_texture;
+    std::unordered_map<uint64_t, Texture> textures;   // by Thumbnail::id
+    uint64_t frame;
+    size_t uploads;
+
+    bool init_program();
+    GLuint texture_for(const Thumbnail& thumbnail);
+
+public:
+    static constexpr size_t MAX_TEXTURES = 64;
+    // Textures drawn within this many frames are never deleted
+    static constexpr uint64_t KEEP_FRAMES = 2;
+
+    // Null shader_cache = software rendering
+    explicit ThumbnailView(ShaderCache* shader_cache);
+    ~ThumbnailView();
+
+    ThumbnailView(const ThumbnailView&) = delete;
+    ThumbnailView& operator=(const ThumbnailView&) = delete;
+
+    // Once per frame, after the thumbnails are drawn: deletes textures
+    // beyond MAX_TEXTURES that were not drawn lately
+    void end_frame();
+
+    // Coverage in color over area (window pixels, as for boxes)
+    void draw(const Thumbnail& thumbnail, const BoxArea& area, const Color& color);
+
+    size_t texture_count() const { return textures.size(); }
+    size_t upload_count() const { return uploads; }
+};
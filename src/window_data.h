@@ -11,6 +11,7 @@ struct WindowData {
     bool mouse_pressed;
     bool mouse_released;
     bool mouse_held;
+    float scroll_y;      // this frame's vertical scrolling, pixels, positive down
     
     // Window state
     bool window_resized;
@@ -18,7 +19,7 @@ struct WindowData {
     
     WindowData() : screen_width(0), screen_height(0), 
                    mouse_x(0), mouse_y(0), 
-                   mouse_pressed(false), mouse_released(false), mouse_held(false),
+                   mouse_pressed(false), mouse_released(false), mouse_held(false), scroll_y(0),
                    window_resized(false), should_exit(false) {}
 };
 